@@ -82,10 +82,17 @@ src/myers.c \
 src/optimize.c \
 src/sequence.c \
 src/range_mapping.c \
+src/refine_parallel.c \
 src/string_hash_map.c \
 src/utils.c \
 src/print_utils.c \
 src/utf8_utils.c \
+src/minhash.c \
+src/moved_lines.c \
+src/repro.c \
+src/sparse_lcs.c \
+src/flat_result.c \
+src/trace.c \
 vendor/utf8proc.c"
 
 # Build
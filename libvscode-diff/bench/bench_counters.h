@@ -0,0 +1,167 @@
+/**
+ * Hardware Performance Counters for Benchmarks
+ *
+ * Thin wrapper over Linux perf_event_open(2) counting, for the calling
+ * thread and user space only:
+ * - cycles, instructions, cache misses, branch misses
+ * - opened as one group so all counters cover the same interval
+ * - values are scaled when the kernel multiplexes the group
+ *
+ * On other platforms, or when the kernel refuses access (containers,
+ * perf_event_paranoid, missing PMU in VMs), bench_counters_open() fails with a
+ * reason and the caller keeps timing only. Individual counters the PMU does not
+ * support are reported as unavailable (-1) rather than failing the group.
+ */
+
+#ifndef BENCH_COUNTERS_H
+#define BENCH_COUNTERS_H
+
+// syscall() is hidden by the project-wide _POSIX_C_SOURCE; include this header
+// before any system header
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef enum {
+  BENCH_COUNTER_CYCLES = 0,
+  BENCH_COUNTER_INSTRUCTIONS,
+  BENCH_COUNTER_CACHE_MISSES,
+  BENCH_COUNTER_BRANCH_MISSES,
+  BENCH_COUNTER_COUNT
+} BenchCounterId;
+
+typedef struct {
+  int64_t values[BENCH_COUNTER_COUNT]; // -1 when the counter is unavailable
+} BenchCounterValues;
+
+typedef struct {
+  int fds[BENCH_COUNTER_COUNT];   // -1 when not opened
+  int leader;                     // Group leader fd
+  int opened;                     // Number of counters in the group
+  int order[BENCH_COUNTER_COUNT]; // Counter id of the i-th value in a group read
+} BenchCounters;
+
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static inline int bench_perf_event_open(uint64_t config, int group_fd) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = group_fd == -1 ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+/**
+ * Open the counter group. On failure, *reason names the cause.
+ */
+static inline bool bench_counters_open(BenchCounters *counters, const char **reason) {
+  static const uint64_t configs[BENCH_COUNTER_COUNT] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES};
+  counters->leader = -1;
+  counters->opened = 0;
+  for (int i = 0; i < BENCH_COUNTER_COUNT; i++) {
+    counters->fds[i] = -1;
+  }
+
+  for (int i = 0; i < BENCH_COUNTER_COUNT; i++) {
+    int fd = bench_perf_event_open(configs[i], counters->leader);
+    if (fd < 0) {
+      if (counters->leader == -1) {
+        if (errno == EACCES || errno == EPERM) {
+          *reason = "permission denied (perf_event_paranoid)";
+        } else if (errno == ENOENT || errno == ENODEV || errno == EOPNOTSUPP) {
+          *reason = "no hardware PMU";
+        } else {
+          *reason = "perf_event_open failed";
+        }
+        return false;
+      }
+      continue; // This counter is unsupported; keep the rest of the group
+    }
+    if (counters->leader == -1) {
+      counters->leader = fd;
+    }
+    counters->fds[i] = fd;
+    counters->order[counters->opened++] = i;
+  }
+  return true;
+}
+
+static inline void bench_counters_close(BenchCounters *counters) {
+  for (int i = 0; i < BENCH_COUNTER_COUNT; i++) {
+    if (counters->fds[i] >= 0) {
+      close(counters->fds[i]);
+      counters->fds[i] = -1;
+    }
+  }
+  counters->leader = -1;
+  counters->opened = 0;
+}
+
+static inline void bench_counters_start(BenchCounters *counters) {
+  ioctl(counters->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(counters->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+/**
+ * Stop counting and read the values accumulated since bench_counters_start()
+ */
+static inline bool bench_counters_stop(BenchCounters *counters, BenchCounterValues *out) {
+  ioctl(counters->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+  uint64_t buffer[3 + BENCH_COUNTER_COUNT]; // nr, time_enabled, time_running, values
+  ssize_t bytes = read(counters->leader, buffer, sizeof(buffer));
+  for (int i = 0; i < BENCH_COUNTER_COUNT; i++) {
+    out->values[i] = -1;
+  }
+  if (bytes < (ssize_t)(3 * sizeof(uint64_t)) || buffer[0] != (uint64_t)counters->opened) {
+    return false;
+  }
+
+  // Scale up when the group only ran for part of the interval (multiplexing)
+  double scale = buffer[2] > 0 ? (double)buffer[1] / (double)buffer[2] : 0.0;
+  for (int i = 0; i < counters->opened; i++) {
+    out->values[counters->order[i]] = (int64_t)((double)buffer[3 + i] * scale);
+  }
+  return true;
+}
+
+#else
+
+static inline bool bench_counters_open(BenchCounters *counters, const char **reason) {
+  memset(counters, 0, sizeof(*counters));
+  *reason = "perf_event_open is Linux-only";
+  return false;
+}
+
+static inline void bench_counters_close(BenchCounters *counters) { (void)counters; }
+
+static inline void bench_counters_start(BenchCounters *counters) { (void)counters; }
+
+static inline bool bench_counters_stop(BenchCounters *counters, BenchCounterValues *out) {
+  (void)counters;
+  for (int i = 0; i < BENCH_COUNTER_COUNT; i++) {
+    out->values[i] = -1;
+  }
+  return false;
+}
+
+#endif
+
+#endif // BENCH_COUNTERS_H
@@ -0,0 +1,916 @@
+/**
+ * bench_diff - Diff Pipeline Benchmark
+ *
+ * Generates deterministic synthetic corpora of several shapes, sweeps their
+ * size and times the full pipeline (compute_diff) as well as the individual
+ * stages (compute_line_alignments, refine_diff_char_level). Every measurement
+ * is preceded by warmup runs and repeated; median / p95 are emitted as JSON.
+ *
+ * Usage: bench_diff [options]
+ *   --sizes <n,n,...>         Sizes to sweep (lines; default 1000,5000,20000)
+ *   --shapes <name,...>       Shapes to run (default: all, see --list)
+ *   --reps <n>                Timed repetitions per stage (default 7)
+ *   --warmup <n>              Untimed warmup runs per stage (default 1)
+ *   --timeout <ms>            max_computation_time_ms (default 5000, 0 = none)
+ *   --rewrite-threshold <x>   DiffOptions.rewrite_threshold (default 0)
+ *   --moves                   Enable compute_moves for the compute_diff stage
+ *   --quality <parity|fast>   DiffOptions.quality for all stages (default parity)
+ *   --divergence              Also time compute_diff with quality = fast and report how far
+ *                             its result is from parity (see below)
+ *   --counters                Also collect hardware counters per stage (Linux perf_event)
+ *   --output <file>           Write JSON to file instead of stdout
+ *   --list                    List shapes and exit
+ *
+ * The same seed always produces the same corpus, so results are comparable
+ * across builds and machines.
+ *
+ * With --counters, each stage also reports cycles, instructions, cache misses
+ * and branch misses (mean per run), IPC, and misses per element. Elements are
+ * lines (original + modified) for compute_diff and compute_line_alignments, and
+ * bytes inside the refined regions for refine_diff_char_level. Counters cover
+ * the calling thread only; run with OMP_NUM_THREADS=1 to include refinement.
+ *
+ * With --divergence, each case also reports the fast result's distance from
+ * the parity result: hunk_delta (fast minus parity line mappings) and
+ * char_jaccard, the Jaccard index of the characters highlighted by inner
+ * changes on both sides (1.0 = identical highlights).
+ */
+
+#include "bench_counters.h"
+#include "bench_utils.h"
+#include "char_level.h"
+#include "default_lines_diff_computer.h"
+#include "line_level.h"
+#include "types.h"
+#include "utf8_utils.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#define DEFAULT_SIZES "1000,5000,20000"
+#define MAX_SIZES 32
+#define LINE_BUFFER 256
+#define MINIFIED_BYTES_PER_LINE 40
+#define REORDER_BLOCK_LINES 12
+
+// ============================================================================
+// Corpus
+// ============================================================================
+
+typedef struct {
+  char **lines;
+  int count;
+  int capacity;
+} LineList;
+
+typedef struct {
+  LineList original;
+  LineList modified;
+  size_t bytes; // Total bytes of both sides
+} Corpus;
+
+static void line_list_push(LineList *list, const char *text, size_t len) {
+  if (list->count >= list->capacity) {
+    int new_capacity = list->capacity == 0 ? 1024 : list->capacity * 2;
+    char **new_lines = (char **)realloc(list->lines, (size_t)new_capacity * sizeof(char *));
+    if (!new_lines) {
+      fprintf(stderr, "bench_diff: out of memory\n");
+      exit(1);
+    }
+    list->lines = new_lines;
+    list->capacity = new_capacity;
+  }
+  char *copy = (char *)malloc(len + 1);
+  if (!copy) {
+    fprintf(stderr, "bench_diff: out of memory\n");
+    exit(1);
+  }
+  memcpy(copy, text, len);
+  copy[len] = '\0';
+  list->lines[list->count++] = copy;
+}
+
+static void corpus_push(Corpus *corpus, LineList *side, const char *text) {
+  size_t len = strlen(text);
+  line_list_push(side, text, len);
+  corpus->bytes += len + 1;
+}
+
+static void line_list_free(LineList *list) {
+  for (int i = 0; i < list->count; i++) {
+    free(list->lines[i]);
+  }
+  free(list->lines);
+  list->lines = NULL;
+  list->count = 0;
+  list->capacity = 0;
+}
+
+// ============================================================================
+// Line Generators
+// ============================================================================
+
+static uint64_t line_seed(uint64_t salt, int index) {
+  BenchRng rng;
+  bench_rng_seed(&rng, salt * 0x100000001b3ull + (uint64_t)index + 1);
+  return bench_rng_next(&rng);
+}
+
+/**
+ * Code-like line derived only from (seed, ident): regenerating a line with a
+ * different identifier yields a rename of the same statement.
+ */
+static void code_line(char *buf, size_t cap, uint64_t seed, const char *ident) {
+  static const char *const fields[] = {"count", "items", "name", "offset", "buffer", "state"};
+  BenchRng rng;
+  bench_rng_seed(&rng, seed);
+  int kind = bench_rng_below(&rng, 10);
+  int n = bench_rng_below(&rng, 1000);
+  const char *field = fields[bench_rng_below(&rng, 6)];
+  int indent = 2 * (1 + bench_rng_below(&rng, 3));
+
+  switch (kind) {
+  case 0:
+  case 1:
+    snprintf(buf, cap, "%*slocal %s_%s = compute(%s.%s, %d)", indent, "", ident, field, ident,
+             field, n);
+    break;
+  case 2:
+    snprintf(buf, cap, "%*sif %s.%s > %d then", indent, "", ident, field, n);
+    break;
+  case 3:
+    snprintf(buf, cap, "%*sreturn %s:call(\"%s\", %d)", indent, "", ident, field, n);
+    break;
+  case 4:
+    snprintf(buf, cap, "%*s%s.%s = %s.%s + %d", indent, "", ident, field, ident, field, n);
+    break;
+  case 5:
+    snprintf(buf, cap, "%*s-- update %s %s (step %d)", indent, "", ident, field, n);
+    break;
+  case 6:
+    snprintf(buf, cap, "%*send", indent, "");
+    break;
+  case 7:
+    buf[0] = '\0';
+    break;
+  default:
+    snprintf(buf, cap, "%*stable.insert(%s.%s, { id = %d })", indent, "", ident, field, n);
+    break;
+  }
+}
+
+/**
+ * Mixed CJK / emoji line. Word `edit_word` (or none if -1) is replaced by a
+ * word drawn from `edit_seed`, so edited lines differ by one grapheme cluster.
+ */
+static void unicode_line(char *buf, size_t cap, uint64_t seed, int edit_word, uint64_t edit_seed) {
+  static const char *const words[] = {
+      "数据",       "函数",       "变量",     "返回值",   "日本語", "テキスト", "한국어",
+      "文字列",     "処理",       "😀",       "🚀",       "✨",     "👍🏽",       "👨‍👩‍👧",
+      "🇯🇵",         "value",      "é",        "naïve",    "中文注释", "絵文字✅"};
+  const int word_count = (int)(sizeof(words) / sizeof(words[0]));
+  BenchRng rng;
+  bench_rng_seed(&rng, seed);
+  BenchRng edit_rng;
+  bench_rng_seed(&edit_rng, edit_seed);
+  int n = 3 + bench_rng_below(&rng, 8);
+
+  size_t len = 0;
+  buf[0] = '\0';
+  for (int w = 0; w < n; w++) {
+    int pick = bench_rng_below(&rng, word_count);
+    if (w == edit_word) {
+      pick = (pick + 1 + bench_rng_below(&edit_rng, word_count - 1)) % word_count;
+    }
+    int written = snprintf(buf + len, cap - len, "%s%s", w ? " " : "", words[pick]);
+    if (written < 0 || (size_t)written >= cap - len) {
+      break;
+    }
+    len += (size_t)written;
+  }
+}
+
+// ============================================================================
+// Shapes
+// ============================================================================
+
+typedef void (*ShapeGenerator)(Corpus *corpus, int size);
+
+/** Scattered small edits: ~2% modified lines, ~1% deletions, ~1% insertions */
+static void gen_scattered(Corpus *corpus, int size) {
+  char line[LINE_BUFFER];
+  BenchRng rng;
+  bench_rng_seed(&rng, 0x5ca7);
+  for (int i = 0; i < size; i++) {
+    code_line(line, sizeof(line), line_seed(1, i), "ctx");
+    corpus_push(corpus, &corpus->original, line);
+
+    int roll = bench_rng_below(&rng, 100);
+    if (roll < 2) {
+      code_line(line, sizeof(line), line_seed(2, i), "ctx");
+      corpus_push(corpus, &corpus->modified, line);
+    } else if (roll == 2) {
+      continue;
+    } else {
+      corpus_push(corpus, &corpus->modified, line);
+      if (roll == 3) {
+        code_line(line, sizeof(line), line_seed(3, i), "ctx");
+        corpus_push(corpus, &corpus->modified, line);
+      }
+    }
+  }
+}
+
+/** One large insertion of size/2 new lines a third of the way in */
+static void gen_insertion(Corpus *corpus, int size) {
+  char line[LINE_BUFFER];
+  for (int i = 0; i < size; i++) {
+    code_line(line, sizeof(line), line_seed(1, i), "ctx");
+    corpus_push(corpus, &corpus->original, line);
+    if (i == size / 3) {
+      for (int j = 0; j < size / 2; j++) {
+        code_line(line, sizeof(line), line_seed(4, j), "inserted");
+        corpus_push(corpus, &corpus->modified, line);
+      }
+    }
+    code_line(line, sizeof(line), line_seed(1, i), "ctx");
+    corpus_push(corpus, &corpus->modified, line);
+  }
+}
+
+/** Identifier renamed on every line that mentions it (~80% of lines) */
+static void gen_rename(Corpus *corpus, int size) {
+  char line[LINE_BUFFER];
+  for (int i = 0; i < size; i++) {
+    code_line(line, sizeof(line), line_seed(1, i), "ctx");
+    corpus_push(corpus, &corpus->original, line);
+    code_line(line, sizeof(line), line_seed(1, i), "request_context");
+    corpus_push(corpus, &corpus->modified, line);
+  }
+}
+
+/** Single minified line of ~size * 40 bytes with ~1% of tokens edited */
+static void gen_minified(Corpus *corpus, int size) {
+  size_t target = (size_t)size * MINIFIED_BYTES_PER_LINE;
+  size_t cap = target + 64;
+  char *original = (char *)malloc(cap);
+  char *modified = (char *)malloc(cap);
+  if (!original || !modified) {
+    fprintf(stderr, "bench_diff: out of memory\n");
+    exit(1);
+  }
+
+  BenchRng rng;
+  bench_rng_seed(&rng, 0x3141);
+  size_t len_a = 0;
+  size_t len_b = 0;
+  int token = 0;
+  while (len_a < target) {
+    int n = bench_rng_below(&rng, 100);
+    bool edited = bench_rng_below(&rng, 100) == 0;
+    len_a += (size_t)snprintf(original + len_a, cap - len_a, "v%d=f(%d,\"k%d\");", token, n,
+                              token % 97);
+    len_b += (size_t)snprintf(modified + len_b, cap - len_b, "v%d=f(%d,\"k%d\");", token,
+                              edited ? n + 1 : n, token % 97);
+    token++;
+  }
+
+  line_list_push(&corpus->original, original, len_a);
+  line_list_push(&corpus->modified, modified, len_b);
+  corpus->bytes += len_a + len_b + 2;
+  free(original);
+  free(modified);
+}
+
+/** CJK / emoji text with one word replaced on ~5% of lines */
+static void gen_unicode(Corpus *corpus, int size) {
+  char line[LINE_BUFFER];
+  BenchRng rng;
+  bench_rng_seed(&rng, 0xc1c);
+  for (int i = 0; i < size; i++) {
+    uint64_t seed = line_seed(5, i);
+    unicode_line(line, sizeof(line), seed, -1, 0);
+    corpus_push(corpus, &corpus->original, line);
+    if (bench_rng_below(&rng, 20) == 0) {
+      unicode_line(line, sizeof(line), seed, bench_rng_below(&rng, 3), line_seed(6, i));
+    }
+    corpus_push(corpus, &corpus->modified, line);
+  }
+}
+
+/** Blocks of REORDER_BLOCK_LINES lines, ~20% of blocks swapped with another block */
+static void gen_reordered(Corpus *corpus, int size) {
+  char line[LINE_BUFFER];
+  int block_count = (size + REORDER_BLOCK_LINES - 1) / REORDER_BLOCK_LINES;
+  int *order = (int *)malloc((size_t)block_count * sizeof(int));
+  if (!order) {
+    fprintf(stderr, "bench_diff: out of memory\n");
+    exit(1);
+  }
+  for (int b = 0; b < block_count; b++) {
+    order[b] = b;
+  }
+  BenchRng rng;
+  bench_rng_seed(&rng, 0xb10c);
+  for (int swaps = block_count / 10; swaps > 0; swaps--) {
+    int x = bench_rng_below(&rng, block_count);
+    int y = bench_rng_below(&rng, block_count);
+    int tmp = order[x];
+    order[x] = order[y];
+    order[y] = tmp;
+  }
+
+  for (int i = 0; i < size; i++) {
+    code_line(line, sizeof(line), line_seed(7, i), "ctx");
+    corpus_push(corpus, &corpus->original, line);
+  }
+  for (int b = 0; b < block_count; b++) {
+    int start = order[b] * REORDER_BLOCK_LINES;
+    for (int i = start; i < start + REORDER_BLOCK_LINES && i < size; i++) {
+      code_line(line, sizeof(line), line_seed(7, i), "ctx");
+      corpus_push(corpus, &corpus->modified, line);
+    }
+  }
+  free(order);
+}
+
+/** Near-total rewrite: only every 25th line survives */
+static void gen_rewrite(Corpus *corpus, int size) {
+  char line[LINE_BUFFER];
+  for (int i = 0; i < size; i++) {
+    code_line(line, sizeof(line), line_seed(8, i), "ctx");
+    corpus_push(corpus, &corpus->original, line);
+    if (i % 25 != 0) {
+      code_line(line, sizeof(line), line_seed(9, i), "next");
+    }
+    corpus_push(corpus, &corpus->modified, line);
+  }
+}
+
+/** Whole file re-indented by two spaces; every 10th line instead loses trailing whitespace */
+static void gen_reindent(Corpus *corpus, int size) {
+  char line[LINE_BUFFER];
+  char edited[LINE_BUFFER + 8];
+  for (int i = 0; i < size; i++) {
+    code_line(line, sizeof(line), line_seed(10, i), "ctx");
+    if (i % 10 == 0) {
+      snprintf(edited, sizeof(edited), "%s  ", line);
+      corpus_push(corpus, &corpus->original, edited);
+      corpus_push(corpus, &corpus->modified, line);
+      continue;
+    }
+    corpus_push(corpus, &corpus->original, line);
+    snprintf(edited, sizeof(edited), "%s%s", line[0] ? "  " : "", line);
+    corpus_push(corpus, &corpus->modified, edited);
+  }
+}
+
+typedef struct {
+  const char *name;
+  const char *description;
+  ShapeGenerator generate;
+} Shape;
+
+static const Shape SHAPES[] = {
+    {"scattered", "scattered small edits (~4% of lines)", gen_scattered},
+    {"insertion", "one insertion of size/2 lines", gen_insertion},
+    {"rename", "identifier renamed on ~80% of lines", gen_rename},
+    {"minified", "single line of size*40 bytes, ~1% tokens edited", gen_minified},
+    {"unicode", "CJK/emoji text, one word edited on ~5% of lines", gen_unicode},
+    {"reordered", "12-line blocks, ~20% moved", gen_reordered},
+    {"rewrite", "near-total rewrite (4% of lines kept)", gen_rewrite},
+    {"reindent", "every line re-indented or trailing whitespace stripped", gen_reindent},
+};
+#define SHAPE_COUNT ((int)(sizeof(SHAPES) / sizeof(SHAPES[0])))
+
+// ============================================================================
+// Stages
+// ============================================================================
+
+typedef struct {
+  int warmup;
+  int reps;
+  int timeout_ms;
+  double rewrite_threshold;
+  bool compute_moves;
+  DiffQuality quality;
+  bool divergence;
+  BenchCounters *counters; // NULL unless --counters succeeded
+} BenchConfig;
+
+typedef struct {
+  const char **original;
+  int original_count;
+  const char **modified;
+  int modified_count;
+  const SequenceDiffArray *alignments; // Input of the char_refine stage
+} StageInput;
+
+typedef bool (*StageFn)(const StageInput *input, const BenchConfig *config);
+
+static bool stage_compute_diff(const StageInput *input, const BenchConfig *config) {
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = config->timeout_ms,
+                         .compute_moves = config->compute_moves,
+                         .extend_to_subwords = false,
+                         .rewrite_threshold = config->rewrite_threshold,
+                         .quality = config->quality};
+  LinesDiff *diff = compute_diff(input->original, input->original_count, input->modified,
+                                 input->modified_count, &options);
+  bool hit_timeout = diff ? diff->hit_timeout : false;
+  free_lines_diff(diff);
+  return hit_timeout;
+}
+
+static bool stage_compute_diff_fast(const StageInput *input, const BenchConfig *config) {
+  BenchConfig fast = *config;
+  fast.quality = DIFF_QUALITY_FAST;
+  return stage_compute_diff(input, &fast);
+}
+
+static bool stage_line_alignments(const StageInput *input, const BenchConfig *config) {
+  bool hit_timeout = false;
+  SequenceDiffArray *alignments = compute_line_alignments(
+      input->original, input->original_count, input->modified, input->modified_count,
+      config->timeout_ms, config->rewrite_threshold, config->quality, &hit_timeout, NULL, NULL);
+  free_sequence_diff_array(alignments);
+  return hit_timeout;
+}
+
+static bool stage_char_refine(const StageInput *input, const BenchConfig *config) {
+  CharLevelOptions options = {.consider_whitespace_changes = true,
+                              .extend_to_subwords = false,
+                              .timeout_ms = config->timeout_ms,
+                              .fast = config->quality == DIFF_QUALITY_FAST};
+  bool hit_timeout = false;
+  for (int i = 0; i < input->alignments->count; i++) {
+    bool region_timeout = false;
+    RangeMappingArray *mappings =
+        refine_diff_char_level(&input->alignments->diffs[i], input->original,
+                               input->original_count, input->modified, input->modified_count,
+                               &options, &region_timeout);
+    free_range_mapping_array(mappings);
+    hit_timeout = hit_timeout || region_timeout;
+  }
+  return hit_timeout;
+}
+
+static void print_counter_json(FILE *out, const char *key, double value, bool available) {
+  if (available) {
+    fprintf(out, ", \"%s\": %.4f", key, value);
+  } else {
+    fprintf(out, ", \"%s\": null", key);
+  }
+}
+
+/**
+ * Print per-run counter means, IPC and misses per element as JSON members
+ * (and as a summary line on stderr)
+ */
+static void report_counters(FILE *out, const char *name, double median_ms, const int64_t *totals,
+                            int reps, long long elements) {
+  static const char *const keys[BENCH_COUNTER_COUNT] = {"cycles", "instructions", "cache_misses",
+                                                        "branch_misses"};
+  double mean[BENCH_COUNTER_COUNT];
+  bool available[BENCH_COUNTER_COUNT];
+  for (int c = 0; c < BENCH_COUNTER_COUNT; c++) {
+    available[c] = totals[c] >= 0;
+    mean[c] = available[c] ? (double)totals[c] / reps : 0.0;
+  }
+  double per_element = elements > 0 ? 1.0 / (double)elements : 0.0;
+  bool has_ipc = available[BENCH_COUNTER_CYCLES] && available[BENCH_COUNTER_INSTRUCTIONS] &&
+                 mean[BENCH_COUNTER_CYCLES] > 0;
+  double ipc = has_ipc ? mean[BENCH_COUNTER_INSTRUCTIONS] / mean[BENCH_COUNTER_CYCLES] : 0.0;
+  double cache_per_element = mean[BENCH_COUNTER_CACHE_MISSES] * per_element;
+  double branch_per_element = mean[BENCH_COUNTER_BRANCH_MISSES] * per_element;
+
+  fprintf(out, ", \"counters\": {\"elements\": %lld", elements);
+  for (int c = 0; c < BENCH_COUNTER_COUNT; c++) {
+    print_counter_json(out, keys[c], mean[c], available[c]);
+  }
+  print_counter_json(out, "ipc", ipc, has_ipc);
+  print_counter_json(out, "cache_misses_per_element", cache_per_element,
+                     available[BENCH_COUNTER_CACHE_MISSES] && elements > 0);
+  print_counter_json(out, "branch_misses_per_element", branch_per_element,
+                     available[BENCH_COUNTER_BRANCH_MISSES] && elements > 0);
+  fputc('}', out);
+
+  fprintf(stderr, "    %-24s %10.3f ms  IPC %5.2f  cache-miss/elem %8.3f  branch-miss/elem %8.3f\n",
+          name, median_ms, ipc, cache_per_element, branch_per_element);
+}
+
+/**
+ * Run a stage warmup + reps times and print its JSON object
+ */
+static void run_stage(FILE *out, const char *name, StageFn fn, const StageInput *input,
+                      const BenchConfig *config, long long elements, bool last) {
+  double *samples = (double *)malloc((size_t)config->reps * sizeof(double));
+  if (!samples) {
+    fprintf(stderr, "bench_diff: out of memory\n");
+    exit(1);
+  }
+
+  for (int i = 0; i < config->warmup; i++) {
+    fn(input, config);
+  }
+
+  int timeouts = 0;
+  int64_t totals[BENCH_COUNTER_COUNT] = {0, 0, 0, 0};
+  for (int i = 0; i < config->reps; i++) {
+    if (config->counters) {
+      bench_counters_start(config->counters);
+    }
+    double start = bench_now_ms();
+    bool hit_timeout = fn(input, config);
+    samples[i] = bench_now_ms() - start;
+    timeouts += hit_timeout ? 1 : 0;
+    if (config->counters) {
+      BenchCounterValues values;
+      bench_counters_stop(config->counters, &values);
+      for (int c = 0; c < BENCH_COUNTER_COUNT; c++) {
+        totals[c] = values.values[c] < 0 || totals[c] < 0 ? -1 : totals[c] + values.values[c];
+      }
+    }
+  }
+
+  BenchStats stats = bench_compute_stats(samples, config->reps);
+  fprintf(out,
+          "        \"%s\": {\"median_ms\": %.3f, \"p95_ms\": %.3f, \"min_ms\": %.3f, "
+          "\"max_ms\": %.3f, \"timeouts\": %d",
+          name, stats.median_ms, stats.p95_ms, stats.min_ms, stats.max_ms, timeouts);
+  if (config->counters) {
+    report_counters(out, name, stats.median_ms, totals, config->reps, elements);
+  }
+  fprintf(out, "}%s\n", last ? "" : ",");
+  free(samples);
+}
+
+// ============================================================================
+// Divergence (--divergence)
+// ============================================================================
+
+/**
+ * Mark the characters of one side highlighted by inner changes. Lines are laid
+ * out back to back in UTF-16 units with one unit for each line break, so a
+ * multi-line range is one contiguous span.
+ */
+static unsigned char *highlight_mask(const LinesDiff *diff, bool original, const char **lines,
+                                     int count, long long *out_size) {
+  long long *line_starts = (long long *)malloc(((size_t)count + 1) * sizeof(long long));
+  if (!line_starts) {
+    fprintf(stderr, "bench_diff: out of memory\n");
+    exit(1);
+  }
+  line_starts[0] = 0;
+  for (int i = 0; i < count; i++) {
+    line_starts[i + 1] = line_starts[i] + utf8_to_utf16_length(lines[i]) + 1;
+  }
+  long long size = line_starts[count];
+  unsigned char *mask = (unsigned char *)calloc((size_t)size + 1, 1);
+  if (!mask) {
+    fprintf(stderr, "bench_diff: out of memory\n");
+    exit(1);
+  }
+
+  for (int m = 0; m < diff->changes.count; m++) {
+    const DetailedLineRangeMapping *mapping = &diff->changes.mappings[m];
+    for (int c = 0; c < mapping->inner_change_count; c++) {
+      const CharRange *range = original ? &mapping->inner_changes[c].original
+                                        : &mapping->inner_changes[c].modified;
+      long long offsets[2];
+      int ends[2][2] = {{range->start_line, range->start_col}, {range->end_line, range->end_col}};
+      for (int e = 0; e < 2; e++) {
+        int line = ends[e][0];
+        if (line < 1) {
+          offsets[e] = 0;
+        } else if (line > count) {
+          offsets[e] = size;
+        } else {
+          long long line_len = line_starts[line] - line_starts[line - 1] - 1;
+          long long col = ends[e][1] - 1 < 0 ? 0 : ends[e][1] - 1;
+          offsets[e] = line_starts[line - 1] + (col > line_len ? line_len : col);
+        }
+      }
+      memset(mask + offsets[0], 1, offsets[1] > offsets[0] ? (size_t)(offsets[1] - offsets[0]) : 0);
+    }
+  }
+  free(line_starts);
+  *out_size = size;
+  return mask;
+}
+
+/** Add one side's highlight overlap to the running intersection / union counts */
+static void count_overlap(const LinesDiff *parity, const LinesDiff *fast, bool original,
+                          const char **lines, int count, long long *both, long long *either) {
+  long long size = 0;
+  unsigned char *a = highlight_mask(parity, original, lines, count, &size);
+  unsigned char *b = highlight_mask(fast, original, lines, count, &size);
+  for (long long i = 0; i < size; i++) {
+    *both += a[i] & b[i];
+    *either += a[i] | b[i];
+  }
+  free(a);
+  free(b);
+}
+
+static void report_divergence(FILE *out, const StageInput *input, const BenchConfig *config) {
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = config->timeout_ms,
+                         .compute_moves = config->compute_moves,
+                         .extend_to_subwords = false,
+                         .rewrite_threshold = config->rewrite_threshold,
+                         .quality = DIFF_QUALITY_PARITY};
+  LinesDiff *parity = compute_diff(input->original, input->original_count, input->modified,
+                                   input->modified_count, &options);
+  options.quality = DIFF_QUALITY_FAST;
+  LinesDiff *fast = compute_diff(input->original, input->original_count, input->modified,
+                                 input->modified_count, &options);
+  if (!parity || !fast) {
+    fprintf(stderr, "bench_diff: compute_diff failed while measuring divergence\n");
+    exit(1);
+  }
+
+  long long both = 0;
+  long long either = 0;
+  count_overlap(parity, fast, true, input->original, input->original_count, &both, &either);
+  count_overlap(parity, fast, false, input->modified, input->modified_count, &both, &either);
+  double jaccard = either > 0 ? (double)both / (double)either : 1.0;
+
+  fprintf(out,
+          ",\n      \"divergence\": {\"parity_changes\": %d, \"fast_changes\": %d, "
+          "\"hunk_delta\": %d, \"highlighted_chars\": %lld, \"char_jaccard\": %.4f}",
+          parity->changes.count, fast->changes.count,
+          fast->changes.count - parity->changes.count, either, jaccard);
+  free_lines_diff(parity);
+  free_lines_diff(fast);
+}
+
+static void run_case(FILE *out, const Shape *shape, int size, const BenchConfig *config,
+                     bool first) {
+  Corpus corpus;
+  memset(&corpus, 0, sizeof(corpus));
+  shape->generate(&corpus, size);
+
+  StageInput input = {(const char **)corpus.original.lines, corpus.original.count,
+                      (const char **)corpus.modified.lines, corpus.modified.count, NULL};
+
+  // Alignments feeding the char_refine stage are computed once, outside the timing
+  bool alignment_timeout = false;
+  SequenceDiffArray *alignments = compute_line_alignments(
+      input.original, input.original_count, input.modified, input.modified_count,
+      config->timeout_ms, config->rewrite_threshold, config->quality, &alignment_timeout, NULL,
+      NULL);
+  if (!alignments) {
+    fprintf(stderr, "bench_diff: compute_line_alignments failed for %s/%d\n", shape->name, size);
+    exit(1);
+  }
+  input.alignments = alignments;
+
+  int largest_region = 0;
+  long long region_bytes = 0;
+  for (int i = 0; i < alignments->count; i++) {
+    const SequenceDiff *d = &alignments->diffs[i];
+    int lines = (d->seq1_end - d->seq1_start) + (d->seq2_end - d->seq2_start);
+    if (lines > largest_region) {
+      largest_region = lines;
+    }
+    for (int line = d->seq1_start; line < d->seq1_end; line++) {
+      region_bytes += (long long)strlen(input.original[line]);
+    }
+    for (int line = d->seq2_start; line < d->seq2_end; line++) {
+      region_bytes += (long long)strlen(input.modified[line]);
+    }
+  }
+  long long total_lines = (long long)corpus.original.count + corpus.modified.count;
+
+  fprintf(stderr, "  %-10s size=%-7d (%d/%d lines, %zu bytes)\n", shape->name, size,
+          corpus.original.count, corpus.modified.count, corpus.bytes);
+
+  fprintf(out, "%s    {\n", first ? "" : ",\n");
+  fprintf(out, "      \"shape\": ");
+  bench_json_string(out, shape->name);
+  fprintf(out, ",\n      \"size\": %d,\n", size);
+  fprintf(out, "      \"original_lines\": %d,\n      \"modified_lines\": %d,\n",
+          corpus.original.count, corpus.modified.count);
+  fprintf(out, "      \"bytes\": %zu,\n", corpus.bytes);
+  fprintf(out, "      \"regions\": %d,\n      \"largest_region_lines\": %d,\n", alignments->count,
+          largest_region);
+  fprintf(out, "      \"stages\": {\n");
+  run_stage(out, "compute_diff", stage_compute_diff, &input, config, total_lines, false);
+  if (config->divergence) {
+    run_stage(out, "compute_diff_fast", stage_compute_diff_fast, &input, config, total_lines,
+              false);
+  }
+  run_stage(out, "compute_line_alignments", stage_line_alignments, &input, config, total_lines,
+            false);
+  run_stage(out, "refine_diff_char_level", stage_char_refine, &input, config, region_bytes, true);
+  fprintf(out, "      }");
+  if (config->divergence) {
+    report_divergence(out, &input, config);
+  }
+  fprintf(out, "\n    }");
+  fflush(out);
+
+  free_sequence_diff_array(alignments);
+  line_list_free(&corpus.original);
+  line_list_free(&corpus.modified);
+}
+
+// ============================================================================
+// Main Program
+// ============================================================================
+
+static int parse_sizes(const char *arg, int *sizes) {
+  int count = 0;
+  const char *p = arg;
+  while (*p && count < MAX_SIZES) {
+    char *end = NULL;
+    long value = strtol(p, &end, 10);
+    if (end == p || value <= 0 || value > 10000000) {
+      return -1;
+    }
+    sizes[count++] = (int)value;
+    p = *end == ',' ? end + 1 : end;
+    if (*end != ',' && *end != '\0') {
+      return -1;
+    }
+  }
+  return count;
+}
+
+static bool shape_selected(const char *list, const char *name) {
+  if (!list) {
+    return true;
+  }
+  size_t len = strlen(name);
+  const char *p = list;
+  while (*p) {
+    const char *comma = strchr(p, ',');
+    size_t item_len = comma ? (size_t)(comma - p) : strlen(p);
+    if (item_len == len && strncmp(p, name, len) == 0) {
+      return true;
+    }
+    if (!comma) {
+      break;
+    }
+    p = comma + 1;
+  }
+  return false;
+}
+
+static void print_usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [options]\n", prog);
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr, "  --sizes <n,n,...>        Sizes to sweep (default: %s)\n", DEFAULT_SIZES);
+  fprintf(stderr, "  --shapes <name,...>      Shapes to run (default: all)\n");
+  fprintf(stderr, "  --reps <n>               Timed repetitions per stage (default: 7)\n");
+  fprintf(stderr, "  --warmup <n>             Warmup runs per stage (default: 1)\n");
+  fprintf(stderr, "  --timeout <ms>           Timeout in milliseconds (default: 5000, 0 = none)\n");
+  fprintf(stderr, "  --rewrite-threshold <x>  Rewrite pre-check threshold (default: 0)\n");
+  fprintf(stderr, "  --moves                  Detect moved code in compute_diff\n");
+  fprintf(stderr, "  --quality <parity|fast>  DiffOptions.quality (default: parity)\n");
+  fprintf(stderr, "  --divergence             Time quality = fast and report divergence from parity\n");
+  fprintf(stderr, "  --counters               Collect hardware counters (cycles, IPC, misses)\n");
+  fprintf(stderr, "  --output <file>          Write JSON to file (default: stdout)\n");
+  fprintf(stderr, "  --list                   List shapes and exit\n");
+}
+
+int main(int argc, char *argv[]) {
+  BenchConfig config = {.warmup = 1,
+                        .reps = 7,
+                        .timeout_ms = 5000,
+                        .rewrite_threshold = 0.0,
+                        .compute_moves = false,
+                        .quality = DIFF_QUALITY_PARITY,
+                        .divergence = false,
+                        .counters = NULL};
+  bool want_counters = false;
+  const char *sizes_arg = DEFAULT_SIZES;
+  const char *shapes_arg = NULL;
+  const char *output_path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (strcmp(arg, "--list") == 0) {
+      for (int s = 0; s < SHAPE_COUNT; s++) {
+        printf("%-10s %s\n", SHAPES[s].name, SHAPES[s].description);
+      }
+      return 0;
+    } else if (strcmp(arg, "--moves") == 0) {
+      config.compute_moves = true;
+    } else if (strcmp(arg, "--counters") == 0) {
+      want_counters = true;
+    } else if (strcmp(arg, "--divergence") == 0) {
+      config.divergence = true;
+    } else if (strcmp(arg, "--quality") == 0 && has_value) {
+      const char *quality = argv[++i];
+      if (strcmp(quality, "parity") != 0 && strcmp(quality, "fast") != 0) {
+        fprintf(stderr, "Error: --quality must be parity or fast\n");
+        return 1;
+      }
+      config.quality = strcmp(quality, "fast") == 0 ? DIFF_QUALITY_FAST : DIFF_QUALITY_PARITY;
+    } else if (strcmp(arg, "--sizes") == 0 && has_value) {
+      sizes_arg = argv[++i];
+    } else if (strcmp(arg, "--shapes") == 0 && has_value) {
+      shapes_arg = argv[++i];
+    } else if (strcmp(arg, "--reps") == 0 && has_value) {
+      config.reps = atoi(argv[++i]);
+    } else if (strcmp(arg, "--warmup") == 0 && has_value) {
+      config.warmup = atoi(argv[++i]);
+    } else if (strcmp(arg, "--timeout") == 0 && has_value) {
+      config.timeout_ms = atoi(argv[++i]);
+    } else if (strcmp(arg, "--rewrite-threshold") == 0 && has_value) {
+      config.rewrite_threshold = atof(argv[++i]);
+    } else if (strcmp(arg, "--output") == 0 && has_value) {
+      output_path = argv[++i];
+    } else {
+      fprintf(stderr, "Error: Unknown or incomplete option: %s\n", arg);
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  int sizes[MAX_SIZES];
+  int size_count = parse_sizes(sizes_arg, sizes);
+  if (size_count <= 0 || config.reps <= 0 || config.warmup < 0 || config.timeout_ms < 0) {
+    fprintf(stderr, "Error: Invalid --sizes, --reps, --warmup or --timeout value\n");
+    return 1;
+  }
+
+  int selected = 0;
+  for (int s = 0; s < SHAPE_COUNT; s++) {
+    selected += shape_selected(shapes_arg, SHAPES[s].name) ? 1 : 0;
+  }
+  if (selected == 0) {
+    fprintf(stderr, "Error: No known shape in --shapes (see --list)\n");
+    return 1;
+  }
+
+  FILE *out = stdout;
+  if (output_path) {
+    out = fopen(output_path, "w");
+    if (!out) {
+      fprintf(stderr, "Error: Cannot open output file '%s'\n", output_path);
+      return 1;
+    }
+  }
+
+  int threads = 1;
+#ifdef USE_OPENMP
+  threads = omp_get_max_threads();
+#endif
+
+  fprintf(stderr, "bench_diff %s: %d reps + %d warmup, timeout %d ms, %d thread(s)\n",
+          get_version(), config.reps, config.warmup, config.timeout_ms, threads);
+
+  BenchCounters counters;
+  if (want_counters) {
+    const char *reason = NULL;
+    if (bench_counters_open(&counters, &reason)) {
+      config.counters = &counters;
+      if (threads > 1) {
+        fprintf(stderr, "  counters cover the main thread only (set OMP_NUM_THREADS=1 to include "
+                        "parallel refinement)\n");
+      }
+    } else {
+      fprintf(stderr, "  hardware counters unavailable: %s; reporting timings only\n", reason);
+    }
+  }
+
+  fprintf(out, "{\n  \"version\": ");
+  bench_json_string(out, get_version());
+  fprintf(out, ",\n  \"threads\": %d,\n  \"warmup\": %d,\n  \"repetitions\": %d,\n", threads,
+          config.warmup, config.reps);
+  fprintf(out, "  \"timeout_ms\": %d,\n  \"rewrite_threshold\": %g,\n  \"compute_moves\": %s,\n",
+          config.timeout_ms, config.rewrite_threshold, config.compute_moves ? "true" : "false");
+  fprintf(out, "  \"quality\": \"%s\",\n",
+          config.quality == DIFF_QUALITY_FAST ? "fast" : "parity");
+  fprintf(out, "  \"hardware_counters\": %s,\n", config.counters ? "true" : "false");
+  fprintf(out, "  \"results\": [\n");
+
+  bool first = true;
+  for (int s = 0; s < SHAPE_COUNT; s++) {
+    if (!shape_selected(shapes_arg, SHAPES[s].name)) {
+      continue;
+    }
+    for (int i = 0; i < size_count; i++) {
+      run_case(out, &SHAPES[s], sizes[i], &config, first);
+      first = false;
+    }
+  }
+
+  fprintf(out, "\n  ]\n}\n");
+  if (config.counters) {
+    bench_counters_close(config.counters);
+  }
+  if (out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,529 @@
+/**
+ * bench_replay - Real-History Replay Benchmark
+ *
+ * Runs compute_diff over a manifest of (before, after) file pairs, typically
+ * extracted from a repository's history by scripts/bench_history.sh, and
+ * reports throughput (files/s, MB/s), per-file latency (p50/p99/max) and the
+ * timeout rate.
+ *
+ * Up to two library builds can be loaded at runtime with --lib and are run
+ * on the same inputs, interleaved per file, for a side-by-side comparison.
+ * Without --lib the library compiled into this executable is used.
+ *
+ * Manifest format: one pair per line, tab-separated:
+ *   <before_path>\t<after_path>[\t<label>]
+ *
+ * Usage: bench_replay [options] <manifest>
+ *   --lib <path>     Library build to load (repeat once to compare two builds)
+ *   --timeout <ms>   max_computation_time_ms (default 5000, 0 = none)
+ *   --reps <n>       Timed runs per file and library; the median is kept (default 1)
+ *   --warmup <n>     Untimed runs per file and library (default 0)
+ *   --json <file>    Also write the report as JSON
+ *
+ * NOTE: Loaded builds must share this tree's DiffOptions / LinesDiff layout.
+ */
+
+#include "bench_utils.h"
+#include "default_lines_diff_computer.h"
+#include "types.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#define MAX_LIBRARIES 2
+#define SLOWEST_REPORTED 5
+
+// ============================================================================
+// Library Loading
+// ============================================================================
+
+typedef LinesDiff *(*ComputeDiffFn)(const char **, int, const char **, int, const DiffOptions *);
+typedef void (*FreeLinesDiffFn)(LinesDiff *);
+typedef const char *(*GetVersionFn)(void);
+
+typedef struct {
+  const char *path; // NULL for the built-in library
+  void *handle;
+  ComputeDiffFn compute_diff;
+  FreeLinesDiffFn free_lines_diff;
+  GetVersionFn get_version;
+} DiffLibrary;
+
+static void *load_symbol(void *handle, const char *name) {
+#ifdef _WIN32
+  return (void *)GetProcAddress((HMODULE)handle, name);
+#else
+  return dlsym(handle, name);
+#endif
+}
+
+static bool library_open(DiffLibrary *lib, const char *path) {
+  memset(lib, 0, sizeof(*lib));
+  lib->path = path;
+  if (!path) {
+    lib->compute_diff = compute_diff;
+    lib->free_lines_diff = free_lines_diff;
+    lib->get_version = get_version;
+    return true;
+  }
+
+#ifdef _WIN32
+  lib->handle = (void *)LoadLibraryA(path);
+#else
+  // RTLD_LOCAL keeps the two builds' internal symbols apart
+  lib->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+#endif
+  if (!lib->handle) {
+    fprintf(stderr, "Error: Cannot load library '%s'\n", path);
+    return false;
+  }
+
+  lib->compute_diff = (ComputeDiffFn)load_symbol(lib->handle, "compute_diff");
+  lib->free_lines_diff = (FreeLinesDiffFn)load_symbol(lib->handle, "free_lines_diff");
+  lib->get_version = (GetVersionFn)load_symbol(lib->handle, "get_version");
+  if (!lib->compute_diff || !lib->free_lines_diff || !lib->get_version) {
+    fprintf(stderr, "Error: '%s' does not export compute_diff/free_lines_diff/get_version\n",
+            path);
+    return false;
+  }
+  return true;
+}
+
+static void library_close(DiffLibrary *lib) {
+  if (!lib->handle) {
+    return;
+  }
+#ifdef _WIN32
+  FreeLibrary((HMODULE)lib->handle);
+#else
+  dlclose(lib->handle);
+#endif
+}
+
+// ============================================================================
+// Input Files
+// ============================================================================
+
+typedef struct {
+  char *content; // Single buffer, lines are NUL-terminated in place
+  const char **lines;
+  int count;
+  size_t bytes;
+} FileLines;
+
+/**
+ * Read a file split on '\n' with JavaScript split('\n') semantics
+ * (same as diff_tool: trailing newline yields a final empty line, '\r' is kept).
+ */
+static bool read_file_lines(const char *path, FileLines *out) {
+  memset(out, 0, sizeof(*out));
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "Error: Cannot open file '%s'\n", path);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (size < 0) {
+    fclose(file);
+    return false;
+  }
+
+  out->content = (char *)malloc((size_t)size + 1);
+  if (!out->content) {
+    fclose(file);
+    return false;
+  }
+  out->bytes = fread(out->content, 1, (size_t)size, file);
+  out->content[out->bytes] = '\0';
+  fclose(file);
+
+  int count = 1;
+  for (size_t i = 0; i < out->bytes; i++) {
+    count += out->content[i] == '\n' ? 1 : 0;
+  }
+  out->lines = (const char **)malloc((size_t)count * sizeof(char *));
+  if (!out->lines) {
+    free(out->content);
+    return false;
+  }
+
+  out->lines[0] = out->content;
+  out->count = 1;
+  for (size_t i = 0; i < out->bytes; i++) {
+    if (out->content[i] == '\n') {
+      out->content[i] = '\0';
+      out->lines[out->count++] = out->content + i + 1;
+    }
+  }
+  return true;
+}
+
+static void free_file_lines(FileLines *file) {
+  free(file->content);
+  free((void *)file->lines);
+}
+
+typedef struct {
+  char *before;
+  char *after;
+  char *label;
+} ManifestEntry;
+
+static int read_manifest(const char *path, ManifestEntry **entries_out) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr, "Error: Cannot open manifest '%s'\n", path);
+    return -1;
+  }
+
+  ManifestEntry *entries = NULL;
+  int count = 0;
+  int capacity = 0;
+  char line[8192];
+  while (fgets(line, sizeof(line), file)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    char *tab = strchr(line, '\t');
+    if (!tab || line[0] == '#') {
+      continue;
+    }
+    *tab = '\0';
+    char *after = tab + 1;
+    char *label_tab = strchr(after, '\t');
+    if (label_tab) {
+      *label_tab = '\0';
+    }
+
+    if (count >= capacity) {
+      capacity = capacity == 0 ? 256 : capacity * 2;
+      ManifestEntry *grown =
+          (ManifestEntry *)realloc(entries, (size_t)capacity * sizeof(ManifestEntry));
+      if (!grown) {
+        fclose(file);
+        free(entries);
+        return -1;
+      }
+      entries = grown;
+    }
+    entries[count].before = strdup(line);
+    entries[count].after = strdup(after);
+    entries[count].label = strdup(label_tab ? label_tab + 1 : after);
+    count++;
+  }
+  fclose(file);
+  *entries_out = entries;
+  return count;
+}
+
+// ============================================================================
+// Measurement
+// ============================================================================
+
+typedef struct {
+  double *latency_ms; // Per file (median of reps)
+  int *timeouts;      // Per file: 1 if the kept run hit the timeout
+  double total_ms;
+} LibraryResult;
+
+typedef struct {
+  double files_per_sec;
+  double mb_per_sec;
+  double p50_ms;
+  double p99_ms;
+  double max_ms;
+  int timeouts;
+} ReplaySummary;
+
+static double run_pair(const DiffLibrary *lib, const FileLines *a, const FileLines *b,
+                       const DiffOptions *options, int warmup, int reps, double *samples,
+                       bool *hit_timeout) {
+  for (int i = 0; i < warmup; i++) {
+    lib->free_lines_diff(lib->compute_diff(a->lines, a->count, b->lines, b->count, options));
+  }
+  *hit_timeout = false;
+  for (int i = 0; i < reps; i++) {
+    double start = bench_now_ms();
+    LinesDiff *diff = lib->compute_diff(a->lines, a->count, b->lines, b->count, options);
+    samples[i] = bench_now_ms() - start;
+    if (diff && diff->hit_timeout) {
+      *hit_timeout = true;
+    }
+    lib->free_lines_diff(diff);
+  }
+  return bench_compute_stats(samples, reps).median_ms;
+}
+
+static ReplaySummary summarize(const LibraryResult *result, int files, size_t bytes) {
+  ReplaySummary summary;
+  memset(&summary, 0, sizeof(summary));
+  if (files == 0) {
+    return summary;
+  }
+
+  double *sorted = (double *)malloc((size_t)files * sizeof(double));
+  if (!sorted) {
+    return summary;
+  }
+  memcpy(sorted, result->latency_ms, (size_t)files * sizeof(double));
+  qsort(sorted, (size_t)files, sizeof(double), bench_compare_doubles);
+
+  double seconds = result->total_ms / 1000.0;
+  summary.files_per_sec = seconds > 0 ? files / seconds : 0.0;
+  summary.mb_per_sec = seconds > 0 ? (double)bytes / (1024.0 * 1024.0) / seconds : 0.0;
+  summary.p50_ms = bench_percentile(sorted, files, 50);
+  summary.p99_ms = bench_percentile(sorted, files, 99);
+  summary.max_ms = sorted[files - 1];
+  for (int i = 0; i < files; i++) {
+    summary.timeouts += result->timeouts[i];
+  }
+  free(sorted);
+  return summary;
+}
+
+// ============================================================================
+// Report
+// ============================================================================
+
+static void print_row(const char *name, const double *values, int lib_count, const char *format) {
+  printf("  %-14s", name);
+  for (int l = 0; l < lib_count; l++) {
+    printf(" ");
+    printf(format, values[l]);
+  }
+  if (lib_count == 2 && values[0] > 0) {
+    printf("   %6.2fx", values[1] / values[0]);
+  }
+  printf("\n");
+}
+
+static void print_slowest(const ManifestEntry *entries, const LibraryResult *result, int files) {
+  int shown[SLOWEST_REPORTED];
+  int shown_count = 0;
+  for (int k = 0; k < SLOWEST_REPORTED && k < files; k++) {
+    int best = -1;
+    for (int i = 0; i < files; i++) {
+      bool taken = false;
+      for (int j = 0; j < shown_count; j++) {
+        taken = taken || shown[j] == i;
+      }
+      if (!taken && (best < 0 || result->latency_ms[i] > result->latency_ms[best])) {
+        best = i;
+      }
+    }
+    shown[shown_count++] = best;
+    printf("    %10.3f ms%s  %s\n", result->latency_ms[best], result->timeouts[best] ? " (T)" : "",
+           entries[best].label);
+  }
+}
+
+static void write_json(const char *path, const DiffLibrary *libs, const ReplaySummary *summaries,
+                       int lib_count, int files, size_t bytes, int timeout_ms, int reps) {
+  FILE *out = fopen(path, "w");
+  if (!out) {
+    fprintf(stderr, "Error: Cannot open JSON output '%s'\n", path);
+    return;
+  }
+  fprintf(out, "{\n  \"files\": %d,\n  \"bytes\": %zu,\n  \"timeout_ms\": %d,\n", files, bytes,
+          timeout_ms);
+  fprintf(out, "  \"repetitions\": %d,\n  \"libraries\": [\n", reps);
+  for (int l = 0; l < lib_count; l++) {
+    const ReplaySummary *s = &summaries[l];
+    fprintf(out, "    {\"path\": ");
+    bench_json_string(out, libs[l].path ? libs[l].path : "(built-in)");
+    fprintf(out, ", \"version\": ");
+    bench_json_string(out, libs[l].get_version());
+    fprintf(out,
+            ", \"files_per_sec\": %.2f, \"mb_per_sec\": %.3f, \"p50_ms\": %.3f, "
+            "\"p99_ms\": %.3f, \"max_ms\": %.3f, \"timeouts\": %d, \"timeout_rate\": %.5f}%s\n",
+            s->files_per_sec, s->mb_per_sec, s->p50_ms, s->p99_ms, s->max_ms, s->timeouts,
+            files ? (double)s->timeouts / files : 0.0, l + 1 < lib_count ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+  fclose(out);
+}
+
+// ============================================================================
+// Main Program
+// ============================================================================
+
+static void print_usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [options] <manifest>\n", prog);
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr, "  --lib <path>     Library build to load (repeat to compare two builds)\n");
+  fprintf(stderr, "  --timeout <ms>   Timeout in milliseconds (default: 5000, 0 = none)\n");
+  fprintf(stderr, "  --reps <n>       Timed runs per file, median kept (default: 1)\n");
+  fprintf(stderr, "  --warmup <n>     Untimed runs per file (default: 0)\n");
+  fprintf(stderr, "  --json <file>    Also write the report as JSON\n");
+}
+
+int main(int argc, char *argv[]) {
+  const char *lib_paths[MAX_LIBRARIES];
+  int lib_count = 0;
+  int timeout_ms = 5000;
+  int reps = 1;
+  int warmup = 0;
+  const char *json_path = NULL;
+  const char *manifest_path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (strcmp(arg, "--lib") == 0 && has_value) {
+      if (lib_count >= MAX_LIBRARIES) {
+        fprintf(stderr, "Error: At most %d libraries can be compared\n", MAX_LIBRARIES);
+        return 1;
+      }
+      lib_paths[lib_count++] = argv[++i];
+    } else if (strcmp(arg, "--timeout") == 0 && has_value) {
+      timeout_ms = atoi(argv[++i]);
+    } else if (strcmp(arg, "--reps") == 0 && has_value) {
+      reps = atoi(argv[++i]);
+    } else if (strcmp(arg, "--warmup") == 0 && has_value) {
+      warmup = atoi(argv[++i]);
+    } else if (strcmp(arg, "--json") == 0 && has_value) {
+      json_path = argv[++i];
+    } else if (arg[0] != '-' && !manifest_path) {
+      manifest_path = arg;
+    } else {
+      fprintf(stderr, "Error: Unknown or incomplete option: %s\n", arg);
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+  if (!manifest_path || timeout_ms < 0 || reps <= 0 || warmup < 0) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  DiffLibrary libs[MAX_LIBRARIES];
+  int open_count = lib_count == 0 ? 1 : lib_count;
+  for (int l = 0; l < open_count; l++) {
+    if (!library_open(&libs[l], lib_count == 0 ? NULL : lib_paths[l])) {
+      return 1;
+    }
+  }
+
+  ManifestEntry *entries = NULL;
+  int entry_count = read_manifest(manifest_path, &entries);
+  if (entry_count < 0) {
+    return 1;
+  }
+
+  LibraryResult results[MAX_LIBRARIES];
+  for (int l = 0; l < open_count; l++) {
+    results[l].latency_ms = (double *)calloc((size_t)(entry_count + 1), sizeof(double));
+    results[l].timeouts = (int *)calloc((size_t)(entry_count + 1), sizeof(int));
+    results[l].total_ms = 0.0;
+  }
+  double *samples = (double *)malloc((size_t)reps * sizeof(double));
+
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = timeout_ms,
+                         .compute_moves = false,
+                         .extend_to_subwords = false,
+                         .rewrite_threshold = 0.0};
+
+  // Interleave libraries per file so drift (thermal, caches) affects both equally
+  int files = 0;
+  size_t bytes = 0;
+  for (int e = 0; e < entry_count; e++) {
+    FileLines before;
+    FileLines after;
+    bool readable = read_file_lines(entries[e].before, &before);
+    if (readable && !read_file_lines(entries[e].after, &after)) {
+      free_file_lines(&before);
+      readable = false;
+    }
+    if (!readable) {
+      free(entries[e].before);
+      free(entries[e].after);
+      free(entries[e].label);
+      continue;
+    }
+
+    for (int l = 0; l < open_count; l++) {
+      bool hit_timeout = false;
+      double ms = run_pair(&libs[l], &before, &after, &options, warmup, reps, samples,
+                           &hit_timeout);
+      results[l].latency_ms[files] = ms;
+      results[l].timeouts[files] = hit_timeout ? 1 : 0;
+      results[l].total_ms += ms;
+    }
+    entries[files] = entries[e];
+    files++;
+    bytes += before.bytes + after.bytes;
+    free_file_lines(&before);
+    free_file_lines(&after);
+
+    if (files % 100 == 0) {
+      fprintf(stderr, "  %d/%d files\n", files, entry_count);
+    }
+  }
+
+  ReplaySummary summaries[MAX_LIBRARIES];
+  for (int l = 0; l < open_count; l++) {
+    summaries[l] = summarize(&results[l], files, bytes);
+  }
+
+  printf("Replayed %d file pairs (%.2f MB), timeout %d ms, %d rep(s)\n\n", files,
+         (double)bytes / (1024.0 * 1024.0), timeout_ms, reps);
+  for (int l = 0; l < open_count; l++) {
+    printf("  [%c] %s %s\n", 'A' + l, libs[l].get_version(),
+           libs[l].path ? libs[l].path : "(built-in)");
+  }
+  printf("\n  %-14s", "");
+  for (int l = 0; l < open_count; l++) {
+    printf(" %12c", 'A' + l);
+  }
+  printf("%s\n", open_count == 2 ? "        B/A" : "");
+
+  double values[MAX_LIBRARIES];
+#define ROW(name, field, format)                                                                   \
+  do {                                                                                             \
+    for (int l = 0; l < open_count; l++) {                                                         \
+      values[l] = (double)summaries[l].field;                                                      \
+    }                                                                                              \
+    print_row(name, values, open_count, format);                                                   \
+  } while (0)
+  ROW("files/s", files_per_sec, "%12.1f");
+  ROW("MB/s", mb_per_sec, "%12.3f");
+  ROW("p50 ms", p50_ms, "%12.3f");
+  ROW("p99 ms", p99_ms, "%12.3f");
+  ROW("max ms", max_ms, "%12.3f");
+  ROW("timeouts", timeouts, "%12.0f");
+#undef ROW
+  printf("  %-14s", "timeout rate");
+  for (int l = 0; l < open_count; l++) {
+    printf(" %11.2f%%", files ? 100.0 * summaries[l].timeouts / files : 0.0);
+  }
+  printf("\n");
+
+  for (int l = 0; l < open_count; l++) {
+    printf("\n  Slowest files [%c]:\n", 'A' + l);
+    print_slowest(entries, &results[l], files);
+  }
+
+  if (json_path) {
+    write_json(json_path, libs, summaries, open_count, files, bytes, timeout_ms, reps);
+  }
+
+  for (int e = 0; e < files; e++) {
+    free(entries[e].before);
+    free(entries[e].after);
+    free(entries[e].label);
+  }
+  free(entries);
+  free(samples);
+  for (int l = 0; l < open_count; l++) {
+    free(results[l].latency_ms);
+    free(results[l].timeouts);
+    library_close(&libs[l]);
+  }
+  return 0;
+}
@@ -0,0 +1,329 @@
+/**
+ * bench_threads - Parallel Refinement Scalability Benchmark
+ *
+ * Times compute_diff() on synthetic inputs that mix hunk count and hunk size
+ * (many one-line hunks, a few large ones, one huge one, ...) at every thread
+ * count from 1 to --max-threads, with the parallel cutoff disabled so every
+ * count really runs. Each mix then runs once more with the default cutoff
+ * (refine_parallel.h) to show the worker count it picks and what that costs.
+ * Median / p95 and the speedup over one thread are emitted as JSON.
+ *
+ * Usage: bench_threads [options]
+ *   --max-threads <n>   Highest thread count (default: omp_get_max_threads())
+ *   --mixes <name,...>  Mixes to run (default: all, see --list)
+ *   --reps <n>          Timed repetitions per thread count (default 7)
+ *   --warmup <n>        Untimed warmup runs per thread count (default 1)
+ *   --output <file>     Write JSON to file instead of stdout
+ *   --list              List mixes and exit
+ *
+ * To tune the cutoff: REFINE_PARALLEL_MIN_WORK_UNITS should sit where the
+ * best parallel time stops beating one thread, and
+ * REFINE_WORK_UNITS_PER_THREAD where adding a thread stops paying off
+ * (compare "work_units" against the speedup curves).
+ *
+ * Without OpenMP only the one-thread column is reported.
+ */
+
+#include "bench_utils.h"
+#include "default_lines_diff_computer.h"
+#include "refine_parallel.h"
+#include "types.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#define GAP_LINES 8
+#define LINE_BUFFER 160
+#define MAX_THREADS 256
+
+typedef struct {
+  const char *name;
+  const char *description;
+  int hunks;
+  int hunk_lines;
+} Mix;
+
+static const Mix MIXES[] = {
+    {"few_small", "4 hunks of 2 lines (typical small edit)", 4, 2},
+    {"tiny_hunks", "2000 one-line hunks", 2000, 1},
+    {"small_hunks", "400 hunks of 5 lines", 400, 5},
+    {"medium_hunks", "60 hunks of 40 lines", 60, 40},
+    {"large_hunks", "8 hunks of 100 lines", 8, 100},
+    {"single_hunk", "1 hunk of 400 lines", 1, 400},
+};
+#define MIX_COUNT ((int)(sizeof(MIXES) / sizeof(MIXES[0])))
+
+typedef struct {
+  char **original;
+  char **modified;
+  int count; // Lines per side
+} Input;
+
+static char *dup_line(const char *text) {
+  size_t len = strlen(text);
+  char *copy = (char *)malloc(len + 1);
+  if (!copy) {
+    fprintf(stderr, "bench_threads: out of memory\n");
+    exit(1);
+  }
+  memcpy(copy, text, len + 1);
+  return copy;
+}
+
+/**
+ * Hunks of edited lines separated by GAP_LINES unchanged lines. An edited
+ * line keeps its shape but changes an identifier and a number, so every hunk
+ * needs real character refinement.
+ */
+static Input input_create(const Mix *mix) {
+  static const char *const idents[] = {"count", "items", "name", "offset", "buffer", "state"};
+  Input input;
+  input.count = mix->hunks * (GAP_LINES + mix->hunk_lines) + GAP_LINES;
+  input.original = (char **)malloc((size_t)input.count * sizeof(char *));
+  input.modified = (char **)malloc((size_t)input.count * sizeof(char *));
+  if (!input.original || !input.modified) {
+    fprintf(stderr, "bench_threads: out of memory\n");
+    exit(1);
+  }
+
+  BenchRng rng;
+  bench_rng_seed(&rng, 0x7e4d5);
+  char line[LINE_BUFFER];
+  int period = GAP_LINES + mix->hunk_lines;
+  for (int i = 0; i < input.count; i++) {
+    const char *ident = idents[bench_rng_below(&rng, 6)];
+    int n = bench_rng_below(&rng, 10000);
+    snprintf(line, sizeof(line), "    local %s_%d = compute(%s.%s, %d) -- step %d", ident, i, ident,
+             idents[bench_rng_below(&rng, 6)], n, i);
+    input.original[i] = dup_line(line);
+    if (i % period >= GAP_LINES) {
+      snprintf(line, sizeof(line), "    local %s_%d = compute(%s.%s, %d) -- step %d", ident, i,
+               idents[bench_rng_below(&rng, 6)], ident, n + 1 + bench_rng_below(&rng, 50), i);
+    }
+    input.modified[i] = dup_line(line);
+  }
+  return input;
+}
+
+static void input_free(Input *input) {
+  for (int i = 0; i < input->count; i++) {
+    free(input->original[i]);
+    free(input->modified[i]);
+  }
+  free(input->original);
+  free(input->modified);
+}
+
+static void set_threads(int threads) {
+#ifdef USE_OPENMP
+  omp_set_num_threads(threads);
+#else
+  (void)threads;
+#endif
+}
+
+static BenchStats time_compute_diff(const Input *input, int warmup, int reps, double *samples,
+                                    int *regions) {
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = 0,
+                         .compute_moves = false,
+                         .extend_to_subwords = false};
+  for (int r = 0; r < warmup + reps; r++) {
+    double start_ms = bench_now_ms();
+    LinesDiff *diff = compute_diff((const char **)input->original, input->count,
+                                   (const char **)input->modified, input->count, &options);
+    double elapsed_ms = bench_now_ms() - start_ms;
+    if (!diff) {
+      fprintf(stderr, "bench_threads: compute_diff failed\n");
+      exit(1);
+    }
+    *regions = diff->changes.count;
+    free_lines_diff(diff);
+    if (r >= warmup) {
+      samples[r - warmup] = elapsed_ms;
+    }
+  }
+  return bench_compute_stats(samples, reps);
+}
+
+static void run_mix(FILE *out, const Mix *mix, int max_threads, int warmup, int reps,
+                    bool first) {
+  Input input = input_create(mix);
+  double *samples = (double *)malloc((size_t)reps * sizeof(double));
+  if (!samples) {
+    fprintf(stderr, "bench_threads: out of memory\n");
+    exit(1);
+  }
+
+  // Same estimate compute_diff() makes: one region per hunk
+  SequenceDiff *hunks = (SequenceDiff *)malloc((size_t)mix->hunks * sizeof(SequenceDiff));
+  if (!hunks) {
+    fprintf(stderr, "bench_threads: out of memory\n");
+    exit(1);
+  }
+  for (int h = 0; h < mix->hunks; h++) {
+    int start = h * (GAP_LINES + mix->hunk_lines) + GAP_LINES;
+    hunks[h] = (SequenceDiff){start, start + mix->hunk_lines, start, start + mix->hunk_lines};
+  }
+  SequenceDiffArray regions = {hunks, mix->hunks, mix->hunks};
+  int64_t work_units = refine_work_units(&regions, (const char **)input.original,
+                                         (const char **)input.modified);
+  free(hunks);
+
+  fprintf(stderr, "  %-13s %6d lines, %9lld work units\n", mix->name, input.count,
+          (long long)work_units);
+  fprintf(out, "%s    {\n      \"mix\": ", first ? "" : ",\n");
+  bench_json_string(out, mix->name);
+  fprintf(out, ",\n      \"hunks\": %d,\n      \"hunk_lines\": %d,\n      \"lines\": %d,\n",
+          mix->hunks, mix->hunk_lines, input.count);
+  fprintf(out, "      \"work_units\": %lld,\n", (long long)work_units);
+
+  // Forced: every thread count runs in parallel
+  refine_set_parallel_cutoff(0, 0);
+  double serial_ms = 0.0;
+  int changes = 0;
+  fprintf(out, "      \"threads\": [\n");
+  for (int t = 1; t <= max_threads; t++) {
+    set_threads(t);
+    BenchStats stats = time_compute_diff(&input, warmup, reps, samples, &changes);
+    if (t == 1) {
+      serial_ms = stats.median_ms;
+    }
+    fprintf(out,
+            "        {\"threads\": %d, \"median_ms\": %.4f, \"p95_ms\": %.4f, "
+            "\"speedup\": %.3f}%s\n",
+            t, stats.median_ms, stats.p95_ms,
+            stats.median_ms > 0.0 ? serial_ms / stats.median_ms : 0.0,
+            t < max_threads ? "," : "");
+  }
+  fprintf(out, "      ],\n");
+
+  // Default cutoff at the full thread count
+  refine_set_parallel_cutoff(-1, -1);
+  set_threads(max_threads);
+  BenchStats stats = time_compute_diff(&input, warmup, reps, samples, &changes);
+  fprintf(out, "      \"changes\": %d,\n", changes);
+  fprintf(out,
+          "      \"auto\": {\"workers\": %d, \"median_ms\": %.4f, \"p95_ms\": %.4f, "
+          "\"speedup\": %.3f}\n",
+          refine_worker_count(work_units, mix->hunks, max_threads), stats.median_ms,
+          stats.p95_ms, stats.median_ms > 0.0 ? serial_ms / stats.median_ms : 0.0);
+  fprintf(out, "    }");
+
+  free(samples);
+  input_free(&input);
+}
+
+static bool mix_selected(const char *list, const char *name) {
+  if (!list) {
+    return true;
+  }
+  size_t len = strlen(name);
+  const char *p = list;
+  while (*p) {
+    const char *comma = strchr(p, ',');
+    size_t item_len = comma ? (size_t)(comma - p) : strlen(p);
+    if (item_len == len && strncmp(p, name, len) == 0) {
+      return true;
+    }
+    if (!comma) {
+      break;
+    }
+    p = comma + 1;
+  }
+  return false;
+}
+
+static void print_usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [options]\n", prog);
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr, "  --max-threads <n>   Highest thread count (default: all)\n");
+  fprintf(stderr, "  --mixes <name,...>  Mixes to run (default: all)\n");
+  fprintf(stderr, "  --reps <n>          Timed repetitions per thread count (default: 7)\n");
+  fprintf(stderr, "  --warmup <n>        Warmup runs per thread count (default: 1)\n");
+  fprintf(stderr, "  --output <file>     Write JSON to file (default: stdout)\n");
+  fprintf(stderr, "  --list              List mixes and exit\n");
+}
+
+int main(int argc, char *argv[]) {
+  int max_threads = 1;
+#ifdef USE_OPENMP
+  max_threads = omp_get_max_threads();
+#endif
+  int reps = 7;
+  int warmup = 1;
+  const char *mixes_arg = NULL;
+  const char *output_path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (strcmp(arg, "--list") == 0) {
+      for (int m = 0; m < MIX_COUNT; m++) {
+        printf("%-13s %s\n", MIXES[m].name, MIXES[m].description);
+      }
+      return 0;
+    } else if (strcmp(arg, "--max-threads") == 0 && has_value) {
+      max_threads = atoi(argv[++i]);
+    } else if (strcmp(arg, "--mixes") == 0 && has_value) {
+      mixes_arg = argv[++i];
+    } else if (strcmp(arg, "--reps") == 0 && has_value) {
+      reps = atoi(argv[++i]);
+    } else if (strcmp(arg, "--warmup") == 0 && has_value) {
+      warmup = atoi(argv[++i]);
+    } else if (strcmp(arg, "--output") == 0 && has_value) {
+      output_path = argv[++i];
+    } else {
+      fprintf(stderr, "Error: Unknown or incomplete option: %s\n", arg);
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (max_threads <= 0 || max_threads > MAX_THREADS || reps <= 0 || warmup < 0) {
+    fprintf(stderr, "Error: Invalid --max-threads, --reps or --warmup value\n");
+    return 1;
+  }
+#ifndef USE_OPENMP
+  max_threads = 1;
+#endif
+
+  FILE *out = stdout;
+  if (output_path) {
+    out = fopen(output_path, "w");
+    if (!out) {
+      fprintf(stderr, "Error: Cannot open output file '%s'\n", output_path);
+      return 1;
+    }
+  }
+
+  fprintf(stderr, "bench_threads %s: 1..%d thread(s), %d reps + %d warmup\n", get_version(),
+          max_threads, reps, warmup);
+
+  fprintf(out, "{\n  \"version\": ");
+  bench_json_string(out, get_version());
+  fprintf(out, ",\n  \"max_threads\": %d,\n  \"warmup\": %d,\n  \"repetitions\": %d,\n",
+          max_threads, warmup, reps);
+  fprintf(out, "  \"min_work_units\": %d,\n  \"work_units_per_thread\": %d,\n",
+          REFINE_PARALLEL_MIN_WORK_UNITS, REFINE_WORK_UNITS_PER_THREAD);
+  fprintf(out, "  \"results\": [\n");
+
+  bool first = true;
+  for (int m = 0; m < MIX_COUNT; m++) {
+    if (mix_selected(mixes_arg, MIXES[m].name)) {
+      run_mix(out, &MIXES[m], max_threads, warmup, reps, first);
+      first = false;
+    }
+  }
+
+  fprintf(out, "\n  ]\n}\n");
+  if (out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,140 @@
+/**
+ * Common Benchmark Utilities
+ *
+ * Shared helpers for the bench_* executables:
+ * - Portable high-resolution wall clock
+ * - Deterministic PRNG for synthetic corpora
+ * - Sample statistics (median / p95) over repeated runs
+ * - Minimal JSON string escaping
+ */
+
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Portable High-Resolution Timing
+// ============================================================================
+
+#ifdef _WIN32
+#include <windows.h>
+
+static inline double bench_now_ms(void) {
+  static LARGE_INTEGER frequency = {0};
+  LARGE_INTEGER counter;
+  if (frequency.QuadPart == 0) {
+    QueryPerformanceFrequency(&frequency);
+  }
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart / (double)frequency.QuadPart * 1000.0;
+}
+
+#else
+#include <time.h>
+
+static inline double bench_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+#endif
+
+// ============================================================================
+// Deterministic PRNG (xorshift64*)
+// ============================================================================
+
+typedef struct {
+  uint64_t state;
+} BenchRng;
+
+static inline void bench_rng_seed(BenchRng *rng, uint64_t seed) {
+  rng->state = seed ? seed : 0x9e3779b97f4a7c15ull;
+}
+
+static inline uint64_t bench_rng_next(BenchRng *rng) {
+  uint64_t x = rng->state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  rng->state = x;
+  return x * 0x2545f4914f6cdd1dull;
+}
+
+/**
+ * Uniform integer in [0, bound) (bound must be > 0)
+ */
+static inline int bench_rng_below(BenchRng *rng, int bound) {
+  return (int)(bench_rng_next(rng) % (uint64_t)bound);
+}
+
+// ============================================================================
+// Sample Statistics
+// ============================================================================
+
+typedef struct {
+  double median_ms;
+  double p95_ms;
+  double min_ms;
+  double max_ms;
+} BenchStats;
+
+static inline int bench_compare_doubles(const void *a, const void *b) {
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+  return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+/**
+ * Nearest-rank percentile of sorted samples (count > 0, percent in 1..100)
+ */
+static inline double bench_percentile(const double *sorted, int count, int percent) {
+  long long rank = ((long long)count * percent + 99) / 100; // ceil(percent% * count)
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * Summarize samples (sorted in place). Percentiles use the nearest-rank method.
+ */
+static inline BenchStats bench_compute_stats(double *samples, int count) {
+  BenchStats stats = {0.0, 0.0, 0.0, 0.0};
+  if (count <= 0) {
+    return stats;
+  }
+  qsort(samples, (size_t)count, sizeof(double), bench_compare_doubles);
+
+  stats.median_ms = count % 2 ? samples[count / 2]
+                              : (samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+  stats.p95_ms = bench_percentile(samples, count, 95);
+  stats.min_ms = samples[0];
+  stats.max_ms = samples[count - 1];
+  return stats;
+}
+
+// ============================================================================
+// JSON Output
+// ============================================================================
+
+/**
+ * Print a JSON string literal (quotes included)
+ */
+static inline void bench_json_string(FILE *out, const char *s) {
+  fputc('"', out);
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') {
+      fputc('\\', out);
+      fputc(c, out);
+    } else if (c < 0x20) {
+      fprintf(out, "\\u%04x", c);
+    } else {
+      fputc(c, out);
+    }
+  }
+  fputc('"', out);
+}
+
+#endif // BENCH_UTILS_H
@@ -7,14 +7,18 @@
 // VSCode Reference:
 //   src/vs/editor/common/diff/defaultLinesDiffComputer/defaultLinesDiffComputer.ts
 //
-// VSCode Parity: 100% (excluding computeMoves)
+// VSCode Parity: 100% (moves are reported without refined inner changes)
 //
 // ============================================================================
 
 #include "default_lines_diff_computer.h"
 #include "line_level.h"
 #include "char_level.h"
+#include "moved_lines.h"
 #include "range_mapping.h"
+#include "refine_parallel.h"
+#include "repro.h"
+#include "trace.h"
 #include "utils.h"
 #include <stdlib.h>
 #include <string.h>
@@ -58,7 +62,7 @@ static RangeMappingArray* refine_diff(
  * VSCode Parity: 100%
  */
 static LinesDiff* create_empty_lines_diff(void) {
-    LinesDiff* result = (LinesDiff*)malloc(sizeof(LinesDiff));
+    LinesDiff* result = (LinesDiff*)diff_malloc(sizeof(LinesDiff));
     if (!result) return NULL;
     
     result->changes.mappings = NULL;
@@ -70,6 +74,8 @@ static LinesDiff* create_empty_lines_diff(void) {
     result->moves.capacity = 0;
     
     result->hit_timeout = false;
+    result->is_rewrite = false;
+    memset(&result->stats, 0, sizeof(DiffStats));
     
     return result;
 }
@@ -88,11 +94,11 @@ static LinesDiff* create_full_file_diff(
     const char** modified_lines,
     int modified_count
 ) {
-    LinesDiff* result = (LinesDiff*)malloc(sizeof(LinesDiff));
+    LinesDiff* result = (LinesDiff*)diff_malloc(sizeof(LinesDiff));
     if (!result) return NULL;
     
     // Allocate one DetailedLineRangeMapping
-    result->changes.mappings = (DetailedLineRangeMapping*)malloc(sizeof(DetailedLineRangeMapping));
+    result->changes.mappings = (DetailedLineRangeMapping*)diff_malloc(sizeof(DetailedLineRangeMapping));
     if (!result->changes.mappings) {
         free(result);
         return NULL;
@@ -107,7 +113,7 @@ static LinesDiff* create_full_file_diff(
     result->changes.mappings[0].modified.end_line = modified_count + 1;
     
     // Create one RangeMapping for the entire content
-    result->changes.mappings[0].inner_changes = (RangeMapping*)malloc(sizeof(RangeMapping));
+    result->changes.mappings[0].inner_changes = (RangeMapping*)diff_malloc(sizeof(RangeMapping));
     if (!result->changes.mappings[0].inner_changes) {
         free(result->changes.mappings);
         free(result);
@@ -143,6 +149,8 @@ static LinesDiff* create_full_file_diff(
     result->moves.capacity = 0;
     
     result->hit_timeout = false;
+    result->is_rewrite = false;
+    memset(&result->stats, 0, sizeof(DiffStats));
     
     return result;
 }
@@ -199,6 +207,7 @@ static RangeMappingArray* refine_diff(
     char_opts.consider_whitespace_changes = consider_whitespace_changes;
     char_opts.extend_to_subwords = options->extend_to_subwords;
     char_opts.timeout_ms = timeout->timeout_ms;
+    char_opts.fast = options->quality == DIFF_QUALITY_FAST;
     
     bool local_timeout = false;
     RangeMappingArray* result = refine_diff_char_level(
@@ -216,6 +225,29 @@ static RangeMappingArray* refine_diff(
     return result;
 }
 
+/**
+ * Append a mapping to an alignments array, growing it if needed.
+ * The mapping is dropped if the array cannot grow.
+ */
+static void append_range_mapping(RangeMappingArray* alignments, const RangeMapping* mapping) {
+    if (alignments->count >= alignments->capacity) {
+        int new_capacity = diff_grow_capacity(alignments->capacity, 8);
+        RangeMapping* new_mappings = new_capacity < 0 ? NULL : (RangeMapping*)diff_realloc_array(
+            alignments->mappings,
+            (size_t)new_capacity,
+            sizeof(RangeMapping)
+        );
+        if (new_mappings) {
+            alignments->mappings = new_mappings;
+            alignments->capacity = new_capacity;
+        }
+    }
+    
+    if (alignments->count < alignments->capacity) {
+        alignments->mappings[alignments->count++] = *mapping;
+    }
+}
+
 /**
  * Scan equal-length line regions for whitespace-only changes.
  * 
@@ -262,6 +294,16 @@ static void scan_for_whitespace_changes(
         int seq2_offset = seq2_last_start + i;
         
         if (strcmp(original_lines[seq1_offset], modified_lines[seq2_offset]) != 0) {
+            // Most reindents and trailing-whitespace edits map straight from the trim bounds
+            RangeMapping whitespace_mapping;
+            if (refine_whitespace_only_line(original_lines[seq1_offset],
+                                            modified_lines[seq2_offset],
+                                            seq1_offset + 1, seq2_offset + 1,
+                                            &whitespace_mapping)) {
+                append_range_mapping(alignments, &whitespace_mapping);
+                continue;
+            }
+
             // This is because of whitespace changes, diff these lines
             SequenceDiff line_diff = {
                 .seq1_start = seq1_offset,
@@ -284,22 +326,7 @@ static void scan_for_whitespace_changes(
             if (character_diffs) {
                 // Add all mappings to alignments array
                 for (int j = 0; j < character_diffs->count; j++) {
-                    // Grow alignments array if needed
-                    if (alignments->count >= alignments->capacity) {
-                        size_t new_capacity = (size_t)(alignments->capacity == 0 ? 8 : alignments->capacity * 2);
-                        RangeMapping* new_mappings = (RangeMapping*)realloc(
-                            alignments->mappings,
-                            new_capacity * sizeof(RangeMapping)
-                        );
-                        if (new_mappings) {
-                            alignments->mappings = new_mappings;
-                            alignments->capacity = (int)new_capacity;
-                        }
-                    }
-                    
-                    if (alignments->count < alignments->capacity) {
-                        alignments->mappings[alignments->count++] = character_diffs->mappings[j];
-                    }
+                    append_range_mapping(alignments, &character_diffs->mappings[j]);
                 }
                 
                 range_mapping_array_free(character_diffs);
@@ -312,106 +339,87 @@ static void scan_for_whitespace_changes(
     }
 }
 
-// ============================================================================
-// Main Function: compute_diff
-// ============================================================================
+/**
+ * Finalize DiffStats for a compute_diff() result (no-op if result is NULL).
+ */
+static LinesDiff* attach_stats(LinesDiff* result, DiffStats* stats,
+                               double call_start_ms, int64_t call_start_allocations) {
+    if (result) {
+        stats->total_ms = get_precise_time_ms() - call_start_ms;
+        stats->allocations = diff_allocation_count() - call_start_allocations;
+        result->stats = *stats;
+    }
+    return result;
+}
 
 /**
- * Compute diff between two files.
- * 
- * This is the main entry point, implementing VSCode's computeDiff() method
- * with 100% algorithmic parity.
- * 
- * @param original_lines Original file lines
- * @param original_count Number of lines in original
- * @param modified_lines Modified file lines
- * @param modified_count Number of lines in modified
- * @param options Diff computation options
- * @return LinesDiff structure containing changes and metadata
- * 
- * VSCode Reference: defaultLinesDiffComputer.ts computeDiff() lines 31-174
- * VSCode Parity: 100% (excluding computeMoves)
- * 
- * Notable differences from VSCode:
- * - No computeMoves implementation (Neovim UI limitation)
- * - No assertion validation (can be added later if needed)
+ * Steps 4-5 of compute_diff(): whitespace scan and character refinement of
+ * every line region, conversion to line mappings and (optionally) moves.
+ *
+ * @param line_alignments Line-level regions (sorted; not modified or freed)
+ * @param timeout Deadline shared with the line-level stage
+ * @param hit_timeout Whether an earlier stage already timed out
+ * @param stats Per-stage timings and counters (NULL = not collected)
+ * @return LinesDiff with zeroed stats, or NULL on allocation failure
  */
-LinesDiff* compute_diff(
+static LinesDiff* refine_line_regions(
+    const SequenceDiffArray* line_alignments,
     const char** original_lines,
     int original_count,
     const char** modified_lines,
     int modified_count,
-    const DiffOptions* options
+    const DiffOptions* options,
+    Timeout* timeout,
+    bool hit_timeout,
+    DiffStats* stats
 ) {
-    // Early exit: 0-1 lines and equal
-    if (original_count <= 1 && arrays_equal(original_lines, original_count, 
-                                            modified_lines, modified_count)) {
-        return create_empty_lines_diff();
-    }
-    
-    // Early exit: single empty line
-    if ((original_count == 1 && strlen(original_lines[0]) == 0) ||
-        (modified_count == 1 && strlen(modified_lines[0]) == 0)) {
-        return create_full_file_diff(original_lines, original_count,
-                                     modified_lines, modified_count);
-    }
-    
-    // Setup timeout
-    Timeout timeout;
-    timeout.timeout_ms = options->max_computation_time_ms;
-    timeout.start_time_ms = get_current_time_ms();
-    
+    const bool collect = stats != NULL;
     bool consider_whitespace_changes = !options->ignore_trim_whitespace;
     
-    // Line-level diff
-    // Use our compute_line_alignments which internally selects DP (<1700 lines) or Myers
-    // VSCode Reference: defaultLinesDiffComputer.ts lines 66-77
-    bool line_hit_timeout = false;
-    SequenceDiffArray* line_alignments = compute_line_alignments(
-        original_lines, original_count,
-        modified_lines, modified_count,
-        timeout.timeout_ms,
-        &line_hit_timeout
-    );
-    bool hit_timeout = line_hit_timeout;
-    
-    if (!line_alignments) {
-        return NULL;
-    }
-    
-    // Optimize line diffs (already done inside compute_line_diff)
-    // No need to call optimize_sequence_diffs or remove_very_short_matching_lines_between_diffs
-    
     // Initialize character mappings array
-    RangeMappingArray* alignments = (RangeMappingArray*)malloc(sizeof(RangeMappingArray));
+    RangeMappingArray* alignments = (RangeMappingArray*)diff_malloc(sizeof(RangeMappingArray));
     if (!alignments) {
-        sequence_diff_array_free(line_alignments);
         return NULL;
     }
     alignments->mappings = NULL;
     alignments->count = 0;
     alignments->capacity = 0;
     
-#ifdef USE_OPENMP
-    // Parallel character refinement (OpenMP)
-    // Set default thread count if not explicitly configured by user
-    if (getenv("OMP_NUM_THREADS") == NULL) {
-        int num_procs = omp_get_num_procs();
-        omp_set_num_threads(num_procs > 4 ? 4 : num_procs);
+    // Per-stage refinement totals (summed over regions, reduced across threads)
+    DIFF_TRACE_BEGIN("refine");
+    double refine_start_ms = collect ? get_precise_time_ms() : 0.0;
+    double ws_scan_ms = 0.0;
+    double char_refine_ms = 0.0;
+    int ws_scan_timeouts = 0;
+    int char_refine_timeouts = 0;
+    if (collect) {
+        stats->refined_regions = line_alignments->count;
+        for (int i = 0; i < line_alignments->count; i++) {
+            const SequenceDiff* d = &line_alignments->diffs[i];
+            int region_lines = (d->seq1_end - d->seq1_start) + (d->seq2_end - d->seq2_start);
+            if (region_lines > stats->largest_region_lines) {
+                stats->largest_region_lines = region_lines;
+            }
+        }
     }
     
-    // Only parallelize if we have enough diffs to justify thread overhead
-    const int MIN_DIFFS_FOR_PARALLEL = 1;
-    int use_parallel = line_alignments->count >= MIN_DIFFS_FOR_PARALLEL;
+#ifdef USE_OPENMP
+    // Parallel character refinement (OpenMP), sized by the estimated work
+    // (see refine_parallel.h); omp_get_max_threads() honors OMP_NUM_THREADS
+    int num_workers = line_alignments->count > 1
+        ? refine_worker_count(refine_work_units(line_alignments, original_lines, modified_lines),
+                              line_alignments->count, omp_get_max_threads())
+        : 1;
+    int use_parallel = num_workers > 1;
     
     if (use_parallel) {
         // Pre-allocate thread-local result arrays
         int num_diffs = line_alignments->count;
-        RangeMappingArray** thread_results = (RangeMappingArray**)calloc((size_t)num_diffs, sizeof(RangeMappingArray*));
-        int* thread_equal_lines = (int*)calloc((size_t)num_diffs, sizeof(int));
-        int* thread_seq1_starts = (int*)calloc((size_t)num_diffs, sizeof(int));
-        int* thread_seq2_starts = (int*)calloc((size_t)num_diffs, sizeof(int));
-        int* thread_timeouts = (int*)calloc((size_t)num_diffs, sizeof(int));
+        RangeMappingArray** thread_results = (RangeMappingArray**)diff_calloc((size_t)num_diffs, sizeof(RangeMappingArray*));
+        int* thread_equal_lines = (int*)diff_calloc((size_t)num_diffs, sizeof(int));
+        int* thread_seq1_starts = (int*)diff_calloc((size_t)num_diffs, sizeof(int));
+        int* thread_seq2_starts = (int*)diff_calloc((size_t)num_diffs, sizeof(int));
+        int* thread_timeouts = (int*)diff_calloc((size_t)num_diffs, sizeof(int));
         
         if (!thread_results || !thread_equal_lines || !thread_seq1_starts || 
             !thread_seq2_starts || !thread_timeouts) {
@@ -441,16 +449,25 @@ LinesDiff* compute_diff(
             #pragma warning(disable: 4101) // unreferenced local variable (false positive with OpenMP)
 #endif
             int diff_idx;
-            #pragma omp parallel for schedule(dynamic, 1) shared(thread_results, thread_timeouts) private(diff_idx)
+            int64_t worker_allocations = 0;
+            #pragma omp parallel for num_threads(num_workers) schedule(dynamic, 1) \
+                shared(thread_results, thread_timeouts) private(diff_idx) \
+                reduction(+: ws_scan_ms, char_refine_ms, ws_scan_timeouts, char_refine_timeouts, \
+                          worker_allocations)
             for (diff_idx = 0; diff_idx < num_diffs; diff_idx++) {
                 const SequenceDiff* diff = &line_alignments->diffs[diff_idx];
+                int64_t allocations_before = diff_allocation_count();
                 
                 // Thread-local timeout flags
                 bool ws_timeout = false;
                 bool char_timeout = false;
+                double stage_start_ms = collect ? get_precise_time_ms() : 0.0;
+                int region_lines = (diff->seq1_end - diff->seq1_start) +
+                                   (diff->seq2_end - diff->seq2_start);
+                DIFF_TRACE_BEGIN_REGION("whitespace_scan", diff_idx, thread_equal_lines[diff_idx]);
                 
                 // Thread-local whitespace change scanning
-                RangeMappingArray* ws_changes = (RangeMappingArray*)malloc(sizeof(RangeMappingArray));
+                RangeMappingArray* ws_changes = (RangeMappingArray*)diff_malloc(sizeof(RangeMappingArray));
                 ws_changes->mappings = NULL;
                 ws_changes->count = 0;
                 ws_changes->capacity = 0;
@@ -462,22 +479,37 @@ LinesDiff* compute_diff(
                     original_lines, original_count,
                     modified_lines, modified_count,
                     consider_whitespace_changes,
-                    &timeout,
+                    timeout,
                     options,
                     ws_changes,
                     &ws_timeout
                 );
+                DIFF_TRACE_END_REGION("whitespace_scan", diff_idx);
+                
+                if (collect) {
+                    double now_ms = get_precise_time_ms();
+                    ws_scan_ms += now_ms - stage_start_ms;
+                    stage_start_ms = now_ms;
+                }
                 
                 // Thread-local character diff refinement
+                DIFF_TRACE_BEGIN_REGION("refine_diff_char_level", diff_idx, region_lines);
                 RangeMappingArray* character_diffs = refine_diff(
                     diff,
                     original_lines, original_count,
                     modified_lines, modified_count,
-                    &timeout,
+                    timeout,
                     consider_whitespace_changes,
                     options,
                     &char_timeout
                 );
+                DIFF_TRACE_END_REGION("refine_diff_char_level", diff_idx);
+                
+                if (collect) {
+                    char_refine_ms += get_precise_time_ms() - stage_start_ms;
+                }
+                ws_scan_timeouts += ws_timeout ? 1 : 0;
+                char_refine_timeouts += char_timeout ? 1 : 0;
                 
                 // Store timeout flags - no race condition since each thread writes to its own index
                 if (ws_timeout || char_timeout) {
@@ -489,8 +521,8 @@ LinesDiff* compute_diff(
                                  (character_diffs ? character_diffs->count : 0);
                 
                 if (total_count > 0) {
-                    RangeMappingArray* combined = (RangeMappingArray*)malloc(sizeof(RangeMappingArray));
-                    combined->mappings = (RangeMapping*)malloc((size_t)total_count * sizeof(RangeMapping));
+                    RangeMappingArray* combined = (RangeMappingArray*)diff_malloc(sizeof(RangeMappingArray));
+                    combined->mappings = (RangeMapping*)diff_malloc((size_t)total_count * sizeof(RangeMapping));
                     combined->count = 0;
                     combined->capacity = total_count;
                     
@@ -511,10 +543,12 @@ LinesDiff* compute_diff(
                 
                 if (ws_changes) range_mapping_array_free(ws_changes);
                 if (character_diffs) range_mapping_array_free(character_diffs);
+                worker_allocations += diff_worker_allocations(allocations_before);
             }
 #ifdef _MSC_VER
             #pragma warning(pop)
 #endif
+            diff_credit_allocations(worker_allocations);
             
             // Check timeout flags
             for (int i = 0; i < num_diffs; i++) {
@@ -533,7 +567,7 @@ LinesDiff* compute_diff(
             }
             
             if (total_size > 0) {
-                alignments->mappings = (RangeMapping*)malloc((size_t)total_size * sizeof(RangeMapping));
+                alignments->mappings = (RangeMapping*)diff_malloc((size_t)total_size * sizeof(RangeMapping));
                 if (alignments->mappings) {
                     alignments->capacity = total_size;
                     int offset = 0;
@@ -576,8 +610,13 @@ LinesDiff* compute_diff(
             const SequenceDiff* diff = &line_alignments->diffs[diff_idx];
             
             int equal_lines_count = diff->seq1_start - seq1_last_start;
+            int region_lines = (diff->seq1_end - diff->seq1_start) +
+                               (diff->seq2_end - diff->seq2_start);
+            double stage_start_ms = collect ? get_precise_time_ms() : 0.0;
+            DIFF_TRACE_BEGIN_REGION("whitespace_scan", diff_idx, equal_lines_count);
             
             // Scan equal lines for whitespace changes
+            bool ws_timeout = false;
             scan_for_whitespace_changes(
                 equal_lines_count,
                 seq1_last_start,
@@ -585,49 +624,52 @@ LinesDiff* compute_diff(
                 original_lines, original_count,
                 modified_lines, modified_count,
                 consider_whitespace_changes,
-                &timeout,
+                timeout,
                 options,
                 alignments,
-                &hit_timeout
+                &ws_timeout
             );
+            DIFF_TRACE_END_REGION("whitespace_scan", diff_idx);
+            
+            if (ws_timeout) {
+                hit_timeout = true;
+                ws_scan_timeouts++;
+            }
+            if (collect) {
+                double now_ms = get_precise_time_ms();
+                ws_scan_ms += now_ms - stage_start_ms;
+                stage_start_ms = now_ms;
+            }
             
             seq1_last_start = diff->seq1_end;
             seq2_last_start = diff->seq2_end;
             
             // Refine this diff region
             bool local_timeout = false;
+            DIFF_TRACE_BEGIN_REGION("refine_diff_char_level", diff_idx, region_lines);
             RangeMappingArray* character_diffs = refine_diff(
                 diff,
                 original_lines, original_count,
                 modified_lines, modified_count,
-                &timeout,
+                timeout,
                 consider_whitespace_changes,
                 options,
                 &local_timeout
             );
+            DIFF_TRACE_END_REGION("refine_diff_char_level", diff_idx);
             
             if (local_timeout) {
                 hit_timeout = true;
+                char_refine_timeouts++;
+            }
+            if (collect) {
+                char_refine_ms += get_precise_time_ms() - stage_start_ms;
             }
             
             if (character_diffs) {
                 // Add all character mappings
                 for (int j = 0; j < character_diffs->count; j++) {
-                    if (alignments->count >= alignments->capacity) {
-                        size_t new_capacity = (size_t)(alignments->capacity == 0 ? 16 : alignments->capacity * 2);
-                        RangeMapping* new_mappings = (RangeMapping*)realloc(
-                            alignments->mappings,
-                            new_capacity * sizeof(RangeMapping)
-                        );
-                        if (new_mappings) {
-                            alignments->mappings = new_mappings;
-                            alignments->capacity = (int)new_capacity;
-                        }
-                    }
-                    
-                    if (alignments->count < alignments->capacity) {
-                        alignments->mappings[alignments->count++] = character_diffs->mappings[j];
-                    }
+                    append_range_mapping(alignments, &character_diffs->mappings[j]);
                 }
                 
                 range_mapping_array_free(character_diffs);
@@ -644,6 +686,9 @@ LinesDiff* compute_diff(
     }
     
     int remaining = original_count - seq1_final;
+    double tail_start_ms = collect ? get_precise_time_ms() : 0.0;
+    bool tail_timeout = false;
+    DIFF_TRACE_BEGIN_REGION("whitespace_scan", line_alignments->count, remaining);
     scan_for_whitespace_changes(
         remaining,
         seq1_final,
@@ -651,13 +696,29 @@ LinesDiff* compute_diff(
         original_lines, original_count,
         modified_lines, modified_count,
         consider_whitespace_changes,
-        &timeout,
+        timeout,
         options,
         alignments,
-        &hit_timeout
+        &tail_timeout
     );
+    DIFF_TRACE_END_REGION("whitespace_scan", line_alignments->count);
+    if (tail_timeout) {
+        hit_timeout = true;
+        ws_scan_timeouts++;
+    }
+    
+    if (collect) {
+        double now_ms = get_precise_time_ms();
+        stats->whitespace_scan_ms = ws_scan_ms + (now_ms - tail_start_ms);
+        stats->char_refine_ms = char_refine_ms;
+        stats->refine_ms = now_ms - refine_start_ms;
+        stats->whitespace_scan_timeouts = ws_scan_timeouts;
+        stats->char_refine_timeouts = char_refine_timeouts;
+    }
+    DIFF_TRACE_END("refine");
     
     // Convert to line mappings
+    DIFF_TRACE_BEGIN("conversion");
     DetailedLineRangeMappingArray* changes = line_range_mapping_from_range_mappings(
         alignments,
         original_lines, original_count,
@@ -666,26 +727,40 @@ LinesDiff* compute_diff(
     );
     
     // VSCode: if (options.computeMoves) { moves = this.computeMoves(...); }
-    //
-    // SKIPPED: computeMoves is not implemented
-    //
-    // Reason: Neovim does not support moved block visualization in UI.
-    // The computeMoves algorithm exists in VSCode at:
-    //   src/vs/editor/common/diff/defaultLinesDiffComputer/computeMovedLines.ts
-    //
-    // When UI support is added, implement:
-    // 1. Port computeMovedLines() function
-    // 2. Port refineDiff for moved blocks
-    // 3. Populate moves array instead of leaving it empty
-    //
-    // For now, always return empty moves array.
+    // Bounded by the same deadline as the rest of the computation
+    DIFF_TRACE_END("conversion");
+    double conversion_end_ms = 0.0;
+    if (collect) {
+        conversion_end_ms = get_precise_time_ms();
+        stats->conversion_ms = conversion_end_ms - (refine_start_ms + stats->refine_ms);
+    }
+    MovedTextArray* moves = NULL;
+    if (options->compute_moves && changes && changes->count > 0) {
+        bool moves_timeout = false;
+        DIFF_TRACE_BEGIN("moves");
+        moves = compute_moved_lines(
+            changes,
+            original_lines, original_count,
+            modified_lines, modified_count,
+            timeout,
+            &moves_timeout
+        );
+        DIFF_TRACE_END("moves");
+        if (moves_timeout) {
+            hit_timeout = true;
+        }
+        if (collect) {
+            stats->moves_timeouts = moves_timeout ? 1 : 0;
+            stats->moves_ms = get_precise_time_ms() - conversion_end_ms;
+        }
+    }
     
     // Create LinesDiff result
-    LinesDiff* result = (LinesDiff*)malloc(sizeof(LinesDiff));
+    LinesDiff* result = (LinesDiff*)diff_malloc(sizeof(LinesDiff));
     if (!result) {
         free_detailed_line_range_mapping_array(changes);
+        moved_text_array_free(moves);
         range_mapping_array_free(alignments);
-        sequence_diff_array_free(line_alignments);
         return NULL;
     }
     
@@ -699,17 +774,466 @@ LinesDiff* compute_diff(
         result->changes.capacity = 0;
     }
     
-    // No moves
-    result->moves.moves = NULL;
-    result->moves.count = 0;
-    result->moves.capacity = 0;
+    // Transfer moves
+    if (moves) {
+        result->moves = *moves;
+        free(moves);  // Free the container, not the contents
+    } else {
+        result->moves.moves = NULL;
+        result->moves.count = 0;
+        result->moves.capacity = 0;
+    }
     
     result->hit_timeout = hit_timeout;
+    result->is_rewrite = false;
+    memset(&result->stats, 0, sizeof(DiffStats));
     
     // Cleanup
     range_mapping_array_free(alignments);
+    
+    return result;
+}
+
+// ============================================================================
+// Main Function: compute_diff
+// ============================================================================
+
+/**
+ * Compute diff between two files.
+ * 
+ * This is the main entry point, implementing VSCode's computeDiff() method
+ * with 100% algorithmic parity.
+ * 
+ * @param original_lines Original file lines
+ * @param original_count Number of lines in original
+ * @param modified_lines Modified file lines
+ * @param modified_count Number of lines in modified
+ * @param options Diff computation options
+ * @return LinesDiff structure containing changes and metadata
+ * 
+ * VSCode Reference: defaultLinesDiffComputer.ts computeDiff() lines 31-174
+ * VSCode Parity: 100% (moves are reported without refined inner changes)
+ * 
+ * Notable differences from VSCode:
+ * - MovedText has no inner changes (VSCode refines each move with refineDiff)
+ * - No assertion validation (can be added later if needed)
+ */
+static LinesDiff* compute_diff_pipeline(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options
+) {
+    // Instrumentation (DiffStats): all timing is skipped unless requested
+    const bool collect = options->collect_stats;
+    DiffStats stats;
+    memset(&stats, 0, sizeof(stats));
+    double call_start_ms = collect ? get_precise_time_ms() : 0.0;
+    int64_t call_start_allocations = collect ? diff_allocation_count() : 0;
+    
+    // Early exit: 0-1 lines and equal
+    if (original_count <= 1 && arrays_equal(original_lines, original_count, 
+                                            modified_lines, modified_count)) {
+        LinesDiff* empty = create_empty_lines_diff();
+        return collect ? attach_stats(empty, &stats, call_start_ms, call_start_allocations) : empty;
+    }
+    
+    // Early exit: single empty line
+    if ((original_count == 1 && strlen(original_lines[0]) == 0) ||
+        (modified_count == 1 && strlen(modified_lines[0]) == 0)) {
+        LinesDiff* full = create_full_file_diff(original_lines, original_count,
+                                                modified_lines, modified_count);
+        return collect ? attach_stats(full, &stats, call_start_ms, call_start_allocations) : full;
+    }
+    
+    // Setup timeout
+    Timeout timeout;
+    timeout.timeout_ms = options->max_computation_time_ms;
+    timeout.start_time_ms = get_current_time_ms();
+    
+    // Line-level diff
+    // Use our compute_line_alignments which internally selects DP (<1700 lines) or Myers
+    // VSCode Reference: defaultLinesDiffComputer.ts lines 66-77
+    bool line_hit_timeout = false;
+    bool is_rewrite = false;
+    SequenceDiffArray* line_alignments = compute_line_alignments(
+        original_lines, original_count,
+        modified_lines, modified_count,
+        timeout.timeout_ms,
+        options->rewrite_threshold,
+        (DiffQuality)options->quality,
+        &line_hit_timeout,
+        &is_rewrite,
+        collect ? &stats : NULL
+    );
+    bool hit_timeout = line_hit_timeout;
+    stats.line_alignment_timeouts = line_hit_timeout ? 1 : 0;
+    
+    if (!line_alignments) {
+        return NULL;
+    }
+    
+    // Rewrite: one whole-file change, no character refinement (nothing useful to align)
+    if (is_rewrite) {
+        sequence_diff_array_free(line_alignments);
+        LinesDiff* rewrite = create_full_file_diff(original_lines, original_count,
+                                                   modified_lines, modified_count);
+        if (rewrite) {
+            rewrite->is_rewrite = true;
+        }
+        return collect ? attach_stats(rewrite, &stats, call_start_ms, call_start_allocations)
+                       : rewrite;
+    }
+    
+    // Optimize line diffs (already done inside compute_line_diff)
+    // No need to call optimize_sequence_diffs or remove_very_short_matching_lines_between_diffs
+    LinesDiff* result = refine_line_regions(
+        line_alignments,
+        original_lines, original_count,
+        modified_lines, modified_count,
+        options,
+        &timeout,
+        hit_timeout,
+        collect ? &stats : NULL
+    );
     sequence_diff_array_free(line_alignments);
     
+    return collect ? attach_stats(result, &stats, call_start_ms, call_start_allocations) : result;
+}
+
+/**
+ * Public entry point: compute_diff_pipeline() bracketed by a trace event
+ * (see trace.h; VSCODE_DIFF_TRACE enables tracing on the first call) and,
+ * while reproducer capture is on, timed so slow calls are saved (see repro.h).
+ */
+LinesDiff* compute_diff(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options
+) {
+    diff_trace_init_from_env();
+    diff_repro_init_from_env();
+    DIFF_TRACE_BEGIN("compute_diff");
+    LinesDiff* result;
+    if (diff_repro_active && options) {
+        // Stats are always collected so the reproducer records the stage breakdown
+        DiffOptions capture_options = *options;
+        capture_options.collect_stats = true;
+        double start_ms = get_precise_time_ms();
+        result = compute_diff_pipeline(original_lines, original_count,
+                                       modified_lines, modified_count, &capture_options);
+        diff_repro_maybe_capture(original_lines, original_count, modified_lines, modified_count,
+                                 options, result, get_precise_time_ms() - start_ms);
+        if (result && !options->collect_stats) {
+            memset(&result->stats, 0, sizeof(DiffStats));
+        }
+    } else {
+        result = compute_diff_pipeline(original_lines, original_count,
+                                       modified_lines, modified_count, options);
+    }
+    DIFF_TRACE_END("compute_diff");
+    return result;
+}
+
+// ============================================================================
+// Staged API: refine_line_alignments
+// ============================================================================
+
+/**
+ * Check caller-provided line regions: in bounds, non-empty, sorted, and
+ * separated by equal-length gaps on both sides (the lines between regions are
+ * paired one-to-one, like the unchanged lines of a Myers result).
+ */
+static bool line_alignments_valid(const SequenceDiff* alignments, int alignment_count,
+                                  int original_count, int modified_count) {
+    int seq1_last_end = 0;
+    int seq2_last_end = 0;
+    for (int i = 0; i < alignment_count; i++) {
+        const SequenceDiff* diff = &alignments[i];
+        if (diff->seq1_start < seq1_last_end || diff->seq2_start < seq2_last_end ||
+            diff->seq1_end < diff->seq1_start || diff->seq2_end < diff->seq2_start ||
+            diff->seq1_end > original_count || diff->seq2_end > modified_count) {
+            return false;
+        }
+        if (diff->seq1_start == diff->seq1_end && diff->seq2_start == diff->seq2_end) {
+            return false;
+        }
+        if (diff->seq1_start - seq1_last_end != diff->seq2_start - seq2_last_end) {
+            return false;
+        }
+        seq1_last_end = diff->seq1_end;
+        seq2_last_end = diff->seq2_end;
+    }
+    return original_count - seq1_last_end == modified_count - seq2_last_end;
+}
+
+LinesDiff* refine_line_alignments(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const SequenceDiff* alignments,
+    int alignment_count,
+    const DiffOptions* options
+) {
+    if (!options || original_count < 0 || modified_count < 0 || alignment_count < 0 ||
+        (original_count > 0 && !original_lines) || (modified_count > 0 && !modified_lines) ||
+        (alignment_count > 0 && !alignments) ||
+        !line_alignments_valid(alignments, alignment_count, original_count, modified_count)) {
+        return NULL;
+    }
+    
+    diff_trace_init_from_env();
+    DIFF_TRACE_BEGIN("refine_line_alignments");
+    const bool collect = options->collect_stats;
+    DiffStats stats;
+    memset(&stats, 0, sizeof(stats));
+    double call_start_ms = collect ? get_precise_time_ms() : 0.0;
+    int64_t call_start_allocations = collect ? diff_allocation_count() : 0;
+    
+    Timeout timeout;
+    timeout.timeout_ms = options->max_computation_time_ms;
+    timeout.start_time_ms = get_current_time_ms();
+    
+    // Borrowed view of the caller's array (refine_line_regions() does not modify it)
+    SequenceDiffArray line_alignments;
+    line_alignments.diffs = (SequenceDiff*)alignments;
+    line_alignments.count = alignment_count;
+    line_alignments.capacity = alignment_count;
+    
+    LinesDiff* result = refine_line_regions(
+        &line_alignments,
+        original_lines, original_count,
+        modified_lines, modified_count,
+        options,
+        &timeout,
+        false,
+        collect ? &stats : NULL
+    );
+    DIFF_TRACE_END("refine_line_alignments");
+    
+    return collect ? attach_stats(result, &stats, call_start_ms, call_start_allocations) : result;
+}
+
+// ============================================================================
+// Counting-Only Mode: compute_diff_stats
+// ============================================================================
+
+/**
+ * Add one line-level region to the running counts.
+ */
+static void add_region_to_stats(int original_length, int modified_length, DiffLineStats* stats) {
+    int paired = original_length < modified_length ? original_length : modified_length;
+    stats->modified_lines += paired;
+    stats->deleted_lines += original_length - paired;
+    stats->inserted_lines += modified_length - paired;
+}
+
+/**
+ * Count equal-trimmed lines that still differ in whitespace.
+ *
+ * Counting equivalent of scan_for_whitespace_changes(): a strcmp per line
+ * instead of a full character refinement.
+ */
+static void count_whitespace_only_lines(
+    int equal_lines_count,
+    int seq1_last_start,
+    int seq2_last_start,
+    const char** original_lines,
+    const char** modified_lines,
+    DiffLineStats* stats
+) {
+    for (int i = 0; i < equal_lines_count; i++) {
+        if (strcmp(original_lines[seq1_last_start + i], modified_lines[seq2_last_start + i]) != 0) {
+            stats->modified_lines++;
+        }
+    }
+}
+
+/**
+ * Compute inserted/deleted/modified line counts.
+ *
+ * Shares the early exits and line alignment of compute_diff(), then walks
+ * the alignments instead of refining them.
+ */
+bool compute_diff_stats(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options,
+    DiffLineStats* out_stats
+) {
+    if (!original_lines || !modified_lines || !options || !out_stats) {
+        return false;
+    }
+
+    memset(out_stats, 0, sizeof(DiffLineStats));
+
+    // Early exit: 0-1 lines and equal (same as compute_diff)
+    if (original_count <= 1 && arrays_equal(original_lines, original_count,
+                                            modified_lines, modified_count)) {
+        return true;
+    }
+
+    // Early exit: single empty line -> full file diff (same as compute_diff)
+    if ((original_count == 1 && strlen(original_lines[0]) == 0) ||
+        (modified_count == 1 && strlen(modified_lines[0]) == 0)) {
+        add_region_to_stats(original_count, modified_count, out_stats);
+        return true;
+    }
+
+    bool hit_timeout = false;
+    SequenceDiffArray* line_alignments = compute_line_alignments(
+        original_lines, original_count,
+        modified_lines, modified_count,
+        options->max_computation_time_ms,
+        options->rewrite_threshold,
+        (DiffQuality)options->quality,
+        &hit_timeout,
+        NULL,
+        NULL
+    );
+
+    if (!line_alignments) {
+        return false;
+    }
+
+    bool consider_whitespace_changes = !options->ignore_trim_whitespace;
+    int seq1_last_start = 0;
+    int seq2_last_start = 0;
+
+    for (int i = 0; i < line_alignments->count; i++) {
+        const SequenceDiff* diff = &line_alignments->diffs[i];
+
+        if (consider_whitespace_changes) {
+            count_whitespace_only_lines(diff->seq1_start - seq1_last_start,
+                                        seq1_last_start, seq2_last_start,
+                                        original_lines, modified_lines, out_stats);
+        }
+
+        add_region_to_stats(diff->seq1_end - diff->seq1_start,
+                            diff->seq2_end - diff->seq2_start, out_stats);
+
+        seq1_last_start = diff->seq1_end;
+        seq2_last_start = diff->seq2_end;
+    }
+
+    if (consider_whitespace_changes) {
+        count_whitespace_only_lines(original_count - seq1_last_start,
+                                    seq1_last_start, seq2_last_start,
+                                    original_lines, modified_lines, out_stats);
+    }
+
+    out_stats->hit_timeout = hit_timeout;
+
+    sequence_diff_array_free(line_alignments);
+    return true;
+}
+
+// ============================================================================
+// Buffer Input: compute_diff_buffers
+// ============================================================================
+
+/**
+ * Split a text buffer into NUL-terminated lines.
+ *
+ * Makes a single copy of the buffer and terminates lines in place, so every
+ * line pointer points into one allocation (no per-line malloc/copy).
+ * A trailing '\n' terminates the last line instead of starting an empty one.
+ *
+ * @param text Buffer (need not be NUL-terminated)
+ * @param length Buffer length in bytes
+ * @param out_storage Output: backing copy (caller frees)
+ * @param out_count Output: number of lines
+ * @return Line pointer array (caller frees), or NULL on allocation failure or
+ *         more than DIFF_MAX_ELEMENTS lines
+ */
+static const char** split_buffer_lines(const char* text, size_t length,
+                                       char** out_storage, int* out_count) {
+    size_t count = (length > 0 && text[length - 1] != '\n') ? 1 : 0;
+    for (const char* p = text; length > 0 && (p = memchr(p, '\n', length - (size_t)(p - text)));
+         p++) {
+        count++;
+    }
+    if (count > (size_t)DIFF_MAX_ELEMENTS || length == SIZE_MAX) {
+        return NULL;
+    }
+
+    char* storage = (char*)diff_malloc(length + 1);
+    if (!storage) {
+        return NULL;
+    }
+    if (length > 0) {
+        memcpy(storage, text, length);
+    }
+    storage[length] = '\0';
+
+    const char** lines = (const char**)diff_malloc_array(count > 0 ? count : 1, sizeof(char*));
+    if (!lines) {
+        free(storage);
+        return NULL;
+    }
+
+    int line = 0;
+    size_t line_start = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (storage[i] == '\n') {
+            storage[i] = '\0';
+            lines[line++] = storage + line_start;
+            line_start = i + 1;
+        }
+    }
+    if (line_start < length) {
+        lines[line++] = storage + line_start;
+    }
+
+    *out_storage = storage;
+    *out_count = (int)count;
+    return lines;
+}
+
+/**
+ * Compute diff between two text buffers.
+ *
+ * Splits both buffers with split_buffer_lines() and runs compute_diff().
+ * The result only holds ranges, so the split copies are freed before return.
+ */
+LinesDiff* compute_diff_buffers(
+    const char* original_text,
+    size_t original_length,
+    const char* modified_text,
+    size_t modified_length,
+    const DiffOptions* options
+) {
+    if ((!original_text && original_length > 0) || (!modified_text && modified_length > 0) ||
+        !options) {
+        return NULL;
+    }
+
+    char* original_storage = NULL;
+    char* modified_storage = NULL;
+    int original_count = 0;
+    int modified_count = 0;
+
+    const char** original_lines = split_buffer_lines(original_text, original_length,
+                                                     &original_storage, &original_count);
+    const char** modified_lines = split_buffer_lines(modified_text, modified_length,
+                                                     &modified_storage, &modified_count);
+
+    LinesDiff* result = NULL;
+    if (original_lines && modified_lines) {
+        result = compute_diff(original_lines, original_count,
+                              modified_lines, modified_count, options);
+    }
+
+    free(original_lines);
+    free(original_storage);
+    free(modified_lines);
+    free(modified_storage);
     return result;
 }
 
@@ -745,3 +1269,7 @@ void free_lines_diff(LinesDiff* diff) {
 const char* get_version(void) {
     return VSCODE_DIFF_VERSION;
 }
+
+int get_api_version(void) {
+    return VSCODE_DIFF_API_VERSION;
+}
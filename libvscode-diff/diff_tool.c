@@ -3,9 +3,17 @@
 // ============================================================================
 //
 // Usage: diff_tool [-t] <original_file> <modified_file>
+//        diff_tool --replay <dir>
+//        diff_tool --shm <path> [--shm-offset <n>] <original_file> <modified_file>
 //
 // Options:
 //   -t    Show timing information for compute_diff
+//   -s    Show per-stage instrumentation (DiffStats)
+//   --trace <file>  Write a Chrome trace-event timeline (chrome://tracing, Perfetto)
+//   --replay <dir>  Re-run captured slow-diff reproducers (see repro.h) with timing
+//   --shm <path>    Write the result into a shared-memory file in the flat layout
+//                   (see flat_result.h) and print only "<offset> <length>"
+//   --shm-fd <n>    Same, into an inherited descriptor (e.g. a memfd)
 //
 // This tool:
 // 1. Reads two files from disk
@@ -15,8 +23,14 @@
 // ============================================================================
 
 #include "default_lines_diff_computer.h"
+#include "flat_result.h"
 #include "print_utils.h"
+#include "repro.h"
+#include "trace.h"
 #include "types.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -46,8 +60,17 @@ static double portable_time_diff_ms(portable_time_t* start, portable_time_t* end
     return (double)(end->counter.QuadPart - start->counter.QuadPart) / frequency.QuadPart * 1000.0;
 }
 
+#define portable_fseek(file, offset, whence) _fseeki64(file, offset, whence)
+#define portable_ftell(file) ((int64_t)_ftelli64(file))
+
 #else
 // POSIX (Linux, macOS)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 typedef struct timespec portable_time_t;
 
 static void portable_gettime(portable_time_t* t) {
@@ -58,6 +81,10 @@ static double portable_time_diff_ms(portable_time_t* start, portable_time_t* end
     return (end->tv_sec - start->tv_sec) * 1000.0 + 
            (end->tv_nsec - start->tv_nsec) / 1000000.0;
 }
+
+// off_t is 64-bit on 64-bit POSIX targets
+#define portable_fseek(file, offset, whence) fseeko(file, (off_t)(offset), whence)
+#define portable_ftell(file) ((int64_t)ftello(file))
 #endif
 
 // ============================================================================
@@ -80,30 +107,41 @@ static int read_file_lines(const char* filename, char*** lines_out) {
         return -1;
     }
     
-    // Read entire file content
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    // Read entire file content (64-bit offsets: files can exceed 2 GiB)
+    portable_fseek(file, 0, SEEK_END);
+    int64_t file_size = portable_ftell(file);
+    portable_fseek(file, 0, SEEK_SET);
+    if (file_size < 0 || (uint64_t)file_size >= SIZE_MAX) {
+        fprintf(stderr, "Error: Cannot read file '%s'\n", filename);
+        fclose(file);
+        return -1;
+    }
     
-    char* content = (char*)malloc(file_size + 1);
+    char* content = (char*)malloc((size_t)file_size + 1);
     if (!content) {
+        fprintf(stderr, "Error: Out of memory reading '%s'\n", filename);
         fclose(file);
         return -1;
     }
     
-    size_t bytes_read = fread(content, 1, file_size, file);
+    size_t bytes_read = fread(content, 1, (size_t)file_size, file);
     content[bytes_read] = '\0';
     fclose(file);
     
     // Count lines by counting '\n' characters (matching JavaScript split('\n'))
     // This matches: "a\nb\nc".split('\n') -> ["a", "b", "c"] (3 lines)
     //               "a\nb\nc\n".split('\n') -> ["a", "b", "c", ""] (4 lines)
-    int line_count = 1;  // At least one line (even empty file has 1 empty line)
+    size_t line_count = 1;  // At least one line (even empty file has 1 empty line)
     for (size_t i = 0; i < bytes_read; i++) {
         if (content[i] == '\n') {
             line_count++;
         }
     }
+    if (line_count > INT_MAX) {
+        fprintf(stderr, "Error: '%s' has more than %d lines\n", filename, INT_MAX);
+        free(content);
+        return -1;
+    }
     
     // Allocate lines array
     char** lines = (char**)malloc(line_count * sizeof(char*));
@@ -141,7 +179,7 @@ static int read_file_lines(const char* filename, char*** lines_out) {
     
     free(content);
     *lines_out = lines;
-    return line_count;
+    return (int)line_count;
 }
 
 /**
@@ -155,6 +193,275 @@ static void free_lines(char** lines, int count) {
     free(lines);
 }
 
+// ============================================================================
+// Reproducer Replay
+// ============================================================================
+
+#define REPLAY_RUNS 3
+
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static bool has_case_extension(const char* name) {
+    size_t len = strlen(name);
+    size_t ext_len = strlen(DIFF_REPRO_CASE_EXT);
+    return len > ext_len && strcmp(name + len - ext_len, DIFF_REPRO_CASE_EXT) == 0;
+}
+
+/**
+ * Collect the .case files directly inside dir, sorted by name.
+ * Returns the number of paths (caller frees each and the array), or -1 on error.
+ */
+static int list_case_files(const char* dir, char*** paths_out) {
+    char** paths = NULL;
+    int count = 0;
+    int capacity = 0;
+
+#ifdef _WIN32
+    char pattern[4096];
+    snprintf(pattern, sizeof(pattern), "%s\\*%s", dir, DIFF_REPRO_CASE_EXT);
+    WIN32_FIND_DATAA entry;
+    HANDLE find = FindFirstFileA(pattern, &entry);
+    if (find == INVALID_HANDLE_VALUE) {
+        *paths_out = NULL;
+        return GetFileAttributesA(dir) == INVALID_FILE_ATTRIBUTES ? -1 : 0;
+    }
+    do {
+        const char* name = entry.cFileName;
+#else
+    DIR* handle = opendir(dir);
+    if (!handle) {
+        return -1;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(handle)) != NULL) {
+        const char* name = entry->d_name;
+#endif
+        if (has_case_extension(name)) {
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 16;
+                char** grown = (char**)realloc(paths, capacity * sizeof(char*));
+                if (!grown) {
+                    break;
+                }
+                paths = grown;
+            }
+            size_t size = strlen(dir) + strlen(name) + 2;
+            paths[count] = (char*)malloc(size);
+            if (paths[count]) {
+                snprintf(paths[count], size, "%s/%s", dir, name);
+                count++;
+            }
+        }
+#ifdef _WIN32
+    } while (FindNextFileA(find, &entry));
+    FindClose(find);
+#else
+    }
+    closedir(handle);
+#endif
+
+    if (count > 1) {
+        qsort(paths, count, sizeof(char*), compare_paths);
+    }
+    *paths_out = paths;
+    return count;
+}
+
+/**
+ * Name and time of the slowest top-level pipeline stage.
+ */
+static const char* slowest_stage(const DiffStats* stats, double* ms_out) {
+    const char* names[] = {"hash", "line_alignment", "line_optimize", "refine", "conversion", "moves"};
+    double values[] = {stats->hash_ms, stats->line_alignment_ms, stats->line_optimize_ms,
+                       stats->refine_ms, stats->conversion_ms, stats->moves_ms};
+    int best = 0;
+    for (int i = 1; i < (int)(sizeof(values) / sizeof(values[0])); i++) {
+        if (values[i] > values[best]) {
+            best = i;
+        }
+    }
+    *ms_out = values[best];
+    return names[best];
+}
+
+/**
+ * Re-run one captured case REPLAY_RUNS times and print its row.
+ * Returns false if the case could not be loaded.
+ */
+static bool replay_case(const char* case_path) {
+    DiffReproCase repro;
+    if (!diff_repro_read_case(case_path, &repro)) {
+        fprintf(stderr, "Error: Cannot parse '%s'\n", case_path);
+        return false;
+    }
+
+    char stem[4096];
+    char original_path[4200];
+    char modified_path[4200];
+    snprintf(stem, sizeof(stem), "%.*s", (int)(strlen(case_path) - strlen(DIFF_REPRO_CASE_EXT)),
+             case_path);
+    snprintf(original_path, sizeof(original_path), "%s.original", stem);
+    snprintf(modified_path, sizeof(modified_path), "%s.modified", stem);
+
+    char** original_lines = NULL;
+    char** modified_lines = NULL;
+    int original_count = read_file_lines(original_path, &original_lines);
+    int modified_count = read_file_lines(modified_path, &modified_lines);
+    if (original_count < 0 || modified_count < 0) {
+        free_lines(original_lines, original_count);
+        free_lines(modified_lines, modified_count);
+        return false;
+    }
+    // An empty capture reads back as one empty line; the .case file has the real count
+    int original_used = repro.original_count == 0 ? 0 : original_count;
+    int modified_used = repro.modified_count == 0 ? 0 : modified_count;
+    if (original_used != repro.original_count || modified_used != repro.modified_count) {
+        fprintf(stderr, "Warning: '%s' line counts differ from the .case file\n", stem);
+    }
+
+    DiffOptions options = repro.options;
+    options.collect_stats = true;
+    double best_ms = 0.0;
+    DiffStats best_stats;
+    memset(&best_stats, 0, sizeof(best_stats));
+    int changes = 0;
+    bool hit_timeout = false;
+    for (int run = 0; run < REPLAY_RUNS; run++) {
+        portable_time_t start_time, end_time;
+        portable_gettime(&start_time);
+        LinesDiff* diff = compute_diff((const char**)original_lines, original_used,
+                                       (const char**)modified_lines, modified_used, &options);
+        portable_gettime(&end_time);
+        if (!diff) {
+            fprintf(stderr, "Error: compute_diff failed on '%s'\n", stem);
+            free_lines(original_lines, original_count);
+            free_lines(modified_lines, modified_count);
+            return false;
+        }
+        double ms = portable_time_diff_ms(&start_time, &end_time);
+        if (run == 0 || ms < best_ms) {
+            best_ms = ms;
+            best_stats = diff->stats;
+        }
+        changes = diff->changes.count;
+        hit_timeout = diff->hit_timeout;
+        free_lines_diff(diff);
+    }
+
+    double stage_ms = 0.0;
+    const char* stage = slowest_stage(&best_stats, &stage_ms);
+    const char* name = strrchr(stem, '/');
+    char changes_text[32];
+    if (changes == repro.changes) {
+        snprintf(changes_text, sizeof(changes_text), "%d", changes);
+    } else {
+        snprintf(changes_text, sizeof(changes_text), "%d (was %d)", changes, repro.changes);
+    }
+    printf("%-32s %8d %8d %12.2f %12.2f %-16s %-5s %s %.2f ms\n", name ? name + 1 : stem,
+           original_used, modified_used, repro.captured_ms, best_ms, changes_text,
+           hit_timeout ? "yes" : "no", stage, stage_ms);
+
+    free_lines(original_lines, original_count);
+    free_lines(modified_lines, modified_count);
+    return true;
+}
+
+/**
+ * diff_tool --replay <dir>: re-run every captured case in dir.
+ */
+static int run_replay(const char* dir) {
+    char** cases = NULL;
+    int count = list_case_files(dir, &cases);
+    if (count < 0) {
+        fprintf(stderr, "Error: Cannot read directory '%s'\n", dir);
+        return 1;
+    }
+    if (count == 0) {
+        printf("No %s files in %s\n", DIFF_REPRO_CASE_EXT, dir);
+        return 0;
+    }
+
+    printf("Replaying %d case(s) from %s (best of %d runs)\n\n", count, dir, REPLAY_RUNS);
+    printf("%-32s %8s %8s %12s %12s %-16s %-5s %s\n", "case", "original", "modified",
+           "captured ms", "replay ms", "changes", "t/o", "slowest stage");
+    int failures = 0;
+    for (int i = 0; i < count; i++) {
+        if (!replay_case(cases[i])) {
+            failures++;
+        }
+        free(cases[i]);
+    }
+    free(cases);
+    return failures > 0 ? 1 : 0;
+}
+
+// ============================================================================
+// Shared-Memory Result Handoff
+// ============================================================================
+
+/**
+ * diff_tool --shm <path> | --shm-fd <n>: write the result into a shared
+ * region in the flat layout and print "<offset> <length>" on stdout.
+ *
+ * The region is the whole file behind path / fd; the caller sizes it. If the
+ * result does not fit, the size needed is reported on stderr and the exit
+ * code is 2, so the caller can grow the region and run again.
+ */
+static int write_shared_result(const LinesDiff* diff, const char* shm_path, int shm_fd,
+                               size_t shm_offset) {
+#ifdef _WIN32
+    (void)diff;
+    (void)shm_path;
+    (void)shm_fd;
+    (void)shm_offset;
+    fprintf(stderr, "Error: --shm is not supported on Windows\n");
+    return 1;
+#else
+    int fd = shm_fd;
+    if (shm_path) {
+        fd = open(shm_path, O_RDWR);
+        if (fd < 0) {
+            fprintf(stderr, "Error: Cannot open shared region '%s'\n", shm_path);
+            return 1;
+        }
+    }
+
+    int result = 1;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0 ||
+        (uint64_t)info.st_size != (uint64_t)(size_t)info.st_size) {
+        fprintf(stderr, "Error: Shared region is empty or cannot be sized\n");
+    } else {
+        size_t region_size = (size_t)info.st_size;
+        void* region = mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (region == MAP_FAILED) {
+            fprintf(stderr, "Error: Cannot map shared region\n");
+        } else {
+            size_t offset = 0;
+            size_t length = 0;
+            if (diff_flat_write(diff, region, region_size, shm_offset, &offset, &length)) {
+                printf("%zu %zu\n", offset, length);
+                result = 0;
+            } else if (length == 0) {
+                fprintf(stderr, "Error: Result is too large for the flat layout\n");
+            } else {
+                fprintf(stderr, "Error: Result needs %zu bytes at offset %zu, region has %zu\n",
+                        length, offset, region_size);
+                result = 2;
+            }
+            munmap(region, region_size);
+        }
+    }
+
+    if (shm_path) {
+        close(fd);
+    }
+    return result;
+#endif
+}
+
 // ============================================================================
 // Main Program
 // ============================================================================
@@ -162,6 +469,13 @@ static void free_lines(char** lines, int count) {
 int main(int argc, char* argv[]) {
     // Parse arguments
     bool show_timing = false;
+    bool compute_moves = false;
+    bool show_stats = false;
+    bool fast = false;
+    const char* trace_file = NULL;
+    const char* shm_path = NULL;
+    int shm_fd = -1;
+    size_t shm_offset = 0;
     int timeout_ms = 5000; // Default timeout: 5 seconds
     int arg_idx = 1;
 
@@ -173,6 +487,60 @@ int main(int argc, char* argv[]) {
         } else if (strcmp(argv[arg_idx], "-b") == 0) {
             show_timing = true;
             arg_idx++;
+        } else if (strcmp(argv[arg_idx], "-m") == 0 || strcmp(argv[arg_idx], "--moves") == 0) {
+            compute_moves = true;
+            arg_idx++;
+        } else if (strcmp(argv[arg_idx], "-s") == 0 || strcmp(argv[arg_idx], "--stats") == 0) {
+            show_stats = true;
+            arg_idx++;
+        } else if (strcmp(argv[arg_idx], "--fast") == 0) {
+            fast = true;
+            arg_idx++;
+        } else if (strcmp(argv[arg_idx], "--replay") == 0) {
+            if (arg_idx + 1 >= argc) {
+                fprintf(stderr, "Error: %s requires a directory\n", argv[arg_idx]);
+                return 1;
+            }
+            return run_replay(argv[arg_idx + 1]);
+        } else if (strcmp(argv[arg_idx], "--trace") == 0) {
+            if (arg_idx + 1 >= argc) {
+                fprintf(stderr, "Error: %s requires a file\n", argv[arg_idx]);
+                return 1;
+            }
+            trace_file = argv[arg_idx + 1];
+            arg_idx += 2;
+        } else if (strcmp(argv[arg_idx], "--shm") == 0) {
+            if (arg_idx + 1 >= argc) {
+                fprintf(stderr, "Error: %s requires a path\n", argv[arg_idx]);
+                return 1;
+            }
+            shm_path = argv[arg_idx + 1];
+            arg_idx += 2;
+        } else if (strcmp(argv[arg_idx], "--shm-fd") == 0 ||
+                   strcmp(argv[arg_idx], "--shm-offset") == 0) {
+            if (arg_idx + 1 >= argc) {
+                fprintf(stderr, "Error: %s requires a value\n", argv[arg_idx]);
+                return 1;
+            }
+            bool is_fd = strcmp(argv[arg_idx], "--shm-fd") == 0;
+            unsigned long long limit = is_fd ? INT_MAX : SIZE_MAX;
+            char* end = NULL;
+            errno = 0;
+            unsigned long long value = strtoull(argv[arg_idx + 1], &end, 10);
+            if (*argv[arg_idx + 1] == '-' || *end != '\0' || end == argv[arg_idx + 1]) {
+                fprintf(stderr, "Error: %s must be a non-negative integer\n", argv[arg_idx]);
+                return 1;
+            }
+            if (errno == ERANGE || value > limit) {
+                fprintf(stderr, "Error: %s must be at most %llu\n", argv[arg_idx], limit);
+                return 1;
+            }
+            if (is_fd) {
+                shm_fd = (int)value;
+            } else {
+                shm_offset = (size_t)value;
+            }
+            arg_idx += 2;
         } else if (strcmp(argv[arg_idx], "-T") == 0 || strcmp(argv[arg_idx], "--timeout") == 0) {
             if (arg_idx + 1 >= argc) {
                 fprintf(stderr, "Error: %s requires a value\n", argv[arg_idx]);
@@ -199,6 +567,14 @@ int main(int argc, char* argv[]) {
         fprintf(stderr, "Options:\n");
         fprintf(stderr, "  -v, --version   Show version information\n");
         fprintf(stderr, "  -b              Show benchmark timing information\n");
+        fprintf(stderr, "  -m, --moves     Detect moved code blocks\n");
+        fprintf(stderr, "  -s, --stats     Show per-stage instrumentation (DiffStats)\n");
+        fprintf(stderr, "  --fast          Use approximate engines (quality = fast, not VSCode parity)\n");
+        fprintf(stderr, "  --trace <file>  Write a Chrome trace-event timeline to <file>\n");
+        fprintf(stderr, "  --replay <dir>  Re-run captured slow-diff reproducers in <dir> with timing\n");
+        fprintf(stderr, "  --shm <path>    Write the result into shared memory, print \"<offset> <length>\"\n");
+        fprintf(stderr, "  --shm-fd <n>    Same as --shm, into an open descriptor (e.g. a memfd)\n");
+        fprintf(stderr, "  --shm-offset <n> Where to write in the region (default: 0)\n");
         fprintf(stderr, "  -T <ms>         Set timeout in milliseconds (default: 5000, 0 = no timeout)\n");
         fprintf(stderr, "  --timeout <ms>  Same as -T\n");
         return 1;
@@ -222,21 +598,31 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    printf("=================================================================\n");
-    printf("Diff Tool - Computing differences\n");
-    printf("=================================================================\n");
-    printf("Original: %s (%d lines)\n", original_file, original_count);
-    printf("Modified: %s (%d lines)\n", modified_file, modified_count);
-    printf("=================================================================\n\n");
+    // Shared-memory mode prints nothing but the blob location
+    bool shared = shm_path != NULL || shm_fd >= 0;
+    if (!shared) {
+        printf("=================================================================\n");
+        printf("Diff Tool - Computing differences\n");
+        printf("=================================================================\n");
+        printf("Original: %s (%d lines)\n", original_file, original_count);
+        printf("Modified: %s (%d lines)\n", modified_file, modified_count);
+        printf("=================================================================\n\n");
+    }
     
     // Set up diff options
     DiffOptions options = {
         .ignore_trim_whitespace = false,
         .max_computation_time_ms = timeout_ms,
-        .compute_moves = false,
-        .extend_to_subwords = false
+        .compute_moves = compute_moves,
+        .extend_to_subwords = false,
+        .collect_stats = show_stats,
+        .quality = fast ? DIFF_QUALITY_FAST : DIFF_QUALITY_PARITY
     };
 
+    if (trace_file) {
+        diff_trace_enable(true);
+    }
+
     // Compute diff with timing
     portable_time_t start_time, end_time;
     clock_t cpu_start, cpu_end;
@@ -253,6 +639,13 @@ int main(int argc, char* argv[]) {
     cpu_end = clock();
     portable_gettime(&end_time);
     
+    if (trace_file) {
+        diff_trace_enable(false);
+        if (!diff_trace_dump(trace_file)) {
+            fprintf(stderr, "Error: Cannot write trace to '%s'\n", trace_file);
+        }
+    }
+    
     double wall_clock_ms = portable_time_diff_ms(&start_time, &end_time);
     double cpu_time_ms = ((double)(cpu_end - cpu_start)) / CLOCKS_PER_SEC * 1000.0;
     
@@ -262,6 +655,14 @@ int main(int argc, char* argv[]) {
         free_lines(modified_lines, modified_count);
         return 1;
     }
+
+    if (shared) {
+        int result = write_shared_result(diff, shm_path, shm_fd, shm_offset);
+        free_lines_diff(diff);
+        free_lines(original_lines, original_count);
+        free_lines(modified_lines, modified_count);
+        return result;
+    }
     
     // Print the results
     printf("Diff Results:\n");
@@ -276,6 +677,16 @@ int main(int argc, char* argv[]) {
         printf("No differences found - files are identical.\n");
     }
     
+    if (diff->moves.count > 0) {
+        printf("\nMoves: %d\n", diff->moves.count);
+        for (int i = 0; i < diff->moves.count; i++) {
+            const MovedText* move = &diff->moves.moves[i];
+            printf("  [%d] Lines %d-%d -> Lines %d-%d\n", i,
+                   move->original.start_line, move->original.end_line,
+                   move->modified.start_line, move->modified.end_line);
+        }
+    }
+    
     printf("\n=================================================================\n");
     
     if (show_timing) {
@@ -287,6 +698,31 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    if (show_stats) {
+        static const char* algorithm_names[] = {"none", "dp", "myers", "rewrite", "sparse"};
+        const DiffStats* stats = &diff->stats;
+        int algorithm = stats->algorithm >= 0 && stats->algorithm <= 4 ? stats->algorithm : 0;
+        printf("\nDiff Stats:\n");
+        printf("  Algorithm:        %s (D = %d)\n", algorithm_names[algorithm],
+               stats->line_edit_distance);
+        printf("  Hashing:          %10.3f ms\n", stats->hash_ms);
+        printf("  Line alignment:   %10.3f ms%s\n", stats->line_alignment_ms,
+               stats->line_alignment_timeouts ? "  (timeout)" : "");
+        printf("  Line optimize:    %10.3f ms\n", stats->line_optimize_ms);
+        printf("  Refinement:       %10.3f ms (wall)\n", stats->refine_ms);
+        printf("    Whitespace:     %10.3f ms  (%d timeouts)\n", stats->whitespace_scan_ms,
+               stats->whitespace_scan_timeouts);
+        printf("    Characters:     %10.3f ms  (%d timeouts)\n", stats->char_refine_ms,
+               stats->char_refine_timeouts);
+        printf("  Conversion:       %10.3f ms\n", stats->conversion_ms);
+        printf("  Moves:            %10.3f ms%s\n", stats->moves_ms,
+               stats->moves_timeouts ? "  (timeout)" : "");
+        printf("  Total:            %10.3f ms\n", stats->total_ms);
+        printf("  Refined regions:  %d (largest %d lines)\n", stats->refined_regions,
+               stats->largest_region_lines);
+        printf("  Allocations:      %lld\n", (long long)stats->allocations);
+    }
+    
     // Cleanup
     free_lines_diff(diff);
     free_lines(original_lines, original_count);
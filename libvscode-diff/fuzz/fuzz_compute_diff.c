@@ -0,0 +1,711 @@
+/**
+ * fuzz_compute_diff - Algorithmic-Complexity Fuzzer for compute_diff()
+ *
+ * Looks for inputs that make compute_diff() slow or memory hungry rather than
+ * only inputs that crash: highly repetitive lines, long runs of shift-equal
+ * lines (join_sequence_diffs_by_shifting), very long words
+ * (extend_diffs_to_entire_word), whitespace-only edits. An input fails when
+ * its runtime or the process peak RSS crosses a threshold, or when the result
+ * has out-of-range line ranges.
+ *
+ * Input format (one file per case):
+ *   byte 0       option flags: 1 ignore_trim_whitespace, 2 compute_moves,
+ *                4 extend_to_subwords, 8 rewrite_threshold = 0.1,
+ *                16 quality = DIFF_QUALITY_FAST
+ *   bytes 1..    original text, a NUL byte, modified text
+ *                (without a NUL, the text is split in half)
+ *
+ * Two builds from the same source:
+ *
+ * Standalone (default):
+ *   fuzz_compute_diff [options] <file|dir>...     Replay cases, exit 1 on any failure
+ *   fuzz_compute_diff --search [options] [seeds]  Cost-guided search, failures saved
+ *     --runs <n>         Search iterations (default 2000)
+ *     --seconds <n>      Stop the search after n seconds (default 60)
+ *     --save-dir <dir>   Where failing inputs are written (default .)
+ *     --max-len <bytes>  Largest generated input (default 65536)
+ *     --max-ms <ms>      Runtime threshold per input (default 1000)
+ *     --max-rss-mb <mb>  Peak RSS threshold (default 1024, Linux/macOS only)
+ *     --timeout <ms>     max_computation_time_ms passed to compute_diff (default 100)
+ *     --seed <n>         PRNG seed (default 1)
+ *   The search mutates the costliest inputs seen so far (duplicating chunks,
+ *   repeating lines, deleting ranges, flipping bytes). Each input is written
+ *   to <save-dir>/current.bin before it runs, so a crash leaves it behind.
+ *
+ * libFuzzer (-DBUILD_LIBFUZZER=ON, clang): the same thresholds abort() the
+ * run, so libFuzzer saves the input; use its -max_len, -timeout and
+ * -rss_limit_mb flags as well.
+ *
+ * Failing inputs belong in fuzz/corpus/, which the fuzz_regression ctest
+ * replays.
+ */
+
+#include "default_lines_diff_computer.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#endif
+
+// ============================================================================
+// Running One Input
+// ============================================================================
+
+typedef struct {
+  double max_ms;
+  long max_rss_mb;
+  int timeout_ms;
+} FuzzLimits;
+
+typedef enum { FUZZ_OK = 0, FUZZ_SLOW, FUZZ_MEMORY, FUZZ_INVALID } FuzzStatus;
+
+static const char *const STATUS_NAMES[] = {"ok", "slow", "memory", "invalid"};
+
+typedef struct {
+  FuzzStatus status;
+  double elapsed_ms;
+  int64_t allocations;
+  long rss_mb;
+  const char *detail; // What was invalid
+} FuzzResult;
+
+static long peak_rss_mb(void) {
+#ifdef _WIN32
+  return 0; // Not measured
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return (long)(usage.ru_maxrss / (1024 * 1024)); // bytes
+#else
+  return usage.ru_maxrss / 1024; // kilobytes
+#endif
+#endif
+}
+
+// Same line count as split_buffer_lines() (compute_diff_buffers)
+static int buffer_line_count(const char *text, size_t length) {
+  int count = (length > 0 && text[length - 1] != '\n') ? 1 : 0;
+  for (size_t i = 0; i < length; i++) {
+    count += text[i] == '\n' ? 1 : 0;
+  }
+  return count;
+}
+
+static bool line_range_valid(LineRange range, int line_count) {
+  return range.start_line >= 1 && range.start_line <= range.end_line &&
+         range.end_line <= line_count + 1;
+}
+
+static const char *validate_result(const LinesDiff *diff, int original_count, int modified_count) {
+  int previous_end = 1;
+  for (int i = 0; i < diff->changes.count; i++) {
+    const DetailedLineRangeMapping *m = &diff->changes.mappings[i];
+    if (!line_range_valid(m->original, original_count) ||
+        !line_range_valid(m->modified, modified_count)) {
+      return "change line range out of bounds";
+    }
+    if (m->original.start_line < previous_end) {
+      return "changes overlap or are unsorted";
+    }
+    previous_end = m->original.end_line;
+    for (int j = 0; j < m->inner_change_count; j++) {
+      const RangeMapping *inner = &m->inner_changes[j];
+      if (inner->original.start_line < 1 || inner->original.end_line > original_count + 1 ||
+          inner->modified.start_line < 1 || inner->modified.end_line > modified_count + 1) {
+        return "inner change out of bounds";
+      }
+    }
+  }
+  for (int i = 0; i < diff->moves.count; i++) {
+    if (!line_range_valid(diff->moves.moves[i].original, original_count) ||
+        !line_range_valid(diff->moves.moves[i].modified, modified_count)) {
+      return "move line range out of bounds";
+    }
+  }
+  return NULL;
+}
+
+static FuzzResult run_input(const uint8_t *data, size_t size, const FuzzLimits *limits) {
+  FuzzResult result = {FUZZ_OK, 0.0, 0, 0, NULL};
+  if (size == 0) {
+    return result;
+  }
+
+  uint8_t flags = data[0];
+  const char *text = (const char *)data + 1;
+  size_t text_length = size - 1;
+  const char *separator = (const char *)memchr(text, '\0', text_length);
+  size_t original_length = separator ? (size_t)(separator - text) : text_length / 2;
+  const char *modified = separator ? separator + 1 : text + original_length;
+  size_t modified_length = text_length - (size_t)(modified - text);
+
+  DiffOptions options = {.ignore_trim_whitespace = (flags & 1) != 0,
+                         .max_computation_time_ms = limits->timeout_ms,
+                         .compute_moves = (flags & 2) != 0,
+                         .extend_to_subwords = (flags & 4) != 0,
+                         .rewrite_threshold = (flags & 8) ? 0.1 : 0.0,
+                         .quality = (flags & 16) ? DIFF_QUALITY_FAST : DIFF_QUALITY_PARITY};
+
+  int64_t allocations_before = diff_allocation_count();
+  double start = get_precise_time_ms();
+  LinesDiff *diff =
+      compute_diff_buffers(text, original_length, modified, modified_length, &options);
+  result.elapsed_ms = get_precise_time_ms() - start;
+  result.allocations = diff_allocation_count() - allocations_before;
+  result.rss_mb = peak_rss_mb();
+
+  if (!diff) {
+    result.status = FUZZ_INVALID;
+    result.detail = "compute_diff_buffers returned NULL";
+    return result;
+  }
+  result.detail = validate_result(diff, buffer_line_count(text, original_length),
+                                  buffer_line_count(modified, modified_length));
+  free_lines_diff(diff);
+
+  if (result.detail) {
+    result.status = FUZZ_INVALID;
+  } else if (result.elapsed_ms > limits->max_ms) {
+    result.status = FUZZ_SLOW;
+  } else if (limits->max_rss_mb > 0 && result.rss_mb > limits->max_rss_mb) {
+    result.status = FUZZ_MEMORY;
+  }
+  return result;
+}
+
+#ifdef FUZZ_WITH_LIBFUZZER
+
+// ============================================================================
+// libFuzzer Entry Point
+// ============================================================================
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  static const FuzzLimits limits = {1000.0, 1024, 100};
+  FuzzResult result = run_input(data, size, &limits);
+  if (result.status != FUZZ_OK) {
+    fprintf(stderr, "fuzz_compute_diff: %s input (%.1f ms, %ld MB RSS%s%s)\n",
+            STATUS_NAMES[result.status], result.elapsed_ms, result.rss_mb,
+            result.detail ? ", " : "", result.detail ? result.detail : "");
+    abort();
+  }
+  return 0;
+}
+
+#else
+
+// ============================================================================
+// Input Buffers and Files
+// ============================================================================
+
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+} Buffer;
+
+static void buffer_reserve(Buffer *buffer, size_t capacity) {
+  if (capacity <= buffer->capacity) {
+    return;
+  }
+  size_t new_capacity = buffer->capacity ? buffer->capacity : 256;
+  while (new_capacity < capacity) {
+    new_capacity *= 2;
+  }
+  uint8_t *data = (uint8_t *)realloc(buffer->data, new_capacity);
+  if (!data) {
+    fprintf(stderr, "fuzz_compute_diff: out of memory\n");
+    exit(1);
+  }
+  buffer->data = data;
+  buffer->capacity = new_capacity;
+}
+
+static void buffer_append(Buffer *buffer, const void *data, size_t size) {
+  buffer_reserve(buffer, buffer->size + size);
+  memcpy(buffer->data + buffer->size, data, size);
+  buffer->size += size;
+}
+
+static void buffer_append_str(Buffer *buffer, const char *s) { buffer_append(buffer, s, strlen(s)); }
+
+static bool read_file(const char *path, Buffer *out) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return false;
+  }
+  out->size = 0;
+  uint8_t chunk[65536];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    buffer_append(out, chunk, n);
+  }
+  fclose(file);
+  return true;
+}
+
+static bool write_file(const char *path, const uint8_t *data, size_t size) {
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+  bool ok = fwrite(data, 1, size, file) == size;
+  return fclose(file) == 0 && ok;
+}
+
+static uint64_t fnv1a(const uint8_t *data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+typedef void (*FileVisitor)(const char *path, void *context);
+
+/**
+ * Call visit() for path itself, or for every regular file directly inside it
+ */
+static bool for_each_file(const char *path, FileVisitor visit, void *context) {
+  char child[4096];
+#ifdef _WIN32
+  DWORD attributes = GetFileAttributesA(path);
+  if (attributes == INVALID_FILE_ATTRIBUTES) {
+    return false;
+  }
+  if (!(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+    visit(path, context);
+    return true;
+  }
+  char pattern[4096];
+  snprintf(pattern, sizeof(pattern), "%s\\*", path);
+  WIN32_FIND_DATAA entry;
+  HANDLE find = FindFirstFileA(pattern, &entry);
+  if (find == INVALID_HANDLE_VALUE) {
+    return true;
+  }
+  do {
+    if (!(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+      snprintf(child, sizeof(child), "%s\\%s", path, entry.cFileName);
+      visit(child, context);
+    }
+  } while (FindNextFileA(find, &entry));
+  FindClose(find);
+#else
+  struct stat info;
+  if (stat(path, &info) != 0) {
+    return false;
+  }
+  if (!S_ISDIR(info.st_mode)) {
+    visit(path, context);
+    return true;
+  }
+  DIR *dir = opendir(path);
+  if (!dir) {
+    return false;
+  }
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+    if (stat(child, &info) == 0 && S_ISREG(info.st_mode)) {
+      visit(child, context);
+    }
+  }
+  closedir(dir);
+#endif
+  return true;
+}
+
+// ============================================================================
+// Replay Mode
+// ============================================================================
+
+typedef struct {
+  const FuzzLimits *limits;
+  int files;
+  int failures;
+} ReplayContext;
+
+static void replay_file(const char *path, void *context) {
+  ReplayContext *replay = (ReplayContext *)context;
+  Buffer input = {NULL, 0, 0};
+  if (!read_file(path, &input)) {
+    fprintf(stderr, "  %-50s cannot read\n", path);
+    replay->failures++;
+    return;
+  }
+  FuzzResult result = run_input(input.data, input.size, replay->limits);
+  printf("  %-50s %8zu bytes %9.1f ms %9lld allocs  %s%s%s\n", path, input.size, result.elapsed_ms,
+         (long long)result.allocations, STATUS_NAMES[result.status], result.detail ? ": " : "",
+         result.detail ? result.detail : "");
+  replay->files++;
+  replay->failures += result.status != FUZZ_OK ? 1 : 0;
+  free(input.data);
+}
+
+// ============================================================================
+// Search Mode
+// ============================================================================
+
+#define POOL_SIZE 16
+
+typedef struct {
+  Buffer input;
+  double cost;
+} PoolEntry;
+
+typedef struct {
+  PoolEntry entries[POOL_SIZE];
+  int count;
+} Pool;
+
+static uint64_t rng_state = 1;
+
+static uint64_t rng_next(void) {
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return rng_state * 0x2545f4914f6cdd1dull;
+}
+
+static size_t rng_below(size_t bound) { return bound ? (size_t)(rng_next() % bound) : 0; }
+
+static double input_cost(const FuzzResult *result) {
+  // Runtime first; allocations break ties between inputs that finish instantly
+  return result->elapsed_ms + (double)result->allocations * 1e-4;
+}
+
+static void pool_offer(Pool *pool, const Buffer *input, double cost) {
+  int slot = pool->count;
+  if (pool->count == POOL_SIZE) {
+    slot = 0;
+    for (int i = 1; i < POOL_SIZE; i++) {
+      if (pool->entries[i].cost < pool->entries[slot].cost) {
+        slot = i;
+      }
+    }
+    if (pool->entries[slot].cost >= cost) {
+      return;
+    }
+    free(pool->entries[slot].input.data);
+  } else {
+    pool->count++;
+  }
+  Buffer copy = {NULL, 0, 0};
+  buffer_append(&copy, input->data, input->size);
+  pool->entries[slot].input = copy;
+  pool->entries[slot].cost = cost;
+}
+
+// Built-in seeds aimed at the known superlinear spots
+static void seed_repetitive(Buffer *out) {
+  buffer_append(out, "\0", 1);
+  for (int i = 0; i < 1500; i++) {
+    buffer_append_str(out, i % 2 ? "}\n" : "\n");
+  }
+  buffer_append(out, "\0", 1);
+  for (int i = 0; i < 1500; i++) {
+    buffer_append_str(out, i % 3 ? "}\n" : "\n");
+  }
+}
+
+static void seed_shift_equal(Buffer *out) {
+  buffer_append(out, "\0", 1);
+  for (int i = 0; i < 2000; i++) {
+    buffer_append_str(out, "x = x;\n");
+  }
+  buffer_append(out, "\0", 1);
+  for (int i = 0; i < 2000; i++) {
+    buffer_append_str(out, "x = x;\n");
+    if (i % 97 == 0) {
+      buffer_append_str(out, "x = x;\n");
+    }
+  }
+}
+
+static void seed_long_word(Buffer *out) {
+  uint8_t flags = 4; // extend_to_subwords
+  buffer_append(out, &flags, 1);
+  for (int i = 0; i < 20000; i++) {
+    buffer_append(out, &"abcdefghij"[i % 10], 1);
+  }
+  buffer_append(out, "\0", 1);
+  for (int i = 0; i < 20000; i++) {
+    buffer_append(out, i % 211 == 0 ? "Z" : &"abcdefghij"[i % 10], 1);
+  }
+}
+
+static void seed_whitespace(Buffer *out) {
+  buffer_append(out, "\0", 1);
+  for (int i = 0; i < 1000; i++) {
+    buffer_append_str(out, "    value = compute(value, 1);\n");
+  }
+  buffer_append(out, "\0", 1);
+  for (int i = 0; i < 1000; i++) {
+    buffer_append_str(out, i % 2 ? "\tvalue = compute(value, 1);\n"
+                                 : "        value  =  compute(value,  1);\n");
+  }
+}
+
+// Large rewrite sharing few lines: fast quality takes the sparse LCS
+static void seed_sparse_rewrite(Buffer *out) {
+  uint8_t flags = 16; // quality = DIFF_QUALITY_FAST
+  char line[48];
+  buffer_append(out, &flags, 1);
+  for (int i = 0; i < 600; i++) {
+    snprintf(line, sizeof(line), "old_%d = load(%d);\n", i, i * 7);
+    buffer_append_str(out, i % 50 == 0 ? "return;\n" : line);
+  }
+  buffer_append(out, "\0", 1);
+  for (int i = 0; i < 600; i++) {
+    snprintf(line, sizeof(line), "new_%d = store(%d);\n", i, i * 3);
+    buffer_append_str(out, i % 50 == 25 ? "return;\n" : line);
+  }
+}
+
+static void mutate(Buffer *input, size_t max_len) {
+  if (input->size < 2) {
+    buffer_append_str(input, "a\n");
+  }
+  size_t size = input->size;
+  switch (rng_below(5)) {
+  case 0: { // Flip a text byte (flags are toggled by the default case)
+    input->data[1 + rng_below(size - 1)] = (uint8_t)rng_next();
+    break;
+  }
+  case 1: { // Repeat a chunk several times in place
+    size_t start = 1 + rng_below(size - 1);
+    size_t length = 1 + rng_below(size - start < 64 ? size - start : 64);
+    size_t repeats = 1 + rng_below(32);
+    if (size + length * repeats > max_len) {
+      break;
+    }
+    buffer_reserve(input, size + length * repeats);
+    memmove(input->data + start + length * repeats, input->data + start, size - start);
+    for (size_t r = 0; r < repeats; r++) {
+      memcpy(input->data + start + r * length, input->data + start + length * repeats, length);
+    }
+    input->size = size + length * repeats;
+    break;
+  }
+  case 2: { // Delete a range
+    size_t start = 1 + rng_below(size - 1);
+    size_t length = rng_below(size - start < 256 ? size - start : 256);
+    memmove(input->data + start, input->data + start + length, size - start - length);
+    input->size = size - length;
+    break;
+  }
+  case 3: { // Duplicate the line under a random position somewhere else
+    size_t at = 1 + rng_below(size - 1);
+    size_t line_start = at;
+    while (line_start > 1 && input->data[line_start - 1] != '\n' && input->data[line_start - 1]) {
+      line_start--;
+    }
+    size_t line_end = at;
+    while (line_end < size && input->data[line_end] != '\n' && input->data[line_end]) {
+      line_end++;
+    }
+    size_t length = line_end - line_start + (line_end < size ? 1 : 0);
+    size_t dest = 1 + rng_below(size - 1);
+    if (length == 0 || size + length > max_len) {
+      break;
+    }
+    uint8_t *line = (uint8_t *)malloc(length);
+    if (!line) {
+      break;
+    }
+    memcpy(line, input->data + line_start, length);
+    buffer_reserve(input, size + length);
+    memmove(input->data + dest + length, input->data + dest, size - dest);
+    memcpy(input->data + dest, line, length);
+    input->size = size + length;
+    free(line);
+    break;
+  }
+  default: // Toggle option flags
+    input->data[0] ^= (uint8_t)(1u << rng_below(5));
+    break;
+  }
+}
+
+typedef struct {
+  Pool *pool;
+  const FuzzLimits *limits;
+} SeedContext;
+
+static void seed_from_file(const char *path, void *context) {
+  SeedContext *seed = (SeedContext *)context;
+  Buffer input = {NULL, 0, 0};
+  if (read_file(path, &input) && input.size > 0) {
+    FuzzResult result = run_input(input.data, input.size, seed->limits);
+    pool_offer(seed->pool, &input, input_cost(&result));
+  }
+  free(input.data);
+}
+
+static int search(const char **seed_paths, int seed_count, const FuzzLimits *limits, int runs,
+                  double seconds, size_t max_len, const char *save_dir) {
+  Pool pool;
+  memset(&pool, 0, sizeof(pool));
+
+  void (*generators[])(Buffer *) = {seed_repetitive, seed_shift_equal, seed_long_word,
+                                    seed_whitespace, seed_sparse_rewrite};
+  for (size_t i = 0; i < sizeof(generators) / sizeof(generators[0]); i++) {
+    Buffer input = {NULL, 0, 0};
+    generators[i](&input);
+    FuzzResult result = run_input(input.data, input.size, limits);
+    pool_offer(&pool, &input, input_cost(&result));
+    free(input.data);
+  }
+  SeedContext seed = {&pool, limits};
+  for (int i = 0; i < seed_count; i++) {
+    for_each_file(seed_paths[i], seed_from_file, &seed);
+  }
+
+  char current_path[4096];
+  snprintf(current_path, sizeof(current_path), "%s/current.bin", save_dir);
+  double deadline = get_precise_time_ms() + seconds * 1000.0;
+  double worst_ms = 0.0;
+  int failures = 0;
+
+  for (int run = 0; run < runs && get_precise_time_ms() < deadline; run++) {
+    const PoolEntry *parent = &pool.entries[rng_below((size_t)pool.count)];
+    Buffer child = {NULL, 0, 0};
+    buffer_append(&child, parent->input.data, parent->input.size);
+    int mutations = 1 + (int)rng_below(4);
+    for (int m = 0; m < mutations; m++) {
+      mutate(&child, max_len);
+    }
+
+    write_file(current_path, child.data, child.size); // Survives a crash
+    FuzzResult result = run_input(child.data, child.size, limits);
+    if (result.elapsed_ms > worst_ms) {
+      worst_ms = result.elapsed_ms;
+    }
+    if (result.status != FUZZ_OK) {
+      char path[4096];
+      snprintf(path, sizeof(path), "%s/%s-%016llx.bin", save_dir, STATUS_NAMES[result.status],
+               (unsigned long long)fnv1a(child.data, child.size));
+      write_file(path, child.data, child.size);
+      fprintf(stderr, "  run %d: %s input saved to %s (%.1f ms, %zu bytes%s%s)\n", run,
+              STATUS_NAMES[result.status], path, result.elapsed_ms, child.size,
+              result.detail ? ", " : "", result.detail ? result.detail : "");
+      failures++;
+      if (result.status == FUZZ_MEMORY) {
+        free(child.data);
+        break; // Peak RSS only grows; every later input would be flagged too
+      }
+    }
+    pool_offer(&pool, &child, input_cost(&result));
+    free(child.data);
+
+    if (run % 500 == 0) {
+      fprintf(stderr, "  run %d: worst %.1f ms, %d failing input(s)\n", run, worst_ms, failures);
+    }
+  }
+  remove(current_path);
+
+  fprintf(stderr, "Search done: worst %.1f ms, %d failing input(s)\n", worst_ms, failures);
+  for (int i = 0; i < pool.count; i++) {
+    free(pool.entries[i].input.data);
+  }
+  return failures > 0 ? 1 : 0;
+}
+
+// ============================================================================
+// Main Program
+// ============================================================================
+
+static void print_usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [options] <file|dir>...          Replay inputs\n", prog);
+  fprintf(stderr, "       %s --search [options] [seed|dir]... Search for slow inputs\n", prog);
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr, "  --max-ms <ms>        Runtime threshold per input (default: 1000)\n");
+  fprintf(stderr, "  --max-rss-mb <mb>    Peak RSS threshold (default: 1024)\n");
+  fprintf(stderr, "  --timeout <ms>       compute_diff timeout (default: 100)\n");
+  fprintf(stderr, "  --runs <n>           Search iterations (default: 2000)\n");
+  fprintf(stderr, "  --seconds <n>        Search time limit (default: 60)\n");
+  fprintf(stderr, "  --max-len <bytes>    Largest generated input (default: 65536)\n");
+  fprintf(stderr, "  --save-dir <dir>     Directory for failing inputs (default: .)\n");
+  fprintf(stderr, "  --seed <n>           PRNG seed (default: 1)\n");
+}
+
+int main(int argc, char *argv[]) {
+  FuzzLimits limits = {1000.0, 1024, 100};
+  bool search_mode = false;
+  int runs = 2000;
+  double seconds = 60.0;
+  size_t max_len = 65536;
+  const char *save_dir = ".";
+  const char **paths = (const char **)malloc((size_t)argc * sizeof(char *));
+  int path_count = 0;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (strcmp(arg, "--search") == 0) {
+      search_mode = true;
+    } else if (strcmp(arg, "--max-ms") == 0 && has_value) {
+      limits.max_ms = atof(argv[++i]);
+    } else if (strcmp(arg, "--max-rss-mb") == 0 && has_value) {
+      limits.max_rss_mb = atol(argv[++i]);
+    } else if (strcmp(arg, "--timeout") == 0 && has_value) {
+      limits.timeout_ms = atoi(argv[++i]);
+    } else if (strcmp(arg, "--runs") == 0 && has_value) {
+      runs = atoi(argv[++i]);
+    } else if (strcmp(arg, "--seconds") == 0 && has_value) {
+      seconds = atof(argv[++i]);
+    } else if (strcmp(arg, "--max-len") == 0 && has_value) {
+      max_len = (size_t)atol(argv[++i]);
+    } else if (strcmp(arg, "--save-dir") == 0 && has_value) {
+      save_dir = argv[++i];
+    } else if (strcmp(arg, "--seed") == 0 && has_value) {
+      rng_state = (uint64_t)strtoull(argv[++i], NULL, 10);
+      rng_state = rng_state ? rng_state : 1;
+    } else if (arg[0] == '-') {
+      fprintf(stderr, "Error: Unknown or incomplete option: %s\n", arg);
+      print_usage(argv[0]);
+      free(paths);
+      return 1;
+    } else {
+      paths[path_count++] = arg;
+    }
+  }
+
+  int status;
+  if (search_mode) {
+    status = search(paths, path_count, &limits, runs, seconds, max_len, save_dir);
+  } else if (path_count == 0) {
+    print_usage(argv[0]);
+    status = 1;
+  } else {
+    ReplayContext replay = {&limits, 0, 0};
+    for (int i = 0; i < path_count; i++) {
+      if (!for_each_file(paths[i], replay_file, &replay)) {
+        fprintf(stderr, "Error: Cannot open '%s'\n", paths[i]);
+        replay.failures++;
+      }
+    }
+    printf("%d input(s), %d failure(s) (limits: %.0f ms, %ld MB RSS)\n", replay.files,
+           replay.failures, limits.max_ms, limits.max_rss_mb);
+    status = replay.failures > 0 ? 1 : 0;
+  }
+  free(paths);
+  return status;
+}
+
+#endif // FUZZ_WITH_LIBFUZZER
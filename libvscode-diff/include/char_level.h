@@ -28,6 +28,7 @@ typedef struct {
   bool consider_whitespace_changes; // If false, trim whitespace
   bool extend_to_subwords;          // If true, extend to CamelCase subwords
   int timeout_ms;                   // Timeout in milliseconds (0 = infinite)
+  bool fast;                        // DIFF_QUALITY_FAST: Myers O(ND) even below 500 chars
 } CharLevelOptions;
 
 /**
@@ -56,12 +57,34 @@ typedef struct {
  * @param len_b Number of lines in modified
  * @param options Refinement options
  * @param out_hit_timeout Output: Set to true if timeout occurred, can be NULL
- * @return RangeMappingArray* Character-level mappings (caller must free)
+ * @return RangeMappingArray* Character-level mappings (caller must free). A region
+ *         too large to refine (more than DIFF_MAX_ELEMENTS characters) yields
+ *         one mapping covering the whole region. NULL on invalid arguments or
+ *         allocation failure.
  */
 RangeMappingArray *refine_diff_char_level(const SequenceDiff *line_diff, const char **lines_a,
                                           int len_a, const char **lines_b, int len_b,
                                           const CharLevelOptions *options, bool *out_hit_timeout);
 
+/**
+ * Whitespace-only line fast path for scanForWhitespaceChanges()
+ *
+ * Lines that hash equal but differ as strings only differ in leading/trailing
+ * whitespace. When exactly one end changed and its runs either share no
+ * character (whole run replaced) or repeat the same space/tab (insertion or
+ * deletion placed by boundary score), the mapping follows directly from the
+ * trim bounds and matches refine_diff_char_level() exactly.
+ *
+ * @param line_a Original line
+ * @param line_b Modified line
+ * @param line_number_a 1-based line number of line_a
+ * @param line_number_b 1-based line number of line_b
+ * @param out_mapping Output: the single character-level mapping
+ * @return false if the change is not covered (caller runs the full refinement)
+ */
+bool refine_whitespace_only_line(const char *line_a, const char *line_b, int line_number_a,
+                                 int line_number_b, RangeMapping *out_mapping);
+
 /**
  * Refine all line-level diffs to character-level - VSCode Parity
  * 
@@ -2,6 +2,7 @@
 #define DEFAULT_LINES_DIFF_COMPUTER_H
 
 #include "types.h"
+#include <stddef.h>
 
 // DLL export/import declarations for Windows
 #ifdef _WIN32
@@ -14,6 +15,27 @@
   #define DLL_EXPORT
 #endif
 
+/**
+ * FFI API version, bumped whenever an exported signature or a struct passed
+ * across the FFI changes. get_api_version() reports the library's value and
+ * the Lua side refuses to load a library whose version differs.
+ *
+ * 1: plugin 1.13.2 and earlier (no get_api_version() export)
+ * 2: DiffOptions.rewrite_threshold (double) appended after
+ *    extend_to_subwords; LinesDiff.is_rewrite (bool) appended after
+ *    hit_timeout
+ * 3: DiffOptions.collect_stats (bool) and LinesDiff.stats (DiffStats)
+ *    appended
+ * 4: DiffOptions.quality (int, DiffQuality) appended; DIFF_ALGORITHM_SPARSE (4)
+ * 5: get_api_version() exported; compute_diff_buffers_sized() takes size_t
+ *    lengths. Counts, line numbers and columns stay int: inputs with more
+ *    lines than INT_MAX are rejected, and a changed region with more
+ *    characters is reported as one change without character refinement.
+ * 6: compute_diff_buffers() takes the size_t lengths itself;
+ *    compute_diff_buffers_sized() removed
+ */
+#define VSCODE_DIFF_API_VERSION 6
+
 /**
  * Compute diff between two files.
  * 
@@ -27,13 +49,94 @@
  * @param options Diff computation options
  * @return LinesDiff structure (caller must free with free_lines_diff())
  * 
+ * If options->rewrite_threshold is set and the files share fewer lines than
+ * that ratio, the result is a single whole-file change with is_rewrite set
+ * (no Myers alignment, no character refinement).
+ * 
  * VSCode Reference: defaultLinesDiffComputer.ts computeDiff()
- * VSCode Parity: 100% (excluding computeMoves and DP algorithm)
+ * VSCode Parity: 100% (excluding DP algorithm and refined inner changes of moves)
  */
 DLL_EXPORT LinesDiff *compute_diff(const char **original_lines, int original_count,
                         const char **modified_lines, int modified_count,
                         const DiffOptions *options);
 
+/**
+ * Refine caller-provided line alignments (staged API).
+ *
+ * Runs only the second half of compute_diff(): the whitespace scan of the
+ * unchanged lines, character refinement of each region, conversion to line
+ * mappings and, if options->compute_moves, moved code detection. The line
+ * regions come from the caller, e.g. Neovim's xdiff (`vim.diff` with
+ * result_type = "indices"), so a faster line pass still gets VSCode-quality
+ * character highlights. Regions are used as given: no line-level
+ * optimization passes and no rewrite check (rewrite_threshold is ignored).
+ *
+ * Regions are 0-based and end-exclusive, must be sorted and non-empty, and
+ * the unchanged gaps between them must have the same length on both sides.
+ *
+ * @param original_lines Original file lines
+ * @param original_count Number of lines in original
+ * @param modified_lines Modified file lines
+ * @param modified_count Number of lines in modified
+ * @param alignments Line-level regions (only read during this call)
+ * @param alignment_count Number of regions (0 = lines only differ in whitespace, if at all)
+ * @param options Diff computation options
+ * @return LinesDiff structure (caller must free with free_lines_diff()), or NULL
+ *         on invalid input or allocation failure
+ */
+DLL_EXPORT LinesDiff *refine_line_alignments(const char **original_lines, int original_count,
+                        const char **modified_lines, int modified_count,
+                        const SequenceDiff *alignments, int alignment_count,
+                        const DiffOptions *options);
+
+/**
+ * Count changed lines between two files without building a LinesDiff.
+ *
+ * Runs only line hashing and the line-level alignment (same as compute_diff
+ * Steps 1-3). No character refinement and no result allocation, so it is
+ * cheap enough to annotate every file in the explorer.
+ *
+ * Each aligned region contributes min(len1, len2) modified lines and the
+ * remainder as inserted/deleted lines. When whitespace is considered, equal
+ * lines that differ only in leading/trailing whitespace count as modified,
+ * matching what compute_diff() would report.
+ *
+ * @param original_lines Original file lines
+ * @param original_count Number of lines in original
+ * @param modified_lines Modified file lines
+ * @param modified_count Number of lines in modified
+ * @param options Diff computation options (compute_moves/extend_to_subwords ignored)
+ * @param out_stats Output: line counts (must not be NULL)
+ * @return true on success, false on invalid input or allocation failure
+ */
+DLL_EXPORT bool compute_diff_stats(const char **original_lines, int original_count,
+                        const char **modified_lines, int modified_count,
+                        const DiffOptions *options, DiffLineStats *out_stats);
+
+/**
+ * Compute diff between two text buffers.
+ *
+ * Same as compute_diff(), but takes raw file contents (e.g. `git show`
+ * output) so callers don't have to split them into a line array first.
+ * Lines are split on '\n' ('\r' is kept); a trailing '\n' does not produce
+ * an extra empty line. Buffers need not be NUL-terminated and are only read
+ * during this call.
+ *
+ * This is not zero-copy: each buffer is copied once so its lines can be
+ * NUL-terminated in place. What it saves is the caller-side line array.
+ *
+ * @param original_text Original file contents (can be NULL if length is 0)
+ * @param original_length Length of original_text in bytes
+ * @param modified_text Modified file contents (can be NULL if length is 0)
+ * @param modified_length Length of modified_text in bytes
+ * @param options Diff computation options
+ * @return LinesDiff structure (caller must free with free_lines_diff()), or NULL
+ *         on error, including a buffer with more than INT_MAX lines
+ */
+DLL_EXPORT LinesDiff *compute_diff_buffers(const char *original_text, size_t original_length,
+                                           const char *modified_text, size_t modified_length,
+                                           const DiffOptions *options);
+
 /**
  * Free LinesDiff structure and all contained data.
  * 
@@ -48,4 +151,11 @@ DLL_EXPORT void free_lines_diff(LinesDiff *diff);
  */
 DLL_EXPORT const char *get_version(void);
 
+/**
+ * Get the FFI API version the library was built with.
+ *
+ * @return VSCODE_DIFF_API_VERSION
+ */
+DLL_EXPORT int get_api_version(void);
+
 #endif // DEFAULT_LINES_DIFF_COMPUTER_H
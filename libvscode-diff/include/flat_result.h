@@ -0,0 +1,110 @@
+#ifndef FLAT_RESULT_H
+#define FLAT_RESULT_H
+
+#include "default_lines_diff_computer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Flat Result Layout - LinesDiff as one relocatable struct-of-arrays blob
+ *
+ * For out-of-process callers (editor worker processes, a diff daemon) that
+ * would otherwise serialize a large LinesDiff through a pipe. diff_flat_write()
+ * lays the result out in a caller-provided memory region, typically a memfd
+ * or POSIX shared-memory mapping, and reports only its offset and length. The
+ * consumer maps the same region and reads the arrays in place: no parsing and
+ * no copies.
+ *
+ * Layout (host byte order, every array 8-byte aligned):
+ *
+ *   DiffFlatHeader   counts, flags and the byte offset of every array
+ *   int32_t arrays   one per DiffFlatArray, in enum order
+ *
+ * Offsets are relative to the start of the blob, so the blob can be copied or
+ * mapped at any address. Change i owns the inner changes
+ * [inner_offset[i], inner_offset[i + 1]). Lines and columns are 1-based, as in
+ * LinesDiff; ranges are end-exclusive.
+ */
+
+#define DIFF_FLAT_MAGIC 0x52464456u // "VDFR" in memory on little-endian hosts
+#define DIFF_FLAT_VERSION 1
+#define DIFF_FLAT_ALIGNMENT 8
+
+// DiffFlatHeader.flags
+#define DIFF_FLAT_HIT_TIMEOUT 0x1
+#define DIFF_FLAT_IS_REWRITE 0x2
+
+typedef enum {
+  // change_count entries each (except the inner offsets)
+  DIFF_FLAT_CHANGE_ORIGINAL_START,
+  DIFF_FLAT_CHANGE_ORIGINAL_END,
+  DIFF_FLAT_CHANGE_MODIFIED_START,
+  DIFF_FLAT_CHANGE_MODIFIED_END,
+  DIFF_FLAT_CHANGE_INNER_OFFSET, // change_count + 1 entries
+  // inner_count entries each
+  DIFF_FLAT_INNER_ORIGINAL_START_LINE,
+  DIFF_FLAT_INNER_ORIGINAL_START_COL,
+  DIFF_FLAT_INNER_ORIGINAL_END_LINE,
+  DIFF_FLAT_INNER_ORIGINAL_END_COL,
+  DIFF_FLAT_INNER_MODIFIED_START_LINE,
+  DIFF_FLAT_INNER_MODIFIED_START_COL,
+  DIFF_FLAT_INNER_MODIFIED_END_LINE,
+  DIFF_FLAT_INNER_MODIFIED_END_COL,
+  // move_count entries each
+  DIFF_FLAT_MOVE_ORIGINAL_START,
+  DIFF_FLAT_MOVE_ORIGINAL_END,
+  DIFF_FLAT_MOVE_MODIFIED_START,
+  DIFF_FLAT_MOVE_MODIFIED_END,
+  DIFF_FLAT_ARRAY_COUNT
+} DiffFlatArray;
+
+typedef struct {
+  uint32_t magic;        // DIFF_FLAT_MAGIC
+  uint16_t version;      // DIFF_FLAT_VERSION
+  uint16_t flags;        // DIFF_FLAT_HIT_TIMEOUT | DIFF_FLAT_IS_REWRITE
+  int32_t change_count;
+  int32_t inner_count;   // Inner changes of all changes
+  int32_t move_count;
+  uint32_t header_bytes; // sizeof(DiffFlatHeader)
+  uint64_t total_bytes;  // Header and all arrays
+  uint64_t offsets[DIFF_FLAT_ARRAY_COUNT]; // Byte offset of each array from the blob start
+} DiffFlatHeader;
+
+/**
+ * Bytes diff_flat_write() needs for a result.
+ *
+ * @return Blob size, or 0 if the result has more than INT32_MAX entries in
+ *         one array
+ */
+DLL_EXPORT size_t diff_flat_size(const LinesDiff *diff);
+
+/**
+ * Write a result into a memory region in the flat layout.
+ *
+ * @param diff Result to write
+ * @param region Start of the region (e.g. an mmap of a memfd)
+ * @param region_size Bytes available in the region
+ * @param offset Where to write; rounded up to DIFF_FLAT_ALIGNMENT
+ * @param out_offset Output: offset of the blob in the region
+ * @param out_length Output: length of the blob (diff_flat_size())
+ * @return true on success, false if the blob does not fit (nothing written;
+ *         *out_offset and *out_length still say where it would go)
+ */
+DLL_EXPORT bool diff_flat_write(const LinesDiff *diff, void *region, size_t region_size,
+                                size_t offset, size_t *out_offset, size_t *out_length);
+
+/**
+ * Locate one array of a flat blob, checking the header first.
+ *
+ * @param blob Start of the blob (8-byte aligned)
+ * @param length Bytes readable at blob
+ * @param array Which array
+ * @param out_count Output: number of entries (may be NULL)
+ * @return Pointer into the blob, or NULL if the blob is truncated, has a
+ *         different magic / version, or is otherwise inconsistent
+ */
+DLL_EXPORT const int32_t *diff_flat_array(const void *blob, size_t length, DiffFlatArray array,
+                                          int *out_count);
+
+#endif // FLAT_RESULT_H
@@ -4,6 +4,9 @@
 #include "sequence.h"
 #include "types.h"
 
+// Smaller inputs always run the full alignment (cheap, and keeps VSCode parity)
+#define REWRITE_MIN_TOTAL_LINES 200
+
 /**
  * Line-Level Diff Computation (Steps 1-3 Consolidation) - FULL VSCODE PARITY
  * 
@@ -13,7 +16,8 @@
  * Pipeline (VSCode lines 66-87, 224-245):
  * 1. Create perfect hash map for line deduplication
  * 2. Create LineSequence with hashed lines
- * 3. Run Myers diff (DP for small files <1700 lines, O(ND) for large)
+ * 3. Run Myers diff (DP for small files <1700 lines, O(ND) for large, sparse
+ *    LCS for large files with few matching lines)
  *    - DP uses equality scoring for whitespace sensitivity
  * 4. optimizeSequenceDiffs() - Step 2 optimization
  * 5. removeVeryShortMatchingLinesBetweenDiffs() - Step 3 optimization
@@ -36,9 +40,12 @@
  * 1. Create perfect hash map for line content
  * 2. Hash each line (trimmed) using perfect hash
  * 3. Create LineSequence(hashes, lines) for both sides
- * 4. If total lines < 1700:
+ * 4. If total lines < 1700 (and quality is DIFF_QUALITY_PARITY):
  *      Use DP algorithm with equality scoring:
  *        score = (line1 == line2) ? (empty ? 0.1 : 1 + log(1 + len)) : 0.99
+ *    Else if quality is DIFF_QUALITY_FAST and few line pairs match
+ *    (sparse_lcs_preferred()):
+ *      Use sparse LCS (Hunt-Szymanski), no VSCode equivalent
  *    Else:
  *      Use Myers O(ND) algorithm
  * 5. lineAlignments = optimizeSequenceDiffs(seq1, seq2, lineAlignments)
@@ -49,14 +56,27 @@
  * @param lines_b Modified file lines
  * @param len_b Number of lines in modified
  * @param timeout_ms Maximum milliseconds (0 = no timeout)
+ * @param rewrite_threshold Min shared-line ratio before skipping Myers (0 = disabled)
+ * @param quality DIFF_QUALITY_FAST never uses DP and may use sparse LCS; parity
+ *                follows VSCode (DP or Myers O(ND))
  * @param hit_timeout Output: set to true if timeout reached
+ * @param is_rewrite Output: set to true if the rewrite pre-check fired (can be NULL)
+ * @param stats Output: hashing / alignment / optimization times, algorithm and
+ *              D are written to it (can be NULL; other fields are untouched)
  * @return SequenceDiffArray* Line alignments (caller must free with free_sequence_diff_array)
  * 
  * NOTE: This is the consolidation of Steps 1-3, producing the exact same output
  * as VSCode's lineAlignments variable at line 245.
+ *
+ * Rewrite pre-check (no VSCode equivalent): if the sides have at least
+ * REWRITE_MIN_TOTAL_LINES lines and the multiset overlap of their trimmed line
+ * IDs (2 * shared / (len_a + len_b)) is below rewrite_threshold, Myers would
+ * run to D ~ len_a + len_b. The result is then a single whole-range diff.
  */
 SequenceDiffArray *compute_line_alignments(const char **lines_a, int len_a, const char **lines_b,
-                                           int len_b, int timeout_ms, bool *hit_timeout);
+                                           int len_b, int timeout_ms, double rewrite_threshold,
+                                           DiffQuality quality, bool *hit_timeout, bool *is_rewrite,
+                                           DiffStats *stats);
 
 /**
  * Helper: Free SequenceDiffArray
@@ -0,0 +1,94 @@
+#ifndef MINHASH_H
+#define MINHASH_H
+
+#include "default_lines_diff_computer.h"
+#include <stdbool.h>
+
+/**
+ * MinHash Similarity Index - Rename/Copy Candidate Pairing
+ *
+ * Pairs deleted ("original") files with added ("modified") files that are
+ * likely renames or copies, without running compute_diff() on every pair.
+ *
+ * Each file is reduced to a fixed-size MinHash signature over the set of its
+ * line IDs. Line IDs come from line_sequence_create() with a hash map shared
+ * by the whole index, so equal trimmed lines get the same ID across files
+ * (blank lines are skipped). Candidate pairs are found with LSH banding and
+ * then filtered by the estimated Jaccard similarity of their signatures.
+ *
+ * Cost: O(total_lines * MINHASH_SIGNATURE_SIZE) to build. A query sorts the
+ * files once per band and compares the files within each bucket pairwise;
+ * buckets larger than MINHASH_MAX_BUCKET_SIZE are skipped, so a query is
+ * O(MINHASH_BAND_COUNT * files * (log files + MINHASH_MAX_BUCKET_SIZE)).
+ * compute_diff() then only runs on the shortlisted pairs.
+ *
+ * No VSCode equivalent (VSCode relies on git's rename detection).
+ */
+
+#define MINHASH_SIGNATURE_SIZE 64
+#define MINHASH_BAND_COUNT 16
+#define MINHASH_ROWS_PER_BAND (MINHASH_SIGNATURE_SIZE / MINHASH_BAND_COUNT)
+// Files sharing one band value beyond which the bucket is ignored
+#define MINHASH_MAX_BUCKET_SIZE 64
+
+typedef struct MinHashIndex MinHashIndex;
+
+/**
+ * SimilarityCandidate - One likely original -> modified pairing
+ */
+typedef struct {
+  int original_id;   // ID returned by minhash_index_add() for the original file
+  int modified_id;   // ID returned by minhash_index_add() for the modified file
+  double similarity; // Estimated Jaccard similarity of the line sets (0.0 - 1.0)
+} SimilarityCandidate;
+
+typedef struct {
+  SimilarityCandidate *candidates;
+  int count;
+  int capacity;
+} SimilarityCandidateArray;
+
+/**
+ * Create an empty index.
+ *
+ * @return New index (caller must free with minhash_index_destroy()), or NULL
+ */
+DLL_EXPORT MinHashIndex *minhash_index_create(void);
+
+/**
+ * Add a file to the index and compute its signature.
+ *
+ * @param index Index to add to
+ * @param lines File lines (only read during this call)
+ * @param line_count Number of lines
+ * @param is_original true for the deleted/old side, false for the added/new side
+ * @return File ID (0, 1, 2, ... in insertion order), or -1 on error
+ */
+DLL_EXPORT int minhash_index_add(MinHashIndex *index, const char **lines, int line_count,
+                                 bool is_original);
+
+/**
+ * Find original/modified pairs whose estimated similarity is >= threshold.
+ *
+ * Results are sorted by descending similarity. Files without any non-blank
+ * line never produce candidates.
+ *
+ * @param index Index to query
+ * @param threshold Minimum estimated similarity (0.0 - 1.0)
+ * @return Candidate array (caller must free with similarity_candidate_array_free()),
+ *         or NULL on allocation failure
+ */
+DLL_EXPORT SimilarityCandidateArray *minhash_index_find_candidates(const MinHashIndex *index,
+                                                                   double threshold);
+
+/**
+ * Free a candidate array (can be NULL).
+ */
+DLL_EXPORT void similarity_candidate_array_free(SimilarityCandidateArray *arr);
+
+/**
+ * Free the index and all signatures (can be NULL).
+ */
+DLL_EXPORT void minhash_index_destroy(MinHashIndex *index);
+
+#endif // MINHASH_H
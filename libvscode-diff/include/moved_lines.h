@@ -0,0 +1,64 @@
+#ifndef MOVED_LINES_H
+#define MOVED_LINES_H
+
+#include "types.h"
+#include <stdbool.h>
+
+/**
+ * Moved Code Detection - VSCode computeMovedLines()
+ *
+ * Finds blocks that were deleted in one place and inserted in another, so a
+ * function moved between regions is reported as a move instead of a large
+ * delete + insert pair. Only lines inside changes participate.
+ *
+ * Pipeline (VSCode computeMovedLines.ts):
+ * 1. Simple deletions -> simple insertions: pure-delete and pure-insert
+ *    changes (>= 3 lines) whose character histograms are > 90% similar
+ * 2. Unchanged moves: index every MOVE_WINDOW_SIZE-line window of the
+ *    original changes by a rolling hash over trimmed line IDs, chain matching
+ *    windows in the modified changes, then greedily keep the longest chains
+ *    that don't overlap already accepted moves
+ * 3. Extend moves up/down over similar lines, join close consecutive moves,
+ *    drop trivial moves and moves that stay within the same change
+ *
+ * Differences from VSCode:
+ * - Window index is a sorted array + binary search instead of a string-keyed
+ *   map: O(n log n) over changed lines
+ * - Windows occurring more than MOVE_MAX_WINDOW_OCCURRENCES times in the
+ *   original (blank lines, lone braces) only extend existing chains and never
+ *   start new ones, bounding the candidate count on repetitive input
+ * - Step 1 similarities and step 2 chains are computed in parallel per change
+ *   (OpenMP); results are identical to the sequential order
+ * - MovedText carries no refined inner changes
+ *
+ * VSCode Reference:
+ * src/vs/editor/common/diff/defaultLinesDiffComputer/computeMovedLines.ts
+ */
+
+#define MOVE_WINDOW_SIZE 3
+#define MOVE_MAX_WINDOW_OCCURRENCES 64
+
+/**
+ * Compute moved blocks between the original and modified lines.
+ *
+ * @param changes Line-level changes from compute_diff()
+ * @param original_lines Original file lines
+ * @param original_count Number of original lines
+ * @param modified_lines Modified file lines
+ * @param modified_count Number of modified lines
+ * @param timeout Global deadline of the enclosing compute_diff()
+ * @param hit_timeout Output: set to true if the deadline passed (moves are then empty)
+ * @return Moves sorted by original start (caller must free with moved_text_array_free()),
+ *         or NULL on allocation failure
+ */
+MovedTextArray *compute_moved_lines(const DetailedLineRangeMappingArray *changes,
+                                    const char **original_lines, int original_count,
+                                    const char **modified_lines, int modified_count,
+                                    const Timeout *timeout, bool *hit_timeout);
+
+/**
+ * Free a MovedTextArray (can be NULL).
+ */
+void moved_text_array_free(MovedTextArray *arr);
+
+#endif // MOVED_LINES_H
@@ -0,0 +1,64 @@
+#ifndef REFINE_PARALLEL_H
+#define REFINE_PARALLEL_H
+
+#include "types.h"
+#include <stdint.h>
+
+/**
+ * Parallel Refinement Cutoff - serial vs. parallel character refinement
+ *
+ * Starting and joining an OpenMP team costs tens of microseconds, so a diff
+ * with a few short hunks is faster on one thread, while a large rewrite only
+ * scales up to the number of regions it has. The refinement loop therefore
+ * sizes its team from the work it is about to do rather than from the
+ * region count:
+ *
+ *   work units = characters in the changed regions (both sides)
+ *              + unchanged lines between them (whitespace scan)
+ *   workers    = min(max_threads, REFINE_MAX_THREADS, regions,
+ *                    work units / WORK_UNITS_PER_THREAD)
+ *
+ * and refines serially when the work is below MIN_WORK_UNITS or only one
+ * worker would be used. Both constants come from bench_threads, which sweeps
+ * 1..N threads over hunk count / size mixes. Move detection sizes its two
+ * parallel loops with the same function (see moved_lines.c for their units).
+ */
+
+// Below this much work, thread startup costs more than it saves
+#define REFINE_PARALLEL_MIN_WORK_UNITS (4 * 1024)
+// Each additional worker needs at least this much work to pay for itself
+#define REFINE_WORK_UNITS_PER_THREAD (2 * 1024)
+// Never use more workers than this, whatever OMP_NUM_THREADS allows; only
+// raise it once bench_threads shows gains past it on many-core machines
+#define REFINE_MAX_THREADS 8
+
+/**
+ * Estimate the refinement work of a set of line regions.
+ *
+ * @param regions Line regions (sorted, 0-based, end-exclusive)
+ * @param original_lines Original file lines
+ * @param modified_lines Modified file lines
+ * @return Work units (see above)
+ */
+int64_t refine_work_units(const SequenceDiffArray *regions, const char **original_lines,
+                          const char **modified_lines);
+
+/**
+ * Number of threads to refine with.
+ *
+ * @param work_units Result of refine_work_units()
+ * @param region_count Regions to refine (the unit of parallel work)
+ * @param max_threads Upper bound, e.g. omp_get_max_threads() (honors OMP_NUM_THREADS);
+ *                    further capped at REFINE_MAX_THREADS
+ * @return Worker count; 1 means refine serially
+ */
+int refine_worker_count(int64_t work_units, int region_count, int max_threads);
+
+/**
+ * Override the cutoff constants (process-wide, not thread-safe). Used by
+ * bench_threads to time every thread count; 0, 0 parallelizes everything and
+ * lifts the REFINE_MAX_THREADS cap. Negative values restore the defaults.
+ */
+void refine_set_parallel_cutoff(int64_t min_work_units, int64_t work_units_per_thread);
+
+#endif // REFINE_PARALLEL_H
@@ -0,0 +1,111 @@
+#ifndef REPRO_H
+#define REPRO_H
+
+#include "default_lines_diff_computer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Slow-Diff Reproducers - capture real-world slow inputs for offline replay
+ *
+ * When enabled, every compute_diff() call that takes at least the threshold
+ * writes a reproducer into the capture directory:
+ * - <stem>.original, <stem>.modified: the input lines joined with '\n'
+ * - <stem>.case: options, measured time, result summary and DiffStats
+ *   ("key = value" lines)
+ * where <stem> is "repro-<unix time>-<sequence>". `diff_tool --replay <dir>`
+ * re-runs every case in a directory with timing, so captured cases double as
+ * a benchmark corpus.
+ *
+ * Size limits keep capture from filling the disk: calls whose combined input
+ * exceeds max_input_bytes are skipped, and capture stops after max_cases
+ * reproducers in this process.
+ *
+ * Enabling:
+ * - diff_repro_enable(dir, threshold_ms, max_input_bytes, max_cases)
+ * - or set VSCODE_DIFF_REPRO_DIR=<existing dir> (limits from
+ *   VSCODE_DIFF_REPRO_MS and VSCODE_DIFF_REPRO_MAX_KB, defaults below);
+ *   read on the first compute_diff() call
+ *
+ * While capture is on, DiffStats are collected for every call (and cleared
+ * again from the result when the caller did not ask for them).
+ */
+
+#define DIFF_REPRO_ENV "VSCODE_DIFF_REPRO_DIR"
+#define DIFF_REPRO_MS_ENV "VSCODE_DIFF_REPRO_MS"
+#define DIFF_REPRO_MAX_KB_ENV "VSCODE_DIFF_REPRO_MAX_KB"
+#define DIFF_REPRO_DEFAULT_THRESHOLD_MS 1000.0
+#define DIFF_REPRO_DEFAULT_MAX_INPUT_BYTES (8LL * 1024 * 1024)
+#define DIFF_REPRO_DEFAULT_MAX_CASES 32
+#define DIFF_REPRO_CASE_EXT ".case"
+
+/**
+ * Start capturing slow calls into an existing directory.
+ *
+ * @param dir Capture directory (must exist; copied)
+ * @param threshold_ms Minimum compute_diff() wall time to capture
+ * @param max_input_bytes Skip calls whose original + modified text is larger (0 = no limit)
+ * @param max_cases Stop after this many reproducers in this process (0 = no limit)
+ * @return false if dir is NULL or too long
+ */
+DLL_EXPORT bool diff_repro_enable(const char *dir, double threshold_ms, int64_t max_input_bytes,
+                                  int max_cases);
+
+/**
+ * Stop capturing (already written reproducers are kept).
+ */
+DLL_EXPORT void diff_repro_disable(void);
+
+/**
+ * Number of reproducers written by this process.
+ */
+DLL_EXPORT int diff_repro_captured(void);
+
+// ============================================================================
+// Internal Capture / Replay API
+// ============================================================================
+
+extern volatile int diff_repro_active;
+
+/**
+ * Enable capture once per process if VSCODE_DIFF_REPRO_DIR is set.
+ */
+void diff_repro_init_from_env(void);
+
+/**
+ * Write a reproducer if elapsed_ms reaches the threshold and the limits allow.
+ *
+ * @param result compute_diff() result with stats filled (may be NULL)
+ * @return true if a reproducer was written
+ */
+bool diff_repro_maybe_capture(const char **original_lines, int original_count,
+                              const char **modified_lines, int modified_count,
+                              const DiffOptions *options, const LinesDiff *result,
+                              double elapsed_ms);
+
+/**
+ * Path of the .case file most recently written by this process ("" if none).
+ */
+const char *diff_repro_last_case(void);
+
+/**
+ * Options and measurements read back from a .case file.
+ */
+typedef struct {
+  DiffOptions options;
+  int original_count;
+  int modified_count;
+  double captured_ms; // compute_diff() wall time when captured
+  int changes;        // Line mappings in the captured result
+  bool hit_timeout;
+} DiffReproCase;
+
+/**
+ * Parse a .case file written by diff_repro_maybe_capture().
+ * Unknown keys are ignored, so newer captures still replay.
+ *
+ * @return false if the file cannot be read or has no options
+ */
+bool diff_repro_read_case(const char *case_path, DiffReproCase *out);
+
+#endif // REPRO_H
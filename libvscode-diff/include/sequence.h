@@ -171,6 +171,18 @@ ISequence *char_sequence_create(const char **lines, int start_line, int end_line
 ISequence *char_sequence_create_from_range(const char **lines, int line_count,
                                            const CharRange *range, bool consider_whitespace);
 
+/**
+ * Boundary score between two characters - VSCode Parity
+ *
+ * The CharSequence getBoundaryScore() for the position between prev_char and
+ * next_char (-1 = start/end of the sequence).
+ *
+ * VSCode: LinesSliceCharSequence.getBoundaryScore()
+ *
+ * REUSED BY: Step 4 whitespace-only fast path (char_level.c)
+ */
+int char_boundary_score(int prev_char, int next_char);
+
 /**
  * Offset preference for translate operations - VSCode Parity
  * 
@@ -0,0 +1,63 @@
+#ifndef SPARSE_LCS_H
+#define SPARSE_LCS_H
+
+#include "sequence.h"
+#include "types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Sparse LCS (Hunt-Szymanski) - Line Alignment for Inputs With Few Matches
+ *
+ * Myers O(ND) costs roughly D^2 steps, so a heavily rewritten file (D close
+ * to len_a + len_b) is quadratic even when almost no lines match. This engine
+ * only visits matching pairs: for each line of seq1 it walks the occurrences
+ * of the same line ID in seq2 and keeps, for every LCS length k, the smallest
+ * seq2 index that ends a common subsequence of length k (binary search).
+ *
+ * Cost: O((r + n) log n) time and O(r + n) memory, where r is the number of
+ * matching (i, j) pairs after the common prefix/suffix is stripped.
+ *
+ * The result is a longest common subsequence, so its line edit distance is
+ * the same as Myers'. On ties it may pick different lines than Myers, so
+ * compute_line_alignments() only uses it with DIFF_QUALITY_FAST; the optimize
+ * passes then shift and join the diffs as usual.
+ *
+ * No VSCode equivalent (VSCode always runs Myers O(ND) for large inputs).
+ */
+
+// Smaller inputs are cheap for Myers already
+#define SPARSE_LCS_MIN_TOTAL_LINES 200
+// Sparse is picked when its estimated cost is this many times below Myers'
+#define SPARSE_LCS_COST_FACTOR 4
+
+/**
+ * Decide whether the sparse engine beats Myers O(ND) for an input.
+ *
+ * Myers' cost is estimated from the lower bound D >= len_a + len_b - 2 * shared,
+ * the sparse engine's from the number of matching pairs.
+ *
+ * @param len_a Lines in the original
+ * @param len_b Lines in the modified
+ * @param shared Multiset overlap of the line IDs (upper bound of the LCS)
+ * @param matches Matching (i, j) pairs: sum over IDs of count_a * count_b
+ * @return true if sparse_lcs_diff_algorithm() should run instead of Myers
+ */
+bool sparse_lcs_preferred(int len_a, int len_b, int shared, int64_t matches);
+
+/**
+ * Hunt-Szymanski LCS diff over sequences of small integer IDs.
+ *
+ * @param seq1 First sequence; getElement() must return IDs below id_count
+ * @param seq2 Second sequence; same ID space as seq1
+ * @param id_count Number of distinct IDs (e.g. string_hash_map_size())
+ * @param timeout_ms Maximum milliseconds to run (0 = no timeout)
+ * @param hit_timeout Output: set to true if timeout was reached (the result is
+ *                    then a single whole-range diff, like Myers)
+ * @return Array of SequenceDiff structures (caller must free), NULL on
+ *         allocation failure
+ */
+SequenceDiffArray *sparse_lcs_diff_algorithm(const ISequence *seq1, const ISequence *seq2,
+                                             int id_count, int timeout_ms, bool *hit_timeout);
+
+#endif // SPARSE_LCS_H
@@ -0,0 +1,97 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "default_lines_diff_computer.h"
+#include <stdbool.h>
+
+/**
+ * Trace Events - Chrome/Perfetto timeline of a diff computation
+ *
+ * Opt-in recording of begin/end events for every pipeline stage (hashing,
+ * line alignment, optimization, refinement, conversion, moves) and for every
+ * refined region, tagged with the thread that ran it. The dump is Chrome
+ * trace-event JSON, viewable in chrome://tracing or ui.perfetto.dev, and shows
+ * per-thread load balance of the parallel refinement loop.
+ *
+ * Enabling:
+ * - diff_trace_enable(true), then diff_trace_dump(path) when done
+ * - or set VSCODE_DIFF_TRACE=<path>: tracing starts with the first
+ *   compute_diff() call and the trace is written to <path> at process exit
+ *
+ * Each thread records into its own fixed-size ring buffer (no locking on the
+ * hot path; the oldest events are overwritten once it is full). When tracing
+ * is off, every trace point costs one load and branch.
+ *
+ * Dumping or resetting while another thread is inside compute_diff() may
+ * capture partially written events.
+ */
+
+#define DIFF_TRACE_RING_CAPACITY 16384 // Events per thread
+#define DIFF_TRACE_ENV "VSCODE_DIFF_TRACE"
+
+/**
+ * Turn event recording on or off. Recorded events are kept until
+ * diff_trace_reset().
+ */
+DLL_EXPORT void diff_trace_enable(bool enabled);
+
+/**
+ * Discard all recorded events (buffers stay allocated for reuse).
+ */
+DLL_EXPORT void diff_trace_reset(void);
+
+/**
+ * Write all recorded events as Chrome trace-event JSON.
+ *
+ * @param path Output file
+ * @return true on success, false if the file could not be written
+ */
+DLL_EXPORT bool diff_trace_dump(const char *path);
+
+// ============================================================================
+// Internal Recording API
+// ============================================================================
+
+extern volatile int diff_trace_active;
+
+/**
+ * Enable tracing once per process if VSCODE_DIFF_TRACE is set.
+ */
+void diff_trace_init_from_env(void);
+
+/**
+ * Record one event on the calling thread's ring buffer.
+ *
+ * @param name Static string (stored by pointer, must outlive the dump)
+ * @param phase 'B' (begin) or 'E' (end)
+ * @param region Refined region index, or -1 for pipeline stages
+ * @param lines Lines covered: region size (original + modified) for refinement,
+ *              equal lines scanned for whitespace_scan; ignored when region < 0
+ */
+void diff_trace_record(const char *name, char phase, int region, int lines);
+
+#define DIFF_TRACE_BEGIN(name)                                                                     \
+  do {                                                                                             \
+    if (diff_trace_active)                                                                         \
+      diff_trace_record((name), 'B', -1, 0);                                                       \
+  } while (0)
+
+#define DIFF_TRACE_END(name)                                                                       \
+  do {                                                                                             \
+    if (diff_trace_active)                                                                         \
+      diff_trace_record((name), 'E', -1, 0);                                                       \
+  } while (0)
+
+#define DIFF_TRACE_BEGIN_REGION(name, region, lines)                                               \
+  do {                                                                                             \
+    if (diff_trace_active)                                                                         \
+      diff_trace_record((name), 'B', (region), (lines));                                           \
+  } while (0)
+
+#define DIFF_TRACE_END_REGION(name, region)                                                        \
+  do {                                                                                             \
+    if (diff_trace_active)                                                                         \
+      diff_trace_record((name), 'E', (region), 0);                                                 \
+  } while (0)
+
+#endif // TRACE_H
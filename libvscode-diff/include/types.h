@@ -103,6 +103,60 @@ typedef struct {
   int capacity;
 } MovedTextArray;
 
+/**
+ * DiffAlgorithm - Line-level algorithm chosen by compute_line_alignments()
+ */
+typedef enum {
+  DIFF_ALGORITHM_NONE = 0,    // No line alignment ran (trivial input)
+  DIFF_ALGORITHM_DP = 1,      // Dynamic programming (< 1700 total lines)
+  DIFF_ALGORITHM_MYERS = 2,   // Myers O(ND)
+  DIFF_ALGORITHM_REWRITE = 3, // Rewrite pre-check fired, no alignment
+  DIFF_ALGORITHM_SPARSE = 4,  // Hunt-Szymanski sparse LCS (few matching lines)
+} DiffAlgorithm;
+
+/**
+ * DiffStats - Per-stage instrumentation of one compute_diff() call
+ * Filled only when DiffOptions.collect_stats is set (zeroed otherwise).
+ * No VSCode equivalent.
+ *
+ * Stage times are wall-clock milliseconds. whitespace_scan_ms and
+ * char_refine_ms are summed over regions, so with parallel refinement they
+ * add up thread time and may exceed refine_ms (the wall time of both).
+ */
+typedef struct {
+  double hash_ms;           // Line hashing (perfect hash of trimmed lines)
+  double line_alignment_ms; // Myers / DP over line hashes
+  double line_optimize_ms;  // optimizeSequenceDiffs + removeVeryShortMatchingLines
+  double refine_ms;         // Whitespace scan + char refinement (wall)
+  double whitespace_scan_ms;
+  double char_refine_ms;
+  double conversion_ms;     // Range mappings -> line mappings
+  double moves_ms;          // Moved code detection (compute_moves only)
+  double total_ms;
+  int algorithm;            // DiffAlgorithm
+  int line_edit_distance;   // D: lines inserted + deleted by the raw line alignment
+  int refined_regions;      // Line regions passed to char refinement
+  int largest_region_lines; // Max original + modified lines of a refined region
+  int line_alignment_timeouts;
+  int whitespace_scan_timeouts; // Regions whose whitespace scan timed out
+  int char_refine_timeouts;     // Regions whose char refinement timed out
+  int moves_timeouts;
+  int64_t allocations; // Library allocations made by the call (its worker threads included)
+} DiffStats;
+
+/**
+ * DiffQuality - Parity vs approximate engines (DiffOptions.quality)
+ *
+ * DIFF_QUALITY_PARITY follows VSCode exactly. DIFF_QUALITY_FAST uses Myers
+ * O(ND) where VSCode uses the O(N*M) dynamic-programming alignment for small
+ * inputs (< 1700 lines, < 500 characters per refined region). Results may
+ * differ slightly; `bench_diff --divergence` measures by how much.
+ */
+typedef enum {
+  DIFF_QUALITY_PARITY = 0,
+  DIFF_QUALITY_FAST = 1,
+} DiffQuality;
+
 /**
  * DiffOptions - Configuration for diff computation
  * Maps to VSCode's ILinesDiffComputerOptions.
@@ -110,8 +164,12 @@ typedef struct {
 typedef struct {
   bool ignore_trim_whitespace; // If true, ignore leading/trailing whitespace
   int max_computation_time_ms; // 0 = infinite timeout
-  bool compute_moves;          // If true, compute moved blocks (not implemented yet)
+  bool compute_moves;          // If true, compute moved blocks (see moved_lines.h)
   bool extend_to_subwords;     // If true, extend diffs to subword boundaries
+  double rewrite_threshold;    // Min shared-line ratio (0.0 - 1.0) below which the
+                               // file is a rewrite and Myers is skipped (0 = disabled)
+  bool collect_stats;          // If true, fill LinesDiff.stats (see DiffStats)
+  int quality;                 // DiffQuality (0 = VSCode parity)
 } DiffOptions;
 
 /**
@@ -122,6 +180,19 @@ typedef struct {
   DetailedLineRangeMappingArray changes;
   MovedTextArray moves;
   bool hit_timeout;
+  bool is_rewrite; // Sides share fewer lines than rewrite_threshold: one whole-file change
+  DiffStats stats; // Per-stage instrumentation (only if options.collect_stats)
 } LinesDiff;
 
+/**
+ * DiffLineStats - Counting-only diff summary
+ * Output of compute_diff_stats(). No VSCode equivalent (used for +/- counts).
+ */
+typedef struct {
+  int inserted_lines; // Lines only present in modified
+  int deleted_lines;  // Lines only present in original
+  int modified_lines; // Lines paired inside a changed region (incl. whitespace-only)
+  bool hit_timeout;
+} DiffLineStats;
+
 #endif // DIFF_TYPES_H
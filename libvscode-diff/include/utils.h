@@ -2,9 +2,45 @@
 #define UTILS_H
 
 #include "types.h"
+#include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+// Most elements (lines, characters, array entries) the int-typed diff
+// structures can address. Larger inputs are rejected rather than wrapped.
+#define DIFF_MAX_ELEMENTS INT_MAX
+
+// Counting allocators: every library allocation goes through these so
+// DiffStats.allocations can report how many were made. Counts are per thread;
+// diff_allocation_count() is the calling thread's running total.
+void *diff_malloc(size_t size);
+void *diff_calloc(size_t count, size_t size);
+void *diff_realloc(void *ptr, size_t size);
+int64_t diff_allocation_count(void);
+
+// Parallel loops credit their workers' allocations to the thread that started
+// the loop, so its count covers the whole call:
+//   int64_t worker_allocations = 0;
+//   #pragma omp parallel for reduction(+: worker_allocations)
+//   for (...) {
+//     int64_t before = diff_allocation_count();
+//     ...
+//     worker_allocations += diff_worker_allocations(before);
+//   }
+//   diff_credit_allocations(worker_allocations);
+int64_t diff_worker_allocations(int64_t before);
+void diff_credit_allocations(int64_t count);
+
+// Overflow-checked size math: NULL / false instead of a wrapped size
+bool diff_size_mul(size_t count, size_t size, size_t *out);
+void *diff_malloc_array(size_t count, size_t size);
+void *diff_realloc_array(void *ptr, size_t count, size_t size);
+
+// Next capacity for a growing int-indexed array: initial when empty, else
+// doubled and clamped to DIFF_MAX_ELEMENTS; -1 once the array cannot grow
+int diff_grow_capacity(int capacity, int initial);
+
 // Memory management helpers
 void sequence_diff_array_free(SequenceDiffArray *arr);
 void range_mapping_array_free(RangeMappingArray *arr);
@@ -18,5 +54,6 @@ char *trim_string(const char *str);
 
 // Time utilities
 int64_t get_current_time_ms(void);
+double get_precise_time_ms(void); // Monotonic, sub-millisecond resolution (stage timings)
 
 #endif // UTILS_H
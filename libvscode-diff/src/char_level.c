@@ -15,6 +15,8 @@
 #include "optimize.h"
 #include "sequence.h"
 #include "types.h"
+#include "utf8_utils.h"
+#include "utils.h"
 #include <ctype.h>
 #include <limits.h>
 #include <math.h>
@@ -185,11 +187,11 @@ static RangeMapping line_range_mapping_to_range_mapping2(LineRange original, Lin
  * Create RangeMappingArray with initial capacity
  */
 static RangeMappingArray *create_range_mapping_array(int capacity) {
-  RangeMappingArray *arr = (RangeMappingArray *)malloc(sizeof(RangeMappingArray));
+  RangeMappingArray *arr = (RangeMappingArray *)diff_malloc(sizeof(RangeMappingArray));
   if (!arr)
     return NULL;
 
-  arr->mappings = (RangeMapping *)malloc(sizeof(RangeMapping) * (size_t)capacity);
+  arr->mappings = (RangeMapping *)diff_malloc(sizeof(RangeMapping) * (size_t)capacity);
   if (!arr->mappings) {
     free(arr);
     return NULL;
@@ -204,9 +206,11 @@ static RangeMappingArray *create_range_mapping_array(int capacity) {
  * Grow RangeMappingArray capacity
  */
 static bool grow_range_mapping_array(RangeMappingArray *arr) {
-  int new_capacity = arr->capacity * 2;
-  RangeMapping *new_mappings =
-      (RangeMapping *)realloc(arr->mappings, sizeof(RangeMapping) * (size_t)new_capacity);
+  int new_capacity = diff_grow_capacity(arr->capacity, 16);
+  if (new_capacity < 0)
+    return false;
+  RangeMapping *new_mappings = (RangeMapping *)diff_realloc_array(
+      arr->mappings, (size_t)new_capacity, sizeof(RangeMapping));
   if (!new_mappings)
     return false;
 
@@ -245,9 +249,9 @@ typedef struct {
  * Invert diffs to get equal mappings - VSCode SequenceDiff.invert()
  */
 static SequenceDiffArray *invert_diffs(const SequenceDiffArray *diffs, int length1, int length2) {
-  SequenceDiffArray *result = (SequenceDiffArray *)malloc(sizeof(SequenceDiffArray));
+  SequenceDiffArray *result = (SequenceDiffArray *)diff_malloc(sizeof(SequenceDiffArray));
   result->capacity = diffs->count + 2;
-  result->diffs = (SequenceDiff *)malloc(sizeof(SequenceDiff) * (size_t)result->capacity);
+  result->diffs = (SequenceDiff *)diff_malloc(sizeof(SequenceDiff) * (size_t)result->capacity);
   result->count = 0;
 
   int prev_end1 = 0;
@@ -283,9 +287,9 @@ static SequenceDiffArray *invert_diffs(const SequenceDiffArray *diffs, int lengt
  * Merge two sorted diff arrays - VSCode mergeSequenceDiffs()
  */
 static SequenceDiffArray *merge_diffs(SequenceDiffArray *arr1, SequenceDiffArray *arr2) {
-  SequenceDiffArray *result = (SequenceDiffArray *)malloc(sizeof(SequenceDiffArray));
+  SequenceDiffArray *result = (SequenceDiffArray *)diff_malloc(sizeof(SequenceDiffArray));
   result->capacity = arr1->count + arr2->count;
-  result->diffs = (SequenceDiff *)malloc(sizeof(SequenceDiff) * (size_t)result->capacity);
+  result->diffs = (SequenceDiff *)diff_malloc(sizeof(SequenceDiff) * (size_t)result->capacity);
   result->count = 0;
 
   int i1 = 0, i2 = 0;
@@ -443,9 +447,17 @@ static void scan_word(ScanWordContext *ctx, int offset1, int offset2,
 
   if (should_extend) {
     if (ctx->additional->count >= ctx->additional->capacity) {
-      ctx->additional->capacity *= 2;
-      ctx->additional->diffs = (SequenceDiff *)realloc(
-          ctx->additional->diffs, sizeof(SequenceDiff) * (size_t)ctx->additional->capacity);
+      int new_capacity = diff_grow_capacity(ctx->additional->capacity, 8);
+      SequenceDiff *new_diffs =
+          new_capacity < 0 ? NULL
+                           : (SequenceDiff *)diff_realloc_array(ctx->additional->diffs,
+                                                                (size_t)new_capacity,
+                                                                sizeof(SequenceDiff));
+      if (!new_diffs) {
+        return; // Word not extended: the unextended diff stays
+      }
+      ctx->additional->diffs = new_diffs;
+      ctx->additional->capacity = new_capacity;
     }
     ctx->additional->diffs[ctx->additional->count++] = word;
   }
@@ -464,9 +476,10 @@ static SequenceDiffArray *extend_diffs_to_entire_word(const CharSequence *seq1,
                                                       const SequenceDiffArray *diffs,
                                                       bool use_subwords, bool force) {
   SequenceDiffArray *equal_mappings = invert_diffs(diffs, seq1->length, seq2->length);
-  SequenceDiffArray *additional = (SequenceDiffArray *)malloc(sizeof(SequenceDiffArray));
+  SequenceDiffArray *additional = (SequenceDiffArray *)diff_malloc(sizeof(SequenceDiffArray));
   additional->capacity = 100;
-  additional->diffs = (SequenceDiff *)malloc(sizeof(SequenceDiff) * (size_t)additional->capacity);
+  additional->diffs =
+      (SequenceDiff *)diff_malloc(sizeof(SequenceDiff) * (size_t)additional->capacity);
   additional->count = 0;
 
   int last_offset1 = 0;
@@ -537,7 +550,8 @@ static SequenceDiffArray *remove_very_short_text(const CharSequence *seq1, const
 
   do {
     should_repeat = false;
-    SequenceDiff *result = (SequenceDiff *)malloc(sizeof(SequenceDiff) * (size_t)diffs->capacity);
+    SequenceDiff *result =
+        (SequenceDiff *)diff_malloc(sizeof(SequenceDiff) * (size_t)diffs->capacity);
     int result_count = 0;
 
     result[result_count++] = diffs->diffs[0];
@@ -642,7 +656,7 @@ static SequenceDiffArray *remove_very_short_text(const CharSequence *seq1, const
   } while (counter++ < 10 && should_repeat);
 
   // Second phase: Remove short prefixes/suffixes (VSCode's forEachWithNeighbors logic)
-  SequenceDiff *new_diffs = (SequenceDiff *)malloc(sizeof(SequenceDiff) * (size_t)(diffs->capacity + 10));
+  SequenceDiff *new_diffs = (SequenceDiff *)diff_malloc(sizeof(SequenceDiff) * (size_t)(diffs->capacity + 10));
   int new_count = 0;
 
   for (int i = 0; i < diffs->count; i++) {
@@ -783,6 +797,18 @@ static RangeMapping translate_diff_to_range(const CharSequence *seq1, const Char
 /**
  * Main refinement function - VSCode's refineDiff() - FULL PARITY
  */
+/**
+ * The whole region as one mapping, for regions that cannot be refined
+ * (more than DIFF_MAX_ELEMENTS characters). NULL only if out of memory.
+ */
+static RangeMappingArray *unrefined_region(const RangeMapping *base_range) {
+  RangeMappingArray *result = create_range_mapping_array(1);
+  if (result) {
+    add_range_mapping(result, base_range);
+  }
+  return result;
+}
+
 RangeMappingArray *refine_diff_char_level(const SequenceDiff *line_diff, const char **lines_a,
                                           int len_a, const char **lines_b, int len_b,
                                           const CharLevelOptions *options, bool *out_hit_timeout) {
@@ -814,7 +840,7 @@ RangeMappingArray *refine_diff_char_level(const SequenceDiff *line_diff, const c
       seq1_iface->destroy(seq1_iface);
     if (seq2_iface)
       seq2_iface->destroy(seq2_iface);
-    return NULL;
+    return unrefined_region(&base_range);
   }
 
   // Extract CharSequence from ISequence
@@ -833,7 +859,7 @@ RangeMappingArray *refine_diff_char_level(const SequenceDiff *line_diff, const c
   bool hit_timeout = false;
   SequenceDiffArray *diffs;
 
-  if (len1 + len2 < 500) {
+  if (len1 + len2 < 500 && !options->fast) {
     // Use DP algorithm for small character sequences
     diffs = myers_dp_diff_algorithm(seq1_iface, seq2_iface, options->timeout_ms, &hit_timeout, NULL, NULL);
   } else {
@@ -900,6 +926,131 @@ RangeMappingArray *refine_diff_char_level(const SequenceDiff *line_diff, const c
   return result;
 }
 
+// ============================================================================
+// Whitespace-Only Line Fast Path
+// ============================================================================
+
+// Longest whitespace run handled by the fast path; shift_diff_to_better_position()
+// moves a diff at most 99 positions, so longer runs may not reach the best boundary
+#define WHITESPACE_FAST_PATH_MAX_RUN 64
+
+// Characters stripped by trim_string() before line hashing
+static bool is_trim_whitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+static int whitespace_boundary_score(const char *line, int length, int offset) {
+  int prev_char = offset > 0 ? (unsigned char)line[offset - 1] : -1;
+  int next_char = offset < length ? (unsigned char)line[offset] : -1;
+  return char_boundary_score(prev_char, next_char);
+}
+
+static bool runs_share_char(const char *run_a, int len_a, const char *run_b, int len_b) {
+  for (int i = 0; i < len_a; i++) {
+    if (memchr(run_b, run_a[i], (size_t)len_b)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool run_is_uniform(const char *run, int len, char c) {
+  for (int i = 0; i < len; i++) {
+    if (run[i] != c) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool refine_whitespace_only_line(const char *line_a, const char *line_b, int line_number_a,
+                                 int line_number_b, RangeMapping *out_mapping) {
+  int len_a = (int)strlen(line_a);
+  int len_b = (int)strlen(line_b);
+
+  // Leading / trailing whitespace runs; an all-whitespace line is one leading run
+  int lead_a = 0, lead_b = 0, trail_a = 0, trail_b = 0;
+  while (lead_a < len_a && is_trim_whitespace(line_a[lead_a])) {
+    lead_a++;
+  }
+  while (lead_b < len_b && is_trim_whitespace(line_b[lead_b])) {
+    lead_b++;
+  }
+  while (lead_a + trail_a < len_a && is_trim_whitespace(line_a[len_a - 1 - trail_a])) {
+    trail_a++;
+  }
+  while (lead_b + trail_b < len_b && is_trim_whitespace(line_b[len_b - 1 - trail_b])) {
+    trail_b++;
+  }
+
+  int interior = len_a - lead_a - trail_a;
+  if (interior != len_b - lead_b - trail_b ||
+      memcmp(line_a + lead_a, line_b + lead_b, (size_t)interior) != 0) {
+    return false;
+  }
+
+  bool leading_changed = lead_a != lead_b || memcmp(line_a, line_b, (size_t)lead_a) != 0;
+  bool trailing_changed =
+      trail_a != trail_b || memcmp(line_a + len_a - trail_a, line_b + len_b - trail_b,
+                                   (size_t)trail_a) != 0;
+  // Both ends changed: the character diff may merge them across a short interior
+  if (leading_changed == trailing_changed) {
+    return false;
+  }
+
+  int run_start = leading_changed ? 0 : lead_a + interior; // Same byte offset on both sides
+  int run_a = leading_changed ? lead_a : trail_a;
+  int run_b = leading_changed ? lead_b : trail_b;
+  if (run_a > WHITESPACE_FAST_PATH_MAX_RUN || run_b > WHITESPACE_FAST_PATH_MAX_RUN) {
+    return false;
+  }
+
+  int start_a = run_start, end_a = run_start + run_a;
+  int start_b = run_start, end_b = run_start + run_b;
+  if (runs_share_char(line_a + run_start, run_a, line_b + run_start, run_b)) {
+    // Same repeated character ("    " -> "        "): a pure insertion or deletion that
+    // shiftSequenceDiffs() places at the best boundary, leftmost on ties
+    char c = line_a[run_start];
+    if ((c != ' ' && c != '\t') || !run_is_uniform(line_a + run_start, run_a, c) ||
+        !run_is_uniform(line_b + run_start, run_b, c)) {
+      return false;
+    }
+    const char *shorter = run_a < run_b ? line_a : line_b;
+    const char *longer = run_a < run_b ? line_b : line_a;
+    int shorter_len = run_a < run_b ? len_a : len_b;
+    int longer_len = run_a < run_b ? len_b : len_a;
+    int shared = run_a < run_b ? run_a : run_b;
+    int delta = abs(run_a - run_b);
+
+    int best_offset = run_start;
+    int best_score = -1;
+    for (int offset = run_start; offset <= run_start + shared; offset++) {
+      int score = whitespace_boundary_score(shorter, shorter_len, offset) +
+                  whitespace_boundary_score(longer, longer_len, offset) +
+                  whitespace_boundary_score(longer, longer_len, offset + delta);
+      if (score > best_score) {
+        best_score = score;
+        best_offset = offset;
+      }
+    }
+    start_a = start_b = best_offset;
+    end_a = best_offset + (run_a > run_b ? delta : 0);
+    end_b = best_offset + (run_b > run_a ? delta : 0);
+  }
+  // Otherwise the runs share no character: the whole run is replaced
+
+  // Columns are UTF-16 based; only the interior before a trailing run can be non-ASCII
+  int col_shift_a = leading_changed ? 0 : utf8_to_utf16_length(line_a) - len_a;
+  int col_shift_b = leading_changed ? 0 : utf8_to_utf16_length(line_b) - len_b;
+  out_mapping->original = (CharRange){.start_line = line_number_a,
+                                      .start_col = start_a + col_shift_a + 1,
+                                      .end_line = line_number_a,
+                                      .end_col = end_a + col_shift_a + 1};
+  out_mapping->modified = (CharRange){.start_line = line_number_b,
+                                      .start_col = start_b + col_shift_b + 1,
+                                      .end_line = line_number_b,
+                                      .end_col = end_b + col_shift_b + 1};
+  return true;
+}
+
 /**
  * Refine all line-level diffs - VSCode Parity
  */
@@ -0,0 +1,169 @@
+/**
+ * Flat Result Layout - writer and reader
+ *
+ * See flat_result.h for the layout.
+ */
+
+#include "flat_result.h"
+#include <string.h>
+
+static size_t align_up(size_t value) {
+  return (value + DIFF_FLAT_ALIGNMENT - 1) & ~(size_t)(DIFF_FLAT_ALIGNMENT - 1);
+}
+
+// Entries of an array for the given counts
+static int64_t array_entries(DiffFlatArray array, int64_t changes, int64_t inner, int64_t moves) {
+  if (array < DIFF_FLAT_CHANGE_INNER_OFFSET) {
+    return changes;
+  }
+  if (array == DIFF_FLAT_CHANGE_INNER_OFFSET) {
+    return changes + 1;
+  }
+  if (array < DIFF_FLAT_MOVE_ORIGINAL_START) {
+    return inner;
+  }
+  return moves;
+}
+
+/**
+ * Fill header counts and offsets.
+ *
+ * @return Total blob bytes, 0 if a count does not fit the layout
+ */
+static size_t plan_layout(int64_t changes, int64_t inner, int64_t moves, DiffFlatHeader *header) {
+  if (changes < 0 || inner < 0 || moves < 0 || changes >= INT32_MAX || inner > INT32_MAX ||
+      moves > INT32_MAX) {
+    return 0;
+  }
+  memset(header, 0, sizeof(*header));
+  header->magic = DIFF_FLAT_MAGIC;
+  header->version = DIFF_FLAT_VERSION;
+  header->header_bytes = (uint32_t)sizeof(DiffFlatHeader);
+  header->change_count = (int32_t)changes;
+  header->inner_count = (int32_t)inner;
+  header->move_count = (int32_t)moves;
+
+  // At most 2^31 entries of 4 bytes per array: no overflow in 64 bits
+  uint64_t position = align_up(sizeof(DiffFlatHeader));
+  for (int a = 0; a < DIFF_FLAT_ARRAY_COUNT; a++) {
+    uint64_t bytes = (uint64_t)array_entries((DiffFlatArray)a, changes, inner, moves) *
+                     sizeof(int32_t);
+    header->offsets[a] = position;
+    position += (bytes + DIFF_FLAT_ALIGNMENT - 1) & ~(uint64_t)(DIFF_FLAT_ALIGNMENT - 1);
+  }
+#if SIZE_MAX < UINT64_MAX
+  if (position > SIZE_MAX) {
+    return 0;
+  }
+#endif
+  header->total_bytes = position;
+  return (size_t)position;
+}
+
+static int64_t total_inner_changes(const LinesDiff *diff) {
+  int64_t inner = 0;
+  for (int i = 0; i < diff->changes.count; i++) {
+    inner += diff->changes.mappings[i].inner_change_count;
+  }
+  return inner;
+}
+
+size_t diff_flat_size(const LinesDiff *diff) {
+  DiffFlatHeader header;
+  return plan_layout(diff->changes.count, total_inner_changes(diff), diff->moves.count, &header);
+}
+
+static int32_t *array_at(unsigned char *blob, const DiffFlatHeader *header, DiffFlatArray array) {
+  return (int32_t *)(void *)(blob + header->offsets[array]);
+}
+
+bool diff_flat_write(const LinesDiff *diff, void *region, size_t region_size, size_t offset,
+                     size_t *out_offset, size_t *out_length) {
+  DiffFlatHeader header;
+  size_t length = plan_layout(diff->changes.count, total_inner_changes(diff), diff->moves.count,
+                              &header);
+  size_t start = align_up(offset);
+  *out_offset = start;
+  *out_length = length;
+  if (length == 0 || start < offset || start > region_size || region_size - start < length) {
+    return false;
+  }
+
+  unsigned char *blob = (unsigned char *)region + start;
+  header.flags = (uint16_t)((diff->hit_timeout ? DIFF_FLAT_HIT_TIMEOUT : 0) |
+                            (diff->is_rewrite ? DIFF_FLAT_IS_REWRITE : 0));
+  memcpy(blob, &header, sizeof(header));
+
+  int32_t *original_start = array_at(blob, &header, DIFF_FLAT_CHANGE_ORIGINAL_START);
+  int32_t *original_end = array_at(blob, &header, DIFF_FLAT_CHANGE_ORIGINAL_END);
+  int32_t *modified_start = array_at(blob, &header, DIFF_FLAT_CHANGE_MODIFIED_START);
+  int32_t *modified_end = array_at(blob, &header, DIFF_FLAT_CHANGE_MODIFIED_END);
+  int32_t *inner_offset = array_at(blob, &header, DIFF_FLAT_CHANGE_INNER_OFFSET);
+  int32_t *inner[8];
+  for (int a = 0; a < 8; a++) {
+    inner[a] = array_at(blob, &header, (DiffFlatArray)(DIFF_FLAT_INNER_ORIGINAL_START_LINE + a));
+  }
+
+  int32_t next_inner = 0;
+  for (int i = 0; i < diff->changes.count; i++) {
+    const DetailedLineRangeMapping *change = &diff->changes.mappings[i];
+    original_start[i] = change->original.start_line;
+    original_end[i] = change->original.end_line;
+    modified_start[i] = change->modified.start_line;
+    modified_end[i] = change->modified.end_line;
+    inner_offset[i] = next_inner;
+    for (int k = 0; k < change->inner_change_count; k++, next_inner++) {
+      const RangeMapping *m = &change->inner_changes[k];
+      inner[0][next_inner] = m->original.start_line;
+      inner[1][next_inner] = m->original.start_col;
+      inner[2][next_inner] = m->original.end_line;
+      inner[3][next_inner] = m->original.end_col;
+      inner[4][next_inner] = m->modified.start_line;
+      inner[5][next_inner] = m->modified.start_col;
+      inner[6][next_inner] = m->modified.end_line;
+      inner[7][next_inner] = m->modified.end_col;
+    }
+  }
+  inner_offset[diff->changes.count] = next_inner;
+
+  int32_t *move_original_start = array_at(blob, &header, DIFF_FLAT_MOVE_ORIGINAL_START);
+  int32_t *move_original_end = array_at(blob, &header, DIFF_FLAT_MOVE_ORIGINAL_END);
+  int32_t *move_modified_start = array_at(blob, &header, DIFF_FLAT_MOVE_MODIFIED_START);
+  int32_t *move_modified_end = array_at(blob, &header, DIFF_FLAT_MOVE_MODIFIED_END);
+  for (int i = 0; i < diff->moves.count; i++) {
+    const MovedText *move = &diff->moves.moves[i];
+    move_original_start[i] = move->original.start_line;
+    move_original_end[i] = move->original.end_line;
+    move_modified_start[i] = move->modified.start_line;
+    move_modified_end[i] = move->modified.end_line;
+  }
+  return true;
+}
+
+const int32_t *diff_flat_array(const void *blob, size_t length, DiffFlatArray array,
+                               int *out_count) {
+  DiffFlatHeader header;
+  if (!blob || (uintptr_t)blob % DIFF_FLAT_ALIGNMENT != 0 || length < sizeof(header) ||
+      (int)array < 0 || array >= DIFF_FLAT_ARRAY_COUNT) {
+    return NULL;
+  }
+  memcpy(&header, blob, sizeof(header));
+  if (header.magic != DIFF_FLAT_MAGIC || header.version != DIFF_FLAT_VERSION ||
+      header.header_bytes != sizeof(header) || header.total_bytes > length) {
+    return NULL;
+  }
+
+  // Recompute the layout from the counts instead of trusting the offsets
+  DiffFlatHeader expected;
+  if (plan_layout(header.change_count, header.inner_count, header.move_count, &expected) !=
+          header.total_bytes ||
+      memcmp(expected.offsets, header.offsets, sizeof(header.offsets)) != 0) {
+    return NULL;
+  }
+
+  if (out_count) {
+    *out_count = (int)array_entries(array, header.change_count, header.inner_count,
+                                    header.move_count);
+  }
+  return (const int32_t *)(const void *)((const unsigned char *)blob + header.offsets[array]);
+}
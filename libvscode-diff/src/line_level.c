@@ -2,7 +2,8 @@
  * Line-Level Diff Computation (Steps 1-3 Consolidation) - FULL VSCODE PARITY
  * 
  * Consolidates:
- * - Step 1: Myers diff algorithm with perfect hashing
+ * - Step 1: Myers diff algorithm with perfect hashing (sparse LCS when few
+ *   lines match, see sparse_lcs.h)
  * - Step 2: optimizeSequenceDiffs (joinSequenceDiffsByShifting + shiftSequenceDiffs)
  * - Step 3: removeVeryShortMatchingLinesBetweenDiffs
  * 
@@ -17,7 +18,10 @@
 #include "myers.h"
 #include "optimize.h"
 #include "sequence.h"
+#include "sparse_lcs.h"
 #include "string_hash_map.h"
+#include "trace.h"
+#include "utils.h"
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -63,19 +67,67 @@ static double line_equality_score(const ISequence *seq1, const ISequence *seq2,
   return 0.99; // Non-matching lines get nearly 1.0 (high penalty)
 }
 
+/**
+ * How many lines the two sides can possibly match.
+ *
+ * shared: multiset overlap of trimmed line IDs (upper bound of the LCS)
+ * matches: matching (i, j) pairs, sum over IDs of count_a * count_b
+ *
+ * IDs are sequential perfect hashes, so counting arrays replace a map.
+ * Returns false if the counts could not be allocated.
+ */
+static bool line_match_profile(const LineSequence *a, const LineSequence *b, int id_count,
+                               int *shared, int64_t *matches) {
+  size_t slots = (size_t)(id_count > 0 ? id_count : 1);
+  int *counts = (int *)diff_calloc(slots, sizeof(int));
+  int *taken = (int *)diff_calloc(slots, sizeof(int));
+  if (!counts || !taken) {
+    free(counts);
+    free(taken);
+    return false;
+  }
+
+  for (int i = 0; i < a->length; i++) {
+    counts[a->trimmed_hash[i]]++;
+  }
+
+  *shared = 0;
+  *matches = 0;
+  for (int i = 0; i < b->length; i++) {
+    uint32_t id = b->trimmed_hash[i];
+    *matches += counts[id];
+    if (taken[id] < counts[id]) {
+      taken[id]++;
+      (*shared)++;
+    }
+  }
+
+  free(counts);
+  free(taken);
+  return true;
+}
+
 /**
  * compute_line_alignments() - VSCode Parity
  * 
  * Implements exact VSCode pipeline from defaultLinesDiffComputer.ts:224-245
  */
 SequenceDiffArray *compute_line_alignments(const char **lines_a, int len_a, const char **lines_b,
-                                           int len_b, int timeout_ms, bool *hit_timeout) {
+                                           int len_b, int timeout_ms, double rewrite_threshold,
+                                           DiffQuality quality, bool *hit_timeout, bool *is_rewrite,
+                                           DiffStats *stats) {
 
   if (!lines_a || !lines_b || !hit_timeout) {
     return NULL;
   }
 
   *hit_timeout = false;
+  if (is_rewrite) {
+    *is_rewrite = false;
+  }
+
+  double stage_start = stats ? get_precise_time_ms() : 0.0;
+  DIFF_TRACE_BEGIN("hash_lines");
 
   // Step 1: Create perfect hash map (VSCode line 68-75)
   StringHashMap *hash_map = string_hash_map_create();
@@ -89,21 +141,81 @@ SequenceDiffArray *compute_line_alignments(const char **lines_a, int len_a, cons
   ISequence *seq1 = line_sequence_create(lines_a, len_a, true, hash_map);
   ISequence *seq2 = line_sequence_create(lines_b, len_b, true, hash_map);
 
+  DIFF_TRACE_END("hash_lines");
+  DIFF_TRACE_BEGIN("line_alignment");
+  if (stats) {
+    double now = get_precise_time_ms();
+    stats->hash_ms = now - stage_start;
+    stage_start = now;
+  }
+
+  int total_lines = len_a + len_b;
+  bool use_dp = total_lines < 1700 && quality != DIFF_QUALITY_FAST;
+  int id_count = string_hash_map_size(hash_map);
+  int shared = 0;
+  int64_t matches = 0;
+  bool have_profile =
+      (rewrite_threshold > 0 || quality == DIFF_QUALITY_FAST) &&
+      total_lines >= REWRITE_MIN_TOTAL_LINES &&
+      line_match_profile((const LineSequence *)seq1->data, (const LineSequence *)seq2->data,
+                         id_count, &shared, &matches);
+
+  // Rewrite pre-check: skip Myers when the sides share almost no lines
+  if (rewrite_threshold > 0 && have_profile &&
+      2.0 * shared / (double)total_lines < rewrite_threshold) {
+    seq1->destroy(seq1);
+    seq2->destroy(seq2);
+    string_hash_map_destroy(hash_map);
+    DIFF_TRACE_END("line_alignment");
+
+    SequenceDiffArray *whole = (SequenceDiffArray *)diff_malloc(sizeof(SequenceDiffArray));
+    if (!whole) {
+      return NULL;
+    }
+    whole->diffs = (SequenceDiff *)diff_malloc(sizeof(SequenceDiff));
+    if (!whole->diffs) {
+      free(whole);
+      return NULL;
+    }
+    whole->diffs[0].seq1_start = 0;
+    whole->diffs[0].seq1_end = len_a;
+    whole->diffs[0].seq2_start = 0;
+    whole->diffs[0].seq2_end = len_b;
+    whole->count = 1;
+    whole->capacity = 1;
+
+    if (is_rewrite) {
+      *is_rewrite = true;
+    }
+    if (stats) {
+      stats->line_alignment_ms = get_precise_time_ms() - stage_start;
+      stats->algorithm = DIFF_ALGORITHM_REWRITE;
+      stats->line_edit_distance = len_a + len_b;
+    }
+    return whole;
+  }
+
   // Step 4: Run Myers diff with algorithm selection (VSCode line 83-97)
   SequenceDiffArray *line_alignments;
 
-  int total_lines = len_a + len_b;
-  if (total_lines < 1700) {
+  // Few matching pairs: Hunt-Szymanski instead of Myers (no VSCode equivalent).
+  // It can break ties differently from Myers, so only in fast mode.
+  bool use_sparse = !use_dp && quality == DIFF_QUALITY_FAST && have_profile &&
+                    sparse_lcs_preferred(len_a, len_b, shared, matches);
+  if (use_dp) {
     // Use DP algorithm with equality scoring for small files
     LineEqualityContext ctx = {.lines_a = lines_a, .lines_b = lines_b};
 
     line_alignments =
         myers_dp_diff_algorithm(seq1, seq2, timeout_ms, hit_timeout, line_equality_score, &ctx);
+  } else if (use_sparse) {
+    line_alignments = sparse_lcs_diff_algorithm(seq1, seq2, id_count, timeout_ms, hit_timeout);
   } else {
     // Use Myers O(ND) for large files
     line_alignments = myers_nd_diff_algorithm(seq1, seq2, timeout_ms, hit_timeout);
   }
 
+  DIFF_TRACE_END("line_alignment");
   if (!line_alignments) {
     seq1->destroy(seq1);
     seq2->destroy(seq2);
@@ -111,12 +223,32 @@ SequenceDiffArray *compute_line_alignments(const char **lines_a, int len_a, cons
     return NULL;
   }
 
+  DIFF_TRACE_BEGIN("line_optimize");
+  if (stats) {
+    double now = get_precise_time_ms();
+    stats->line_alignment_ms = now - stage_start;
+    stats->algorithm = use_dp       ? DIFF_ALGORITHM_DP
+                       : use_sparse ? DIFF_ALGORITHM_SPARSE
+                                    : DIFF_ALGORITHM_MYERS;
+    stats->line_edit_distance = 0;
+    for (int i = 0; i < line_alignments->count; i++) {
+      const SequenceDiff *d = &line_alignments->diffs[i];
+      stats->line_edit_distance += (d->seq1_end - d->seq1_start) + (d->seq2_end - d->seq2_start);
+    }
+    stage_start = now;
+  }
+
   // Step 5: Apply Step 2 optimization (VSCode line 244)
   line_alignments = optimize_sequence_diffs(seq1, seq2, line_alignments);
 
   // Step 6: Apply Step 3 optimization (VSCode line 245)
   line_alignments = remove_very_short_matching_lines_between_diffs(seq1, seq2, line_alignments);
 
+  DIFF_TRACE_END("line_optimize");
+  if (stats) {
+    stats->line_optimize_ms = get_precise_time_ms() - stage_start;
+  }
+
   // Cleanup sequences (but keep the result)
   seq1->destroy(seq1);
   seq2->destroy(seq2);
@@ -0,0 +1,358 @@
+/**
+ * MinHash Similarity Index Implementation
+ *
+ * Signatures: for each of MINHASH_SIGNATURE_SIZE independent hash functions,
+ * keep the minimum hash over the file's distinct line IDs. The fraction of
+ * equal slots between two signatures estimates the Jaccard similarity of the
+ * two line sets.
+ *
+ * LSH banding: the signature is split into MINHASH_BAND_COUNT bands of
+ * MINHASH_ROWS_PER_BAND slots. Two files become candidates if any band is
+ * identical. With 16 bands x 4 rows the detection curve 1 - (1 - s^4)^16
+ * crosses 50% at s ~= 0.45 (just below git's default 50% rename threshold)
+ * and exceeds 99% at s = 0.75.
+ */
+
+#include "minhash.h"
+#include "sequence.h"
+#include "string_hash_map.h"
+#include "utils.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  uint32_t signature[MINHASH_SIGNATURE_SIZE];
+  bool is_original;
+  bool has_lines; // false if the file has no non-blank line
+} FileSignature;
+
+struct MinHashIndex {
+  StringHashMap *hash_map; // Shared so line IDs are comparable across files
+  FileSignature *files;
+  int count;
+  int capacity;
+};
+
+// ============================================================================
+// Hashing Helpers
+// ============================================================================
+
+/**
+ * 32-bit integer finalizer (lowbias32) - cheap, well-distributed mixing
+ */
+static uint32_t mix32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+static uint32_t slot_seed(int slot) { return mix32((uint32_t)slot * 0x9e3779b9u + 0x85ebca6bu); }
+
+static bool is_blank_line(const char *line) {
+  while (*line) {
+    if (!isspace((unsigned char)*line)) {
+      return false;
+    }
+    line++;
+  }
+  return true;
+}
+
+// ============================================================================
+// Index Construction
+// ============================================================================
+
+MinHashIndex *minhash_index_create(void) {
+  MinHashIndex *index = (MinHashIndex *)diff_malloc(sizeof(MinHashIndex));
+  if (!index) {
+    return NULL;
+  }
+  index->hash_map = string_hash_map_create();
+  if (!index->hash_map) {
+    free(index);
+    return NULL;
+  }
+  index->files = NULL;
+  index->count = 0;
+  index->capacity = 0;
+  return index;
+}
+
+int minhash_index_add(MinHashIndex *index, const char **lines, int line_count,
+                      bool is_original) {
+  if (!index || (!lines && line_count > 0) || line_count < 0) {
+    return -1;
+  }
+
+  if (index->count >= index->capacity) {
+    int new_capacity = diff_grow_capacity(index->capacity, 16);
+    FileSignature *new_files =
+        new_capacity < 0 ? NULL
+                         : (FileSignature *)diff_realloc_array(index->files, (size_t)new_capacity,
+                                                               sizeof(FileSignature));
+    if (!new_files) {
+      return -1;
+    }
+    index->files = new_files;
+    index->capacity = new_capacity;
+  }
+
+  FileSignature *file = &index->files[index->count];
+  file->is_original = is_original;
+  file->has_lines = false;
+  for (int slot = 0; slot < MINHASH_SIGNATURE_SIZE; slot++) {
+    file->signature[slot] = UINT32_MAX;
+  }
+
+  // Same trimmed perfect hashing as compute_line_alignments()
+  ISequence *seq = line_sequence_create(lines, line_count, true, index->hash_map);
+  if (!seq) {
+    return -1;
+  }
+  const LineSequence *line_seq = (const LineSequence *)seq->data;
+
+  uint32_t seeds[MINHASH_SIGNATURE_SIZE];
+  for (int slot = 0; slot < MINHASH_SIGNATURE_SIZE; slot++) {
+    seeds[slot] = slot_seed(slot);
+  }
+
+  for (int i = 0; i < line_count; i++) {
+    if (is_blank_line(lines[i])) {
+      continue;
+    }
+    file->has_lines = true;
+
+    uint32_t base = mix32(line_seq->trimmed_hash[i] + 1);
+    for (int slot = 0; slot < MINHASH_SIGNATURE_SIZE; slot++) {
+      uint32_t h = mix32(base ^ seeds[slot]);
+      if (h < file->signature[slot]) {
+        file->signature[slot] = h;
+      }
+    }
+  }
+
+  seq->destroy(seq);
+  return index->count++;
+}
+
+// ============================================================================
+// LSH Query
+// ============================================================================
+
+typedef struct {
+  uint64_t key;
+  int file_id;
+} BandEntry;
+
+static int compare_band_entries(const void *a, const void *b) {
+  const BandEntry *ea = (const BandEntry *)a;
+  const BandEntry *eb = (const BandEntry *)b;
+  if (ea->key != eb->key) {
+    return ea->key < eb->key ? -1 : 1;
+  }
+  return ea->file_id - eb->file_id;
+}
+
+static int compare_u64(const void *a, const void *b) {
+  uint64_t va = *(const uint64_t *)a;
+  uint64_t vb = *(const uint64_t *)b;
+  return va < vb ? -1 : (va > vb ? 1 : 0);
+}
+
+static int compare_candidates(const void *a, const void *b) {
+  const SimilarityCandidate *ca = (const SimilarityCandidate *)a;
+  const SimilarityCandidate *cb = (const SimilarityCandidate *)b;
+  if (ca->similarity != cb->similarity) {
+    return ca->similarity > cb->similarity ? -1 : 1;
+  }
+  if (ca->original_id != cb->original_id) {
+    return ca->original_id - cb->original_id;
+  }
+  return ca->modified_id - cb->modified_id;
+}
+
+static uint64_t band_key(const FileSignature *file, int band) {
+  uint64_t key = 1469598103934665603ull; // FNV-1a offset basis
+  const uint32_t *rows = &file->signature[band * MINHASH_ROWS_PER_BAND];
+  for (int r = 0; r < MINHASH_ROWS_PER_BAND; r++) {
+    key ^= rows[r];
+    key *= 1099511628211ull;
+  }
+  return key;
+}
+
+static double estimate_similarity(const FileSignature *a, const FileSignature *b) {
+  int equal = 0;
+  for (int slot = 0; slot < MINHASH_SIGNATURE_SIZE; slot++) {
+    if (a->signature[slot] == b->signature[slot]) {
+      equal++;
+    }
+  }
+  return (double)equal / MINHASH_SIGNATURE_SIZE;
+}
+
+static bool push_pair(uint64_t **pairs, int *count, int *capacity, int original_id,
+                      int modified_id) {
+  if (*count >= *capacity) {
+    int new_capacity = diff_grow_capacity(*capacity, 64);
+    uint64_t *new_pairs =
+        new_capacity < 0
+            ? NULL
+            : (uint64_t *)diff_realloc_array(*pairs, (size_t)new_capacity, sizeof(uint64_t));
+    if (!new_pairs) {
+      return false;
+    }
+    *pairs = new_pairs;
+    *capacity = new_capacity;
+  }
+  (*pairs)[(*count)++] = ((uint64_t)(uint32_t)original_id << 32) | (uint32_t)modified_id;
+  return true;
+}
+
+SimilarityCandidateArray *minhash_index_find_candidates(const MinHashIndex *index,
+                                                        double threshold) {
+  if (!index) {
+    return NULL;
+  }
+
+  SimilarityCandidateArray *result =
+      (SimilarityCandidateArray *)diff_malloc(sizeof(SimilarityCandidateArray));
+  if (!result) {
+    return NULL;
+  }
+  result->candidates = NULL;
+  result->count = 0;
+  result->capacity = 0;
+
+  BandEntry *entries = (BandEntry *)diff_malloc((size_t)(index->count > 0 ? index->count : 1) *
+                                           sizeof(BandEntry));
+  if (!entries) {
+    free(result);
+    return NULL;
+  }
+
+  uint64_t *pairs = NULL;
+  int pair_count = 0;
+  int pair_capacity = 0;
+  bool ok = true;
+
+  // Collect pairs that share at least one identical band
+  for (int band = 0; band < MINHASH_BAND_COUNT && ok; band++) {
+    int entry_count = 0;
+    for (int i = 0; i < index->count; i++) {
+      if (index->files[i].has_lines) {
+        entries[entry_count].key = band_key(&index->files[i], band);
+        entries[entry_count].file_id = i;
+        entry_count++;
+      }
+    }
+    qsort(entries, (size_t)entry_count, sizeof(BandEntry), compare_band_entries);
+
+    int group_start = 0;
+    while (group_start < entry_count && ok) {
+      int group_end = group_start + 1;
+      while (group_end < entry_count && entries[group_end].key == entries[group_start].key) {
+        group_end++;
+      }
+
+      // A band shared by many files (license header, generated boilerplate) says
+      // little about any one pair; real renames also share other bands
+      if (group_end - group_start > MINHASH_MAX_BUCKET_SIZE) {
+        group_start = group_end;
+        continue;
+      }
+      for (int a = group_start; a < group_end && ok; a++) {
+        const FileSignature *fa = &index->files[entries[a].file_id];
+        if (!fa->is_original) {
+          continue;
+        }
+        for (int b = group_start; b < group_end && ok; b++) {
+          if (!index->files[entries[b].file_id].is_original) {
+            ok = push_pair(&pairs, &pair_count, &pair_capacity, entries[a].file_id,
+                           entries[b].file_id);
+          }
+        }
+      }
+      group_start = group_end;
+    }
+  }
+
+  free(entries);
+
+  if (!ok) {
+    free(pairs);
+    free(result);
+    return NULL;
+  }
+
+  // Deduplicate (a pair can collide in several bands) and filter by estimate
+  qsort(pairs, (size_t)pair_count, sizeof(uint64_t), compare_u64);
+
+  for (int i = 0; i < pair_count; i++) {
+    if (i > 0 && pairs[i] == pairs[i - 1]) {
+      continue;
+    }
+
+    int original_id = (int)(pairs[i] >> 32);
+    int modified_id = (int)(pairs[i] & 0xffffffffu);
+    double similarity =
+        estimate_similarity(&index->files[original_id], &index->files[modified_id]);
+    if (similarity < threshold) {
+      continue;
+    }
+
+    if (result->count >= result->capacity) {
+      int new_capacity = diff_grow_capacity(result->capacity, 16);
+      SimilarityCandidate *new_candidates =
+          new_capacity < 0 ? NULL
+                           : (SimilarityCandidate *)diff_realloc_array(
+                                 result->candidates, (size_t)new_capacity,
+                                 sizeof(SimilarityCandidate));
+      if (!new_candidates) {
+        free(pairs);
+        similarity_candidate_array_free(result);
+        return NULL;
+      }
+      result->candidates = new_candidates;
+      result->capacity = new_capacity;
+    }
+
+    SimilarityCandidate *candidate = &result->candidates[result->count++];
+    candidate->original_id = original_id;
+    candidate->modified_id = modified_id;
+    candidate->similarity = similarity;
+  }
+
+  free(pairs);
+
+  if (result->count > 1) {
+    qsort(result->candidates, (size_t)result->count, sizeof(SimilarityCandidate),
+          compare_candidates);
+  }
+
+  return result;
+}
+
+// ============================================================================
+// Cleanup
+// ============================================================================
+
+void similarity_candidate_array_free(SimilarityCandidateArray *arr) {
+  if (!arr)
+    return;
+  free(arr->candidates);
+  free(arr);
+}
+
+void minhash_index_destroy(MinHashIndex *index) {
+  if (!index)
+    return;
+  string_hash_map_destroy(index->hash_map);
+  free(index->files);
+  free(index);
+}
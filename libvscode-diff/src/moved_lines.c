@@ -0,0 +1,1137 @@
+/**
+ * Moved Code Detection Implementation
+ *
+ * All ranges are handled as 0-based half-open Spans internally and only
+ * converted to 1-based LineRanges when building the MovedTextArray.
+ *
+ * VSCode Reference:
+ * src/vs/editor/common/diff/defaultLinesDiffComputer/computeMovedLines.ts
+ */
+
+#include "moved_lines.h"
+#include "refine_parallel.h"
+#include "sequence.h"
+#include "string_hash_map.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+// Similarity above which a deleted block and an inserted block are a move (VSCode: 0.90)
+#define SIMPLE_MOVE_SIMILARITY 0.90
+// Lines longer than this on both sides are never "similar" (VSCode: 300)
+#define SIMILAR_LINE_MAX_LENGTH 300
+
+#define WINDOW_HASH_BASE 0x100000001b3ull // FNV-1a 64-bit prime
+
+typedef struct {
+  int start; // 0-indexed, inclusive
+  int end;   // 0-indexed, exclusive
+} Span;
+
+typedef struct {
+  Span *spans;
+  int count;
+  int capacity;
+} SpanList;
+
+typedef struct {
+  Span original;
+  Span modified;
+} SpanPair;
+
+typedef struct {
+  SpanPair *pairs;
+  int count;
+  int capacity;
+} SpanPairArray;
+
+typedef struct {
+  uint64_t key;
+  int line; // Start line of the window in the original
+} WindowEntry;
+
+typedef struct {
+  const char **original_lines;
+  int original_count;
+  const char **modified_lines;
+  int modified_count;
+  const uint32_t *original_ids; // Perfect hash of each trimmed line
+  const uint32_t *modified_ids;
+  const Timeout *timeout;
+} MoveContext;
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static bool timeout_is_valid(const Timeout *timeout) {
+  if (timeout->timeout_ms <= 0) {
+    return true;
+  }
+  return get_current_time_ms() - timeout->start_time_ms < timeout->timeout_ms;
+}
+
+static int span_length(Span span) { return span.end - span.start; }
+
+static bool span_list_push(SpanList *list, Span span) {
+  if (list->count >= list->capacity) {
+    int new_capacity = diff_grow_capacity(list->capacity, 8);
+    Span *new_spans =
+        new_capacity < 0
+            ? NULL
+            : (Span *)diff_realloc_array(list->spans, (size_t)new_capacity, sizeof(Span));
+    if (!new_spans) {
+      return false;
+    }
+    list->spans = new_spans;
+    list->capacity = new_capacity;
+  }
+  list->spans[list->count++] = span;
+  return true;
+}
+
+static bool span_pair_array_push(SpanPairArray *arr, Span original, Span modified) {
+  if (arr->count >= arr->capacity) {
+    int new_capacity = diff_grow_capacity(arr->capacity, 16);
+    SpanPair *new_pairs =
+        new_capacity < 0
+            ? NULL
+            : (SpanPair *)diff_realloc_array(arr->pairs, (size_t)new_capacity, sizeof(SpanPair));
+    if (!new_pairs) {
+      return false;
+    }
+    arr->pairs = new_pairs;
+    arr->capacity = new_capacity;
+  }
+  arr->pairs[arr->count].original = original;
+  arr->pairs[arr->count].modified = modified;
+  arr->count++;
+  return true;
+}
+
+static bool ensure_int_capacity(int **buffer, int *capacity, int needed) {
+  if (needed <= *capacity) {
+    return true;
+  }
+  int new_capacity = *capacity == 0 ? 16 : *capacity;
+  while (new_capacity >= 0 && new_capacity < needed) {
+    new_capacity = diff_grow_capacity(new_capacity, 16);
+  }
+  if (new_capacity < 0) {
+    return false;
+  }
+  int *new_buffer = (int *)diff_realloc_array(*buffer, (size_t)new_capacity, sizeof(int));
+  if (!new_buffer) {
+    return false;
+  }
+  *buffer = new_buffer;
+  *capacity = new_capacity;
+  return true;
+}
+
+/**
+ * Last index i with spans[i].start < limit, or -1 (VSCode findLastMonotonous)
+ */
+static int last_span_starting_before(const Span *spans, int count, int limit) {
+  int lo = 0;
+  int hi = count;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (spans[mid].start < limit) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo - 1;
+}
+
+// ============================================================================
+// Span Set (VSCode LineRangeSet)
+// ============================================================================
+
+/**
+ * First index whose span ends at or after line.
+ */
+static int span_set_lower_bound(const SpanList *set, int line) {
+  int lo = 0;
+  int hi = set->count;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (set->spans[mid].end < line) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/**
+ * Add a span, merging with overlapping and touching spans.
+ */
+static bool span_set_add(SpanList *set, Span span) {
+  int first = span_set_lower_bound(set, span.start);
+  int last = first;
+  while (last < set->count && set->spans[last].start <= span.end) {
+    if (set->spans[last].start < span.start) {
+      span.start = set->spans[last].start;
+    }
+    if (set->spans[last].end > span.end) {
+      span.end = set->spans[last].end;
+    }
+    last++;
+  }
+
+  if (first == last) {
+    if (!span_list_push(set, span)) {
+      return false;
+    }
+    memmove(&set->spans[first + 1], &set->spans[first],
+            (size_t)(set->count - 1 - first) * sizeof(Span));
+    set->spans[first] = span;
+    return true;
+  }
+
+  set->spans[first] = span;
+  memmove(&set->spans[first + 1], &set->spans[last], (size_t)(set->count - last) * sizeof(Span));
+  set->count -= last - first - 1;
+  return true;
+}
+
+static bool span_set_contains(const SpanList *set, int line) {
+  int idx = span_set_lower_bound(set, line + 1);
+  return idx < set->count && set->spans[idx].start <= line;
+}
+
+/**
+ * Parts of span not covered by the set, shifted by delta (VSCode subtractFrom + getWithDelta).
+ */
+static bool span_set_subtract_from(const SpanList *set, Span span, int delta, SpanList *out) {
+  out->count = 0;
+  int cursor = span.start;
+  for (int i = span_set_lower_bound(set, span.start + 1);
+       i < set->count && set->spans[i].start < span.end; i++) {
+    if (set->spans[i].start > cursor) {
+      Span gap = {cursor + delta, set->spans[i].start + delta};
+      if (!span_list_push(out, gap)) {
+        return false;
+      }
+    }
+    if (set->spans[i].end > cursor) {
+      cursor = set->spans[i].end;
+    }
+  }
+  if (cursor < span.end) {
+    Span gap = {cursor + delta, span.end + delta};
+    return span_list_push(out, gap);
+  }
+  return true;
+}
+
+static bool span_list_intersect(const SpanList *a, const SpanList *b, SpanList *out) {
+  out->count = 0;
+  int i = 0;
+  int j = 0;
+  while (i < a->count && j < b->count) {
+    Span s = {a->spans[i].start > b->spans[j].start ? a->spans[i].start : b->spans[j].start,
+              a->spans[i].end < b->spans[j].end ? a->spans[i].end : b->spans[j].end};
+    if (s.start < s.end && !span_list_push(out, s)) {
+      return false;
+    }
+    if (a->spans[i].end < b->spans[j].end) {
+      i++;
+    } else {
+      j++;
+    }
+  }
+  return true;
+}
+
+// ============================================================================
+// Step 1: Simple Deletions -> Simple Insertions
+// ============================================================================
+
+/**
+ * Character histogram of a block (VSCode LineRangeFragment, bytes instead of UTF-16)
+ */
+typedef struct {
+  int histogram[256];
+  int total;
+} Fragment;
+
+static void fragment_init(Fragment *fragment, const char **lines, Span span) {
+  memset(fragment, 0, sizeof(Fragment));
+  for (int i = span.start; i < span.end; i++) {
+    for (const unsigned char *p = (const unsigned char *)lines[i]; *p; p++) {
+      fragment->histogram[*p]++;
+      fragment->total++;
+    }
+    fragment->histogram['\n']++;
+    fragment->total++;
+  }
+}
+
+static double fragment_similarity(const Fragment *a, const Fragment *b) {
+  int sum_differences = 0;
+  for (int i = 0; i < 256; i++) {
+    int diff = a->histogram[i] - b->histogram[i];
+    sum_differences += diff < 0 ? -diff : diff;
+  }
+  return 1.0 - (double)sum_differences / (double)(a->total + b->total);
+}
+
+/**
+ * Pair pure deletions with the most similar pure insertion.
+ *
+ * The best insertion per deletion is computed in parallel; the greedy pass
+ * (in deletion order, each insertion used at most once) only recomputes when
+ * its precomputed best was already taken, so the result matches VSCode.
+ *
+ * VSCode Reference: computeMovesFromSimpleDeletionsToSimpleInsertions()
+ */
+static bool compute_simple_moves(const MoveContext *ctx, const Span *orig_spans,
+                                 const Span *mod_spans, int change_count, bool *excluded,
+                                 SpanPairArray *moves, bool *timed_out) {
+  int *deletions = (int *)diff_malloc((size_t)(change_count > 0 ? change_count : 1) * sizeof(int));
+  int *insertions = (int *)diff_malloc((size_t)(change_count > 0 ? change_count : 1) * sizeof(int));
+  if (!deletions || !insertions) {
+    free(deletions);
+    free(insertions);
+    return false;
+  }
+
+  int deletion_count = 0;
+  int insertion_count = 0;
+  for (int i = 0; i < change_count; i++) {
+    if (span_length(mod_spans[i]) == 0 && span_length(orig_spans[i]) >= 3) {
+      deletions[deletion_count++] = i;
+    } else if (span_length(orig_spans[i]) == 0 && span_length(mod_spans[i]) >= 3) {
+      insertions[insertion_count++] = i;
+    }
+  }
+
+  if (deletion_count == 0 || insertion_count == 0) {
+    free(deletions);
+    free(insertions);
+    return true;
+  }
+
+  Fragment *fragments = (Fragment *)diff_malloc((size_t)(deletion_count + insertion_count) *
+                                           sizeof(Fragment));
+  int *best = (int *)diff_malloc((size_t)deletion_count * sizeof(int));
+  double *best_similarity = (double *)diff_malloc((size_t)deletion_count * sizeof(double));
+  bool *taken = (bool *)diff_calloc((size_t)insertion_count, sizeof(bool));
+  bool ok = fragments && best && best_similarity && taken;
+
+  if (ok) {
+    Fragment *deleted = fragments;
+    Fragment *inserted = fragments + deletion_count;
+    for (int d = 0; d < deletion_count; d++) {
+      fragment_init(&deleted[d], ctx->original_lines, orig_spans[deletions[d]]);
+    }
+    for (int n = 0; n < insertion_count; n++) {
+      fragment_init(&inserted[n], ctx->modified_lines, mod_spans[insertions[n]]);
+    }
+
+    int d;
+#ifdef USE_OPENMP
+    // Work units as in refinement: each pair compares two 256-bin histograms
+    int workers = refine_worker_count((int64_t)deletion_count * insertion_count * 256,
+                                      deletion_count, omp_get_max_threads());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(workers) if (workers > 1)
+#endif
+    for (d = 0; d < deletion_count; d++) {
+      best[d] = -1;
+      best_similarity[d] = -1.0;
+      for (int n = 0; n < insertion_count; n++) {
+        double similarity = fragment_similarity(&deleted[d], &inserted[n]);
+        if (similarity > best_similarity[d]) {
+          best_similarity[d] = similarity;
+          best[d] = n;
+        }
+      }
+    }
+
+    for (d = 0; d < deletion_count && ok; d++) {
+      int candidate = best[d];
+      double similarity = best_similarity[d];
+
+      if (candidate >= 0 && taken[candidate]) {
+        candidate = -1;
+        similarity = -1.0;
+        for (int n = 0; n < insertion_count; n++) {
+          if (taken[n]) {
+            continue;
+          }
+          double s = fragment_similarity(&deleted[d], &inserted[n]);
+          if (s > similarity) {
+            similarity = s;
+            candidate = n;
+          }
+        }
+      }
+
+      if (candidate >= 0 && similarity > SIMPLE_MOVE_SIMILARITY) {
+        taken[candidate] = true;
+        ok = span_pair_array_push(moves, orig_spans[deletions[d]],
+                                  mod_spans[insertions[candidate]]);
+        excluded[deletions[d]] = true;
+        excluded[insertions[candidate]] = true;
+      }
+
+      if (!timeout_is_valid(ctx->timeout)) {
+        *timed_out = true;
+        break;
+      }
+    }
+  }
+
+  free(deletions);
+  free(insertions);
+  free(fragments);
+  free(best);
+  free(best_similarity);
+  free(taken);
+  return ok;
+}
+
+// ============================================================================
+// Step 2: Unchanged Moves (Window Hash Index)
+// ============================================================================
+
+static uint64_t window_top_power(void) {
+  uint64_t power = 1;
+  for (int k = 1; k < MOVE_WINDOW_SIZE; k++) {
+    power *= WINDOW_HASH_BASE;
+  }
+  return power;
+}
+
+static uint64_t window_hash(const uint32_t *ids, int start) {
+  uint64_t hash = 0;
+  for (int k = 0; k < MOVE_WINDOW_SIZE; k++) {
+    hash = hash * WINDOW_HASH_BASE + ids[start + k] + 1;
+  }
+  return hash;
+}
+
+/**
+ * Slide a window hash from [start, start + k) to [start + 1, start + k + 1).
+ */
+static uint64_t window_hash_roll(uint64_t hash, uint64_t top_power, const uint32_t *ids,
+                                 int start) {
+  hash -= ((uint64_t)ids[start] + 1) * top_power;
+  return hash * WINDOW_HASH_BASE + ids[start + MOVE_WINDOW_SIZE] + 1;
+}
+
+static bool windows_equal(const uint32_t *a, int a_start, const uint32_t *b, int b_start) {
+  for (int k = 0; k < MOVE_WINDOW_SIZE; k++) {
+    if (a[a_start + k] != b[b_start + k]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static int compare_window_entries(const void *a, const void *b) {
+  const WindowEntry *ea = (const WindowEntry *)a;
+  const WindowEntry *eb = (const WindowEntry *)b;
+  if (ea->key != eb->key) {
+    return ea->key < eb->key ? -1 : 1;
+  }
+  return ea->line - eb->line;
+}
+
+static int window_lower_bound(const WindowEntry *index, int count, uint64_t key) {
+  int lo = 0;
+  int hi = count;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (index[mid].key < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/**
+ * Chain matching windows of one modified change into candidate mappings.
+ *
+ * A chain from the previous window is extended when the next original line
+ * has the same ID and belongs to the same change; every other occurrence of
+ * the window in the original starts a new chain. Active chains stay sorted
+ * by original end, so "already extended" is a merge instead of a scan.
+ *
+ * VSCode Reference: computeUnchangedMoves() lastMappings/nextMappings loop
+ */
+static bool collect_window_chains(const MoveContext *ctx, const WindowEntry *index,
+                                  int index_count, const int *orig_change, Span mod_span,
+                                  SpanPairArray *out, bool *timed_out) {
+  const uint64_t top_power = window_top_power();
+  int *last = NULL;
+  int *extended = NULL;
+  int *next = NULL;
+  int last_capacity = 0;
+  int extended_capacity = 0;
+  int next_capacity = 0;
+  int last_count = 0;
+  bool ok = true;
+  uint64_t key = 0;
+
+  for (int m = mod_span.start; m + MOVE_WINDOW_SIZE <= mod_span.end && ok; m++) {
+    key = m == mod_span.start ? window_hash(ctx->modified_ids, m)
+                              : window_hash_roll(key, top_power, ctx->modified_ids, m - 1);
+
+    if (((m - mod_span.start) & 1023) == 1023 && !timeout_is_valid(ctx->timeout)) {
+      *timed_out = true;
+      break;
+    }
+
+    // Extend chains ending right before this window
+    int extended_count = 0;
+    if (!ensure_int_capacity(&extended, &extended_capacity, last_count)) {
+      ok = false;
+      break;
+    }
+    for (int j = 0; j < last_count; j++) {
+      SpanPair *pair = &out->pairs[last[j]];
+      int oe = pair->original.end;
+      if (oe < ctx->original_count && orig_change[oe] >= 0 &&
+          orig_change[oe] == orig_change[oe - 1] &&
+          ctx->original_ids[oe] == ctx->modified_ids[m + MOVE_WINDOW_SIZE - 1]) {
+        pair->original.end++;
+        pair->modified.end++;
+        extended[extended_count++] = last[j];
+      }
+    }
+
+    int group_start = window_lower_bound(index, index_count, key);
+    int group_end = group_start;
+    while (group_end < index_count && index[group_end].key == key) {
+      group_end++;
+    }
+    int group_size = group_end - group_start;
+    bool start_chains = group_size <= MOVE_MAX_WINDOW_OCCURRENCES;
+
+    if (!ensure_int_capacity(&next, &next_capacity,
+                             extended_count + (start_chains ? group_size : 0))) {
+      ok = false;
+      break;
+    }
+
+    int next_count = 0;
+    int e = 0;
+    if (start_chains) {
+      for (int g = group_start; g < group_end && ok; g++) {
+        int o = index[g].line;
+        while (e < extended_count && out->pairs[extended[e]].original.end < o + MOVE_WINDOW_SIZE) {
+          next[next_count++] = extended[e++];
+        }
+        if (e < extended_count && out->pairs[extended[e]].original.end == o + MOVE_WINDOW_SIZE) {
+          next[next_count++] = extended[e++]; // This window already extended a chain
+          continue;
+        }
+        if (!windows_equal(ctx->original_ids, o, ctx->modified_ids, m)) {
+          continue; // Hash collision
+        }
+        Span original = {o, o + MOVE_WINDOW_SIZE};
+        Span modified = {m, m + MOVE_WINDOW_SIZE};
+        ok = span_pair_array_push(out, original, modified);
+        next[next_count++] = out->count - 1;
+      }
+    }
+    while (e < extended_count) {
+      next[next_count++] = extended[e++];
+    }
+
+    int *swap = last;
+    last = next;
+    next = swap;
+    int swap_capacity = last_capacity;
+    last_capacity = next_capacity;
+    next_capacity = swap_capacity;
+    last_count = next_count;
+  }
+
+  free(last);
+  free(extended);
+  free(next);
+  return ok;
+}
+
+typedef struct {
+  SpanPair pair;
+  int order; // Creation order, for a stable sort
+} MoveCandidate;
+
+static int compare_candidates_by_length(const void *a, const void *b) {
+  const MoveCandidate *ca = (const MoveCandidate *)a;
+  const MoveCandidate *cb = (const MoveCandidate *)b;
+  int la = span_length(ca->pair.modified);
+  int lb = span_length(cb->pair.modified);
+  if (la != lb) {
+    return lb - la;
+  }
+  return ca->order - cb->order;
+}
+
+static int compare_pairs_by_original(const void *a, const void *b) {
+  const SpanPair *pa = (const SpanPair *)a;
+  const SpanPair *pb = (const SpanPair *)b;
+  if (pa->original.start != pb->original.start) {
+    return pa->original.start - pb->original.start;
+  }
+  return pa->modified.start - pb->modified.start;
+}
+
+static int count_non_space(const char *line, char *out, int max_out) {
+  int count = 0;
+  for (; *line; line++) {
+    if (*line != ' ' && *line != '\t') {
+      if (out && count < max_out) {
+        out[count] = *line;
+      }
+      count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * VSCode areLinesSimilar(): equal when trimmed, or > 60% of the longer
+ * line's non-space characters are common (and it has > 10 of them).
+ *
+ * Uses an LCS over non-space bytes; the length bound on the shorter line
+ * keeps it at most 300 x 500.
+ */
+static bool lines_similar(const MoveContext *ctx, int orig_line, int mod_line) {
+  if (ctx->original_ids[orig_line] == ctx->modified_ids[mod_line]) {
+    return true;
+  }
+
+  const char *line1 = ctx->original_lines[orig_line];
+  const char *line2 = ctx->modified_lines[mod_line];
+  if (strlen(line1) > SIMILAR_LINE_MAX_LENGTH && strlen(line2) > SIMILAR_LINE_MAX_LENGTH) {
+    return false;
+  }
+
+  char a[512];
+  char b[512];
+  int len_a = count_non_space(line1, a, (int)sizeof(a));
+  int len_b = count_non_space(line2, b, (int)sizeof(b));
+  int longer = len_a > len_b ? len_a : len_b;
+  int shorter = len_a < len_b ? len_a : len_b;
+
+  // LCS <= shorter, so this rules out the pair without running the LCS
+  if (longer <= 10 || shorter <= 0.6 * longer || longer > (int)sizeof(a)) {
+    return false;
+  }
+
+  int row[513];
+  memset(row, 0, (size_t)(len_b + 1) * sizeof(int));
+  for (int i = 1; i <= len_a; i++) {
+    int diagonal = 0;
+    for (int j = 1; j <= len_b; j++) {
+      int above = row[j];
+      if (a[i - 1] == b[j - 1]) {
+        row[j] = diagonal + 1;
+      } else if (row[j - 1] > row[j]) {
+        row[j] = row[j - 1];
+      }
+      diagonal = above;
+    }
+  }
+
+  return (double)row[len_b] / longer > 0.6;
+}
+
+/**
+ * Grow each move over similar lines inside the changes it touches.
+ *
+ * VSCode Reference: computeUnchangedMoves() extendToTop/extendToBottom
+ */
+static bool extend_moves(const MoveContext *ctx, const Span *orig_spans, const Span *mod_spans,
+                         int change_count, SpanPairArray *moves, SpanList *original_set,
+                         SpanList *modified_set) {
+  if (moves->count > 1) {
+    qsort(moves->pairs, (size_t)moves->count, sizeof(SpanPair), compare_pairs_by_original);
+  }
+
+  for (int i = 0; i < moves->count; i++) {
+    SpanPair move = moves->pairs[i];
+
+    int first_orig = last_span_starting_before(orig_spans, change_count, move.original.start + 1);
+    int first_mod = last_span_starting_before(mod_spans, change_count, move.modified.start + 1);
+    int last_orig = last_span_starting_before(orig_spans, change_count, move.original.end);
+    int last_mod = last_span_starting_before(mod_spans, change_count, move.modified.end);
+    if (first_orig < 0 || first_mod < 0 || last_orig < 0 || last_mod < 0) {
+      continue;
+    }
+
+    int lines_above = move.original.start - orig_spans[first_orig].start;
+    if (move.modified.start - mod_spans[first_mod].start > lines_above) {
+      lines_above = move.modified.start - mod_spans[first_mod].start;
+    }
+    int lines_below = orig_spans[last_orig].end - move.original.end;
+    if (mod_spans[last_mod].end - move.modified.end > lines_below) {
+      lines_below = mod_spans[last_mod].end - move.modified.end;
+    }
+
+    int extend_to_top;
+    for (extend_to_top = 0; extend_to_top < lines_above; extend_to_top++) {
+      int orig_line = move.original.start - extend_to_top - 1;
+      int mod_line = move.modified.start - extend_to_top - 1;
+      if (orig_line < 0 || mod_line < 0) {
+        break;
+      }
+      if (span_set_contains(modified_set, mod_line) ||
+          span_set_contains(original_set, orig_line)) {
+        break;
+      }
+      if (!lines_similar(ctx, orig_line, mod_line)) {
+        break;
+      }
+    }
+
+    if (extend_to_top > 0) {
+      Span original = {move.original.start - extend_to_top, move.original.start};
+      Span modified = {move.modified.start - extend_to_top, move.modified.start};
+      if (!span_set_add(original_set, original) || !span_set_add(modified_set, modified)) {
+        return false;
+      }
+    }
+
+    int extend_to_bottom;
+    for (extend_to_bottom = 0; extend_to_bottom < lines_below; extend_to_bottom++) {
+      int orig_line = move.original.end + extend_to_bottom;
+      int mod_line = move.modified.end + extend_to_bottom;
+      if (orig_line >= ctx->original_count || mod_line >= ctx->modified_count) {
+        break;
+      }
+      if (span_set_contains(modified_set, mod_line) ||
+          span_set_contains(original_set, orig_line)) {
+        break;
+      }
+      if (!lines_similar(ctx, orig_line, mod_line)) {
+        break;
+      }
+    }
+
+    if (extend_to_bottom > 0) {
+      Span original = {move.original.end, move.original.end + extend_to_bottom};
+      Span modified = {move.modified.end, move.modified.end + extend_to_bottom};
+      if (!span_set_add(original_set, original) || !span_set_add(modified_set, modified)) {
+        return false;
+      }
+    }
+
+    moves->pairs[i].original.start -= extend_to_top;
+    moves->pairs[i].modified.start -= extend_to_top;
+    moves->pairs[i].original.end += extend_to_bottom;
+    moves->pairs[i].modified.end += extend_to_bottom;
+  }
+
+  return true;
+}
+
+/**
+ * VSCode Reference: computeUnchangedMoves()
+ */
+static bool compute_unchanged_moves(const MoveContext *ctx, const Span *orig_spans,
+                                    const Span *mod_spans, int change_count,
+                                    SpanPairArray *moves, bool *timed_out) {
+  int *orig_change = (int *)diff_malloc(
+      (size_t)(ctx->original_count > 0 ? ctx->original_count : 1) * sizeof(int));
+  if (!orig_change) {
+    return false;
+  }
+  for (int i = 0; i < ctx->original_count; i++) {
+    orig_change[i] = -1;
+  }
+
+  // Index every window that lies entirely inside one original change
+  int index_count = 0;
+  for (int c = 0; c < change_count; c++) {
+    for (int line = orig_spans[c].start; line < orig_spans[c].end; line++) {
+      orig_change[line] = c;
+    }
+    if (span_length(orig_spans[c]) >= MOVE_WINDOW_SIZE) {
+      index_count += span_length(orig_spans[c]) - MOVE_WINDOW_SIZE + 1;
+    }
+  }
+
+  WindowEntry *index =
+      (WindowEntry *)diff_malloc((size_t)(index_count > 0 ? index_count : 1) * sizeof(WindowEntry));
+  SpanPairArray *chains =
+      (SpanPairArray *)diff_calloc((size_t)(change_count > 0 ? change_count : 1),
+                                   sizeof(SpanPairArray));
+  int *chain_status =
+      (int *)diff_calloc((size_t)(change_count > 0 ? change_count : 1), sizeof(int));
+  if (!index || !chains || !chain_status) {
+    free(orig_change);
+    free(index);
+    free(chains);
+    free(chain_status);
+    return false;
+  }
+
+  const uint64_t top_power = window_top_power();
+  int entry = 0;
+  for (int c = 0; c < change_count; c++) {
+    uint64_t key = 0;
+    for (int o = orig_spans[c].start; o + MOVE_WINDOW_SIZE <= orig_spans[c].end; o++) {
+      key = o == orig_spans[c].start ? window_hash(ctx->original_ids, o)
+                                     : window_hash_roll(key, top_power, ctx->original_ids, o - 1);
+      index[entry].key = key;
+      index[entry].line = o;
+      entry++;
+    }
+  }
+  qsort(index, (size_t)index_count, sizeof(WindowEntry), compare_window_entries);
+
+  // Chains of different modified changes are independent (lastMappings resets per change)
+  // chain_status: 0 = ok, 1 = timed out, 2 = allocation failure
+  int c;
+  int64_t worker_allocations = 0;
+#ifdef USE_OPENMP
+  // Work units: one window lookup per modified line in the changes
+  int64_t window_lookups = 0;
+  for (c = 0; c < change_count; c++) {
+    window_lookups += span_length(mod_spans[c]);
+  }
+  int workers = refine_worker_count(window_lookups, change_count, omp_get_max_threads());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(workers) if (workers > 1) \
+    reduction(+ : worker_allocations)
+#endif
+  for (c = 0; c < change_count; c++) {
+    int64_t allocations_before = diff_allocation_count();
+    bool change_timed_out = false;
+    if (!collect_window_chains(ctx, index, index_count, orig_change, mod_spans[c], &chains[c],
+                               &change_timed_out)) {
+      chain_status[c] = 2;
+    } else if (change_timed_out) {
+      chain_status[c] = 1;
+    }
+    worker_allocations += diff_worker_allocations(allocations_before);
+  }
+  diff_credit_allocations(worker_allocations);
+
+  bool ok = true;
+  int candidate_count = 0;
+  for (c = 0; c < change_count; c++) {
+    if (chain_status[c] == 2) {
+      ok = false;
+    } else if (chain_status[c] == 1) {
+      *timed_out = true;
+    }
+    candidate_count += chains[c].count;
+  }
+
+  MoveCandidate *candidates = NULL;
+  if (ok && !*timed_out && candidate_count > 0) {
+    candidates = (MoveCandidate *)diff_malloc((size_t)candidate_count * sizeof(MoveCandidate));
+    ok = candidates != NULL;
+  }
+  if (candidates) {
+    int n = 0;
+    for (c = 0; c < change_count; c++) {
+      for (int i = 0; i < chains[c].count; i++) {
+        candidates[n].pair = chains[c].pairs[i];
+        candidates[n].order = n;
+        n++;
+      }
+    }
+  }
+
+  for (c = 0; c < change_count; c++) {
+    free(chains[c].pairs);
+  }
+  free(chains);
+  free(chain_status);
+  free(index);
+  free(orig_change);
+
+  if (!candidates) {
+    return ok;
+  }
+
+  // Greedily keep the longest chains, minus lines already claimed by a move
+  qsort(candidates, (size_t)candidate_count, sizeof(MoveCandidate), compare_candidates_by_length);
+
+  SpanList original_set = {NULL, 0, 0};
+  SpanList modified_set = {NULL, 0, 0};
+  SpanList modified_sections = {NULL, 0, 0};
+  SpanList original_sections = {NULL, 0, 0};
+  SpanList intersected = {NULL, 0, 0};
+  int first_new = moves->count;
+
+  for (int i = 0; i < candidate_count && ok; i++) {
+    const SpanPair *pair = &candidates[i].pair;
+    int delta = pair->modified.start - pair->original.start;
+
+    ok = span_set_subtract_from(&modified_set, pair->modified, 0, &modified_sections) &&
+         span_set_subtract_from(&original_set, pair->original, delta, &original_sections) &&
+         span_list_intersect(&modified_sections, &original_sections, &intersected);
+
+    for (int s = 0; s < intersected.count && ok; s++) {
+      Span modified = intersected.spans[s];
+      if (span_length(modified) < MOVE_WINDOW_SIZE) {
+        continue;
+      }
+      Span original = {modified.start - delta, modified.end - delta};
+      ok = span_pair_array_push(moves, original, modified) &&
+           span_set_add(&modified_set, modified) && span_set_add(&original_set, original);
+    }
+  }
+
+  free(candidates);
+
+  if (ok) {
+    SpanPairArray unchanged = {moves->pairs + first_new, moves->count - first_new, 0};
+    ok = extend_moves(ctx, orig_spans, mod_spans, change_count, &unchanged, &original_set,
+                      &modified_set);
+  }
+
+  free(original_set.spans);
+  free(modified_set.spans);
+  free(modified_sections.spans);
+  free(original_sections.spans);
+  free(intersected.spans);
+  return ok;
+}
+
+// ============================================================================
+// Step 3: Post-processing
+// ============================================================================
+
+/**
+ * VSCode Reference: joinCloseConsecutiveMoves()
+ */
+static void join_close_consecutive_moves(SpanPairArray *moves) {
+  if (moves->count == 0) {
+    return;
+  }
+  qsort(moves->pairs, (size_t)moves->count, sizeof(SpanPair), compare_pairs_by_original);
+
+  int count = 1;
+  for (int i = 1; i < moves->count; i++) {
+    SpanPair *last = &moves->pairs[count - 1];
+    const SpanPair *current = &moves->pairs[i];
+    int original_dist = current->original.start - last->original.end;
+    int modified_dist = current->modified.start - last->modified.end;
+
+    if (original_dist >= 0 && modified_dist >= 0 && original_dist + modified_dist <= 2) {
+      if (current->original.end > last->original.end) {
+        last->original.end = current->original.end;
+      }
+      if (current->modified.end > last->modified.end) {
+        last->modified.end = current->modified.end;
+      }
+      continue;
+    }
+    moves->pairs[count++] = *current;
+  }
+  moves->count = count;
+}
+
+static int trimmed_length(const char *line) {
+  const char *start = line;
+  while (*start == ' ' || *start == '\t' || *start == '\r' || *start == '\n' || *start == '\f' ||
+         *start == '\v') {
+    start++;
+  }
+  const char *end = start + strlen(start);
+  while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' ||
+                         end[-1] == '\n' || end[-1] == '\f' || end[-1] == '\v')) {
+    end--;
+  }
+  return (int)(end - start);
+}
+
+/**
+ * Moves must have >= 15 characters of trimmed text and >= 2 non-trivial lines.
+ */
+static bool is_significant_move(const MoveContext *ctx, const SpanPair *move) {
+  int text_length = 0;
+  int long_lines = 0;
+  for (int i = move->original.start; i < move->original.end; i++) {
+    int length = trimmed_length(ctx->original_lines[i]);
+    text_length += length + (i > move->original.start ? 1 : 0);
+    if (length >= 2) {
+      long_lines++;
+    }
+  }
+  return text_length >= 15 && long_lines >= 2;
+}
+
+// ============================================================================
+// Main Function
+// ============================================================================
+
+MovedTextArray *compute_moved_lines(const DetailedLineRangeMappingArray *changes,
+                                    const char **original_lines, int original_count,
+                                    const char **modified_lines, int modified_count,
+                                    const Timeout *timeout, bool *hit_timeout) {
+  MovedTextArray *result = (MovedTextArray *)diff_malloc(sizeof(MovedTextArray));
+  if (!result) {
+    return NULL;
+  }
+  result->moves = NULL;
+  result->count = 0;
+  result->capacity = 0;
+
+  if (!changes || changes->count == 0) {
+    return result;
+  }
+
+  int change_count = changes->count;
+  Span *orig_spans = (Span *)diff_malloc((size_t)change_count * sizeof(Span));
+  Span *mod_spans = (Span *)diff_malloc((size_t)change_count * sizeof(Span));
+  Span *filtered_orig = (Span *)diff_malloc((size_t)change_count * sizeof(Span));
+  Span *filtered_mod = (Span *)diff_malloc((size_t)change_count * sizeof(Span));
+  bool *excluded = (bool *)diff_calloc((size_t)change_count, sizeof(bool));
+  if (!orig_spans || !mod_spans || !filtered_orig || !filtered_mod || !excluded) {
+    free(orig_spans);
+    free(mod_spans);
+    free(filtered_orig);
+    free(filtered_mod);
+    free(excluded);
+    free(result);
+    return NULL;
+  }
+
+  for (int i = 0; i < change_count; i++) {
+    orig_spans[i].start = changes->mappings[i].original.start_line - 1;
+    orig_spans[i].end = changes->mappings[i].original.end_line - 1;
+    mod_spans[i].start = changes->mappings[i].modified.start_line - 1;
+    mod_spans[i].end = changes->mappings[i].modified.end_line - 1;
+  }
+
+  // Trimmed line IDs (same hashing as compute_line_alignments())
+  StringHashMap *hash_map = string_hash_map_create();
+  ISequence *original_seq =
+      hash_map ? line_sequence_create(original_lines, original_count, true, hash_map) : NULL;
+  ISequence *modified_seq =
+      hash_map ? line_sequence_create(modified_lines, modified_count, true, hash_map) : NULL;
+  if (!original_seq || !modified_seq) {
+    if (original_seq) {
+      original_seq->destroy(original_seq);
+    }
+    if (modified_seq) {
+      modified_seq->destroy(modified_seq);
+    }
+    string_hash_map_destroy(hash_map);
+    free(orig_spans);
+    free(mod_spans);
+    free(filtered_orig);
+    free(filtered_mod);
+    free(excluded);
+    free(result);
+    return NULL;
+  }
+
+  MoveContext ctx = {
+      .original_lines = original_lines,
+      .original_count = original_count,
+      .modified_lines = modified_lines,
+      .modified_count = modified_count,
+      .original_ids = ((const LineSequence *)original_seq->data)->trimmed_hash,
+      .modified_ids = ((const LineSequence *)modified_seq->data)->trimmed_hash,
+      .timeout = timeout,
+  };
+
+  SpanPairArray moves = {NULL, 0, 0};
+  bool timed_out = false;
+  bool ok = compute_simple_moves(&ctx, orig_spans, mod_spans, change_count, excluded, &moves,
+                                 &timed_out);
+
+  if (ok && !timed_out) {
+    int filtered_count = 0;
+    for (int i = 0; i < change_count; i++) {
+      if (!excluded[i]) {
+        filtered_orig[filtered_count] = orig_spans[i];
+        filtered_mod[filtered_count] = mod_spans[i];
+        filtered_count++;
+      }
+    }
+    ok = compute_unchanged_moves(&ctx, filtered_orig, filtered_mod, filtered_count, &moves,
+                                 &timed_out);
+  }
+
+  if (ok && !timed_out) {
+    join_close_consecutive_moves(&moves);
+
+    for (int i = 0; i < moves.count; i++) {
+      const SpanPair *move = &moves.pairs[i];
+      if (!is_significant_move(&ctx, move)) {
+        continue;
+      }
+
+      // Drop moves whose both ends fall in the same change (VSCode removeMovesInSameDiff)
+      int orig_change = last_span_starting_before(orig_spans, change_count, move->original.end);
+      int mod_change = last_span_starting_before(mod_spans, change_count, move->modified.end);
+      if (orig_change == mod_change && orig_change >= 0) {
+        continue;
+      }
+
+      if (result->count >= result->capacity) {
+        int new_capacity = diff_grow_capacity(result->capacity, 8);
+        MovedText *new_moves =
+            new_capacity < 0 ? NULL
+                             : (MovedText *)diff_realloc_array(result->moves, (size_t)new_capacity,
+                                                               sizeof(MovedText));
+        if (!new_moves) {
+          ok = false;
+          break;
+        }
+        result->moves = new_moves;
+        result->capacity = new_capacity;
+      }
+
+      MovedText *moved = &result->moves[result->count++];
+      moved->original.start_line = move->original.start + 1;
+      moved->original.end_line = move->original.end + 1;
+      moved->modified.start_line = move->modified.start + 1;
+      moved->modified.end_line = move->modified.end + 1;
+    }
+  }
+
+  // VSCode: if (!timeout.isValid()) return [];
+  if (timed_out) {
+    result->count = 0;
+    if (hit_timeout) {
+      *hit_timeout = true;
+    }
+  }
+
+  free(moves.pairs);
+  original_seq->destroy(original_seq);
+  modified_seq->destroy(modified_seq);
+  string_hash_map_destroy(hash_map);
+  free(orig_spans);
+  free(mod_spans);
+  free(filtered_orig);
+  free(filtered_mod);
+  free(excluded);
+
+  if (!ok) {
+    moved_text_array_free(result);
+    return NULL;
+  }
+  return result;
+}
+
+void moved_text_array_free(MovedTextArray *arr) {
+  if (!arr)
+    return;
+  free(arr->moves);
+  free(arr);
+}
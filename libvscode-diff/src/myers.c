@@ -26,6 +26,7 @@
 #include "myers.h"
 #include "sequence.h"
 #include "string_hash_map.h"
+#include "utils.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -49,25 +50,39 @@ typedef struct {
   int cols;
 } Array2D;
 
+// NULL if rows * cols doubles cannot be allocated (or the size overflows)
 static Array2D *array2d_create(int rows, int cols) {
-  Array2D *arr = (Array2D *)malloc(sizeof(Array2D));
+  size_t cells;
+  if (!diff_size_mul((size_t)rows, (size_t)cols, &cells)) {
+    return NULL;
+  }
+  Array2D *arr = (Array2D *)diff_malloc(sizeof(Array2D));
+  if (!arr) {
+    return NULL;
+  }
   arr->rows = rows;
   arr->cols = cols;
-  arr->data = (double *)calloc((size_t)(rows * cols), sizeof(double));
+  arr->data = (double *)diff_calloc(cells, sizeof(double));
+  if (!arr->data) {
+    free(arr);
+    return NULL;
+  }
   return arr;
 }
 
 static void array2d_free(Array2D *arr) {
-  free(arr->data);
-  free(arr);
+  if (arr) {
+    free(arr->data);
+    free(arr);
+  }
 }
 
 static double array2d_get(const Array2D *arr, int row, int col) {
-  return arr->data[row * arr->cols + col];
+  return arr->data[(size_t)row * (size_t)arr->cols + (size_t)col];
 }
 
 static void array2d_set(Array2D *arr, int row, int col, double value) {
-  arr->data[row * arr->cols + col] = value;
+  arr->data[(size_t)row * (size_t)arr->cols + (size_t)col] = value;
 }
 
 //==============================================================================
@@ -102,13 +117,13 @@ SequenceDiffArray *myers_dp_diff_algorithm(const ISequence *seq1, const ISequenc
 
   // Handle trivial cases
   if (len1 == 0 || len2 == 0) {
-    SequenceDiffArray *result = (SequenceDiffArray *)malloc(sizeof(SequenceDiffArray));
+    SequenceDiffArray *result = (SequenceDiffArray *)diff_malloc(sizeof(SequenceDiffArray));
     if (len1 == 0 && len2 == 0) {
       result->diffs = NULL;
       result->count = 0;
       result->capacity = 0;
     } else {
-      result->diffs = (SequenceDiff *)malloc(sizeof(SequenceDiff));
+      result->diffs = (SequenceDiff *)diff_malloc(sizeof(SequenceDiff));
       result->diffs[0].seq1_start = 0;
       result->diffs[0].seq1_end = len1;
       result->diffs[0].seq2_start = 0;
@@ -124,6 +139,13 @@ SequenceDiffArray *myers_dp_diff_algorithm(const ISequence *seq1, const ISequenc
   Array2D *directions =
       array2d_create(len1, len2); // Direction taken (1=horizontal, 2=vertical, 3=diagonal)
   Array2D *lengths = array2d_create(len1, len2); // Length of consecutive diagonals
+  if (!lcs_lengths || !directions || !lengths) {
+    // Matrices too large for memory: O(ND) finds an LCS without them
+    array2d_free(lcs_lengths);
+    array2d_free(directions);
+    array2d_free(lengths);
+    return myers_nd_diff_algorithm(seq1, seq2, timeout_ms, hit_timeout);
+  }
 
   // Timeout tracking
   clock_t start_time = clock();
@@ -148,8 +170,8 @@ SequenceDiffArray *myers_dp_diff_algorithm(const ISequence *seq1, const ISequenc
           array2d_free(directions);
           array2d_free(lengths);
 
-          SequenceDiffArray *result = (SequenceDiffArray *)malloc(sizeof(SequenceDiffArray));
-          result->diffs = (SequenceDiff *)malloc(sizeof(SequenceDiff));
+          SequenceDiffArray *result = (SequenceDiffArray *)diff_malloc(sizeof(SequenceDiffArray));
+          result->diffs = (SequenceDiff *)diff_malloc(sizeof(SequenceDiff));
           result->diffs[0].seq1_start = 0;
           result->diffs[0].seq1_end = len1;
           result->diffs[0].seq2_start = 0;
@@ -242,10 +264,10 @@ SequenceDiffArray *myers_dp_diff_algorithm(const ISequence *seq1, const ISequenc
   }
 
   // Second pass: build result
-  SequenceDiffArray *result = (SequenceDiffArray *)malloc(sizeof(SequenceDiffArray));
+  SequenceDiffArray *result = (SequenceDiffArray *)diff_malloc(sizeof(SequenceDiffArray));
   result->count = diff_count;
   result->capacity = diff_count;
-  result->diffs = diff_count > 0 ? (SequenceDiff *)malloc((size_t)diff_count * sizeof(SequenceDiff)) : NULL;
+  result->diffs = diff_count > 0 ? (SequenceDiff *)diff_malloc((size_t)diff_count * sizeof(SequenceDiff)) : NULL;
 
   s1 = len1 - 1;
   s2 = len2 - 1;
@@ -305,11 +327,11 @@ typedef struct {
 } IntArray;
 
 static IntArray *intarray_create(void) {
-  IntArray *arr = (IntArray *)malloc(sizeof(IntArray));
+  IntArray *arr = (IntArray *)diff_malloc(sizeof(IntArray));
   arr->pos_capacity = 10;
   arr->neg_capacity = 10;
-  arr->positive = (int *)calloc((size_t)arr->pos_capacity, sizeof(int));
-  arr->negative = (int *)calloc((size_t)arr->neg_capacity, sizeof(int));
+  arr->positive = (int *)diff_calloc((size_t)arr->pos_capacity, sizeof(int));
+  arr->negative = (int *)diff_calloc((size_t)arr->neg_capacity, sizeof(int));
   return arr;
 }
 
@@ -328,29 +350,42 @@ static int intarray_get(IntArray *arr, int idx) {
   }
 }
 
-static void intarray_set(IntArray *arr, int idx, int value) {
+// Grow a slot array so index fits, zeroing the new slots
+// Returns the grown array, or NULL with the old one still valid
+static void *grow_slots(void *slots, int *capacity, int index, size_t size) {
+  int new_cap = diff_grow_capacity(*capacity, 16);
+  while (new_cap >= 0 && index >= new_cap)
+    new_cap = diff_grow_capacity(new_cap, 16);
+  if (new_cap < 0)
+    return NULL;
+  char *grown = (char *)diff_realloc_array(slots, (size_t)new_cap, size);
+  if (!grown)
+    return NULL;
+  memset(grown + (size_t)*capacity * size, 0, (size_t)(new_cap - *capacity) * size);
+  *capacity = new_cap;
+  return grown;
+}
+
+static bool intarray_set(IntArray *arr, int idx, int value) {
   if (idx < 0) {
     int neg_idx = -idx - 1;
     if (neg_idx >= arr->neg_capacity) {
-      int new_cap = arr->neg_capacity * 2;
-      while (neg_idx >= new_cap)
-        new_cap *= 2;
-      arr->negative = (int *)realloc(arr->negative, (size_t)new_cap * sizeof(int));
-      memset(arr->negative + arr->neg_capacity, 0, (size_t)(new_cap - arr->neg_capacity) * sizeof(int));
-      arr->neg_capacity = new_cap;
+      int *grown = (int *)grow_slots(arr->negative, &arr->neg_capacity, neg_idx, sizeof(int));
+      if (!grown)
+        return false;
+      arr->negative = grown;
     }
     arr->negative[neg_idx] = value;
   } else {
     if (idx >= arr->pos_capacity) {
-      int new_cap = arr->pos_capacity * 2;
-      while (idx >= new_cap)
-        new_cap *= 2;
-      arr->positive = (int *)realloc(arr->positive, (size_t)new_cap * sizeof(int));
-      memset(arr->positive + arr->pos_capacity, 0, (size_t)(new_cap - arr->pos_capacity) * sizeof(int));
-      arr->pos_capacity = new_cap;
+      int *grown = (int *)grow_slots(arr->positive, &arr->pos_capacity, idx, sizeof(int));
+      if (!grown)
+        return false;
+      arr->positive = grown;
     }
     arr->positive[idx] = value;
   }
+  return true;
 }
 
 // Simple path structure to track snake paths
@@ -362,7 +397,7 @@ typedef struct SnakePath {
 } SnakePath;
 
 static SnakePath *snakepath_create(SnakePath *prev, int x, int y, int length) {
-  SnakePath *path = (SnakePath *)malloc(sizeof(SnakePath));
+  SnakePath *path = (SnakePath *)diff_malloc(sizeof(SnakePath));
   path->prev = prev;
   path->x = x;
   path->y = y;
@@ -387,11 +422,11 @@ typedef struct {
 } PathArray;
 
 static PathArray *patharray_create(void) {
-  PathArray *arr = (PathArray *)malloc(sizeof(PathArray));
+  PathArray *arr = (PathArray *)diff_malloc(sizeof(PathArray));
   arr->pos_capacity = 10;
   arr->neg_capacity = 10;
-  arr->positive = (SnakePath **)calloc((size_t)arr->pos_capacity, sizeof(SnakePath *));
-  arr->negative = (SnakePath **)calloc((size_t)arr->neg_capacity, sizeof(SnakePath *));
+  arr->positive = (SnakePath **)diff_calloc((size_t)arr->pos_capacity, sizeof(SnakePath *));
+  arr->negative = (SnakePath **)diff_calloc((size_t)arr->neg_capacity, sizeof(SnakePath *));
   return arr;
 }
 
@@ -411,31 +446,28 @@ static SnakePath *patharray_get(PathArray *arr, int idx) {
   }
 }
 
-static void patharray_set(PathArray *arr, int idx, SnakePath *value) {
+static bool patharray_set(PathArray *arr, int idx, SnakePath *value) {
   if (idx < 0) {
     int neg_idx = -idx - 1;
     if (neg_idx >= arr->neg_capacity) {
-      int new_cap = arr->neg_capacity * 2;
-      while (neg_idx >= new_cap)
-        new_cap *= 2;
-      arr->negative = (SnakePath **)realloc(arr->negative, (size_t)new_cap * sizeof(SnakePath *));
-      memset(arr->negative + arr->neg_capacity, 0,
-             (size_t)(new_cap - arr->neg_capacity) * sizeof(SnakePath *));
-      arr->neg_capacity = new_cap;
+      SnakePath **grown = (SnakePath **)grow_slots(arr->negative, &arr->neg_capacity, neg_idx,
+                                                   sizeof(SnakePath *));
+      if (!grown)
+        return false;
+      arr->negative = grown;
     }
     arr->negative[neg_idx] = value;
   } else {
     if (idx >= arr->pos_capacity) {
-      int new_cap = arr->pos_capacity * 2;
-      while (idx >= new_cap)
-        new_cap *= 2;
-      arr->positive = (SnakePath **)realloc(arr->positive, (size_t)new_cap * sizeof(SnakePath *));
-      memset(arr->positive + arr->pos_capacity, 0,
-             (size_t)(new_cap - arr->pos_capacity) * sizeof(SnakePath *));
-      arr->pos_capacity = new_cap;
+      SnakePath **grown =
+          (SnakePath **)grow_slots(arr->positive, &arr->pos_capacity, idx, sizeof(SnakePath *));
+      if (!grown)
+        return false;
+      arr->positive = grown;
     }
     arr->positive[idx] = value;
   }
+  return true;
 }
 
 // Helper: Get X position after following snake (diagonal matches)
@@ -451,6 +483,23 @@ static int myers_get_x_after_snake(const ISequence *seq_a, const ISequence *seq_
   return x;
 }
 
+// Free the search state and return the whole range as one diff
+// Used on timeout and when the diagonal arrays cannot grow
+static SequenceDiffArray *give_up(IntArray *V, PathArray *paths, int len_a, int len_b) {
+  intarray_free(V);
+  patharray_free(paths);
+
+  SequenceDiffArray *result = (SequenceDiffArray *)diff_malloc(sizeof(SequenceDiffArray));
+  result->diffs = (SequenceDiff *)diff_malloc(sizeof(SequenceDiff));
+  result->diffs[0].seq1_start = 0;
+  result->diffs[0].seq1_end = len_a;
+  result->diffs[0].seq2_start = 0;
+  result->diffs[0].seq2_end = len_b;
+  result->count = 1;
+  result->capacity = 1;
+  return result;
+}
+
 // Main Myers O(ND) Forward Algorithm
 // (Renamed from myers_diff_algorithm to myers_nd_diff_algorithm)
 SequenceDiffArray *myers_nd_diff_algorithm(const ISequence *seq1, const ISequence *seq2,
@@ -463,13 +512,13 @@ SequenceDiffArray *myers_nd_diff_algorithm(const ISequence *seq1, const ISequenc
 
   // Handle trivial cases
   if (len_a == 0 || len_b == 0) {
-    SequenceDiffArray *result = (SequenceDiffArray *)malloc(sizeof(SequenceDiffArray));
+    SequenceDiffArray *result = (SequenceDiffArray *)diff_malloc(sizeof(SequenceDiffArray));
     if (len_a == 0 && len_b == 0) {
       result->diffs = NULL;
       result->count = 0;
       result->capacity = 0;
     } else {
-      result->diffs = (SequenceDiff *)malloc(sizeof(SequenceDiff));
+      result->diffs = (SequenceDiff *)diff_malloc(sizeof(SequenceDiff));
       result->diffs[0].seq1_start = 0;
       result->diffs[0].seq1_end = len_a;
       result->diffs[0].seq2_start = 0;
@@ -484,7 +533,7 @@ SequenceDiffArray *myers_nd_diff_algorithm(const ISequence *seq1, const ISequenc
   PathArray *paths = patharray_create();
 
   int initial_x = myers_get_x_after_snake(seq1, seq2, 0, 0);
-  intarray_set(V, 0, initial_x);
+  intarray_set(V, 0, initial_x); // Index 0 always fits the initial capacity
   patharray_set(paths, 0, initial_x == 0 ? NULL : snakepath_create(NULL, 0, 0, initial_x));
 
   int d = 0;
@@ -506,20 +555,7 @@ SequenceDiffArray *myers_nd_diff_algorithm(const ISequence *seq1, const ISequenc
       if (elapsed > timeout_seconds) {
         if (hit_timeout)
           *hit_timeout = true;
-
-        // Return trivial diff (entire range changed)
-        intarray_free(V);
-        patharray_free(paths);
-
-        SequenceDiffArray *result = (SequenceDiffArray *)malloc(sizeof(SequenceDiffArray));
-        result->diffs = (SequenceDiff *)malloc(sizeof(SequenceDiff));
-        result->diffs[0].seq1_start = 0;
-        result->diffs[0].seq1_end = len_a;
-        result->diffs[0].seq2_start = 0;
-        result->diffs[0].seq2_end = len_b;
-        result->count = 1;
-        result->capacity = 1;
-        return result;
+        return give_up(V, paths, len_a, len_b);
       }
     }
 
@@ -542,14 +578,16 @@ SequenceDiffArray *myers_nd_diff_algorithm(const ISequence *seq1, const ISequenc
 
       // Follow snake (diagonal matches)
       int new_max_x = myers_get_x_after_snake(seq1, seq2, x, y);
-      intarray_set(V, k, new_max_x);
+      if (!intarray_set(V, k, new_max_x))
+        return give_up(V, paths, len_a, len_b);
 
       // Track path
       SnakePath *last_path =
           (x == max_x_top) ? patharray_get(paths, k + 1) : patharray_get(paths, k - 1);
       SnakePath *new_path =
           (new_max_x != x) ? snakepath_create(last_path, x, y, new_max_x - x) : last_path;
-      patharray_set(paths, k, new_path);
+      if (!patharray_set(paths, k, new_path))
+        return give_up(V, paths, len_a, len_b);
 
       // Check if we reached the end
       if (intarray_get(V, k) == len_a && intarray_get(V, k) - k == len_b) {
@@ -584,10 +622,10 @@ SequenceDiffArray *myers_nd_diff_algorithm(const ISequence *seq1, const ISequenc
   }
 
   // Allocate result
-  SequenceDiffArray *result = (SequenceDiffArray *)malloc(sizeof(SequenceDiffArray));
+  SequenceDiffArray *result = (SequenceDiffArray *)diff_malloc(sizeof(SequenceDiffArray));
   result->count = diff_count;
   result->capacity = diff_count;
-  result->diffs = diff_count > 0 ? (SequenceDiff *)malloc((size_t)diff_count * sizeof(SequenceDiff)) : NULL;
+  result->diffs = diff_count > 0 ? (SequenceDiff *)diff_malloc((size_t)diff_count * sizeof(SequenceDiff)) : NULL;
 
   // Fill result (in reverse order, then we'll reverse)
   int idx = diff_count - 1;
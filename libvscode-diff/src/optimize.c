@@ -116,7 +116,7 @@ static SequenceDiffArray *join_sequence_diffs_by_shifting(const ISequence *seq1,
   int len2 = seq2->getLength(seq2);
 
   // Result array for first pass (move left)
-  SequenceDiff *result1 = (SequenceDiff *)malloc((size_t)diffs->count * sizeof(SequenceDiff));
+  SequenceDiff *result1 = (SequenceDiff *)diff_malloc((size_t)diffs->count * sizeof(SequenceDiff));
   int result1_count = 0;
 
   result1[result1_count++] = diffs->diffs[0];
@@ -177,7 +177,7 @@ static SequenceDiffArray *join_sequence_diffs_by_shifting(const ISequence *seq1,
   }
 
   // Second pass: Move all diffs right and join if possible
-  SequenceDiff *result2 = (SequenceDiff *)malloc((size_t)result1_count * sizeof(SequenceDiff));
+  SequenceDiff *result2 = (SequenceDiff *)diff_malloc((size_t)result1_count * sizeof(SequenceDiff));
   int result2_count = 0;
 
   for (int i = 0; i < result1_count - 1; i++) {
@@ -413,7 +413,7 @@ SequenceDiffArray *remove_short_matches(const ISequence *seq1,
     return diffs;
   }
 
-  SequenceDiff *result = (SequenceDiff *)malloc((size_t)diffs->count * sizeof(SequenceDiff));
+  SequenceDiff *result = (SequenceDiff *)diff_malloc((size_t)diffs->count * sizeof(SequenceDiff));
   int result_count = 0;
 
   for (int i = 0; i < diffs->count; i++) {
@@ -486,7 +486,7 @@ SequenceDiffArray *remove_very_short_matching_lines_between_diffs(const ISequenc
     should_repeat = false;
 
     // Create result array
-    SequenceDiff *result = malloc(sizeof(SequenceDiff) * (size_t)diffs->capacity);
+    SequenceDiff *result = diff_malloc(sizeof(SequenceDiff) * (size_t)diffs->capacity);
     int result_count = 0;
 
     // Start with first diff
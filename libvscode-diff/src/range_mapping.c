@@ -9,6 +9,7 @@
  */
 
 #include "range_mapping.h"
+#include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -131,7 +132,7 @@ DetailedLineRangeMapping get_line_range_mapping(const RangeMapping *range_mappin
   result.modified.end_line = range_mapping->modified.end_line + 1 + line_end_delta;
 
   // Preserve inner character change
-  result.inner_changes = (RangeMapping *)malloc(sizeof(RangeMapping));
+  result.inner_changes = (RangeMapping *)diff_malloc(sizeof(RangeMapping));
   if (result.inner_changes) {
     result.inner_changes[0] = *range_mapping;
     result.inner_change_count = 1;
@@ -195,11 +196,11 @@ static bool should_group_detailed_mappings(const DetailedLineRangeMapping *a,
  * VSCode Parity: 100%
  */
 static GroupArray *group_adjacent_detailed_mappings(DetailedLineRangeMapping *items, int count) {
-  GroupArray *result = (GroupArray *)malloc(sizeof(GroupArray));
+  GroupArray *result = (GroupArray *)diff_malloc(sizeof(GroupArray));
   if (!result)
     return NULL;
 
-  result->groups = (Group *)malloc(sizeof(Group) * 8);
+  result->groups = (Group *)diff_malloc(sizeof(Group) * 8);
   result->count = 0;
   result->capacity = 8;
 
@@ -218,8 +219,11 @@ static GroupArray *group_adjacent_detailed_mappings(DetailedLineRangeMapping *it
     } else {
       // Start new group
       if (result->count >= result->capacity) {
-        result->capacity *= 2;
-        Group *new_groups = (Group *)realloc(result->groups, sizeof(Group) * (size_t)result->capacity);
+        int new_capacity = diff_grow_capacity(result->capacity, 16);
+        Group *new_groups =
+            new_capacity < 0
+                ? NULL
+                : (Group *)diff_realloc_array(result->groups, (size_t)new_capacity, sizeof(Group));
         if (!new_groups) {
           for (int j = 0; j < result->count; j++) {
             free(result->groups[j].items);
@@ -229,11 +233,12 @@ static GroupArray *group_adjacent_detailed_mappings(DetailedLineRangeMapping *it
           return NULL;
         }
         result->groups = new_groups;
+        result->capacity = new_capacity;
       }
 
       current_group = &result->groups[result->count++];
       current_group->items =
-          (DetailedLineRangeMapping *)malloc(sizeof(DetailedLineRangeMapping) * (size_t)(count - i));
+          (DetailedLineRangeMapping *)diff_malloc(sizeof(DetailedLineRangeMapping) * (size_t)(count - i));
       if (!current_group->items) {
         result->count--;
         break;
@@ -277,7 +282,7 @@ DetailedLineRangeMappingArray *line_range_mapping_from_range_mappings(
 
   if (!alignments || alignments->count == 0) {
     DetailedLineRangeMappingArray *result =
-        (DetailedLineRangeMappingArray *)malloc(sizeof(DetailedLineRangeMappingArray));
+        (DetailedLineRangeMappingArray *)diff_malloc(sizeof(DetailedLineRangeMappingArray));
     if (result) {
       result->mappings = NULL;
       result->count = 0;
@@ -288,7 +293,7 @@ DetailedLineRangeMappingArray *line_range_mapping_from_range_mappings(
 
   // Step 1: Convert each RangeMapping to DetailedLineRangeMapping
   DetailedLineRangeMapping *mapped =
-      (DetailedLineRangeMapping *)malloc(sizeof(DetailedLineRangeMapping) * (size_t)alignments->count);
+      (DetailedLineRangeMapping *)diff_malloc(sizeof(DetailedLineRangeMapping) * (size_t)alignments->count);
   if (!mapped)
     return NULL;
 
@@ -306,7 +311,7 @@ DetailedLineRangeMappingArray *line_range_mapping_from_range_mappings(
 
   // Step 3: Create result array
   DetailedLineRangeMappingArray *result =
-      (DetailedLineRangeMappingArray *)malloc(sizeof(DetailedLineRangeMappingArray));
+      (DetailedLineRangeMappingArray *)diff_malloc(sizeof(DetailedLineRangeMappingArray));
   if (!result) {
     for (int i = 0; i < groups->count; i++) {
       free(groups->groups[i].items);
@@ -318,7 +323,8 @@ DetailedLineRangeMappingArray *line_range_mapping_from_range_mappings(
   }
 
   result->mappings =
-      (DetailedLineRangeMapping *)malloc(sizeof(DetailedLineRangeMapping) * (size_t)groups->count);
+      (DetailedLineRangeMapping *)diff_malloc(sizeof(DetailedLineRangeMapping) *
+                                              (size_t)groups->count);
   result->count = 0;
   result->capacity = groups->count;
 
@@ -347,7 +353,7 @@ DetailedLineRangeMappingArray *line_range_mapping_from_range_mappings(
     change.modified = line_range_join(first->modified, last->modified);
 
     // Collect all inner changes from group
-    change.inner_changes = (RangeMapping *)malloc(sizeof(RangeMapping) * (size_t)g->count);
+    change.inner_changes = (RangeMapping *)diff_malloc(sizeof(RangeMapping) * (size_t)g->count);
     if (!change.inner_changes) {
       change.inner_change_count = 0;
     } else {
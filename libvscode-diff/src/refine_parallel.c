@@ -0,0 +1,55 @@
+/**
+ * Parallel Refinement Cutoff - work estimate and worker count
+ *
+ * See refine_parallel.h for the cost model.
+ */
+
+#include "refine_parallel.h"
+#include <limits.h>
+#include <string.h>
+
+static int64_t min_work_units = REFINE_PARALLEL_MIN_WORK_UNITS;
+static int64_t work_units_per_thread = REFINE_WORK_UNITS_PER_THREAD;
+static int thread_cap = REFINE_MAX_THREADS;
+
+static int64_t side_bytes(const char **lines, int start, int end) {
+  int64_t bytes = 0;
+  for (int i = start; i < end; i++) {
+    bytes += (int64_t)strlen(lines[i]);
+  }
+  return bytes;
+}
+
+int64_t refine_work_units(const SequenceDiffArray *regions, const char **original_lines,
+                          const char **modified_lines) {
+  int64_t work = 0;
+  int last_end = 0;
+  for (int i = 0; i < regions->count; i++) {
+    const SequenceDiff *d = &regions->diffs[i];
+    work += d->seq1_start - last_end;
+    work += side_bytes(original_lines, d->seq1_start, d->seq1_end);
+    work += side_bytes(modified_lines, d->seq2_start, d->seq2_end);
+    last_end = d->seq1_end;
+  }
+  return work;
+}
+
+int refine_worker_count(int64_t work_units, int region_count, int max_threads) {
+  if (work_units < min_work_units) {
+    return 1;
+  }
+  int64_t workers = max_threads < region_count ? max_threads : region_count;
+  if (workers > thread_cap) {
+    workers = thread_cap;
+  }
+  if (work_units_per_thread > 0 && work_units / work_units_per_thread < workers) {
+    workers = work_units / work_units_per_thread;
+  }
+  return workers > 1 ? (int)workers : 1;
+}
+
+void refine_set_parallel_cutoff(int64_t min_work, int64_t work_per_thread) {
+  min_work_units = min_work >= 0 ? min_work : REFINE_PARALLEL_MIN_WORK_UNITS;
+  work_units_per_thread = work_per_thread >= 0 ? work_per_thread : REFINE_WORK_UNITS_PER_THREAD;
+  thread_cap = min_work == 0 && work_per_thread == 0 ? INT_MAX : REFINE_MAX_THREADS;
+}
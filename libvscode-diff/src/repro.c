@@ -0,0 +1,237 @@
+/**
+ * Slow-Diff Reproducers - capture on slow calls, .case file parsing
+ *
+ * See repro.h for the public contract.
+ */
+
+#include "repro.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+volatile int diff_repro_active = 0;
+
+static char repro_dir[1024];
+static double repro_threshold_ms = DIFF_REPRO_DEFAULT_THRESHOLD_MS;
+static int64_t repro_max_input_bytes = DIFF_REPRO_DEFAULT_MAX_INPUT_BYTES;
+static int repro_max_cases = DIFF_REPRO_DEFAULT_MAX_CASES;
+static int repro_captured = 0;
+static char repro_last_case[1200];
+static int env_checked = 0;
+
+bool diff_repro_enable(const char *dir, double threshold_ms, int64_t max_input_bytes,
+                       int max_cases) {
+  if (!dir || !dir[0] || strlen(dir) >= sizeof(repro_dir)) {
+    return false;
+  }
+  memcpy(repro_dir, dir, strlen(dir) + 1);
+  repro_threshold_ms = threshold_ms;
+  repro_max_input_bytes = max_input_bytes;
+  repro_max_cases = max_cases;
+  diff_repro_active = 1;
+  return true;
+}
+
+void diff_repro_disable(void) { diff_repro_active = 0; }
+
+int diff_repro_captured(void) { return repro_captured; }
+
+const char *diff_repro_last_case(void) { return repro_last_case; }
+
+void diff_repro_init_from_env(void) {
+  if (env_checked) {
+    return;
+  }
+#ifdef USE_OPENMP
+#pragma omp critical(diff_repro)
+#endif
+  {
+    if (!env_checked) {
+      const char *dir = getenv(DIFF_REPRO_ENV);
+      if (dir && dir[0]) {
+        const char *ms = getenv(DIFF_REPRO_MS_ENV);
+        const char *max_kb = getenv(DIFF_REPRO_MAX_KB_ENV);
+        diff_repro_enable(dir, ms ? atof(ms) : DIFF_REPRO_DEFAULT_THRESHOLD_MS,
+                          max_kb ? (int64_t)atoll(max_kb) * 1024
+                                 : DIFF_REPRO_DEFAULT_MAX_INPUT_BYTES,
+                          DIFF_REPRO_DEFAULT_MAX_CASES);
+      }
+      env_checked = 1;
+    }
+  }
+}
+
+static int64_t input_bytes(const char **lines, int count) {
+  int64_t bytes = 0;
+  for (int i = 0; i < count; i++) {
+    bytes += (int64_t)strlen(lines[i]) + 1;
+  }
+  return bytes;
+}
+
+static bool file_exists(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file) {
+    fclose(file);
+    return true;
+  }
+  return false;
+}
+
+// Lines joined with '\n' (no trailing newline), so a split on '\n' gives back
+// exactly `count` lines
+static bool write_lines(const char *path, const char **lines, int count) {
+  FILE *out = fopen(path, "wb");
+  if (!out) {
+    return false;
+  }
+  for (int i = 0; i < count; i++) {
+    if (i > 0) {
+      fputc('\n', out);
+    }
+    fputs(lines[i], out);
+  }
+  bool ok = !ferror(out);
+  if (fclose(out) != 0) {
+    ok = false;
+  }
+  return ok;
+}
+
+static bool write_case(const char *path, const DiffOptions *options, int original_count,
+                       int modified_count, const LinesDiff *result, double elapsed_ms) {
+  FILE *out = fopen(path, "w");
+  if (!out) {
+    return false;
+  }
+  fprintf(out, "# vscode-diff slow-diff reproducer (replay: diff_tool --replay <dir>)\n");
+  fprintf(out, "version = %s\n", get_version());
+  fprintf(out, "captured_ms = %.3f\n", elapsed_ms);
+  fprintf(out, "ignore_trim_whitespace = %d\n", options->ignore_trim_whitespace ? 1 : 0);
+  fprintf(out, "max_computation_time_ms = %d\n", options->max_computation_time_ms);
+  fprintf(out, "compute_moves = %d\n", options->compute_moves ? 1 : 0);
+  fprintf(out, "extend_to_subwords = %d\n", options->extend_to_subwords ? 1 : 0);
+  fprintf(out, "rewrite_threshold = %.6f\n", options->rewrite_threshold);
+  fprintf(out, "quality = %d\n", options->quality);
+  fprintf(out, "original_lines = %d\n", original_count);
+  fprintf(out, "modified_lines = %d\n", modified_count);
+  if (result) {
+    const DiffStats *stats = &result->stats;
+    fprintf(out, "changes = %d\n", result->changes.count);
+    fprintf(out, "hit_timeout = %d\n", result->hit_timeout ? 1 : 0);
+    fprintf(out, "algorithm = %d\n", stats->algorithm);
+    fprintf(out, "line_edit_distance = %d\n", stats->line_edit_distance);
+    fprintf(out, "hash_ms = %.3f\n", stats->hash_ms);
+    fprintf(out, "line_alignment_ms = %.3f\n", stats->line_alignment_ms);
+    fprintf(out, "line_optimize_ms = %.3f\n", stats->line_optimize_ms);
+    fprintf(out, "refine_ms = %.3f\n", stats->refine_ms);
+    fprintf(out, "whitespace_scan_ms = %.3f\n", stats->whitespace_scan_ms);
+    fprintf(out, "char_refine_ms = %.3f\n", stats->char_refine_ms);
+    fprintf(out, "conversion_ms = %.3f\n", stats->conversion_ms);
+    fprintf(out, "moves_ms = %.3f\n", stats->moves_ms);
+    fprintf(out, "refined_regions = %d\n", stats->refined_regions);
+    fprintf(out, "largest_region_lines = %d\n", stats->largest_region_lines);
+  }
+  bool ok = !ferror(out);
+  if (fclose(out) != 0) {
+    ok = false;
+  }
+  return ok;
+}
+
+bool diff_repro_maybe_capture(const char **original_lines, int original_count,
+                              const char **modified_lines, int modified_count,
+                              const DiffOptions *options, const LinesDiff *result,
+                              double elapsed_ms) {
+  if (!diff_repro_active || elapsed_ms < repro_threshold_ms) {
+    return false;
+  }
+  if (repro_max_input_bytes > 0 &&
+      input_bytes(original_lines, original_count) + input_bytes(modified_lines, modified_count) >
+          repro_max_input_bytes) {
+    return false;
+  }
+
+  bool written = false;
+#ifdef USE_OPENMP
+#pragma omp critical(diff_repro)
+#endif
+  {
+    if (repro_max_cases <= 0 || repro_captured < repro_max_cases) {
+      char stem[1100];
+      char path[1200];
+      long long now = (long long)time(NULL);
+      int sequence = repro_captured;
+      // Never overwrite: another process may capture into the same directory
+      do {
+        snprintf(stem, sizeof(stem), "%s/repro-%lld-%d", repro_dir, now, sequence++);
+        snprintf(path, sizeof(path), "%s" DIFF_REPRO_CASE_EXT, stem);
+      } while (file_exists(path));
+
+      // The .case file is written last: replay only picks up complete cases
+      char original_path[1200];
+      char modified_path[1200];
+      snprintf(original_path, sizeof(original_path), "%s.original", stem);
+      snprintf(modified_path, sizeof(modified_path), "%s.modified", stem);
+      written = write_lines(original_path, original_lines, original_count) &&
+                write_lines(modified_path, modified_lines, modified_count) &&
+                write_case(path, options, original_count, modified_count, result, elapsed_ms);
+      if (written) {
+        repro_captured++;
+        memcpy(repro_last_case, path, strlen(path) + 1);
+      } else {
+        remove(original_path);
+        remove(modified_path);
+        remove(path);
+      }
+    }
+  }
+  return written;
+}
+
+bool diff_repro_read_case(const char *case_path, DiffReproCase *out) {
+  FILE *file = fopen(case_path, "r");
+  if (!file) {
+    return false;
+  }
+  memset(out, 0, sizeof(*out));
+  out->original_count = -1;
+  out->modified_count = -1;
+
+  char line[512];
+  char key[64];
+  double value;
+  bool has_options = false;
+  while (fgets(line, sizeof(line), file)) {
+    if (line[0] == '#' || sscanf(line, " %63[a-z_] = %lf", key, &value) != 2) {
+      continue;
+    }
+    if (strcmp(key, "captured_ms") == 0) {
+      out->captured_ms = value;
+    } else if (strcmp(key, "ignore_trim_whitespace") == 0) {
+      out->options.ignore_trim_whitespace = value != 0;
+    } else if (strcmp(key, "max_computation_time_ms") == 0) {
+      out->options.max_computation_time_ms = (int)value;
+      has_options = true;
+    } else if (strcmp(key, "compute_moves") == 0) {
+      out->options.compute_moves = value != 0;
+    } else if (strcmp(key, "extend_to_subwords") == 0) {
+      out->options.extend_to_subwords = value != 0;
+    } else if (strcmp(key, "rewrite_threshold") == 0) {
+      out->options.rewrite_threshold = value;
+    } else if (strcmp(key, "quality") == 0) {
+      out->options.quality = (int)value;
+    } else if (strcmp(key, "original_lines") == 0) {
+      out->original_count = (int)value;
+    } else if (strcmp(key, "modified_lines") == 0) {
+      out->modified_count = (int)value;
+    } else if (strcmp(key, "changes") == 0) {
+      out->changes = (int)value;
+    } else if (strcmp(key, "hit_timeout") == 0) {
+      out->hit_timeout = value != 0;
+    }
+  }
+  fclose(file);
+  return has_options && out->original_count >= 0 && out->modified_count >= 0;
+}
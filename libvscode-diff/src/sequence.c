@@ -17,6 +17,7 @@
 #include "string_hash_map.h"
 #include "utf8_utils.h"
 #include "utf8proc.h"
+#include "utils.h"
 #include <ctype.h>
 #include <limits.h>
 #include <stdint.h>
@@ -117,7 +118,7 @@ static int write_utf8_as_utf16_units(const char *src, int num_utf16_units, uint3
 /**
  * Create a trimmed copy of string (caller must free)
  */
-static char *trim_string(const char *str) {
+static char *trim_copy(const char *str) {
   if (!str)
     return diff_strdup("");
 
@@ -134,7 +135,7 @@ static char *trim_string(const char *str) {
 
   // Copy trimmed portion
   int len = (int)(end - str);
-  char *result = (char *)malloc((size_t)len + 1);
+  char *result = (char *)diff_malloc((size_t)len + 1);
   memcpy(result, str, (size_t)len);
   result[len] = '\0';
   return result;
@@ -240,7 +241,7 @@ static void line_seq_destroy(ISequence *self) {
  */
 ISequence *line_sequence_create(const char **lines, int length, bool ignore_whitespace,
                                 StringHashMap *hash_map) {
-  LineSequence *seq = (LineSequence *)malloc(sizeof(LineSequence));
+  LineSequence *seq = (LineSequence *)diff_malloc(sizeof(LineSequence));
   seq->lines = lines; // Just reference, not owned
   seq->length = length;
   seq->ignore_whitespace = ignore_whitespace;
@@ -253,10 +254,10 @@ ISequence *line_sequence_create(const char **lines, int length, bool ignore_whit
   }
 
   // Pre-compute perfect hashes for all lines
-  seq->trimmed_hash = (uint32_t *)malloc(sizeof(uint32_t) * (size_t)length);
+  seq->trimmed_hash = (uint32_t *)diff_malloc(sizeof(uint32_t) * (size_t)length);
   for (int i = 0; i < length; i++) {
     if (ignore_whitespace) {
-      char *trimmed = trim_string(lines[i]);
+      char *trimmed = trim_copy(lines[i]);
       seq->trimmed_hash[i] = string_hash_map_get_or_create(hash_map, trimmed);
       free(trimmed);
     } else {
@@ -270,7 +271,7 @@ ISequence *line_sequence_create(const char **lines, int length, bool ignore_whit
   }
 
   // Create ISequence wrapper
-  ISequence *iseq = (ISequence *)malloc(sizeof(ISequence));
+  ISequence *iseq = (ISequence *)diff_malloc(sizeof(ISequence));
   iseq->data = seq;
   iseq->getElement = line_seq_get_element;
   iseq->getLength = line_seq_get_length;
@@ -363,12 +364,7 @@ static int get_category_boundary_score(CharBoundaryCategory category) {
   return scores[category];
 }
 
-static int char_seq_get_boundary_score(const ISequence *self, int length) {
-  CharSequence *seq = (CharSequence *)self->data;
-
-  int prev_char = (length > 0) ? (int)seq->elements[length - 1] : -1;
-  int next_char = (length < seq->length) ? (int)seq->elements[length] : -1;
-
+int char_boundary_score(int prev_char, int next_char) {
   CharBoundaryCategory prev_category = get_char_category(prev_char);
   CharBoundaryCategory next_category = get_char_category(next_char);
 
@@ -402,6 +398,14 @@ static int char_seq_get_boundary_score(const ISequence *self, int length) {
   return score;
 }
 
+static int char_seq_get_boundary_score(const ISequence *self, int length) {
+  CharSequence *seq = (CharSequence *)self->data;
+
+  int prev_char = (length > 0) ? (int)seq->elements[length - 1] : -1;
+  int next_char = (length < seq->length) ? (int)seq->elements[length] : -1;
+  return char_boundary_score(prev_char, next_char);
+}
+
 static void char_seq_destroy(ISequence *self) {
   CharSequence *seq = (CharSequence *)self->data;
   free(seq->elements);
@@ -420,7 +424,7 @@ static void char_seq_destroy(ISequence *self) {
  * REUSED BY: Step 4 (char_level.c) for each line-level diff
  */
 static ISequence *char_sequence_create_empty(bool consider_whitespace) {
-  CharSequence *seq = (CharSequence *)malloc(sizeof(CharSequence));
+  CharSequence *seq = (CharSequence *)diff_malloc(sizeof(CharSequence));
   if (!seq) {
     return NULL;
   }
@@ -432,7 +436,7 @@ static ISequence *char_sequence_create_empty(bool consider_whitespace) {
   seq->line_count = 0;
   seq->consider_whitespace = consider_whitespace;
 
-  ISequence *iseq = (ISequence *)malloc(sizeof(ISequence));
+  ISequence *iseq = (ISequence *)diff_malloc(sizeof(ISequence));
   if (!iseq) {
     free(seq);
     return NULL;
@@ -506,16 +510,27 @@ ISequence *char_sequence_create_from_range(const char **lines, int line_count,
     return char_sequence_create_empty(consider_whitespace);
   }
 
-  CharSequence *seq = (CharSequence *)malloc(sizeof(CharSequence));
+  // Every UTF-16 unit takes at least one UTF-8 byte: a byte total within
+  // DIFF_MAX_ELEMENTS keeps the element count and offsets below in int range
+  size_t total_bytes = 0;
+  for (int line_number = start_line_num; line_number <= end_line_num; line_number++) {
+    const char *line = lines[line_number - 1];
+    total_bytes += (line ? strlen(line) : 0) + 1;
+    if (total_bytes > (size_t)DIFF_MAX_ELEMENTS) {
+      return NULL;
+    }
+  }
+
+  CharSequence *seq = (CharSequence *)diff_malloc(sizeof(CharSequence));
   if (!seq) {
     return NULL;
   }
   seq->consider_whitespace = consider_whitespace;
   seq->line_count = line_span;
   seq->elements = NULL;
-  seq->line_start_offsets = (int *)malloc(sizeof(int) * (size_t)(line_span + 1));
-  seq->trimmed_ws_lengths = (int *)malloc(sizeof(int) * (size_t)line_span);
-  seq->original_line_start_cols = (int *)malloc(sizeof(int) * (size_t)line_span);
+  seq->line_start_offsets = (int *)diff_malloc(sizeof(int) * (size_t)(line_span + 1));
+  seq->trimmed_ws_lengths = (int *)diff_malloc(sizeof(int) * (size_t)line_span);
+  seq->original_line_start_cols = (int *)diff_malloc(sizeof(int) * (size_t)line_span);
   if (!seq->line_start_offsets || !seq->trimmed_ws_lengths || !seq->original_line_start_cols) {
     free(seq->line_start_offsets);
     free(seq->trimmed_ws_lengths);
@@ -524,7 +539,7 @@ ISequence *char_sequence_create_from_range(const char **lines, int line_count,
     return NULL;
   }
 
-  int *effective_lengths = (int *)malloc(sizeof(int) * (size_t)line_span);
+  int *effective_lengths = (int *)diff_malloc(sizeof(int) * (size_t)line_span);
   if (!effective_lengths) {
     free(seq->line_start_offsets);
     free(seq->trimmed_ws_lengths);
@@ -625,7 +640,7 @@ ISequence *char_sequence_create_from_range(const char **lines, int line_count,
     }
   }
 
-  seq->elements = (uint32_t *)malloc(sizeof(uint32_t) * (size_t)(total_len + 1));
+  seq->elements = (uint32_t *)diff_malloc(sizeof(uint32_t) * (size_t)(total_len + 1));
   if (!seq->elements) {
     free(effective_lengths);
     free(seq->line_start_offsets);
@@ -683,7 +698,7 @@ ISequence *char_sequence_create_from_range(const char **lines, int line_count,
 
   free(effective_lengths);
 
-  ISequence *iseq = (ISequence *)malloc(sizeof(ISequence));
+  ISequence *iseq = (ISequence *)diff_malloc(sizeof(ISequence));
   if (!iseq) {
     free(seq->elements);
     free(seq->line_start_offsets);
@@ -910,7 +925,7 @@ char *char_sequence_get_text(const CharSequence *seq, int start_offset, int end_
   }
 
   int len = end_offset - start_offset;
-  char *result = (char *)malloc((size_t)len + 1);
+  char *result = (char *)diff_malloc((size_t)len + 1);
   if (!result)
     return NULL;
 
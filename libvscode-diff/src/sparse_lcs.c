@@ -0,0 +1,262 @@
+/**
+ * Sparse LCS (Hunt-Szymanski) - Line Alignment for Inputs With Few Matches
+ *
+ * See sparse_lcs.h for when this engine is used and what it guarantees.
+ */
+
+#include "sparse_lcs.h"
+#include "utils.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Rows of seq1 between timeout checks
+#define SPARSE_LCS_TIMEOUT_CHECK_ROWS 1024
+
+bool sparse_lcs_preferred(int len_a, int len_b, int shared, int64_t matches) {
+  int total = len_a + len_b;
+  if (total < SPARSE_LCS_MIN_TOTAL_LINES) {
+    return false;
+  }
+  double min_distance = (double)(total - 2 * shared);
+  double myers_cost = min_distance * min_distance / 2.0;
+  double sparse_cost = ((double)matches + total) * log2((double)total);
+  return sparse_cost * SPARSE_LCS_COST_FACTOR < myers_cost;
+}
+
+/**
+ * One candidate match (i, j) and the match before it on its LCS chain
+ */
+typedef struct {
+  int i;
+  int j;
+  int prev; // Index into the node array, -1 for the first match
+} MatchNode;
+
+static SequenceDiffArray *diff_array_create(int capacity) {
+  SequenceDiffArray *result = (SequenceDiffArray *)diff_malloc(sizeof(SequenceDiffArray));
+  if (!result) {
+    return NULL;
+  }
+  result->diffs = capacity > 0
+                      ? (SequenceDiff *)diff_malloc_array((size_t)capacity, sizeof(SequenceDiff))
+                      : NULL;
+  if (capacity > 0 && !result->diffs) {
+    free(result);
+    return NULL;
+  }
+  result->count = 0;
+  result->capacity = capacity;
+  return result;
+}
+
+static void diff_array_push(SequenceDiffArray *arr, int seq1_start, int seq1_end, int seq2_start,
+                            int seq2_end) {
+  SequenceDiff *d = &arr->diffs[arr->count++];
+  d->seq1_start = seq1_start;
+  d->seq1_end = seq1_end;
+  d->seq2_start = seq2_start;
+  d->seq2_end = seq2_end;
+}
+
+static SequenceDiffArray *whole_range_diff(int len_a, int len_b) {
+  SequenceDiffArray *result = diff_array_create(1);
+  if (result && (len_a > 0 || len_b > 0)) {
+    diff_array_push(result, 0, len_a, 0, len_b);
+  }
+  return result;
+}
+
+// First k in [0, length) with tails[k] >= j, or length
+static int lower_bound(const int *tails, int length, int j) {
+  int lo = 0;
+  int hi = length;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (tails[mid] < j) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/**
+ * Working memory for one run, sized for seq2[prefix, end_b)
+ */
+typedef struct {
+  int *starts;     // starts[id]..starts[id + 1]: occurrences of id in positions
+  int *positions;  // seq2 indices grouped by ID, ascending within an ID
+  int *tails;      // tails[k]: smallest seq2 index ending a common subsequence of length k + 1
+  int *tail_nodes; // tail_nodes[k]: node of the match at tails[k]
+  MatchNode *nodes;
+  int node_count;
+  int node_capacity;
+} SparseLcsWork;
+
+static void work_free(SparseLcsWork *work) {
+  free(work->starts);
+  free(work->positions);
+  free(work->tails);
+  free(work->tail_nodes);
+  free(work->nodes);
+}
+
+static bool work_init(SparseLcsWork *work, const ISequence *seq2, int id_count, int prefix,
+                      int end_b, int rows) {
+  int length = end_b - prefix;
+  work->starts = (int *)diff_calloc((size_t)id_count + 1, sizeof(int));
+  work->positions = (int *)diff_malloc((size_t)(length + 1) * sizeof(int));
+  work->tails = (int *)diff_malloc((size_t)(length + 1) * sizeof(int));
+  work->tail_nodes = (int *)diff_malloc((size_t)(length + 1) * sizeof(int));
+  work->node_count = 0;
+  int64_t initial_nodes = (int64_t)rows + length + 16;
+  work->node_capacity = initial_nodes < DIFF_MAX_ELEMENTS ? (int)initial_nodes : DIFF_MAX_ELEMENTS;
+  work->nodes = (MatchNode *)diff_malloc_array((size_t)work->node_capacity, sizeof(MatchNode));
+  if (!work->starts || !work->positions || !work->tails || !work->tail_nodes || !work->nodes) {
+    return false;
+  }
+
+  // Counting sort of seq2 positions by ID
+  int *starts = work->starts;
+  for (int j = prefix; j < end_b; j++) {
+    starts[seq2->getElement(seq2, j) + 1]++;
+  }
+  for (int id = 0; id < id_count; id++) {
+    starts[id + 1] += starts[id];
+  }
+  for (int j = prefix; j < end_b; j++) {
+    work->positions[starts[seq2->getElement(seq2, j)]++] = j;
+  }
+  // The fill advanced every start to the next ID's start: shift back
+  for (int id = id_count; id > 0; id--) {
+    starts[id] = starts[id - 1];
+  }
+  starts[0] = 0;
+  return true;
+}
+
+static bool work_add_node(SparseLcsWork *work, int i, int j, int prev) {
+  if (work->node_count == work->node_capacity) {
+    int grown = diff_grow_capacity(work->node_capacity, 16);
+    MatchNode *resized =
+        grown < 0 ? NULL
+                  : (MatchNode *)diff_realloc_array(work->nodes, (size_t)grown, sizeof(MatchNode));
+    if (!resized) {
+      return false;
+    }
+    work->nodes = resized;
+    work->node_capacity = grown;
+  }
+  MatchNode *node = &work->nodes[work->node_count++];
+  node->i = i;
+  node->j = j;
+  node->prev = prev;
+  return true;
+}
+
+/**
+ * Hunt-Szymanski over seq1[prefix, end_a).
+ *
+ * @return LCS length, or -1 on timeout / allocation failure (*timed_out
+ *         tells the two apart)
+ */
+static int find_lcs(SparseLcsWork *work, const ISequence *seq1, int prefix, int end_a,
+                    int timeout_ms, bool *timed_out) {
+  int lcs_length = 0;
+  double start_ms = timeout_ms > 0 ? get_precise_time_ms() : 0.0;
+  for (int i = prefix; i < end_a; i++) {
+    if (timeout_ms > 0 && (i - prefix) % SPARSE_LCS_TIMEOUT_CHECK_ROWS == 0 &&
+        get_precise_time_ms() - start_ms > timeout_ms) {
+      *timed_out = true;
+      return -1;
+    }
+
+    uint32_t id = seq1->getElement(seq1, i);
+    // Descending j: a row never extends a chain with one of its own matches
+    for (int p = work->starts[id + 1] - 1; p >= work->starts[id]; p--) {
+      int j = work->positions[p];
+      int k = lower_bound(work->tails, lcs_length, j);
+      if (k < lcs_length && work->tails[k] == j) {
+        continue;
+      }
+      if (!work_add_node(work, i, j, k > 0 ? work->tail_nodes[k - 1] : -1)) {
+        return -1;
+      }
+      work->tails[k] = j;
+      work->tail_nodes[k] = work->node_count - 1;
+      if (k == lcs_length) {
+        lcs_length++;
+      }
+    }
+  }
+  return lcs_length;
+}
+
+SequenceDiffArray *sparse_lcs_diff_algorithm(const ISequence *seq1, const ISequence *seq2,
+                                             int id_count, int timeout_ms, bool *hit_timeout) {
+  if (hit_timeout) {
+    *hit_timeout = false;
+  }
+
+  int len_a = seq1->getLength(seq1);
+  int len_b = seq2->getLength(seq2);
+
+  // Common prefix and suffix match trivially and would only add pairs
+  int prefix = 0;
+  while (prefix < len_a && prefix < len_b &&
+         seq1->getElement(seq1, prefix) == seq2->getElement(seq2, prefix)) {
+    prefix++;
+  }
+  int end_a = len_a;
+  int end_b = len_b;
+  while (end_a > prefix && end_b > prefix &&
+         seq1->getElement(seq1, end_a - 1) == seq2->getElement(seq2, end_b - 1)) {
+    end_a--;
+    end_b--;
+  }
+
+  SparseLcsWork work;
+  bool timed_out = false;
+  int lcs_length = -1;
+  if (work_init(&work, seq2, id_count, prefix, end_b, end_a - prefix)) {
+    lcs_length = find_lcs(&work, seq1, prefix, end_a, timeout_ms, &timed_out);
+  }
+  if (lcs_length < 0) {
+    work_free(&work);
+    if (!timed_out) {
+      return NULL;
+    }
+    if (hit_timeout) {
+      *hit_timeout = true;
+    }
+    return whole_range_diff(len_a, len_b);
+  }
+
+  // Walk the chain back to front, storing it in order in tail_nodes (no longer needed)
+  int index = lcs_length;
+  for (int n = lcs_length > 0 ? work.tail_nodes[lcs_length - 1] : -1; n >= 0;
+       n = work.nodes[n].prev) {
+    work.tail_nodes[--index] = n;
+  }
+
+  // At most one diff before each match plus one after the last
+  SequenceDiffArray *result = diff_array_create(lcs_length + 1);
+  if (result) {
+    int next_a = prefix;
+    int next_b = prefix;
+    for (int m = 0; m < lcs_length; m++) {
+      const MatchNode *node = &work.nodes[work.tail_nodes[m]];
+      if (node->i > next_a || node->j > next_b) {
+        diff_array_push(result, next_a, node->i, next_b, node->j);
+      }
+      next_a = node->i + 1;
+      next_b = node->j + 1;
+    }
+    if (end_a > next_a || end_b > next_b) {
+      diff_array_push(result, next_a, end_a, next_b, end_b);
+    }
+  }
+  work_free(&work);
+  return result;
+}
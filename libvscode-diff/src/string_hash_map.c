@@ -16,6 +16,7 @@
 
 #include "string_hash_map.h"
 #include "platform.h"
+#include "utils.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -52,10 +53,10 @@ static uint32_t hash_for_bucket(const char *str) {
 }
 
 StringHashMap *string_hash_map_create(void) {
-  StringHashMap *map = (StringHashMap *)malloc(sizeof(StringHashMap));
+  StringHashMap *map = (StringHashMap *)diff_malloc(sizeof(StringHashMap));
   map->capacity = INITIAL_CAPACITY;
   map->size = 0;
-  map->buckets = (HashEntry **)calloc((size_t)map->capacity, sizeof(HashEntry *));
+  map->buckets = (HashEntry **)diff_calloc((size_t)map->capacity, sizeof(HashEntry *));
   return map;
 }
 
@@ -67,8 +68,13 @@ static void resize_if_needed(StringHashMap *map) {
     return;
   }
 
-  int new_capacity = map->capacity * 2;
-  HashEntry **new_buckets = (HashEntry **)calloc((size_t)new_capacity, sizeof(HashEntry *));
+  int new_capacity = diff_grow_capacity(map->capacity, 16);
+  HashEntry **new_buckets =
+      new_capacity < 0 ? NULL
+                       : (HashEntry **)diff_calloc((size_t)new_capacity, sizeof(HashEntry *));
+  if (!new_buckets) {
+    return; // Keep the current table: lookups still work, just with longer chains
+  }
 
   // Rehash all entries
   for (int i = 0; i < map->capacity; i++) {
@@ -108,7 +114,7 @@ uint32_t string_hash_map_get_or_create(StringHashMap *map, const char *str) {
   // Recompute bucket after potential resize
   bucket = hash_for_bucket(str) % (uint32_t)map->capacity;
 
-  HashEntry *new_entry = (HashEntry *)malloc(sizeof(HashEntry));
+  HashEntry *new_entry = (HashEntry *)diff_malloc(sizeof(HashEntry));
   new_entry->key = diff_strdup(str);
   new_entry->value = (uint32_t)map->size; // Sequential: 0, 1, 2, ...
   new_entry->next = map->buckets[bucket];
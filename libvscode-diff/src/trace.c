@@ -0,0 +1,180 @@
+/**
+ * Trace Events - per-thread ring buffers and Chrome trace-event JSON dump
+ *
+ * See trace.h for the public contract.
+ */
+
+#include "trace.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct {
+  double ts_us; // Microseconds since the trace epoch
+  const char *name;
+  int region;
+  int lines;
+  char phase;
+} TraceEvent;
+
+typedef struct TraceBuffer {
+  int tid;
+  uint64_t written; // Total events recorded; the ring holds the last min(written, capacity)
+  struct TraceBuffer *next;
+  TraceEvent events[DIFF_TRACE_RING_CAPACITY];
+} TraceBuffer;
+
+volatile int diff_trace_active = 0;
+
+// Registry of every thread's buffer. Buffers live until process exit because
+// pool threads keep a pointer to theirs across compute_diff() calls.
+static TraceBuffer *trace_buffers = NULL;
+static int trace_next_tid = 1;
+static double trace_epoch_ms = 0.0;
+static TRACE_THREAD_LOCAL TraceBuffer *thread_buffer = NULL;
+
+static int env_checked = 0;
+static char env_path[1024];
+
+static TraceBuffer *register_thread_buffer(void) {
+  // Plain malloc: tracing must not show up in DiffStats.allocations
+  TraceBuffer *buffer = (TraceBuffer *)malloc(sizeof(TraceBuffer));
+  if (!buffer) {
+    return NULL;
+  }
+  buffer->written = 0;
+#ifdef USE_OPENMP
+#pragma omp critical(diff_trace_registry)
+#endif
+  {
+    buffer->tid = trace_next_tid++;
+    buffer->next = trace_buffers;
+    trace_buffers = buffer;
+  }
+  return buffer;
+}
+
+void diff_trace_record(const char *name, char phase, int region, int lines) {
+  TraceBuffer *buffer = thread_buffer;
+  if (!buffer) {
+    buffer = register_thread_buffer();
+    if (!buffer) {
+      return;
+    }
+    thread_buffer = buffer;
+  }
+
+  TraceEvent *event = &buffer->events[buffer->written % DIFF_TRACE_RING_CAPACITY];
+  event->ts_us = (get_precise_time_ms() - trace_epoch_ms) * 1000.0;
+  event->name = name;
+  event->region = region;
+  event->lines = lines;
+  event->phase = phase;
+  buffer->written++;
+}
+
+void diff_trace_enable(bool enabled) {
+  if (enabled && trace_epoch_ms == 0.0) {
+    trace_epoch_ms = get_precise_time_ms();
+  }
+  diff_trace_active = enabled ? 1 : 0;
+}
+
+void diff_trace_reset(void) {
+#ifdef USE_OPENMP
+#pragma omp critical(diff_trace_registry)
+#endif
+  {
+    for (TraceBuffer *buffer = trace_buffers; buffer; buffer = buffer->next) {
+      buffer->written = 0;
+    }
+  }
+}
+
+static void write_event(FILE *out, const TraceEvent *event, int tid, bool *first) {
+  fprintf(out, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+          *first ? "" : ",", event->name, event->region >= 0 ? "region" : "stage", event->phase,
+          event->ts_us, tid);
+  if (event->region >= 0 && event->phase == 'B') {
+    fprintf(out, ",\"args\":{\"region\":%d,\"lines\":%d}", event->region, event->lines);
+  }
+  fputc('}', out);
+  *first = false;
+}
+
+bool diff_trace_dump(const char *path) {
+  FILE *out = fopen(path, "w");
+  if (!out) {
+    return false;
+  }
+
+  uint64_t dropped = 0;
+  bool first = true;
+  fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+#ifdef USE_OPENMP
+#pragma omp critical(diff_trace_registry)
+#endif
+  {
+    for (TraceBuffer *buffer = trace_buffers; buffer; buffer = buffer->next) {
+      if (buffer->written == 0) {
+        continue;
+      }
+      fprintf(out,
+              "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+              "\"args\":{\"name\":\"diff thread %d\"}}",
+              first ? "" : ",", buffer->tid, buffer->tid);
+      first = false;
+
+      // Oldest surviving event first; an overwritten ring may start with
+      // unmatched 'E' events, which trace viewers ignore
+      uint64_t count = buffer->written < DIFF_TRACE_RING_CAPACITY ? buffer->written
+                                                                  : DIFF_TRACE_RING_CAPACITY;
+      uint64_t start = buffer->written - count;
+      dropped += start;
+      for (uint64_t i = start; i < buffer->written; i++) {
+        write_event(out, &buffer->events[i % DIFF_TRACE_RING_CAPACITY], buffer->tid, &first);
+      }
+    }
+  }
+  fprintf(out, "\n],\"otherData\":{\"dropped_events\":%llu}}\n", (unsigned long long)dropped);
+
+  bool ok = !ferror(out);
+  if (fclose(out) != 0) {
+    ok = false;
+  }
+  return ok;
+}
+
+static void dump_at_exit(void) {
+  if (!diff_trace_dump(env_path)) {
+    fprintf(stderr, "vscode-diff: cannot write trace to %s\n", env_path);
+  }
+}
+
+void diff_trace_init_from_env(void) {
+  if (env_checked) {
+    return;
+  }
+#ifdef USE_OPENMP
+#pragma omp critical(diff_trace_registry)
+#endif
+  {
+    if (!env_checked) {
+      const char *path = getenv(DIFF_TRACE_ENV);
+      if (path && path[0] && strlen(path) < sizeof(env_path)) {
+        memcpy(env_path, path, strlen(path) + 1);
+        diff_trace_enable(true);
+        atexit(dump_at_exit);
+      }
+      env_checked = 1;
+    }
+  }
+}
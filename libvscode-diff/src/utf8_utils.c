@@ -1,4 +1,5 @@
 #include "utf8_utils.h"
+#include "utils.h"
 #include <stdlib.h>
 #include <string.h>
 #include <utf8proc.h>
@@ -169,7 +170,7 @@ uint16_t *utf8_to_utf16(const char *str, int *out_length) {
     return NULL;
 
   // Allocate array
-  uint16_t *utf16 = (uint16_t *)malloc((size_t)utf16_len * sizeof(uint16_t));
+  uint16_t *utf16 = (uint16_t *)diff_malloc((size_t)utf16_len * sizeof(uint16_t));
   if (!utf16) {
     *out_length = 0;
     return NULL;
@@ -1,4 +1,4 @@
-#include "types.h"
+#include "utils.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -10,6 +10,16 @@
 #include <windows.h>
 #endif
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#if defined(_MSC_VER)
+#define DIFF_THREAD_LOCAL __declspec(thread)
+#else
+#define DIFF_THREAD_LOCAL _Thread_local
+#endif
+
 // ============================================================================
 // Unicode Whitespace Detection - 100% JavaScript /\s/ Parity
 // ============================================================================
@@ -72,13 +82,80 @@ bool is_unicode_whitespace(uint32_t ch) {
   return false;
 }
 
+// ============================================================================
+// Counting Allocators
+// ============================================================================
+
+// Per thread: no shared cache line for parallel workers to contend on, and
+// concurrent compute_diff() calls on different threads do not mix counts
+static DIFF_THREAD_LOCAL int64_t allocation_count = 0;
+
+static void count_allocation(void) { allocation_count++; }
+
+void *diff_malloc(size_t size) {
+  count_allocation();
+  return malloc(size);
+}
+
+void *diff_calloc(size_t count, size_t size) {
+  count_allocation();
+  return calloc(count, size);
+}
+
+void *diff_realloc(void *ptr, size_t size) {
+  count_allocation();
+  return realloc(ptr, size);
+}
+
+int64_t diff_allocation_count(void) { return allocation_count; }
+
+int64_t diff_worker_allocations(int64_t before) {
+#ifdef USE_OPENMP
+  // Thread 0 is the thread that started the loop: already counted
+  if (omp_get_thread_num() == 0) {
+    return 0;
+  }
+#endif
+  return allocation_count - before;
+}
+
+void diff_credit_allocations(int64_t count) { allocation_count += count; }
+
+bool diff_size_mul(size_t count, size_t size, size_t *out) {
+  if (size != 0 && count > SIZE_MAX / size) {
+    return false;
+  }
+  *out = count * size;
+  return true;
+}
+
+void *diff_malloc_array(size_t count, size_t size) {
+  size_t bytes;
+  return diff_size_mul(count, size, &bytes) ? diff_malloc(bytes) : NULL;
+}
+
+void *diff_realloc_array(void *ptr, size_t count, size_t size) {
+  size_t bytes;
+  return diff_size_mul(count, size, &bytes) ? diff_realloc(ptr, bytes) : NULL;
+}
+
+int diff_grow_capacity(int capacity, int initial) {
+  if (capacity <= 0) {
+    return initial;
+  }
+  if (capacity >= DIFF_MAX_ELEMENTS) {
+    return -1;
+  }
+  return capacity > DIFF_MAX_ELEMENTS / 2 ? DIFF_MAX_ELEMENTS : capacity * 2;
+}
+
 // ============================================================================
 // Utility Functions
 // ============================================================================
 
 // Safe memory allocation with error checking
 void *mem_alloc(size_t size) {
-  void *ptr = malloc(size);
+  void *ptr = diff_malloc(size);
   if (!ptr && size > 0) {
     fprintf(stderr, "Memory allocation failed: %zu bytes\n", size);
     exit(1);
@@ -88,7 +165,7 @@ void *mem_alloc(size_t size) {
 
 // Safe memory reallocation
 void *mem_realloc(void *ptr, size_t size) {
-  void *new_ptr = realloc(ptr, size);
+  void *new_ptr = diff_realloc(ptr, size);
   if (!new_ptr && size > 0) {
     fprintf(stderr, "Memory reallocation failed: %zu bytes\n", size);
     exit(1);
@@ -166,7 +243,7 @@ char *trim_string(const char *str) {
 
   // All whitespace?
   if (*start == '\0') {
-    char *result = (char *)malloc(1);
+    char *result = (char *)diff_malloc(1);
     if (result)
       result[0] = '\0';
     return result;
@@ -180,7 +257,7 @@ char *trim_string(const char *str) {
 
   // Allocate and copy
   size_t len = (size_t)(end - start + 1);
-  char *result = (char *)malloc(len + 1);
+  char *result = (char *)diff_malloc(len + 1);
   if (result) {
     memcpy(result, start, len);
     result[len] = '\0';
@@ -205,6 +282,29 @@ int64_t get_current_time_ms(void) {
 #endif
 }
 
+/**
+ * Get a monotonic timestamp with sub-millisecond resolution.
+ *
+ * Used for DiffStats stage timings, where get_current_time_ms() is too coarse.
+ *
+ * @return Milliseconds since an arbitrary fixed point
+ */
+double get_precise_time_ms(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency = {0};
+  LARGE_INTEGER counter;
+  if (frequency.QuadPart == 0) {
+    QueryPerformanceFrequency(&frequency);
+  }
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+#endif
+}
+
 // ============================================================================
 // SequenceDiffArray Functions
 // ============================================================================
@@ -219,9 +319,14 @@ SequenceDiffArray *sequence_diff_array_create(void) {
 
 void sequence_diff_array_append(SequenceDiffArray *arr, SequenceDiff diff) {
   if (arr->count >= arr->capacity) {
-    size_t new_capacity = (size_t)(arr->capacity == 0 ? 8 : arr->capacity * 2);
-    arr->diffs = (SequenceDiff *)mem_realloc(arr->diffs, new_capacity * sizeof(SequenceDiff));
-    arr->capacity = (int)new_capacity;
+    int new_capacity = diff_grow_capacity(arr->capacity, 8);
+    if (new_capacity < 0) {
+      fprintf(stderr, "SequenceDiffArray cannot grow past %d entries\n", arr->capacity);
+      exit(1);
+    }
+    arr->diffs =
+        (SequenceDiff *)mem_realloc(arr->diffs, (size_t)new_capacity * sizeof(SequenceDiff));
+    arr->capacity = new_capacity;
   }
   arr->diffs[arr->count++] = diff;
 }
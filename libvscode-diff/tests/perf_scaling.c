@@ -0,0 +1,313 @@
+/**
+ * Scaling Regression Tests (ctest label: perf)
+ *
+ * Times compute_diff() on generated input families at doubling sizes and
+ * checks how fast the time grows, not how long it takes: a linear family
+ * roughly doubles per step, a quadratic one quadruples. The per-step growth
+ * ratio (geometric mean over all steps) must stay below the family's limit,
+ * so a change that makes mostly-equal diffs quadratic fails on any machine.
+ *
+ * Usage: perf_scaling [options] [family...]   (default: all families)
+ *   --base <n>    Lines at the smallest size (default: 4000)
+ *   --steps <n>   Doublings after the smallest size (default: 3)
+ *   --list        List families and their limits
+ *
+ * Each size is timed as the best of several samples, each sample repeating
+ * the diff until it has run for SAMPLE_MS, so small sizes are not lost in
+ * timer noise. A family over its limit is measured up to twice more before
+ * failing, to ride out a busy machine.
+ */
+
+#include "../bench/bench_utils.h"
+#include "default_lines_diff_computer.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_BASE 4000
+#define DEFAULT_STEPS 3
+#define SAMPLES 3
+#define SAMPLE_MS 20.0
+#define ATTEMPTS 3
+#define LINE_BUFFER 96
+#define SCATTERED_EDITS 64
+#define DENSE_EDIT_PERIOD 32
+
+typedef struct {
+  char **original;
+  char **modified;
+  int original_count;
+  int modified_count;
+} Input;
+
+typedef void (*FamilyGenerator)(Input *input, int n);
+
+static void input_alloc(Input *input, int original_count, int modified_count) {
+  input->original = (char **)calloc((size_t)original_count, sizeof(char *));
+  input->modified = (char **)calloc((size_t)modified_count, sizeof(char *));
+  input->original_count = original_count;
+  input->modified_count = modified_count;
+  if (!input->original || !input->modified) {
+    fprintf(stderr, "perf_scaling: out of memory\n");
+    exit(1);
+  }
+}
+
+static char *dup_line(const char *text) {
+  size_t len = strlen(text) + 1;
+  char *copy = (char *)malloc(len);
+  if (!copy) {
+    fprintf(stderr, "perf_scaling: out of memory\n");
+    exit(1);
+  }
+  memcpy(copy, text, len);
+  return copy;
+}
+
+static void input_free(Input *input) {
+  for (int i = 0; i < input->original_count; i++) {
+    free(input->original[i]);
+  }
+  for (int i = 0; i < input->modified_count; i++) {
+    free(input->modified[i]);
+  }
+  free(input->original);
+  free(input->modified);
+}
+
+// Distinct, code-like line i (nesting varies so indentation is realistic)
+static void code_line(char *buffer, size_t size, int i, const char *indent) {
+  snprintf(buffer, size, "%s%*sresult_%d = compute(item_%d, %d);", indent, (i % 4) * 2, "", i,
+           i * 7 % 1000, i % 13);
+}
+
+/** One line changed in the middle of n lines */
+static void gen_single_edit(Input *input, int n) {
+  char line[LINE_BUFFER];
+  input_alloc(input, n, n);
+  for (int i = 0; i < n; i++) {
+    code_line(line, sizeof(line), i, "");
+    input->original[i] = dup_line(line);
+    if (i == n / 2) {
+      snprintf(line, sizeof(line), "result_%d = compute(item_%d, -1);", i, i);
+    }
+    input->modified[i] = dup_line(line);
+  }
+}
+
+// Change the first argument of line i ("compute(x...")
+static void edit_line(char *buffer, size_t size, int i) {
+  code_line(buffer, size, i, "");
+  char *paren = strchr(buffer, '(');
+  if (paren) {
+    paren[1] = 'x';
+  }
+}
+
+/** SCATTERED_EDITS one-token edits spread evenly over n lines */
+static void gen_scattered_edits(Input *input, int n) {
+  char line[LINE_BUFFER];
+  int spacing = n / SCATTERED_EDITS > 0 ? n / SCATTERED_EDITS : 1;
+  input_alloc(input, n, n);
+  for (int i = 0; i < n; i++) {
+    code_line(line, sizeof(line), i, "");
+    input->original[i] = dup_line(line);
+    if (i % spacing == spacing / 2) {
+      edit_line(line, sizeof(line), i);
+    }
+    input->modified[i] = dup_line(line);
+  }
+}
+
+/** One-token edit on every DENSE_EDIT_PERIOD-th line: n / DENSE_EDIT_PERIOD edits */
+static void gen_dense_edits(Input *input, int n) {
+  char line[LINE_BUFFER];
+  input_alloc(input, n, n);
+  for (int i = 0; i < n; i++) {
+    code_line(line, sizeof(line), i, "");
+    input->original[i] = dup_line(line);
+    if (i % DENSE_EDIT_PERIOD == DENSE_EDIT_PERIOD / 2) {
+      edit_line(line, sizeof(line), i);
+    }
+    input->modified[i] = dup_line(line);
+  }
+}
+
+/** Every one of n lines re-indented by four spaces */
+static void gen_reindent(Input *input, int n) {
+  char line[LINE_BUFFER];
+  input_alloc(input, n, n);
+  for (int i = 0; i < n; i++) {
+    code_line(line, sizeof(line), i, "");
+    input->original[i] = dup_line(line);
+    code_line(line, sizeof(line), i, "    ");
+    input->modified[i] = dup_line(line);
+  }
+}
+
+typedef struct {
+  const char *name;
+  const char *description;
+  FamilyGenerator generate;
+  double max_growth; // Per doubling; linear ~2, n log n ~2.2, quadratic ~4
+} Family;
+
+// Line alignment is O(N + D^2) for D edits (Myers), so only dense_edits is
+// allowed to grow quadratically; its limit still catches a cubic step.
+static const Family FAMILIES[] = {
+    {"single_edit", "one line changed in n lines", gen_single_edit, 2.8},
+    {"scattered_edits", "64 one-token edits spread over n lines", gen_scattered_edits, 2.8},
+    {"dense_edits", "n/32 one-token edits spread over n lines", gen_dense_edits, 4.6},
+    {"reindent", "every one of n lines re-indented", gen_reindent, 2.8},
+};
+#define FAMILY_COUNT ((int)(sizeof(FAMILIES) / sizeof(FAMILIES[0])))
+
+/**
+ * Best per-diff time in ms of SAMPLES samples.
+ */
+static double time_diff(const Input *input) {
+  // No timeout: a timeout would cap exactly the blow-up we are looking for
+  DiffOptions options = {.max_computation_time_ms = 0};
+  double best = 0.0;
+  for (int s = 0; s < SAMPLES; s++) {
+    int runs = 0;
+    double start = bench_now_ms();
+    double elapsed = 0.0;
+    do {
+      LinesDiff *diff = compute_diff((const char **)input->original, input->original_count,
+                                     (const char **)input->modified, input->modified_count,
+                                     &options);
+      if (!diff) {
+        fprintf(stderr, "perf_scaling: compute_diff failed\n");
+        exit(1);
+      }
+      free_lines_diff(diff);
+      runs++;
+      elapsed = bench_now_ms() - start;
+    } while (elapsed < SAMPLE_MS);
+    double per_run = elapsed / runs;
+    if (s == 0 || per_run < best) {
+      best = per_run;
+    }
+  }
+  return best;
+}
+
+/**
+ * Time one family over all sizes.
+ *
+ * @return Geometric mean of the growth ratio per doubling
+ */
+static double measure_family(const Family *family, int base, int steps) {
+  double first_ms = 0.0;
+  double last_ms = 0.0;
+  for (int step = 0; step <= steps; step++) {
+    int n = base << step;
+    Input input;
+    family->generate(&input, n);
+    double ms = time_diff(&input);
+    input_free(&input);
+
+    if (step == 0) {
+      first_ms = ms;
+      printf("  n=%-8d %10.3f ms\n", n, ms);
+    } else {
+      printf("  n=%-8d %10.3f ms  x%.2f\n", n, ms, ms / last_ms);
+    }
+    last_ms = ms;
+  }
+  return pow(last_ms / first_ms, 1.0 / steps);
+}
+
+static const Family *find_family(const char *name) {
+  for (int f = 0; f < FAMILY_COUNT; f++) {
+    if (strcmp(FAMILIES[f].name, name) == 0) {
+      return &FAMILIES[f];
+    }
+  }
+  return NULL;
+}
+
+static bool run_family(const Family *family, int base, int steps) {
+  for (int attempt = 1; attempt <= ATTEMPTS; attempt++) {
+    printf("%s (%s), attempt %d:\n", family->name, family->description, attempt);
+    double growth = measure_family(family, base, steps);
+    printf("  growth per doubling: %.2f (limit %.2f)\n", growth, family->max_growth);
+    if (growth <= family->max_growth) {
+      printf("  ✓ PASSED\n\n");
+      return true;
+    }
+  }
+  printf("  ✗ FAIL: %s grows faster than %.2fx per doubling\n\n", family->name,
+         family->max_growth);
+  return false;
+}
+
+static int parse_positive(const char *option, const char *value) {
+  char *end = NULL;
+  long parsed = strtol(value, &end, 10);
+  if (*end != '\0' || parsed <= 0 || parsed > 1000000) {
+    fprintf(stderr, "Error: %s needs a positive integer\n", option);
+    exit(1);
+  }
+  return (int)parsed;
+}
+
+int main(int argc, char **argv) {
+  int base = DEFAULT_BASE;
+  int steps = DEFAULT_STEPS;
+  const Family *selected[FAMILY_COUNT];
+  int selected_count = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--list") == 0) {
+      for (int f = 0; f < FAMILY_COUNT; f++) {
+        printf("%-16s max %.2fx per doubling  %s\n", FAMILIES[f].name, FAMILIES[f].max_growth,
+               FAMILIES[f].description);
+      }
+      return 0;
+    } else if ((strcmp(argv[i], "--base") == 0 || strcmp(argv[i], "--steps") == 0) &&
+               i + 1 < argc) {
+      int value = parse_positive(argv[i], argv[i + 1]);
+      if (strcmp(argv[i], "--base") == 0) {
+        base = value;
+      } else {
+        steps = value;
+      }
+      i++;
+    } else if (argv[i][0] != '-' && find_family(argv[i]) && selected_count < FAMILY_COUNT) {
+      selected[selected_count++] = find_family(argv[i]);
+    } else {
+      fprintf(stderr, "Error: Unknown option or family: %s (see --list)\n", argv[i]);
+      return 1;
+    }
+  }
+  if (selected_count == 0) {
+    for (int f = 0; f < FAMILY_COUNT; f++) {
+      selected[selected_count++] = &FAMILIES[f];
+    }
+  }
+  if (steps > 10 || (long long)base << steps > 4000000) {
+    fprintf(stderr, "Error: --base %d with --steps %d is too large\n", base, steps);
+    return 1;
+  }
+
+  printf("\n========================================\n");
+  printf("Scaling Regression Tests\n");
+  printf("========================================\n\n");
+
+  int failures = 0;
+  for (int i = 0; i < selected_count; i++) {
+    if (!run_family(selected[i], base, steps)) {
+      failures++;
+    }
+  }
+  if (failures > 0) {
+    printf("❌ %d scaling test(s) failed\n", failures);
+    return 1;
+  }
+  printf("✅ All scaling tests passed\n");
+  return 0;
+}
@@ -518,6 +518,135 @@ TEST(delete_and_add) {
   free_range_mapping_array(result2);
 }
 
+/**
+ * Test 13: Whitespace-only fast path on common edits
+ *
+ * Reindent, tab/space conversion and trailing whitespace map straight from the
+ * trim bounds; changes at both ends fall back to the full refinement.
+ */
+TEST(whitespace_fast_path_cases) {
+  RangeMapping m;
+
+  // Indent 4 -> 8: insertion at column 1
+  ASSERT(refine_whitespace_only_line("    foo()", "        foo()", 2, 2, &m), "reindent");
+  ASSERT_EQ(m.original.start_col, 1, "reindent original start");
+  ASSERT_EQ(m.original.end_col, 1, "reindent original end");
+  ASSERT_EQ(m.modified.end_col, 5, "reindent modified end");
+
+  // Tab -> spaces: whole run replaced
+  ASSERT(refine_whitespace_only_line("\tfoo()", "    foo()", 2, 2, &m), "tab to spaces");
+  ASSERT_EQ(m.original.end_col, 2, "tab original end");
+  ASSERT_EQ(m.modified.end_col, 5, "tab modified end");
+
+  // Trailing whitespace removed after a multibyte interior (UTF-16 columns)
+  ASSERT(refine_whitespace_only_line("caf\xc3\xa9;  ", "caf\xc3\xa9;", 3, 4, &m), "trailing");
+  ASSERT_EQ(m.original.start_line, 3, "trailing original line");
+  ASSERT_EQ(m.modified.start_line, 4, "trailing modified line");
+  ASSERT_EQ(m.original.start_col, 6, "trailing original start");
+  ASSERT_EQ(m.original.end_col, 8, "trailing original end");
+  ASSERT_EQ(m.modified.start_col, 6, "trailing modified start");
+
+  // Not covered: both ends changed, mixed runs, interior changed
+  ASSERT(!refine_whitespace_only_line("  x", "x  ", 1, 1, &m), "both ends");
+  ASSERT(!refine_whitespace_only_line("  \t foo", "\t  foo", 1, 1, &m), "mixed runs");
+  ASSERT(!refine_whitespace_only_line("  foo", "    bar", 1, 1, &m), "interior");
+}
+
+static unsigned int fast_path_rng = 12345;
+
+static int next_random(int bound) {
+  fast_path_rng = fast_path_rng * 1103515245u + 12345u;
+  return (int)((fast_path_rng >> 16) % (unsigned int)bound);
+}
+
+static void random_whitespace(char *out, int max_len) {
+  int len = next_random(max_len + 1);
+  char repeated = next_random(2) ? ' ' : '\t';
+  bool uniform = next_random(2);
+  for (int i = 0; i < len; i++) {
+    out[i] = uniform ? repeated : (next_random(2) ? ' ' : '\t');
+  }
+  out[len] = '\0';
+}
+
+/**
+ * Test 14: Whitespace-only fast path matches refine_diff_char_level()
+ *
+ * Randomized differential check over reindents and trailing whitespace edits,
+ * including all-whitespace lines, '\r' endings, multibyte interiors and lines
+ * long enough for the O(ND) path.
+ */
+TEST(whitespace_fast_path_matches_refine) {
+  static char long_interior[1100];
+  for (int i = 0; i < (int)sizeof(long_interior) - 1; i++) {
+    long_interior[i] = (i % 9 == 0) ? ' ' : (char)('a' + (i * 7) % 26);
+  }
+  long_interior[sizeof(long_interior) - 1] = '\0';
+  const char *interiors[] = {"",
+                             "x",
+                             "}",
+                             "foo();",
+                             "if (x) {",
+                             "a  b",
+                             "return a + b;",
+                             "caf\xc3\xa9 = 1;",
+                             "x = \"  \";",
+                             long_interior};
+  int interior_count = (int)(sizeof(interiors) / sizeof(interiors[0]));
+
+  int covered = 0;
+  for (int iter = 0; iter < 20000; iter++) {
+    const char *interior = interiors[next_random(interior_count)];
+    char lead_a[16], lead_b[16], trail_a[16], trail_b[16];
+    random_whitespace(lead_a, 8);
+    random_whitespace(lead_b, 8);
+    random_whitespace(trail_a, 4);
+    random_whitespace(trail_b, 4);
+    if (next_random(3) == 0) {
+      strcpy(lead_b, lead_a);
+    } else if (next_random(2) == 0) {
+      strcpy(trail_b, trail_a);
+    }
+    if (next_random(10) == 0) {
+      strcat(trail_a, "\r");
+      strcat(trail_b, next_random(2) ? "\r" : "");
+    }
+
+    char line_a[1200], line_b[1200];
+    snprintf(line_a, sizeof(line_a), "%s%s%s", lead_a, interior, trail_a);
+    snprintf(line_b, sizeof(line_b), "%s%s%s", lead_b, interior, trail_b);
+    if (strcmp(line_a, line_b) == 0) {
+      continue;
+    }
+
+    RangeMapping fast;
+    if (!refine_whitespace_only_line(line_a, line_b, 2, 2, &fast)) {
+      continue;
+    }
+    covered++;
+
+    const char *lines_a[] = {"head", line_a, "tail"};
+    const char *lines_b[] = {"head", line_b, "tail"};
+    SequenceDiff line_diff = {1, 2, 1, 2};
+    CharLevelOptions opts = {.consider_whitespace_changes = true,
+                             .extend_to_subwords = next_random(2)};
+    RangeMappingArray *full =
+        refine_diff_char_level(&line_diff, lines_a, 3, lines_b, 3, &opts, NULL);
+    ASSERT(full != NULL, "Result should not be NULL");
+    bool same = full->count == 1 &&
+                memcmp(&full->mappings[0].original, &fast.original, sizeof(CharRange)) == 0 &&
+                memcmp(&full->mappings[0].modified, &fast.modified, sizeof(CharRange)) == 0;
+    if (!same) {
+      printf("  Mismatch: \"%s\" -> \"%s\"\n", line_a, line_b);
+    }
+    ASSERT(same, "Fast path should match the full refinement");
+    free_range_mapping_array(full);
+  }
+
+  printf("  %d whitespace-only pairs matched the full refinement\n", covered);
+  ASSERT(covered > 1000, "Fast path should cover most single-ended edits");
+}
+
 // =============================================================================
 // Main Test Runner
 // =============================================================================
@@ -537,6 +666,8 @@ int main(void) {
   RUN_TEST(real_code_function_rename);
   RUN_TEST(cross_line_range_mapping);
   RUN_TEST(delete_and_add);
+  RUN_TEST(whitespace_fast_path_cases);
+  RUN_TEST(whitespace_fast_path_matches_refine);
 
   printf("\n");
   printf("=======================================================\n");
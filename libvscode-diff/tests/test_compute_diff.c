@@ -6,12 +6,16 @@
  * - Character-level refinement
  * - Whitespace change detection
  * - Line mapping conversion
+ * - Staged refinement of caller-provided alignments (refine_line_alignments)
+ * - Fast (approximate) quality mode
  * 
  * VSCode Parity: Tests match VSCode's DefaultLinesDiffComputer behavior
  */
 
 #include "default_lines_diff_computer.h"
+#include "line_level.h"
 #include "print_utils.h"
+#include "utils.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -179,6 +183,302 @@ bool test_ignore_whitespace() {
   return true;
 }
 
+bool test_diff_stats() {
+  printf("Running test_diff_stats...\n");
+
+  const char *original[] = {"keep", "old line", "  indented", "drop me", "tail"};
+  const char *modified[] = {"keep", "new line", "indented", "tail", "added 1", "added 2"};
+
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = 0,
+                         .compute_moves = false,
+                         .extend_to_subwords = false};
+
+  DiffLineStats stats;
+  ASSERT(compute_diff_stats(original, 5, modified, 6, &options, &stats), "Should succeed");
+
+  printf("  inserted=%d deleted=%d modified=%d\n", stats.inserted_lines, stats.deleted_lines,
+         stats.modified_lines);
+
+  ASSERT_EQ(stats.modified_lines, 2, "old->new and whitespace-only line are modified");
+  ASSERT_EQ(stats.deleted_lines, 1, "One deleted line");
+  ASSERT_EQ(stats.inserted_lines, 2, "Two inserted lines");
+  ASSERT(stats.hit_timeout == false, "Should not hit timeout");
+
+  // Whitespace-only change disappears when ignoring trim whitespace
+  options.ignore_trim_whitespace = true;
+  ASSERT(compute_diff_stats(original, 5, modified, 6, &options, &stats), "Should succeed");
+  ASSERT_EQ(stats.modified_lines, 1, "Whitespace-only line ignored");
+
+  // Identical input
+  ASSERT(compute_diff_stats(original, 5, original, 5, &options, &stats), "Should succeed");
+  ASSERT_EQ(stats.inserted_lines + stats.deleted_lines + stats.modified_lines, 0,
+            "Identical files have no changes");
+
+  printf("  ✓ PASSED\n");
+  return true;
+}
+
+bool test_diff_buffers() {
+  printf("Running test_diff_buffers...\n");
+
+  const char *original[] = {"keep", "old line", "tail"};
+  const char *modified[] = {"keep", "new line", "tail", "added"};
+  // Not NUL-terminated at the given lengths; trailing '\n' ends the last line
+  const char original_text[] = "keep\nold line\ntail\nIGNORED";
+  const char modified_text[] = "keep\nnew line\ntail\nadded";
+
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = 0,
+                         .compute_moves = false,
+                         .extend_to_subwords = false};
+
+  LinesDiff *expected = compute_diff(original, 3, modified, 4, &options);
+  LinesDiff *result =
+      compute_diff_buffers(original_text, 19, modified_text, strlen(modified_text), &options);
+  ASSERT(result != NULL, "Should succeed");
+
+  ASSERT_EQ(result->changes.count, expected->changes.count, "Same number of changes");
+  for (int i = 0; i < result->changes.count; i++) {
+    const DetailedLineRangeMapping *a = &result->changes.mappings[i];
+    const DetailedLineRangeMapping *b = &expected->changes.mappings[i];
+    ASSERT_EQ(a->original.start_line, b->original.start_line, "Same original start");
+    ASSERT_EQ(a->original.end_line, b->original.end_line, "Same original end");
+    ASSERT_EQ(a->modified.start_line, b->modified.start_line, "Same modified start");
+    ASSERT_EQ(a->modified.end_line, b->modified.end_line, "Same modified end");
+    ASSERT_EQ(a->inner_change_count, b->inner_change_count, "Same inner changes");
+  }
+
+  free_lines_diff(result);
+  free_lines_diff(expected);
+
+  // Empty buffers
+  result = compute_diff_buffers(NULL, 0, NULL, 0, &options);
+  ASSERT(result != NULL, "Empty buffers should succeed");
+  ASSERT_EQ(result->changes.count, 0, "Empty buffers have no changes");
+  free_lines_diff(result);
+
+  ASSERT(compute_diff_buffers(NULL, 5, NULL, 0, &options) == NULL, "NULL with length fails");
+
+  printf("  ✓ PASSED\n");
+  return true;
+}
+
+bool test_rewrite_detection() {
+  printf("Running test_rewrite_detection...\n");
+
+  enum { N = 150 };
+  static char original_store[N][32];
+  static char modified_store[N][32];
+  const char *original[N];
+  const char *modified[N];
+  for (int i = 0; i < N; i++) {
+    snprintf(original_store[i], sizeof(original_store[i]), "old line %d", i);
+    snprintf(modified_store[i], sizeof(modified_store[i]), "new text %d", i);
+    original[i] = original_store[i];
+    modified[i] = modified_store[i];
+  }
+  // Share a few lines (~5%)
+  for (int i = 0; i < N; i += 20) {
+    modified[i] = original[i];
+  }
+
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = 0,
+                         .compute_moves = false,
+                         .extend_to_subwords = false,
+                         .rewrite_threshold = 0.1};
+
+  LinesDiff *result = compute_diff(original, N, modified, N, &options);
+  ASSERT(result != NULL, "Should succeed");
+  ASSERT(result->is_rewrite, "Should be detected as rewrite");
+  ASSERT_EQ(result->changes.count, 1, "Single whole-file change");
+  ASSERT_EQ(result->changes.mappings[0].original.end_line, N + 1, "Covers whole original");
+  ASSERT_EQ(result->changes.mappings[0].modified.end_line, N + 1, "Covers whole modified");
+  free_lines_diff(result);
+
+  // Disabled threshold: normal alignment keeps the shared lines
+  options.rewrite_threshold = 0;
+  result = compute_diff(original, N, modified, N, &options);
+  ASSERT(result != NULL, "Should succeed");
+  ASSERT(!result->is_rewrite, "Disabled threshold never reports a rewrite");
+  ASSERT(result->changes.count > 1, "Shared lines split the diff");
+  free_lines_diff(result);
+
+  // Small inputs always run the full alignment
+  options.rewrite_threshold = 0.1;
+  result = compute_diff(original, 10, modified + 1, 10, &options);
+  ASSERT(result != NULL, "Should succeed");
+  ASSERT(!result->is_rewrite, "Small files are not checked");
+  free_lines_diff(result);
+
+  printf("  ✓ PASSED\n");
+  return true;
+}
+
+bool test_stats_instrumentation() {
+  printf("Running test_stats_instrumentation...\n");
+
+  const char *original[] = {"int a = 1;", "int b = 2;", "int c = 3;", "int d = 4;"};
+  const char *modified[] = {"int a = 1;", "int b = 20;", "int c = 3;", "  int d = 4;"};
+
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = 0,
+                         .compute_moves = false,
+                         .extend_to_subwords = false,
+                         .collect_stats = true};
+
+  LinesDiff *result = compute_diff(original, 4, modified, 4, &options);
+  ASSERT(result != NULL, "Should succeed");
+  const DiffStats *stats = &result->stats;
+  printf("  total=%.3fms align=%.3fms refine=%.3fms allocations=%lld\n", stats->total_ms,
+         stats->line_alignment_ms, stats->refine_ms, (long long)stats->allocations);
+  ASSERT_EQ(stats->algorithm, DIFF_ALGORITHM_DP, "Small input uses DP");
+  ASSERT_EQ(stats->line_edit_distance, 2, "One replaced line: D = 2");
+  ASSERT_EQ(stats->refined_regions, 1, "One line region refined");
+  ASSERT_EQ(stats->largest_region_lines, 2, "Region spans 1 + 1 lines");
+  ASSERT(stats->allocations > 0, "Allocations are counted");
+  ASSERT(stats->total_ms >= stats->line_alignment_ms, "Total covers stages");
+  ASSERT_EQ(stats->char_refine_timeouts + stats->line_alignment_timeouts, 0, "No timeouts");
+  free_lines_diff(result);
+
+  // Not requested: stats stay zeroed
+  options.collect_stats = false;
+  result = compute_diff(original, 4, modified, 4, &options);
+  ASSERT(result != NULL, "Should succeed");
+  ASSERT_EQ(result->stats.algorithm, DIFF_ALGORITHM_NONE, "No algorithm recorded");
+  ASSERT(result->stats.allocations == 0 && result->stats.total_ms == 0.0, "Stats zeroed");
+  free_lines_diff(result);
+
+  // Large input switches to Myers
+  enum { N = 1000 };
+  static char original_store[N][32];
+  static char modified_store[N][32];
+  const char *large_original[N];
+  const char *large_modified[N];
+  for (int i = 0; i < N; i++) {
+    snprintf(original_store[i], sizeof(original_store[i]), "line %d", i);
+    snprintf(modified_store[i], sizeof(modified_store[i]), i % 100 ? "line %d" : "edit %d", i);
+    large_original[i] = original_store[i];
+    large_modified[i] = modified_store[i];
+  }
+  options.collect_stats = true;
+  result = compute_diff(large_original, N, large_modified, N, &options);
+  ASSERT(result != NULL, "Should succeed");
+  ASSERT_EQ(result->stats.algorithm, DIFF_ALGORITHM_MYERS, "Large input uses Myers");
+  ASSERT_EQ(result->stats.line_edit_distance, 20, "Ten replaced lines: D = 20");
+  ASSERT_EQ(result->stats.refined_regions, 10, "Ten regions refined");
+  free_lines_diff(result);
+
+  printf("  ✓ PASSED\n");
+  return true;
+}
+
+static bool same_changes(const LinesDiff *a, const LinesDiff *b) {
+  if (a->changes.count != b->changes.count) {
+    return false;
+  }
+  for (int i = 0; i < a->changes.count; i++) {
+    const DetailedLineRangeMapping *x = &a->changes.mappings[i];
+    const DetailedLineRangeMapping *y = &b->changes.mappings[i];
+    if (memcmp(&x->original, &y->original, sizeof(LineRange)) != 0 ||
+        memcmp(&x->modified, &y->modified, sizeof(LineRange)) != 0 ||
+        x->inner_change_count != y->inner_change_count ||
+        memcmp(x->inner_changes, y->inner_changes,
+               (size_t)x->inner_change_count * sizeof(RangeMapping)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool test_refine_line_alignments() {
+  printf("Running test_refine_line_alignments...\n");
+
+  const char *original[] = {"int a = 1;", "int b = 2;", "int c = 3;", "int d = 4;", "int e = 5;"};
+  const char *modified[] = {"int a = 1;", "int b = 20;", "int c = 3;", "  int d = 4;",
+                            "int e = 5;", "int f = 6;"};
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = 0,
+                         .compute_moves = false,
+                         .extend_to_subwords = false};
+
+  // Alignments from our own line pass reproduce compute_diff() exactly
+  bool line_timeout = false;
+  SequenceDiffArray *line_alignments =
+      compute_line_alignments(original, 5, modified, 6, 0, 0, DIFF_QUALITY_PARITY,
+                              &line_timeout, NULL, NULL);
+  ASSERT(line_alignments != NULL, "Line alignment should succeed");
+  LinesDiff *expected = compute_diff(original, 5, modified, 6, &options);
+  LinesDiff *staged = refine_line_alignments(original, 5, modified, 6, line_alignments->diffs,
+                                             line_alignments->count, &options);
+  ASSERT(expected != NULL && staged != NULL, "Should succeed");
+  print_lines_diff(staged);
+  ASSERT(same_changes(staged, expected), "Staged result should match compute_diff()");
+  ASSERT_EQ(staged->changes.count, 3, "Edit, whitespace-only line and insertion");
+  free_lines_diff(expected);
+  free_lines_diff(staged);
+  sequence_diff_array_free(line_alignments);
+
+  // Coarser external hunk (lines 2-4 as one region) is refined as given
+  SequenceDiff coarse[] = {{1, 4, 1, 4}, {5, 5, 5, 6}};
+  staged = refine_line_alignments(original, 5, modified, 6, coarse, 2, &options);
+  ASSERT(staged != NULL, "Should succeed");
+  ASSERT_EQ(staged->changes.count, 3, "Unchanged line 3 splits the refined region");
+  ASSERT_EQ(staged->changes.mappings[1].original.start_line, 4, "Indent change on line 4");
+  free_lines_diff(staged);
+
+  // Invalid alignments
+  SequenceDiff uneven_gap[] = {{1, 2, 2, 3}};
+  SequenceDiff overlapping[] = {{1, 3, 1, 3}, {2, 4, 2, 4}};
+  SequenceDiff empty_region[] = {{1, 1, 1, 1}, {5, 5, 5, 6}};
+  ASSERT(refine_line_alignments(original, 5, modified, 6, uneven_gap, 1, &options) == NULL,
+         "Unequal gaps are rejected");
+  ASSERT(refine_line_alignments(original, 5, modified, 6, overlapping, 2, &options) == NULL,
+         "Overlapping regions are rejected");
+  ASSERT(refine_line_alignments(original, 5, modified, 6, empty_region, 2, &options) == NULL,
+         "Empty regions are rejected");
+  ASSERT(refine_line_alignments(original, 5, modified, 6, NULL, 0, &options) == NULL,
+         "Missing insertion leaves unequal tails");
+
+  // No regions: only whitespace-only lines are reported
+  staged = refine_line_alignments(original, 4, modified, 4, NULL, 0, &options);
+  ASSERT(staged != NULL, "Should succeed");
+  ASSERT_EQ(staged->changes.count, 2, "Both differing lines found by the whitespace scan");
+  free_lines_diff(staged);
+
+  printf("  ✓ PASSED\n");
+  return true;
+}
+
+bool test_fast_quality() {
+  printf("Running test_fast_quality...\n");
+
+  const char *original[] = {"int a = 1;", "int b = 2;", "int c = 3;", "int d = 4;"};
+  const char *modified[] = {"int a = 1;", "int b = 20;", "int c = 3;", "  int d = 4;"};
+
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = 0,
+                         .compute_moves = false,
+                         .extend_to_subwords = false,
+                         .collect_stats = true,
+                         .quality = DIFF_QUALITY_FAST};
+
+  // Small input: fast mode skips the DP alignment but finds the same changes
+  LinesDiff *fast = compute_diff(original, 4, modified, 4, &options);
+  options.quality = DIFF_QUALITY_PARITY;
+  LinesDiff *parity = compute_diff(original, 4, modified, 4, &options);
+  ASSERT(fast != NULL && parity != NULL, "Should succeed");
+  ASSERT_EQ(fast->stats.algorithm, DIFF_ALGORITHM_MYERS, "Fast mode uses Myers");
+  ASSERT_EQ(parity->stats.algorithm, DIFF_ALGORITHM_DP, "Parity mode uses DP");
+  ASSERT(same_changes(fast, parity), "Simple edits are identical in both modes");
+  free_lines_diff(fast);
+  free_lines_diff(parity);
+
+  printf("  ✓ PASSED\n");
+  return true;
+}
+
 // ============================================================================
 // Test Runner
 // ============================================================================
@@ -206,6 +506,12 @@ int main(void) {
   RUN_TEST(test_multiline_diff);
   RUN_TEST(test_whitespace_changes);
   RUN_TEST(test_ignore_whitespace);
+  RUN_TEST(test_diff_stats);
+  RUN_TEST(test_diff_buffers);
+  RUN_TEST(test_rewrite_detection);
+  RUN_TEST(test_stats_instrumentation);
+  RUN_TEST(test_refine_line_alignments);
+  RUN_TEST(test_fast_quality);
 
   printf("═══════════════════════════════════════════════════════════\n");
   if (passed == total) {
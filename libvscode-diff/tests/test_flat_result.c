@@ -0,0 +1,199 @@
+/**
+ * Flat Result Layout Tests
+ *
+ * Tests diff_flat_write() / diff_flat_array() (flat_result.h):
+ * - Every array reads back equal to the LinesDiff it was written from
+ * - The blob is placed at the next aligned offset of the region
+ * - A region that is too small is left untouched and reports the size needed
+ * - Truncated or foreign blobs are rejected
+ */
+
+#include "default_lines_diff_computer.h"
+#include "flat_result.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK_LINES 12
+
+static void append_block(TestLines *lines, const char *name, int edited_line) {
+  for (int i = 0; i < BLOCK_LINES; i++) {
+    test_lines_add(lines, i == edited_line ? "  %s_value_%d = %d + 1" : "  %s_value_%d = %d", name,
+                   i, i * 3);
+  }
+}
+
+// alpha moves to the end, beta and delta get one edited line each
+static LinesDiff *sample_diff(void) {
+  TestLines original = test_lines_create(4 * BLOCK_LINES);
+  append_block(&original, "alpha", -1);
+  append_block(&original, "beta", -1);
+  append_block(&original, "gamma", -1);
+  append_block(&original, "delta", -1);
+  TestLines modified = test_lines_create(4 * BLOCK_LINES);
+  append_block(&modified, "beta", 4);
+  append_block(&modified, "gamma", -1);
+  append_block(&modified, "delta", 7);
+  append_block(&modified, "alpha", -1);
+  DiffOptions options = {.max_computation_time_ms = 0, .compute_moves = true};
+  LinesDiff *diff =
+      compute_diff(original.lines, original.count, modified.lines, modified.count, &options);
+  test_lines_free(&original);
+  test_lines_free(&modified);
+  return diff;
+}
+
+static const int32_t *array(const void *blob, size_t length, DiffFlatArray which, int expected) {
+  int count = -1;
+  const int32_t *values = diff_flat_array(blob, length, which, &count);
+  CHECK(values != NULL);
+  CHECK(count == expected);
+  return values;
+}
+
+TEST(round_trip) {
+  LinesDiff *diff = sample_diff();
+  CHECK(diff != NULL);
+  CHECK(diff->changes.count > 1);
+  CHECK(diff->moves.count > 0);
+
+  size_t size = diff_flat_size(diff);
+  CHECK(size > sizeof(DiffFlatHeader));
+  // uint64_t storage keeps the region itself aligned; write at an odd offset
+  uint64_t *storage64 = (uint64_t *)calloc(size / 8 + 4, 8);
+  unsigned char *region = (unsigned char *)storage64;
+  size_t offset = 0;
+  size_t length = 0;
+  CHECK(diff_flat_write(diff, region, size + 16, 3, &offset, &length));
+  CHECK(offset == 8);
+  CHECK(length == size);
+
+  const void *blob = region + offset;
+  DiffFlatHeader header;
+  memcpy(&header, blob, sizeof(header));
+  CHECK(header.total_bytes == length);
+  CHECK(header.change_count == diff->changes.count);
+  CHECK(header.move_count == diff->moves.count);
+  CHECK(((header.flags & DIFF_FLAT_HIT_TIMEOUT) != 0) == diff->hit_timeout);
+
+  int changes = diff->changes.count;
+  const int32_t *original_start = array(blob, length, DIFF_FLAT_CHANGE_ORIGINAL_START, changes);
+  const int32_t *original_end = array(blob, length, DIFF_FLAT_CHANGE_ORIGINAL_END, changes);
+  const int32_t *modified_start = array(blob, length, DIFF_FLAT_CHANGE_MODIFIED_START, changes);
+  const int32_t *modified_end = array(blob, length, DIFF_FLAT_CHANGE_MODIFIED_END, changes);
+  const int32_t *inner_offset = array(blob, length, DIFF_FLAT_CHANGE_INNER_OFFSET, changes + 1);
+  const int32_t *inner[8];
+  for (int a = 0; a < 8; a++) {
+    inner[a] = array(blob, length, (DiffFlatArray)(DIFF_FLAT_INNER_ORIGINAL_START_LINE + a),
+                     header.inner_count);
+  }
+
+  CHECK(inner_offset[0] == 0);
+  for (int i = 0; i < changes; i++) {
+    const DetailedLineRangeMapping *change = &diff->changes.mappings[i];
+    CHECK(original_start[i] == change->original.start_line);
+    CHECK(original_end[i] == change->original.end_line);
+    CHECK(modified_start[i] == change->modified.start_line);
+    CHECK(modified_end[i] == change->modified.end_line);
+    CHECK(inner_offset[i + 1] - inner_offset[i] == change->inner_change_count);
+    for (int k = 0; k < change->inner_change_count; k++) {
+      const RangeMapping *m = &change->inner_changes[k];
+      int j = inner_offset[i] + k;
+      CHECK(inner[0][j] == m->original.start_line && inner[1][j] == m->original.start_col);
+      CHECK(inner[2][j] == m->original.end_line && inner[3][j] == m->original.end_col);
+      CHECK(inner[4][j] == m->modified.start_line && inner[5][j] == m->modified.start_col);
+      CHECK(inner[6][j] == m->modified.end_line && inner[7][j] == m->modified.end_col);
+    }
+  }
+  CHECK(inner_offset[changes] == header.inner_count);
+  CHECK(header.inner_count > 0);
+
+  int moves = diff->moves.count;
+  const int32_t *move_original_start = array(blob, length, DIFF_FLAT_MOVE_ORIGINAL_START, moves);
+  const int32_t *move_modified_end = array(blob, length, DIFF_FLAT_MOVE_MODIFIED_END, moves);
+  for (int i = 0; i < moves; i++) {
+    CHECK(move_original_start[i] == diff->moves.moves[i].original.start_line);
+    CHECK(move_modified_end[i] == diff->moves.moves[i].modified.end_line);
+  }
+
+  free(storage64);
+  free_lines_diff(diff);
+}
+
+TEST(empty_diff) {
+  const char *lines[] = {"same"};
+  DiffOptions options = {.max_computation_time_ms = 0};
+  LinesDiff *diff = compute_diff(lines, 1, lines, 1, &options);
+  CHECK(diff != NULL && diff->changes.count == 0);
+
+  uint64_t region[64];
+  size_t offset = 0;
+  size_t length = 0;
+  CHECK(diff_flat_write(diff, region, sizeof(region), 0, &offset, &length));
+  CHECK(offset == 0 && length == diff_flat_size(diff));
+  array(region, length, DIFF_FLAT_CHANGE_ORIGINAL_START, 0);
+  const int32_t *inner_offset = array(region, length, DIFF_FLAT_CHANGE_INNER_OFFSET, 1);
+  CHECK(inner_offset[0] == 0);
+  free_lines_diff(diff);
+}
+
+TEST(region_too_small) {
+  LinesDiff *diff = sample_diff();
+  size_t size = diff_flat_size(diff);
+  uint64_t *storage64 = (uint64_t *)calloc(size / 8 + 2, 8);
+  size_t offset = 0;
+  size_t length = 0;
+
+  CHECK(!diff_flat_write(diff, storage64, size + 7, 8, &offset, &length));
+  CHECK(offset == 8 && length == size);
+  CHECK(storage64[1] == 0); // Nothing written
+  CHECK(!diff_flat_write(diff, storage64, size, size + 1, &offset, &length));
+  CHECK(diff_flat_write(diff, storage64, size + 8, 8, &offset, &length));
+
+  free(storage64);
+  free_lines_diff(diff);
+}
+
+TEST(rejects_bad_blobs) {
+  LinesDiff *diff = sample_diff();
+  size_t size = diff_flat_size(diff);
+  uint64_t *blob = (uint64_t *)calloc(size / 8 + 2, 8);
+  size_t offset = 0;
+  size_t length = 0;
+  CHECK(diff_flat_write(diff, blob, size, 0, &offset, &length));
+  CHECK(diff_flat_array(blob, length, DIFF_FLAT_MOVE_MODIFIED_END, NULL) != NULL);
+
+  // Truncated, misaligned, out-of-range array
+  CHECK(diff_flat_array(blob, length - 1, DIFF_FLAT_CHANGE_ORIGINAL_START, NULL) == NULL);
+  CHECK(diff_flat_array(blob, sizeof(DiffFlatHeader) - 1, DIFF_FLAT_CHANGE_ORIGINAL_START, NULL) ==
+        NULL);
+  CHECK(diff_flat_array((unsigned char *)blob + 4, length, DIFF_FLAT_CHANGE_ORIGINAL_START,
+                        NULL) == NULL);
+  CHECK(diff_flat_array(blob, length, DIFF_FLAT_ARRAY_COUNT, NULL) == NULL);
+
+  // Foreign magic, then a forged offset
+  DiffFlatHeader *header = (DiffFlatHeader *)(void *)blob;
+  header->magic ^= 1;
+  CHECK(diff_flat_array(blob, length, DIFF_FLAT_CHANGE_ORIGINAL_START, NULL) == NULL);
+  header->magic ^= 1;
+  header->offsets[DIFF_FLAT_MOVE_ORIGINAL_START] += 8;
+  CHECK(diff_flat_array(blob, length, DIFF_FLAT_CHANGE_ORIGINAL_START, NULL) == NULL);
+
+  free(blob);
+  free_lines_diff(diff);
+}
+
+int main(void) {
+  printf("\n========================================\n");
+  printf("Flat Result Layout Tests\n");
+  printf("========================================\n\n");
+
+  RUN_TEST(round_trip);
+  RUN_TEST(empty_diff);
+  RUN_TEST(region_too_small);
+  RUN_TEST(rejects_bad_blobs);
+
+  printf("\n✅ All flat result layout tests passed\n");
+  return 0;
+}
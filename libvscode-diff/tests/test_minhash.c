@@ -0,0 +1,157 @@
+/**
+ * MinHash Similarity Index Tests
+ *
+ * Tests rename/copy candidate pairing:
+ * - Identical and near-identical files are paired
+ * - Unrelated files are not paired
+ * - Only original -> modified pairs are reported
+ * - Blank/empty files never produce candidates
+ * - Buckets over MINHASH_MAX_BUCKET_SIZE files are skipped, other pairs are kept
+ */
+
+#include "minhash.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FILE_LINES 200
+
+// Build a synthetic file whose lines are "<prefix> line <i>"
+static const char **make_file(char storage[][64], const char *prefix, int count) {
+  const char **lines = (const char **)malloc((size_t)count * sizeof(char *));
+  for (int i = 0; i < count; i++) {
+    snprintf(storage[i], 64, "%s line %d", prefix, i);
+    lines[i] = storage[i];
+  }
+  return lines;
+}
+
+static const SimilarityCandidate *find_pair(const SimilarityCandidateArray *arr, int orig, int mod) {
+  for (int i = 0; i < arr->count; i++) {
+    if (arr->candidates[i].original_id == orig && arr->candidates[i].modified_id == mod) {
+      return &arr->candidates[i];
+    }
+  }
+  return NULL;
+}
+
+TEST(pairs_renamed_files) {
+  static char a_store[FILE_LINES][64], b_store[FILE_LINES][64], c_store[FILE_LINES][64];
+  const char **a = make_file(a_store, "alpha", FILE_LINES);
+  const char **b = make_file(b_store, "beta", FILE_LINES);
+  const char **c = make_file(c_store, "alpha", FILE_LINES);
+
+  // c is "alpha" with 10% of lines edited
+  for (int i = 0; i < FILE_LINES; i += 10) {
+    snprintf(c_store[i], 64, "edited %d", i);
+  }
+
+  MinHashIndex *index = minhash_index_create();
+  int id_a = minhash_index_add(index, a, FILE_LINES, true);
+  int id_b = minhash_index_add(index, b, FILE_LINES, true);
+  int id_c = minhash_index_add(index, c, FILE_LINES, false);
+  int id_a_copy = minhash_index_add(index, a, FILE_LINES, false);
+
+  SimilarityCandidateArray *result = minhash_index_find_candidates(index, 0.5);
+  CHECK(result != NULL);
+
+  const SimilarityCandidate *renamed = find_pair(result, id_a, id_c);
+  CHECK(renamed != NULL);
+  printf("  alpha -> edited alpha: %.2f\n", renamed->similarity);
+  CHECK(renamed->similarity >= 0.7);
+
+  const SimilarityCandidate *copied = find_pair(result, id_a, id_a_copy);
+  CHECK(copied != NULL);
+  CHECK(copied->similarity == 1.0);
+
+  CHECK(find_pair(result, id_b, id_c) == NULL);
+  CHECK(find_pair(result, id_b, id_a_copy) == NULL);
+
+  // Sorted by descending similarity
+  for (int i = 1; i < result->count; i++) {
+    CHECK(result->candidates[i - 1].similarity >= result->candidates[i].similarity);
+  }
+
+  similarity_candidate_array_free(result);
+  minhash_index_destroy(index);
+  free(a);
+  free(b);
+  free(c);
+}
+
+TEST(ignores_same_side_and_blank_files) {
+  static char a_store[FILE_LINES][64];
+  const char **a = make_file(a_store, "gamma", FILE_LINES);
+  const char *blank[] = {"", "   ", "\t"};
+
+  MinHashIndex *index = minhash_index_create();
+  minhash_index_add(index, a, FILE_LINES, true);
+  minhash_index_add(index, a, FILE_LINES, true); // Same side: never paired
+  minhash_index_add(index, blank, 3, true);
+  minhash_index_add(index, blank, 3, false);
+  minhash_index_add(index, NULL, 0, false);
+
+  SimilarityCandidateArray *result = minhash_index_find_candidates(index, 0.0);
+  CHECK(result != NULL);
+  CHECK(result->count == 0);
+
+  similarity_candidate_array_free(result);
+  minhash_index_destroy(index);
+  free(a);
+}
+
+TEST(whitespace_insensitive_line_ids) {
+  const char *original[] = {"int main() {", "  return 0;", "}", "// end"};
+  const char *reindented[] = {"int main() {", "\treturn 0;", "}", "// end"};
+
+  MinHashIndex *index = minhash_index_create();
+  int orig = minhash_index_add(index, original, 4, true);
+  int mod = minhash_index_add(index, reindented, 4, false);
+
+  SimilarityCandidateArray *result = minhash_index_find_candidates(index, 0.9);
+  const SimilarityCandidate *pair = find_pair(result, orig, mod);
+  CHECK(pair != NULL);
+  CHECK(pair->similarity == 1.0);
+
+  similarity_candidate_array_free(result);
+  minhash_index_destroy(index);
+}
+
+TEST(oversized_buckets_are_skipped) {
+  static char common_store[FILE_LINES][64], a_store[FILE_LINES][64];
+  const char **common = make_file(common_store, "boilerplate", FILE_LINES);
+  const char **a = make_file(a_store, "delta", FILE_LINES);
+
+  // More identical files than one bucket may hold, on both sides
+  MinHashIndex *index = minhash_index_create();
+  for (int i = 0; i < MINHASH_MAX_BUCKET_SIZE; i++) {
+    minhash_index_add(index, common, FILE_LINES, i % 2 == 0);
+  }
+  int orig = minhash_index_add(index, a, FILE_LINES, true);
+  int mod = minhash_index_add(index, a, FILE_LINES, false);
+  minhash_index_add(index, common, FILE_LINES, true);
+
+  SimilarityCandidateArray *result = minhash_index_find_candidates(index, 0.5);
+  CHECK(result != NULL);
+  CHECK(result->count == 1);
+  CHECK(find_pair(result, orig, mod) != NULL);
+
+  similarity_candidate_array_free(result);
+  minhash_index_destroy(index);
+  free(common);
+  free(a);
+}
+
+int main(void) {
+  printf("\n========================================\n");
+  printf("MinHash Similarity Index Tests\n");
+  printf("========================================\n\n");
+
+  RUN_TEST(pairs_renamed_files);
+  RUN_TEST(ignores_same_side_and_blank_files);
+  RUN_TEST(whitespace_insensitive_line_ids);
+  RUN_TEST(oversized_buckets_are_skipped);
+
+  printf("\n✅ All MinHash tests passed\n");
+  return 0;
+}
@@ -0,0 +1,169 @@
+/**
+ * Moved Code Detection Tests
+ *
+ * Tests compute_diff() with compute_moves enabled:
+ * - A function moved between regions is reported as one move
+ * - A moved block with small edits is paired via histogram similarity
+ * - Moves are not reported when compute_moves is off
+ * - Repetitive input (blank lines, braces) stays bounded
+ */
+
+#include "default_lines_diff_computer.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_LINES 4096
+
+// Append "<name> body line <i>" style lines for a synthetic function
+static void append_function(TestLines *lines, const char *name, int body_lines) {
+  test_lines_add(lines, "function %s() {", name);
+  for (int i = 0; i < body_lines; i++) {
+    test_lines_add(lines, "  local %s_value_%d = %d", name, i, i * 7);
+  }
+  test_lines_add(lines, "end");
+}
+
+static DiffOptions moves_options(void) {
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = 0,
+                         .compute_moves = true,
+                         .extend_to_subwords = false};
+  return options;
+}
+
+TEST(function_moved_between_regions) {
+  // original: alpha, beta, gamma    modified: beta, gamma, alpha
+  TestLines old_lines = test_lines_create(MAX_LINES);
+  append_function(&old_lines, "alpha", 10);
+  append_function(&old_lines, "beta", 10);
+  append_function(&old_lines, "gamma", 10);
+
+  TestLines new_lines = test_lines_create(MAX_LINES);
+  append_function(&new_lines, "beta", 10);
+  append_function(&new_lines, "gamma", 10);
+  append_function(&new_lines, "alpha", 10);
+
+  const char **original = old_lines.lines;
+  const char **modified = new_lines.lines;
+  int n1 = old_lines.count;
+  int n2 = new_lines.count;
+  DiffOptions options = moves_options();
+
+  LinesDiff *diff = compute_diff(original, n1, modified, n2, &options);
+  CHECK(diff != NULL);
+  printf("  changes=%d moves=%d\n", diff->changes.count, diff->moves.count);
+  CHECK(diff->moves.count == 1);
+
+  const MovedText *move = &diff->moves.moves[0];
+  printf("  move: [%d,%d) -> [%d,%d)\n", move->original.start_line, move->original.end_line,
+         move->modified.start_line, move->modified.end_line);
+  CHECK(move->original.end_line - move->original.start_line ==
+        move->modified.end_line - move->modified.start_line);
+  CHECK(move->original.end_line - move->original.start_line >= 10);
+
+  // Every moved line is identical on both sides
+  for (int i = 0; i < move->original.end_line - move->original.start_line; i++) {
+    CHECK(strcmp(original[move->original.start_line - 1 + i],
+                 modified[move->modified.start_line - 1 + i]) == 0);
+  }
+  free_lines_diff(diff);
+
+  // Same input without compute_moves
+  options.compute_moves = false;
+  diff = compute_diff(original, n1, modified, n2, &options);
+  CHECK(diff != NULL);
+  CHECK(diff->moves.count == 0);
+  free_lines_diff(diff);
+
+  test_lines_free(&old_lines);
+  test_lines_free(&new_lines);
+}
+
+TEST(moved_block_with_edits) {
+  // delta moves from the top to the bottom and one of its lines is edited
+  TestLines old_lines = test_lines_create(MAX_LINES);
+  append_function(&old_lines, "delta", 8);
+  for (int i = 0; i < 20; i++) {
+    test_lines_add(&old_lines, "print('unchanged %d')", i);
+  }
+
+  TestLines new_lines = test_lines_create(MAX_LINES);
+  for (int i = 0; i < 20; i++) {
+    test_lines_add(&new_lines, "print('unchanged %d')", i);
+  }
+  int moved_start = new_lines.count;
+  append_function(&new_lines, "delta", 8);
+  test_lines_set(&new_lines, moved_start + 4, "  local delta_value_3 = 22");
+
+  const char **original = old_lines.lines;
+  const char **modified = new_lines.lines;
+  int n1 = old_lines.count;
+  int n2 = new_lines.count;
+  DiffOptions options = moves_options();
+
+  LinesDiff *diff = compute_diff(original, n1, modified, n2, &options);
+  CHECK(diff != NULL);
+  printf("  changes=%d moves=%d\n", diff->changes.count, diff->moves.count);
+  CHECK(diff->moves.count == 1);
+  CHECK(diff->moves.moves[0].original.start_line == 1);
+  CHECK(diff->moves.moves[0].original.end_line == 11);
+  CHECK(diff->moves.moves[0].modified.start_line == moved_start + 1);
+  CHECK(diff->moves.moves[0].modified.end_line == moved_start + 11);
+  free_lines_diff(diff);
+
+  test_lines_free(&old_lines);
+  test_lines_free(&new_lines);
+}
+
+TEST(no_moves_for_plain_edits) {
+  const char *original[] = {"int a = 1;", "int b = 2;", "int c = 3;", "int d = 4;"};
+  const char *modified[] = {"int a = 1;", "int b = 20;", "int c = 3;", "int e = 5;"};
+  DiffOptions options = moves_options();
+
+  LinesDiff *diff = compute_diff(original, 4, modified, 4, &options);
+  CHECK(diff != NULL);
+  CHECK(diff->moves.count == 0);
+  free_lines_diff(diff);
+}
+
+TEST(repetitive_input_is_bounded) {
+  // Thousands of identical windows ("}", "", "}") on both sides
+  TestLines old_lines = test_lines_create(MAX_LINES);
+  TestLines new_lines = test_lines_create(MAX_LINES);
+  for (int i = 0; i < 1500; i++) {
+    test_lines_add(&old_lines, "%s", i % 2 ? "}" : "");
+    test_lines_add(&new_lines, "%s", i % 3 ? "}" : "");
+  }
+
+  const char **original = old_lines.lines;
+  const char **modified = new_lines.lines;
+  int n1 = old_lines.count;
+  int n2 = new_lines.count;
+  DiffOptions options = moves_options();
+  options.max_computation_time_ms = 5000;
+
+  LinesDiff *diff = compute_diff(original, n1, modified, n2, &options);
+  CHECK(diff != NULL);
+  printf("  changes=%d moves=%d timeout=%d\n", diff->changes.count, diff->moves.count,
+         diff->hit_timeout);
+  CHECK(!diff->hit_timeout);
+  free_lines_diff(diff);
+
+  test_lines_free(&old_lines);
+  test_lines_free(&new_lines);
+}
+
+int main(void) {
+  printf("\n========================================\n");
+  printf("Moved Code Detection Tests\n");
+  printf("========================================\n\n");
+
+  RUN_TEST(function_moved_between_regions);
+  RUN_TEST(moved_block_with_edits);
+  RUN_TEST(no_moves_for_plain_edits);
+  RUN_TEST(repetitive_input_is_bounded);
+
+  printf("\n✅ All moved code tests passed\n");
+  return 0;
+}
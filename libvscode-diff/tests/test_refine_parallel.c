@@ -0,0 +1,117 @@
+/**
+ * Parallel Refinement Cutoff Tests
+ *
+ * Tests the work estimate and worker count (refine_parallel.h):
+ * - Work units count region characters and the unchanged lines between regions
+ * - Small work stays serial; workers are capped by threads, REFINE_MAX_THREADS,
+ *   regions and work
+ * - compute_diff() gives the same result serial and with every region parallel,
+ *   and DiffStats.allocations includes the workers' allocations
+ */
+
+#include "default_lines_diff_computer.h"
+#include "refine_parallel.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#define HUNK_COUNT 40
+#define PERIOD 4 // One changed line every PERIOD lines
+
+TEST(work_units) {
+  const char *original[] = {"same", "abc", "same", "same", "de"};
+  const char *modified[] = {"same", "abcd", "same", "same", "xy", "z"};
+  SequenceDiff diffs[] = {{1, 2, 1, 2}, {4, 5, 4, 6}};
+  SequenceDiffArray regions = {diffs, 2, 2};
+  // Gaps of 1 and 2 lines, then 3 + 4 and 2 + 3 characters
+  CHECK(refine_work_units(&regions, original, modified) == 1 + 7 + 2 + 5);
+
+  SequenceDiffArray empty = {NULL, 0, 0};
+  CHECK(refine_work_units(&empty, original, modified) == 0);
+}
+
+TEST(worker_count) {
+  CHECK(refine_worker_count(REFINE_PARALLEL_MIN_WORK_UNITS - 1, 100, 8) == 1);
+  CHECK(refine_worker_count(1000000, 100, 8) == 8);
+  CHECK(refine_worker_count(1000000, 3, 8) == 3);
+  CHECK(refine_worker_count(1000000, 100, 1) == 1);
+  CHECK(refine_worker_count(1000000, 100, 64) == REFINE_MAX_THREADS);
+
+  // Work for three threads only
+  refine_set_parallel_cutoff(0, REFINE_WORK_UNITS_PER_THREAD);
+  CHECK(refine_worker_count(3 * REFINE_WORK_UNITS_PER_THREAD + 1, 100, 8) == 3);
+  refine_set_parallel_cutoff(0, 0);
+  CHECK(refine_worker_count(1, 100, 8) == 8);
+  CHECK(refine_worker_count(1, 1, 8) == 1);
+  CHECK(refine_worker_count(1, 100, 64) == 64);
+  refine_set_parallel_cutoff(-1, -1);
+  CHECK(refine_worker_count(1000000, 100, 64) == REFINE_MAX_THREADS);
+  CHECK(refine_worker_count(1, 100, 8) == 1);
+}
+
+static LinesDiff *run_diff(const char **original, const char **modified, int count) {
+  DiffOptions options = {.max_computation_time_ms = 0, .collect_stats = true};
+  return compute_diff(original, count, modified, count, &options);
+}
+
+TEST(parallel_matches_serial) {
+  static char store_a[HUNK_COUNT * PERIOD][64];
+  static char store_b[HUNK_COUNT * PERIOD][64];
+  const char *a[HUNK_COUNT * PERIOD];
+  const char *b[HUNK_COUNT * PERIOD];
+  for (int i = 0; i < HUNK_COUNT * PERIOD; i++) {
+    snprintf(store_a[i], sizeof(store_a[i]), "  value_%d = compute(%d)", i, i * 7);
+    snprintf(store_b[i], sizeof(store_b[i]),
+             i % PERIOD == 1 ? "  value_%d = compute(%d, x)" : "  value_%d = compute(%d)", i, i * 7);
+    a[i] = store_a[i];
+    b[i] = store_b[i];
+  }
+
+  refine_set_parallel_cutoff(INT64_MAX, 0);
+  LinesDiff *serial = run_diff(a, b, HUNK_COUNT * PERIOD);
+  refine_set_parallel_cutoff(0, 0);
+#ifdef USE_OPENMP
+  // A team even on a single-core machine
+  int max_threads = omp_get_max_threads();
+  omp_set_num_threads(4);
+#endif
+  LinesDiff *parallel = run_diff(a, b, HUNK_COUNT * PERIOD);
+#ifdef USE_OPENMP
+  omp_set_num_threads(max_threads);
+#endif
+  refine_set_parallel_cutoff(-1, -1);
+
+  CHECK(serial != NULL && parallel != NULL);
+  CHECK(serial->changes.count == HUNK_COUNT);
+  CHECK(serial->changes.count == parallel->changes.count);
+  // Same per-region work, plus the parallel path's own result arrays
+  CHECK(parallel->stats.allocations >= serial->stats.allocations);
+  for (int i = 0; i < serial->changes.count; i++) {
+    const DetailedLineRangeMapping *s = &serial->changes.mappings[i];
+    const DetailedLineRangeMapping *p = &parallel->changes.mappings[i];
+    CHECK(memcmp(&s->original, &p->original, sizeof(LineRange)) == 0);
+    CHECK(memcmp(&s->modified, &p->modified, sizeof(LineRange)) == 0);
+    CHECK(s->inner_change_count == p->inner_change_count);
+    CHECK(memcmp(s->inner_changes, p->inner_changes,
+                 (size_t)s->inner_change_count * sizeof(RangeMapping)) == 0);
+  }
+  free_lines_diff(serial);
+  free_lines_diff(parallel);
+}
+
+int main(void) {
+  printf("\n========================================\n");
+  printf("Parallel Refinement Cutoff Tests\n");
+  printf("========================================\n\n");
+
+  RUN_TEST(work_units);
+  RUN_TEST(worker_count);
+  RUN_TEST(parallel_matches_serial);
+
+  printf("\n✅ All parallel refinement cutoff tests passed\n");
+  return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * Slow-Diff Reproducer Tests
+ *
+ * Tests reproducer capture and .case parsing (repro.h):
+ * - A call over the threshold writes inputs and options that read back exactly
+ * - Calls under the threshold or over the input size limit are not captured
+ * - Capture stops after max_cases reproducers
+ * - DiffStats collected for capture are not leaked to callers that did not ask
+ */
+
+#include "default_lines_diff_computer.h"
+#include "repro.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPRO_DIR "."
+
+static const char *original[] = {"int main() {", "  return 0;", "}"};
+static const char *modified[] = {"int main(void) {", "  return 1;", "}", ""};
+
+static DiffOptions options = {.ignore_trim_whitespace = true,
+                              .max_computation_time_ms = 1234,
+                              .compute_moves = true,
+                              .extend_to_subwords = false,
+                              .rewrite_threshold = 0.25,
+                              .collect_stats = false,
+                              .quality = DIFF_QUALITY_FAST};
+
+static LinesDiff *run_diff(void) { return compute_diff(original, 3, modified, 4, &options); }
+
+static char *read_file(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *content = (char *)malloc((size_t)size + 1);
+  size_t read = fread(content, 1, (size_t)size, file);
+  content[read] = '\0';
+  fclose(file);
+  return content;
+}
+
+// Remove the .case file and its .original/.modified siblings
+static void remove_case(const char *case_path) {
+  char path[1300];
+  size_t stem_len = strlen(case_path) - strlen(DIFF_REPRO_CASE_EXT);
+  snprintf(path, sizeof(path), "%.*s.original", (int)stem_len, case_path);
+  remove(path);
+  snprintf(path, sizeof(path), "%.*s.modified", (int)stem_len, case_path);
+  remove(path);
+  remove(case_path);
+}
+
+TEST(slow_call_round_trips) {
+  int before = diff_repro_captured();
+  CHECK(diff_repro_enable(REPRO_DIR, 0.0, 0, 0));
+  LinesDiff *diff = run_diff();
+  diff_repro_disable();
+  CHECK(diff != NULL);
+  CHECK(diff_repro_captured() == before + 1);
+
+  char case_path[1300];
+  snprintf(case_path, sizeof(case_path), "%s", diff_repro_last_case());
+  DiffReproCase repro;
+  CHECK(diff_repro_read_case(case_path, &repro));
+  CHECK(repro.options.ignore_trim_whitespace);
+  CHECK(repro.options.max_computation_time_ms == 1234);
+  CHECK(repro.options.compute_moves);
+  CHECK(!repro.options.extend_to_subwords);
+  CHECK(repro.options.rewrite_threshold == 0.25);
+  CHECK(repro.options.quality == DIFF_QUALITY_FAST);
+  CHECK(repro.original_count == 3);
+  CHECK(repro.modified_count == 4);
+  CHECK(repro.changes == diff->changes.count);
+  CHECK(repro.captured_ms >= 0.0);
+
+  char path[1300];
+  size_t stem_len = strlen(case_path) - strlen(DIFF_REPRO_CASE_EXT);
+  snprintf(path, sizeof(path), "%.*s.modified", (int)stem_len, case_path);
+  char *text = read_file(path);
+  CHECK(text != NULL);
+  CHECK(strcmp(text, "int main(void) {\n  return 1;\n}\n") == 0);
+  free(text);
+
+  // Stats were collected for the .case file only
+  CHECK(diff->stats.total_ms == 0.0);
+  text = read_file(case_path);
+  CHECK(text != NULL && strstr(text, "hash_ms = ") != NULL);
+  free(text);
+
+  free_lines_diff(diff);
+  remove_case(case_path);
+}
+
+TEST(limits_skip_capture) {
+  int before = diff_repro_captured();
+
+  // Fast call under the threshold
+  CHECK(diff_repro_enable(REPRO_DIR, 60000.0, 0, 0));
+  free_lines_diff(run_diff());
+  CHECK(diff_repro_captured() == before);
+
+  // Input larger than the size limit
+  CHECK(diff_repro_enable(REPRO_DIR, 0.0, 16, 0));
+  free_lines_diff(run_diff());
+  CHECK(diff_repro_captured() == before);
+
+  // Case limit: only the first of two calls is captured
+  CHECK(diff_repro_enable(REPRO_DIR, 0.0, 0, before + 1));
+  free_lines_diff(run_diff());
+  char first_case[1300];
+  snprintf(first_case, sizeof(first_case), "%s", diff_repro_last_case());
+  free_lines_diff(run_diff());
+  diff_repro_disable();
+  CHECK(diff_repro_captured() == before + 1);
+  CHECK(strcmp(first_case, diff_repro_last_case()) == 0);
+  remove_case(first_case);
+}
+
+int main(void) {
+  printf("\n========================================\n");
+  printf("Slow-Diff Reproducer Tests\n");
+  printf("========================================\n\n");
+
+  RUN_TEST(slow_call_round_trips);
+  RUN_TEST(limits_skip_capture);
+
+  printf("\n✅ All reproducer tests passed\n");
+  return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * Size Limit Tests
+ *
+ * Tests the 2^31 boundary of the int-typed diff structures:
+ * - Checked size math and capacity growth stop at SIZE_MAX / INT_MAX
+ * - A refined region of more than INT_MAX characters becomes one unrefined
+ *   change, also through compute_diff() (synthetic input: one 16 MiB line
+ *   shared by every line pointer)
+ * - compute_diff_buffers() takes size_t lengths
+ */
+
+#include "char_level.h"
+#include "default_lines_diff_computer.h"
+#include "sequence.h"
+#include "test_utils.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BIG_LINE_BYTES (16 * 1024 * 1024)
+// 129 * (16 MiB + 1) bytes is just over 2^31
+#define BIG_LINE_COUNT 129
+
+TEST(checked_size_math) {
+  size_t bytes = 0;
+  CHECK(diff_size_mul((size_t)1 << 31, 8, &bytes));
+  CHECK(bytes == (size_t)1 << 34);
+  CHECK(!diff_size_mul(SIZE_MAX / 2 + 1, 2, &bytes));
+  CHECK(diff_size_mul(SIZE_MAX, 0, &bytes) && bytes == 0);
+
+  CHECK(diff_malloc_array(SIZE_MAX / 4 + 1, 8) == NULL);
+  int *buffer = (int *)diff_malloc_array(4, sizeof(int));
+  CHECK(buffer != NULL);
+  buffer[3] = 42;
+  // A failed resize leaves the original buffer intact
+  CHECK(diff_realloc_array(buffer, SIZE_MAX, 2) == NULL);
+  CHECK(buffer[3] == 42);
+  free(buffer);
+}
+
+TEST(capacity_growth_boundary) {
+  CHECK(diff_grow_capacity(0, 16) == 16);
+  CHECK(diff_grow_capacity(16, 8) == 32);
+  CHECK(diff_grow_capacity(DIFF_MAX_ELEMENTS / 2, 16) == DIFF_MAX_ELEMENTS - 1);
+  CHECK(diff_grow_capacity(DIFF_MAX_ELEMENTS / 2 + 1, 16) == DIFF_MAX_ELEMENTS);
+  CHECK(diff_grow_capacity(DIFF_MAX_ELEMENTS, 16) == -1);
+}
+
+static char *big_line_a;
+static char *big_line_b;
+static const char *big_lines_a[BIG_LINE_COUNT];
+static const char *big_lines_b[BIG_LINE_COUNT];
+
+// Both sides: BIG_LINE_COUNT pointers to one 16 MiB line; side B differs mid-line
+static void make_big_lines(void) {
+  big_line_a = (char *)malloc(BIG_LINE_BYTES + 1);
+  big_line_b = (char *)malloc(BIG_LINE_BYTES + 1);
+  CHECK(big_line_a && big_line_b);
+  memset(big_line_a, 'a', BIG_LINE_BYTES);
+  memset(big_line_b, 'a', BIG_LINE_BYTES);
+  big_line_a[BIG_LINE_BYTES] = '\0';
+  big_line_b[BIG_LINE_BYTES] = '\0';
+  big_line_b[BIG_LINE_BYTES / 2] = 'b';
+  for (int i = 0; i < BIG_LINE_COUNT; i++) {
+    big_lines_a[i] = big_line_a;
+    big_lines_b[i] = big_line_b;
+  }
+}
+
+TEST(oversized_region_left_unrefined) {
+  const char **lines_a = big_lines_a;
+  const char **lines_b = big_lines_b;
+
+  // Over the limit: no sequence instead of wrapped int lengths
+  CharRange range = {.start_line = 1, .start_col = 1, .end_line = BIG_LINE_COUNT, .end_col = 1};
+  CHECK(char_sequence_create_from_range(lines_a, BIG_LINE_COUNT, &range, true) == NULL);
+
+  SequenceDiff region = {0, BIG_LINE_COUNT, 0, BIG_LINE_COUNT};
+  CharLevelOptions options = {.consider_whitespace_changes = true};
+  bool hit_timeout = false;
+  RangeMappingArray *unrefined = refine_diff_char_level(&region, lines_a, BIG_LINE_COUNT, lines_b,
+                                                        BIG_LINE_COUNT, &options, &hit_timeout);
+  CHECK(unrefined != NULL && unrefined->count == 1);
+  CHECK(unrefined->mappings[0].original.start_line == 1);
+  CHECK(unrefined->mappings[0].original.start_col == 1);
+  CHECK(unrefined->mappings[0].original.end_line == BIG_LINE_COUNT);
+  CHECK(unrefined->mappings[0].original.end_col == BIG_LINE_BYTES + 1);
+  CHECK(memcmp(&unrefined->mappings[0].original, &unrefined->mappings[0].modified,
+               sizeof(CharRange)) == 0);
+  range_mapping_array_free(unrefined);
+
+  // One line is well within the limit
+  range.end_line = 1;
+  range.end_col = 11;
+  ISequence *seq = char_sequence_create_from_range(lines_a, BIG_LINE_COUNT, &range, true);
+  CHECK(seq != NULL);
+  CHECK(seq->getLength(seq) == 10);
+  seq->destroy(seq);
+}
+
+TEST(oversized_region_kept_by_compute_diff) {
+  DiffOptions options = {.max_computation_time_ms = 0};
+  LinesDiff *diff =
+      compute_diff(big_lines_a, BIG_LINE_COUNT, big_lines_b, BIG_LINE_COUNT, &options);
+  CHECK(diff != NULL);
+  CHECK(diff->changes.count == 1);
+  const DetailedLineRangeMapping *change = &diff->changes.mappings[0];
+  CHECK(change->original.start_line == 1 && change->original.end_line == BIG_LINE_COUNT + 1);
+  CHECK(change->modified.start_line == 1 && change->modified.end_line == BIG_LINE_COUNT + 1);
+  CHECK(change->inner_change_count == 1);
+  free_lines_diff(diff);
+}
+
+TEST(buffer_lengths) {
+  DiffOptions options = {.max_computation_time_ms = 0};
+  CHECK(compute_diff_buffers(NULL, (size_t)1 << 31, NULL, 0, &options) == NULL);
+  CHECK(compute_diff_buffers(NULL, 0, NULL, SIZE_MAX, &options) == NULL);
+  CHECK(get_api_version() == VSCODE_DIFF_API_VERSION);
+}
+
+int main(void) {
+  printf("\n========================================\n");
+  printf("Size Limit Tests\n");
+  printf("========================================\n\n");
+
+  RUN_TEST(checked_size_math);
+  RUN_TEST(capacity_growth_boundary);
+  make_big_lines();
+  RUN_TEST(oversized_region_left_unrefined);
+  RUN_TEST(oversized_region_kept_by_compute_diff);
+  free(big_line_a);
+  free(big_line_b);
+  RUN_TEST(buffer_lengths);
+
+  printf("\n✅ All size limit tests passed\n");
+  return 0;
+}
@@ -0,0 +1,218 @@
+/**
+ * Sparse LCS (Hunt-Szymanski) Tests
+ *
+ * Tests sparse_lcs_diff_algorithm() and its selection (sparse_lcs.h):
+ * - Small hand-written cases produce the expected diffs
+ * - On random inputs the result is a valid alignment with Myers' edit distance
+ * - compute_line_alignments() picks it for rewrites in fast mode only, and keeps
+ *   Myers for small edits
+ */
+
+#include "line_level.h"
+#include "myers.h"
+#include "sparse_lcs.h"
+#include "string_hash_map.h"
+#include "test_utils.h"
+#include <stdio.h>
+#include <string.h>
+
+#define RANDOM_CASES 300
+#define MAX_RANDOM_LINES 120
+#define REWRITE_LINES 3000
+
+static uint32_t rng_state = 0x5eed;
+
+static int rng_below(int n) {
+  rng_state = rng_state * 1664525u + 1013904223u;
+  return (int)((rng_state >> 8) % (uint32_t)n);
+}
+
+typedef struct {
+  StringHashMap *map;
+  ISequence *seq1;
+  ISequence *seq2;
+} Sequences;
+
+static Sequences sequences_create(const char **a, int len_a, const char **b, int len_b) {
+  Sequences s;
+  s.map = string_hash_map_create();
+  s.seq1 = line_sequence_create(a, len_a, true, s.map);
+  s.seq2 = line_sequence_create(b, len_b, true, s.map);
+  return s;
+}
+
+static void sequences_destroy(Sequences *s) {
+  s->seq1->destroy(s->seq1);
+  s->seq2->destroy(s->seq2);
+  string_hash_map_destroy(s->map);
+}
+
+static SequenceDiffArray *run_sparse(Sequences *s) {
+  bool hit_timeout = true;
+  SequenceDiffArray *diffs =
+      sparse_lcs_diff_algorithm(s->seq1, s->seq2, string_hash_map_size(s->map), 0, &hit_timeout);
+  CHECK(diffs != NULL);
+  CHECK(!hit_timeout);
+  return diffs;
+}
+
+static int edit_distance(const SequenceDiffArray *diffs) {
+  int distance = 0;
+  for (int i = 0; i < diffs->count; i++) {
+    const SequenceDiff *d = &diffs->diffs[i];
+    distance += (d->seq1_end - d->seq1_start) + (d->seq2_end - d->seq2_start);
+  }
+  return distance;
+}
+
+// Diffs are sorted, non-empty, and every line between them matches
+static bool alignment_valid(const Sequences *s, const SequenceDiffArray *diffs) {
+  int len_a = s->seq1->getLength(s->seq1);
+  int len_b = s->seq2->getLength(s->seq2);
+  int a = 0;
+  int b = 0;
+  for (int i = 0; i <= diffs->count; i++) {
+    int next_a = i < diffs->count ? diffs->diffs[i].seq1_start : len_a;
+    int next_b = i < diffs->count ? diffs->diffs[i].seq2_start : len_b;
+    if (next_a - a != next_b - b || next_a < a) {
+      return false;
+    }
+    for (; a < next_a; a++, b++) {
+      if (s->seq1->getElement(s->seq1, a) != s->seq2->getElement(s->seq2, b)) {
+        return false;
+      }
+    }
+    if (i < diffs->count) {
+      const SequenceDiff *d = &diffs->diffs[i];
+      if (d->seq1_end < d->seq1_start || d->seq2_end < d->seq2_start ||
+          (d->seq1_end == d->seq1_start && d->seq2_end == d->seq2_start)) {
+        return false;
+      }
+      a = d->seq1_end;
+      b = d->seq2_end;
+    }
+  }
+  return a == len_a && b == len_b;
+}
+
+TEST(small_cases) {
+  const char *a[] = {"a", "b", "c", "d"};
+  const char *b[] = {"a", "x", "c", "d", "e"};
+  Sequences s = sequences_create(a, 4, b, 5);
+  SequenceDiffArray *diffs = run_sparse(&s);
+  CHECK(diffs->count == 2);
+  ASSERT_DIFF(diffs, 0, 1, 2, 1, 2);
+  ASSERT_DIFF(diffs, 1, 4, 4, 4, 5);
+  free_sequence_diff_array(diffs);
+  sequences_destroy(&s);
+
+  // Identical
+  s = sequences_create(a, 4, a, 4);
+  diffs = run_sparse(&s);
+  CHECK(diffs->count == 0);
+  free_sequence_diff_array(diffs);
+  sequences_destroy(&s);
+
+  // One side empty
+  s = sequences_create(a, 4, b, 0);
+  diffs = run_sparse(&s);
+  CHECK(diffs->count == 1);
+  ASSERT_DIFF(diffs, 0, 0, 4, 0, 0);
+  free_sequence_diff_array(diffs);
+  sequences_destroy(&s);
+
+  // Nothing in common
+  const char *c[] = {"p", "q"};
+  s = sequences_create(a, 4, c, 2);
+  diffs = run_sparse(&s);
+  CHECK(diffs->count == 1);
+  ASSERT_DIFF(diffs, 0, 0, 4, 0, 2);
+  free_sequence_diff_array(diffs);
+  sequences_destroy(&s);
+}
+
+TEST(random_matches_myers_distance) {
+  static char store_a[MAX_RANDOM_LINES][16];
+  static char store_b[MAX_RANDOM_LINES][16];
+  const char *a[MAX_RANDOM_LINES];
+  const char *b[MAX_RANDOM_LINES];
+
+  for (int c = 0; c < RANDOM_CASES; c++) {
+    int len_a = rng_below(MAX_RANDOM_LINES);
+    int len_b = rng_below(MAX_RANDOM_LINES);
+    // Small alphabets give many repeated lines, large ones few matches
+    int alphabet = 2 + rng_below(c % 2 ? 8 : 200);
+    for (int i = 0; i < len_a; i++) {
+      snprintf(store_a[i], sizeof(store_a[i]), "line %d", rng_below(alphabet));
+      a[i] = store_a[i];
+    }
+    for (int i = 0; i < len_b; i++) {
+      snprintf(store_b[i], sizeof(store_b[i]), "line %d", rng_below(alphabet));
+      b[i] = store_b[i];
+    }
+
+    Sequences s = sequences_create(a, len_a, b, len_b);
+    SequenceDiffArray *sparse = run_sparse(&s);
+    bool hit_timeout = false;
+    SequenceDiffArray *myers = myers_nd_diff_algorithm(s.seq1, s.seq2, 0, &hit_timeout);
+    CHECK(alignment_valid(&s, sparse));
+    CHECK(edit_distance(sparse) == edit_distance(myers));
+    free_sequence_diff_array(sparse);
+    free_sequence_diff_array(myers);
+    sequences_destroy(&s);
+  }
+}
+
+static int alignment_algorithm(const char **a, const char **b, int count, DiffQuality quality) {
+  bool hit_timeout = false;
+  DiffStats stats;
+  memset(&stats, 0, sizeof(stats));
+  SequenceDiffArray *diffs =
+      compute_line_alignments(a, count, b, count, 0, 0.0, quality, &hit_timeout, NULL, &stats);
+  CHECK(diffs != NULL);
+  free_sequence_diff_array(diffs);
+  return stats.algorithm;
+}
+
+TEST(selection) {
+  static char store_a[REWRITE_LINES][32];
+  static char store_b[REWRITE_LINES][32];
+  static const char *a[REWRITE_LINES];
+  static const char *b[REWRITE_LINES];
+
+  // Rewrite keeping every 5th line: Myers would run to D ~ 4800
+  for (int i = 0; i < REWRITE_LINES; i++) {
+    snprintf(store_a[i], sizeof(store_a[i]), "old %d", i);
+    snprintf(store_b[i], sizeof(store_b[i]), i % 5 == 0 ? "old %d" : "new %d", i);
+    a[i] = store_a[i];
+    b[i] = store_b[i];
+  }
+  CHECK(alignment_algorithm(a, b, REWRITE_LINES, DIFF_QUALITY_FAST) == DIFF_ALGORITHM_SPARSE);
+  // Parity never leaves VSCode's engines
+  CHECK(alignment_algorithm(a, b, REWRITE_LINES, DIFF_QUALITY_PARITY) == DIFF_ALGORITHM_MYERS);
+
+  // Below the DP cutoff parity keeps DP; fast mode may use sparse
+  CHECK(alignment_algorithm(a, b, 600, DIFF_QUALITY_PARITY) == DIFF_ALGORITHM_DP);
+  CHECK(alignment_algorithm(a, b, 600, DIFF_QUALITY_FAST) == DIFF_ALGORITHM_SPARSE);
+
+  // A few scattered edits: Myers is cheap
+  for (int i = 0; i < REWRITE_LINES; i++) {
+    snprintf(store_b[i], sizeof(store_b[i]), i % 100 == 0 ? "new %d" : "old %d", i);
+  }
+  CHECK(alignment_algorithm(a, b, REWRITE_LINES, DIFF_QUALITY_FAST) == DIFF_ALGORITHM_MYERS);
+
+  CHECK(!sparse_lcs_preferred(50, 50, 0, 0));
+}
+
+int main(void) {
+  printf("\n========================================\n");
+  printf("Sparse LCS Tests\n");
+  printf("========================================\n\n");
+
+  RUN_TEST(small_cases);
+  RUN_TEST(random_matches_myers_distance);
+  RUN_TEST(selection);
+
+  printf("\n✅ All sparse LCS tests passed\n");
+  return 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * Trace Event Tests
+ *
+ * Tests the Chrome trace-event recorder (trace.h):
+ * - Every refined region gets a balanced begin/end pair
+ * - Pipeline stages are recorded once per compute_diff() call
+ * - Nothing is recorded while tracing is disabled
+ * - A full ring buffer keeps the newest events and reports the dropped ones
+ */
+
+#include "default_lines_diff_computer.h"
+#include "test_utils.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_FILE "test_trace_output.json"
+#define LINE_COUNT 400
+
+static char *read_trace(void) {
+  FILE *file = fopen(TRACE_FILE, "rb");
+  if (!file) {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *content = (char *)malloc((size_t)size + 1);
+  size_t read = fread(content, 1, (size_t)size, file);
+  content[read] = '\0';
+  fclose(file);
+  return content;
+}
+
+static int count_occurrences(const char *haystack, const char *needle) {
+  int count = 0;
+  size_t needle_len = strlen(needle);
+  for (const char *p = strstr(haystack, needle); p; p = strstr(p + needle_len, needle)) {
+    count++;
+  }
+  return count;
+}
+
+static LinesDiff *diff_with_edits(int edit_every) {
+  TestLines original = test_lines_create(LINE_COUNT);
+  TestLines modified = test_lines_create(LINE_COUNT);
+  for (int i = 0; i < LINE_COUNT; i++) {
+    test_lines_add(&original, "line %d = value(%d);", i, i);
+    if (i % edit_every == 5) {
+      test_lines_add(&modified, "line %d = value(%d + 1);", i, i);
+    } else {
+      test_lines_add(&modified, "line %d = value(%d);", i, i);
+    }
+  }
+  DiffOptions options = {.ignore_trim_whitespace = false,
+                         .max_computation_time_ms = 0,
+                         .compute_moves = false,
+                         .extend_to_subwords = false,
+                         .collect_stats = true};
+  LinesDiff *diff = compute_diff(original.lines, LINE_COUNT, modified.lines, LINE_COUNT, &options);
+  test_lines_free(&original);
+  test_lines_free(&modified);
+  return diff;
+}
+
+TEST(regions_have_balanced_events) {
+  diff_trace_reset();
+  diff_trace_enable(true);
+  LinesDiff *diff = diff_with_edits(40);
+  diff_trace_enable(false);
+  CHECK(diff != NULL);
+  CHECK(diff_trace_dump(TRACE_FILE));
+
+  char *trace = read_trace();
+  CHECK(trace != NULL);
+  CHECK(strncmp(trace, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 38) == 0);
+
+  int regions = diff->stats.refined_regions;
+  int begins =
+      count_occurrences(trace, "\"name\":\"refine_diff_char_level\",\"cat\":\"region\",\"ph\":\"B\"");
+  int ends =
+      count_occurrences(trace, "\"name\":\"refine_diff_char_level\",\"cat\":\"region\",\"ph\":\"E\"");
+  printf("  regions=%d begins=%d ends=%d\n", regions, begins, ends);
+  CHECK(regions == 10);
+  CHECK(begins == regions);
+  CHECK(ends == regions);
+  CHECK(count_occurrences(trace, "\"ph\":\"B\"") == count_occurrences(trace, "\"ph\":\"E\""));
+
+  const char *stages[] = {"compute_diff", "hash_lines", "line_alignment", "line_optimize",
+                          "refine",       "conversion"};
+  for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++) {
+    char pattern[96];
+    snprintf(pattern, sizeof(pattern), "\"name\":\"%s\",\"cat\":\"stage\",\"ph\":\"B\"", stages[i]);
+    CHECK(count_occurrences(trace, pattern) == 1);
+  }
+  CHECK(strstr(trace, "\"args\":{\"region\":0,\"lines\":2}") != NULL);
+  CHECK(strstr(trace, "\"dropped_events\":0") != NULL);
+
+  free(trace);
+  free_lines_diff(diff);
+  remove(TRACE_FILE);
+}
+
+TEST(disabled_tracing_records_nothing) {
+  diff_trace_reset();
+  LinesDiff *diff = diff_with_edits(40);
+  CHECK(diff != NULL);
+  CHECK(diff_trace_dump(TRACE_FILE));
+
+  char *trace = read_trace();
+  CHECK(trace != NULL);
+  CHECK(strstr(trace, "\"ph\":\"B\"") == NULL);
+  CHECK(strstr(trace, "\"ph\":\"E\"") == NULL);
+
+  free(trace);
+  free_lines_diff(diff);
+  remove(TRACE_FILE);
+}
+
+TEST(ring_buffer_keeps_newest_events) {
+  diff_trace_reset();
+  diff_trace_enable(true);
+  int extra = 100;
+  for (int i = 0; i < DIFF_TRACE_RING_CAPACITY + extra; i++) {
+    diff_trace_record(i < extra ? "old_event" : "new_event", i % 2 ? 'E' : 'B', -1, 0);
+  }
+  diff_trace_enable(false);
+  CHECK(diff_trace_dump(TRACE_FILE));
+
+  char *trace = read_trace();
+  CHECK(trace != NULL);
+  CHECK(strstr(trace, "old_event") == NULL);
+  CHECK(count_occurrences(trace, "new_event") == DIFF_TRACE_RING_CAPACITY);
+  CHECK(strstr(trace, "\"dropped_events\":100") != NULL);
+
+  free(trace);
+  remove(TRACE_FILE);
+  diff_trace_reset();
+}
+
+int main(void) {
+  printf("\n========================================\n");
+  printf("Trace Event Tests\n");
+  printf("========================================\n\n");
+
+  RUN_TEST(regions_have_balanced_events);
+  RUN_TEST(disabled_tracing_records_nothing);
+  RUN_TEST(ring_buffer_keeps_newest_events);
+
+  printf("\n✅ All trace tests passed\n");
+  return 0;
+}
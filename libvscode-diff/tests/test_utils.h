@@ -11,6 +11,7 @@
 #include "../include/sequence.h"
 #include "../include/types.h"
 #include <assert.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -33,6 +34,17 @@
     printf("  ✓ PASSED\n");                                                                        \
   } while (0)
 
+/**
+ * Assertion that stays active in Release builds (assert() is compiled out by NDEBUG)
+ */
+#define CHECK(cond)                                                                                \
+  do {                                                                                             \
+    if (!(cond)) {                                                                                 \
+      printf("  ✗ FAIL: %s (%s:%d)\n", #cond, __FILE__, __LINE__);                                 \
+      exit(1);                                                                                     \
+    }                                                                                              \
+  } while (0)
+
 /**
  * Helper macro for validating a single diff in an array
  * Makes test code more readable
@@ -155,6 +167,75 @@ static inline void assert_diffs_equal(const SequenceDiffArray *actual,
   }
 }
 
+// ============================================================================
+// Synthetic Input Helpers
+// ============================================================================
+
+#define TEST_LINE_LENGTH 64
+
+/**
+ * Growable list of formatted lines, ready to pass to compute_diff()
+ *
+ * Usage:
+ *   TestLines original = test_lines_create(64);
+ *   test_lines_add(&original, "  value_%d = %d", i, i * 3);
+ *   compute_diff(original.lines, original.count, ...);
+ *   test_lines_free(&original);
+ */
+typedef struct {
+  char (*text)[TEST_LINE_LENGTH];
+  const char **lines; // lines[i] == text[i]
+  int count;
+  int capacity;
+} TestLines;
+
+static inline TestLines test_lines_create(int capacity) {
+  TestLines result;
+  result.text = (char (*)[TEST_LINE_LENGTH])malloc((size_t)capacity * TEST_LINE_LENGTH);
+  result.lines = (const char **)malloc((size_t)capacity * sizeof(char *));
+  result.count = 0;
+  result.capacity = capacity;
+  CHECK(result.text != NULL && result.lines != NULL);
+  return result;
+}
+
+/**
+ * Overwrite line index (0-based, at most count) with a formatted line
+ */
+static inline void test_lines_vset(TestLines *lines, int index, const char *format, va_list args) {
+  CHECK(index >= 0 && index <= lines->count && index < lines->capacity);
+  vsnprintf(lines->text[index], TEST_LINE_LENGTH, format, args);
+  lines->lines[index] = lines->text[index];
+  if (index == lines->count) {
+    lines->count++;
+  }
+}
+
+static inline void test_lines_set(TestLines *lines, int index, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  test_lines_vset(lines, index, format, args);
+  va_end(args);
+}
+
+/**
+ * Append a formatted line
+ */
+static inline void test_lines_add(TestLines *lines, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  test_lines_vset(lines, lines->count, format, args);
+  va_end(args);
+}
+
+static inline void test_lines_free(TestLines *lines) {
+  free(lines->text);
+  free(lines->lines);
+  lines->text = NULL;
+  lines->lines = NULL;
+  lines->count = 0;
+}
+
 // ============================================================================
 // Step 1 Helper (Myers Algorithm Only - No Optimization)
 // ============================================================================
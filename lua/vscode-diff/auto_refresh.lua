@@ -4,6 +4,7 @@ local M = {}
 
 local diff = require("vscode-diff.diff")
 local core = require("vscode-diff.render.core")
+local profile = require("vscode-diff.profile")
 
 -- Throttle delay in milliseconds
 local THROTTLE_DELAY_MS = 200
@@ -89,6 +90,10 @@ local function do_diff_update(bufnr, skip_watcher_check)
     local config = require("vscode-diff.config")
     local diff_options = {
       max_computation_time_ms = config.options.diff.max_computation_time_ms,
+      rewrite_threshold = config.options.diff.rewrite_threshold,
+      quality = config.options.diff.quality,
+      collect_stats = profile.enabled,  -- Profiler records stats without logging them
+      log_stats = config.options.diff.log_stats,
     }
     local lines_diff = diff.compute_diff(original_lines, modified_lines, diff_options)
     if not lines_diff then
@@ -2,7 +2,7 @@
 local M = {}
 
 -- Subcommands available for :CodeDiff
-M.SUBCOMMANDS = { "file", "install" }
+M.SUBCOMMANDS = { "file", "install", "profile" }
 
 local git = require("vscode-diff.git")
 local lifecycle = require("vscode-diff.render.lifecycle")
@@ -10,7 +10,7 @@ local lifecycle = require("vscode-diff.render.lifecycle")
 --- Handles diffing the current buffer against a given git revision.
 -- @param revision string: The git revision (e.g., "HEAD", commit hash, branch name) to compare the current file against.
 -- @param revision2 string?: Optional second revision. If provided, compares revision vs revision2.
--- This function chains async git operations to get git root, resolve revision to hash, and get file content.
+-- Resolves the git root and revisions asynchronously, prefetching file content as hashes become known.
 local function handle_git_diff(revision, revision2)
   local current_file = vim.api.nvim_buf_get_name(0)
 
@@ -25,7 +25,9 @@ local function handle_git_diff(revision, revision2)
     filetype = vim.filetype.match({ filename = current_file }) or ""
   end
 
-  -- Async chain: get_git_root -> resolve_revision -> get_file_content -> render_diff
+  -- Async pipeline: get_git_root (memoized per directory) -> both revisions
+  -- resolved concurrently -> view. Each blob fetch starts as soon as its
+  -- revision resolves; the view's virtual buffers join the running fetch.
   git.get_git_root(current_file, function(err_root, git_root)
     if err_root then
       vim.schedule(function()
@@ -35,8 +37,9 @@ local function handle_git_diff(revision, revision2)
     end
 
     local relative_path = git.get_relative_path(current_file, git_root)
+    local revisions = revision2 and { revision, revision2 } or { revision }
 
-    git.resolve_revision(revision, git_root, function(err_resolve, commit_hash)
+    git.resolve_revisions(revisions, git_root, function(err_resolve, commit_hashes)
       if err_resolve then
         vim.schedule(function()
           vim.notify(err_resolve, vim.log.levels.ERROR)
@@ -44,46 +47,22 @@ local function handle_git_diff(revision, revision2)
         return
       end
 
-      if revision2 then
-        -- Compare two revisions
-        git.resolve_revision(revision2, git_root, function(err_resolve2, commit_hash2)
-          if err_resolve2 then
-            vim.schedule(function()
-              vim.notify(err_resolve2, vim.log.levels.ERROR)
-            end)
-            return
-          end
-
-          vim.schedule(function()
-            local view = require('vscode-diff.render.view')
-            ---@type SessionConfig
-            local session_config = {
-              mode = "standalone",
-              git_root = git_root,
-              original_path = relative_path,
-              modified_path = relative_path,
-              original_revision = commit_hash,
-              modified_revision = commit_hash2,
-            }
-            view.create(session_config, filetype)
-          end)
-        end)
-      else
-        -- Compare revision vs working tree
-        vim.schedule(function()
-          local view = require('vscode-diff.render.view')
-          ---@type SessionConfig
-          local session_config = {
-            mode = "standalone",
-            git_root = git_root,
-            original_path = relative_path,
-            modified_path = relative_path,
-            original_revision = commit_hash,
-            modified_revision = "WORKING",
-          }
-          view.create(session_config, filetype)
-        end)
-      end
+      vim.schedule(function()
+        local view = require('vscode-diff.render.view')
+        ---@type SessionConfig
+        local session_config = {
+          mode = "standalone",
+          git_root = git_root,
+          original_path = relative_path,
+          modified_path = relative_path,
+          original_revision = commit_hashes[1],
+          -- Without a second revision, compare against the working tree
+          modified_revision = commit_hashes[2] or "WORKING",
+        }
+        view.create(session_config, filetype)
+      end)
+    end, function(_, commit_hash)
+      git.prefetch_file_content(commit_hash, git_root, relative_path)
     end)
   end)
 end
@@ -157,8 +136,8 @@ local function handle_explorer(revision, revision2)
     end
 
     if revision and revision2 then
-      -- Compare two revisions
-      git.resolve_revision(revision, git_root, function(err_resolve, commit_hash)
+      -- Compare two revisions (resolved concurrently)
+      git.resolve_revisions({ revision, revision2 }, git_root, function(err_resolve, commit_hashes)
         if err_resolve then
           vim.schedule(function()
             vim.notify(err_resolve, vim.log.levels.ERROR)
@@ -166,17 +145,8 @@ local function handle_explorer(revision, revision2)
           return
         end
 
-        git.resolve_revision(revision2, git_root, function(err_resolve2, commit_hash2)
-          if err_resolve2 then
-            vim.schedule(function()
-              vim.notify(err_resolve2, vim.log.levels.ERROR)
-            end)
-            return
-          end
-
-          git.get_diff_revisions(commit_hash, commit_hash2, git_root, function(err_status, status_result)
-            process_status(err_status, status_result, commit_hash, commit_hash2)
-          end)
+        git.get_diff_revisions(commit_hashes[1], commit_hashes[2], git_root, function(err_status, status_result)
+          process_status(err_status, status_result, commit_hashes[1], commit_hashes[2])
         end)
       end)
     elseif revision then
@@ -205,6 +175,12 @@ local function handle_explorer(revision, revision2)
 end
 
 function M.vscode_diff(opts)
+  -- :CodeDiff profile works from any tab, including an open diff view
+  if opts.fargs[1] == "profile" then
+    require("vscode-diff.profile").command(vim.list_slice(opts.fargs, 2))
+    return
+  end
+
   -- Check if current tab is a diff view and toggle (close) it if so
   local current_tab = vim.api.nvim_get_current_tabpage()
   if lifecycle.get_session(current_tab) then
@@ -23,6 +23,9 @@ M.defaults = {
   diff = {
     disable_inlay_hints = true,  -- Disable inlay hints in diff windows for cleaner view
     max_computation_time_ms = 5000,  -- Maximum time for diff computation (5 seconds, VSCode default)
+    rewrite_threshold = 0,  -- Show files sharing fewer lines than this ratio as rewritten (e.g. 0.1; 0 = off, VSCode output)
+    quality = "parity",  -- "parity" (match VSCode exactly) or "fast" (approximate engines, may differ slightly)
+    log_stats = false,  -- Log per-stage diff timings (DiffStats) at DEBUG level
   },
 
   -- Explorer panel configuration
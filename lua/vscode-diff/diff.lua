@@ -8,6 +8,8 @@ local ffi = require("ffi")
 local version = require("vscode-diff.version")
 local VERSION = version.VERSION
 
+local profile = require("vscode-diff.profile")
+
 -- Load the C library with automatic installation
 local lib_ext
 if ffi.os == "Windows" then
@@ -104,11 +106,35 @@ ffi.cdef[[
     int capacity;
   } MovedTextArray;
 
+  // Per-stage instrumentation (DiffOptions.collect_stats)
+  typedef struct {
+    double hash_ms;
+    double line_alignment_ms;
+    double line_optimize_ms;
+    double refine_ms;
+    double whitespace_scan_ms;
+    double char_refine_ms;
+    double conversion_ms;
+    double moves_ms;
+    double total_ms;
+    int algorithm;
+    int line_edit_distance;
+    int refined_regions;
+    int largest_region_lines;
+    int line_alignment_timeouts;
+    int whitespace_scan_timeouts;
+    int char_refine_timeouts;
+    int moves_timeouts;
+    int64_t allocations;
+  } DiffStats;
+
   // Main diff result
   typedef struct {
     DetailedLineRangeMappingArray changes;
     MovedTextArray moves;
     bool hit_timeout;
+    bool is_rewrite;
+    DiffStats stats;
   } LinesDiff;
 
   // Options
@@ -117,6 +143,9 @@ ffi.cdef[[
     int max_computation_time_ms;
     bool compute_moves;
     bool extend_to_subwords;
+    double rewrite_threshold;
+    bool collect_stats;
+    int quality;  // DiffQuality: 0 = VSCode parity, 1 = fast
   } DiffOptions;
 
   // API functions
@@ -128,15 +157,94 @@ ffi.cdef[[
     const DiffOptions* options
   );
 
+  // Caller-provided line regions (0-based, end-exclusive)
+  typedef struct {
+    int seq1_start;
+    int seq1_end;
+    int seq2_start;
+    int seq2_end;
+  } SequenceDiff;
+
+  LinesDiff* refine_line_alignments(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const SequenceDiff* alignments,
+    int alignment_count,
+    const DiffOptions* options
+  );
+
+  // Counting-only result
+  typedef struct {
+    int inserted_lines;
+    int deleted_lines;
+    int modified_lines;
+    bool hit_timeout;
+  } DiffLineStats;
+
+  bool compute_diff_stats(
+    const char** original_lines,
+    int original_count,
+    const char** modified_lines,
+    int modified_count,
+    const DiffOptions* options,
+    DiffLineStats* out_stats
+  );
+
+  // Rename/copy candidate pairing (MinHash + LSH)
+  typedef struct MinHashIndex MinHashIndex;
+
+  typedef struct {
+    int original_id;
+    int modified_id;
+    double similarity;
+  } SimilarityCandidate;
+
+  typedef struct {
+    SimilarityCandidate* candidates;
+    int count;
+    int capacity;
+  } SimilarityCandidateArray;
+
+  MinHashIndex* minhash_index_create(void);
+  int minhash_index_add(MinHashIndex* index, const char** lines, int line_count, bool is_original);
+  SimilarityCandidateArray* minhash_index_find_candidates(const MinHashIndex* index, double threshold);
+  void similarity_candidate_array_free(SimilarityCandidateArray* arr);
+  void minhash_index_destroy(MinHashIndex* index);
+
   void free_lines_diff(LinesDiff* diff);
   const char* get_version(void);
+  int get_api_version(void);
 ]]
 
+-- FFI API version these declarations match (VSCODE_DIFF_API_VERSION). Structs
+-- are read in place, so a library built for other declarations would be read
+-- out of bounds rather than fail; refuse it while loading instead.
+local API_VERSION = 6
+do
+  local ok, lib_api_version = pcall(function()
+    return lib.get_api_version()
+  end)
+  if not ok or lib_api_version ~= API_VERSION then
+    error(string.format(
+      "libvscode-diff has FFI API version %s, but this plugin needs version %d.\n" ..
+      "Reinstall it with :CodeDiff install! (or rebuild from source with 'make' / 'build.cmd'),\n" ..
+      "then restart Neovim.",
+      ok and tostring(lib_api_version) or "1", API_VERSION
+    ))
+  end
+end
+
 ---@class DiffOptions
 ---@field ignore_trim_whitespace boolean
 ---@field max_computation_time_ms integer
 ---@field compute_moves boolean
 ---@field extend_to_subwords boolean
+---@field rewrite_threshold number
+---@field collect_stats boolean
+---@field log_stats boolean|nil Lua only: log the stats at DEBUG level (implies collect_stats)
+---@field quality "parity"|"fast"|nil
 
 -- Convert Lua string array to C string array
 local function lua_to_c_strings(lines)
@@ -201,8 +309,52 @@ local function moved_text_to_lua(c_moved)
   }
 end
 
+-- DiffAlgorithm enum values (types.h)
+local ALGORITHM_NAMES = { [0] = "none", [1] = "dp", [2] = "myers", [3] = "rewrite", [4] = "sparse" }
+
+-- Convert C DiffStats to Lua table
+local function diff_stats_to_lua(c_stats)
+  return {
+    hash_ms = c_stats.hash_ms,
+    line_alignment_ms = c_stats.line_alignment_ms,
+    line_optimize_ms = c_stats.line_optimize_ms,
+    refine_ms = c_stats.refine_ms,
+    whitespace_scan_ms = c_stats.whitespace_scan_ms,
+    char_refine_ms = c_stats.char_refine_ms,
+    conversion_ms = c_stats.conversion_ms,
+    moves_ms = c_stats.moves_ms,
+    total_ms = c_stats.total_ms,
+    algorithm = ALGORITHM_NAMES[c_stats.algorithm] or "none",
+    line_edit_distance = c_stats.line_edit_distance,
+    refined_regions = c_stats.refined_regions,
+    largest_region_lines = c_stats.largest_region_lines,
+    line_alignment_timeouts = c_stats.line_alignment_timeouts,
+    whitespace_scan_timeouts = c_stats.whitespace_scan_timeouts,
+    char_refine_timeouts = c_stats.char_refine_timeouts,
+    moves_timeouts = c_stats.moves_timeouts,
+    allocations = tonumber(c_stats.allocations),
+  }
+end
+
+-- One-line summary of a stats table for logs
+function M.format_stats(stats)
+  return string.format(
+    "diff %.2fms: %s D=%d | hash %.2f align %.2f optimize %.2f | refine %.2f (ws %.2f, char %.2f) | " ..
+    "convert %.2f moves %.2f | regions %d (max %d lines) | timeouts align %d ws %d char %d moves %d | allocs %d",
+    stats.total_ms, stats.algorithm, stats.line_edit_distance,
+    stats.hash_ms, stats.line_alignment_ms, stats.line_optimize_ms,
+    stats.refine_ms, stats.whitespace_scan_ms, stats.char_refine_ms,
+    stats.conversion_ms, stats.moves_ms,
+    stats.refined_regions, stats.largest_region_lines,
+    stats.line_alignment_timeouts, stats.whitespace_scan_timeouts,
+    stats.char_refine_timeouts, stats.moves_timeouts,
+    stats.allocations)
+end
+
 -- Convert C LinesDiff to Lua table
-local function lines_diff_to_lua(c_diff)
+-- with_stats: include the DiffStats table
+-- log_stats: also log it at DEBUG level
+local function lines_diff_to_lua(c_diff, with_stats, log_stats)
   if c_diff == nil then
     return nil
   end
@@ -217,30 +369,56 @@ local function lines_diff_to_lua(c_diff)
     table.insert(moves, moved_text_to_lua(c_diff.moves.moves[i]))
   end
 
+  local stats = nil
+  if with_stats then
+    stats = diff_stats_to_lua(c_diff.stats)
+    if log_stats then
+      vim.notify(M.format_stats(stats), vim.log.levels.DEBUG)
+    end
+  end
+
   return {
     changes = changes,
     moves = moves,
-    hit_timeout = c_diff.hit_timeout
+    hit_timeout = c_diff.hit_timeout,
+    is_rewrite = c_diff.is_rewrite,
+    stats = stats
   }
 end
 
+-- Convert Lua options table to C DiffOptions struct
+local function make_c_options(options)
+  ---@type DiffOptions
+---@diagnostic disable-next-line: assign-type-mismatch
+  local c_options = ffi.new("DiffOptions")
+  c_options.ignore_trim_whitespace = options.ignore_trim_whitespace or false
+  c_options.max_computation_time_ms = options.max_computation_time_ms or 5000
+  c_options.compute_moves = options.compute_moves or false
+  c_options.extend_to_subwords = options.extend_to_subwords or false
+  c_options.rewrite_threshold = options.rewrite_threshold or 0
+  c_options.collect_stats = options.collect_stats or options.log_stats or false
+  c_options.quality = options.quality == "fast" and 1 or 0
+  return c_options
+end
+
 -- Main API: Compute diff between two sets of lines
 -- Returns Lua table representation of LinesDiff
 function M.compute_diff(original_lines, modified_lines, options)
   options = options or {}
+  local profiling = profile.enabled
+  local start = profiling and profile.now()
 
   -- Convert Lua lines to C arrays
   local c_orig, orig_count = lua_to_c_strings(original_lines)
   local c_mod, mod_count = lua_to_c_strings(modified_lines)
 
   -- Create options struct
-  ---@type DiffOptions
----@diagnostic disable-next-line: assign-type-mismatch
-  local c_options = ffi.new("DiffOptions")
-  c_options.ignore_trim_whitespace = options.ignore_trim_whitespace or false
-  c_options.max_computation_time_ms = options.max_computation_time_ms or 5000
-  c_options.compute_moves = options.compute_moves or false
-  c_options.extend_to_subwords = options.extend_to_subwords or false
+  local c_options = make_c_options(options)
+
+  if profiling then
+    profile.record("marshal", start)
+    start = profile.now()
+  end
 
   -- Call C function
   local c_diff = lib.compute_diff(c_orig, orig_count, c_mod, mod_count, c_options)
@@ -249,18 +427,175 @@ function M.compute_diff(original_lines, modified_lines, options)
     error("compute_diff returned NULL")
   end
 
+  if profiling then
+    profile.record("compute", start)
+    start = profile.now()
+  end
+
   -- Convert to Lua table
-  local lua_diff = lines_diff_to_lua(c_diff)
+  local lua_diff = lines_diff_to_lua(c_diff, c_options.collect_stats, options.log_stats)
 
   -- Free C memory
   lib.free_lines_diff(c_diff)
 
+  if profiling then
+    profile.record("convert", start)
+    if lua_diff.stats then
+      profile.record_stats(lua_diff.stats)
+    end
+  end
+
+  return lua_diff
+end
+
+-- Staged API: refine line hunks computed elsewhere (e.g. vim.diff's xdiff)
+-- hunks: vim.diff(..., { result_type = "indices" }) output, i.e. a list of
+--   { start_a, count_a, start_b, count_b } (1-based; a count of 0 means the
+--   hunk sits after line start_a / start_b)
+-- Only the whitespace scan, char refinement and conversion run in C.
+-- Errors if the hunks do not describe the two line lists.
+function M.refine_line_alignments(original_lines, modified_lines, hunks, options)
+  options = options or {}
+  local profiling = profile.enabled
+  local start = profiling and profile.now()
+
+  local c_orig, orig_count = lua_to_c_strings(original_lines)
+  local c_mod, mod_count = lua_to_c_strings(modified_lines)
+  local c_options = make_c_options(options)
+  local c_hunks = ffi.new("SequenceDiff[?]", math.max(#hunks, 1))
+  for i, hunk in ipairs(hunks) do
+    local start_a, count_a, start_b, count_b = hunk[1], hunk[2], hunk[3], hunk[4]
+    local c_hunk = c_hunks[i - 1]
+    c_hunk.seq1_start = count_a == 0 and start_a or start_a - 1
+    c_hunk.seq1_end = c_hunk.seq1_start + count_a
+    c_hunk.seq2_start = count_b == 0 and start_b or start_b - 1
+    c_hunk.seq2_end = c_hunk.seq2_start + count_b
+  end
+
+  if profiling then
+    profile.record("marshal", start)
+    start = profile.now()
+  end
+
+  local c_diff = lib.refine_line_alignments(
+    c_orig, orig_count, c_mod, mod_count, c_hunks, #hunks, c_options)
+  if c_diff == nil then
+    error("refine_line_alignments returned NULL (hunks do not match the lines)")
+  end
+
+  if profiling then
+    profile.record("compute", start)
+    start = profile.now()
+  end
+
+  local lua_diff = lines_diff_to_lua(c_diff, c_options.collect_stats, options.log_stats)
+  lib.free_lines_diff(c_diff)
+
+  if profiling then
+    profile.record("convert", start)
+    if lua_diff.stats then
+      profile.record_stats(lua_diff.stats)
+    end
+  end
   return lua_diff
 end
 
+-- Counting-only API: line-level alignment without char refinement
+-- Returns { inserted = n, deleted = n, modified = n, hit_timeout = bool }
+function M.compute_diff_stats(original_lines, modified_lines, options)
+  return M.compute_diff_stats_batch({ { original_lines, modified_lines } }, options)[1]
+end
+
+-- Batch variant for annotating many files (e.g. explorer +/- counts)
+-- file_pairs: list of { original_lines, modified_lines }
+-- Returns list of stats tables in the same order
+function M.compute_diff_stats_batch(file_pairs, options)
+  local c_options = make_c_options(options or {})
+  local c_stats = ffi.new("DiffLineStats")
+  local results = {}
+
+  for i, pair in ipairs(file_pairs) do
+    local c_orig, orig_count = lua_to_c_strings(pair[1])
+    local c_mod, mod_count = lua_to_c_strings(pair[2])
+
+    if not lib.compute_diff_stats(c_orig, orig_count, c_mod, mod_count, c_options, c_stats) then
+      error("compute_diff_stats failed")
+    end
+
+    results[i] = {
+      inserted = c_stats.inserted_lines,
+      deleted = c_stats.deleted_lines,
+      modified = c_stats.modified_lines,
+      hit_timeout = c_stats.hit_timeout,
+    }
+  end
+
+  return results
+end
+
+-- Shortlist likely renames/copies between deleted and added files
+-- originals, modifieds: lists of line tables
+-- threshold: minimum estimated line-set similarity (default 0.5)
+-- Returns list of { original = i, modified = j, similarity = s } (1-based indices),
+-- sorted by descending similarity. Run compute_diff only on these pairs.
+function M.find_rename_candidates(originals, modifieds, threshold)
+  local index = lib.minhash_index_create()
+  if index == nil then
+    error("minhash_index_create returned NULL")
+  end
+
+  -- File IDs are assigned in insertion order: originals first, then modifieds.
+  -- A failed add would shift every later ID, so it aborts the whole lookup.
+  local function add(lines, is_original)
+    local c_lines, count = lua_to_c_strings(lines)
+    if lib.minhash_index_add(index, c_lines, count, is_original) < 0 then
+      lib.minhash_index_destroy(index)
+      error("minhash_index_add failed")
+    end
+  end
+  for _, lines in ipairs(originals) do
+    add(lines, true)
+  end
+  for _, lines in ipairs(modifieds) do
+    add(lines, false)
+  end
+
+  local c_result = lib.minhash_index_find_candidates(index, threshold or 0.5)
+  lib.minhash_index_destroy(index)
+  if c_result == nil then
+    error("minhash_index_find_candidates returned NULL")
+  end
+
+  local candidates = {}
+  for i = 0, c_result.count - 1 do
+    local c = c_result.candidates[i]
+    table.insert(candidates, {
+      original = c.original_id + 1,
+      modified = c.modified_id - #originals + 1,
+      similarity = c.similarity,
+    })
+  end
+  lib.similarity_candidate_array_free(c_result)
+  return candidates
+end
+
 -- Get library version
 function M.get_version()
   return ffi.string(lib.get_version())
 end
 
+-- FFI API version of the loaded library (VSCODE_DIFF_API_VERSION)
+function M.get_api_version()
+  return lib.get_api_version()
+end
+
+-- The stages of M.compute_diff, exposed so scripts/bench_ffi.lua can time
+-- marshaling, the C call and conversion separately. Not a stable API.
+M._stages = {
+  lib = lib,
+  lua_to_c_strings = lua_to_c_strings,
+  make_c_options = make_c_options,
+  lines_diff_to_lua = lines_diff_to_lua,
+}
+
 return M
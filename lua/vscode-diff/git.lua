@@ -2,6 +2,8 @@
 -- All operations are async and atomic
 local M = {}
 
+local profile = require("vscode-diff.profile")
+
 -- LRU Cache for git file content
 -- Stores recently fetched file content to avoid redundant git calls
 local ContentCache = {}
@@ -59,7 +61,8 @@ function ContentCache:put(revision, git_root, rel_path, lines)
     table.insert(self.access_order, key)
   end
   
-  -- Store a copy to prevent cache corruption
+  -- Store a copy to prevent cache corruption (get() copies too); only the
+  -- table is copied, the line strings themselves are shared
   self.cache[key] = vim.list_extend({}, lines)
 end
 
@@ -71,15 +74,88 @@ end
 -- Global cache instance
 local file_content_cache = ContentCache.new(50)
 
+-- Fetches in progress: cache key -> callbacks waiting for the same blob
+-- (e.g. a prefetch started by :CodeDiff and the virtual buffer load)
+local pending_fetches = {}
+
+-- Git root per directory: the root of a directory does not change while
+-- Neovim runs, so every file after the first skips `rev-parse --show-toplevel`
+local git_root_cache = {}
+
 -- Public API to clear cache if needed
 function M.clear_cache()
   file_content_cache:clear()
+  git_root_cache = {}
+end
+
+-- Incremental line splitter for streamed stdout
+-- Lines are split as chunks arrive, so the full output never exists as one string.
+-- Matches vim.split(output, "\n") with a trailing "" removed, and normalizes
+-- "\r\n" to "\n" like vim.system's text mode.
+local function new_line_splitter()
+  local lines = {}
+  local count = 0
+  local pending = {}  -- Parts of the current (unterminated) line
+
+  local splitter = {}
+
+  function splitter.feed(chunk)
+    local pos = 1
+    while true do
+      local nl = chunk:find("\n", pos, true)
+      if not nl then
+        break
+      end
+
+      local line = chunk:sub(pos, nl - 1)
+      if #pending > 0 then
+        pending[#pending + 1] = line
+        line = table.concat(pending)
+        pending = {}
+      end
+      if line:byte(-1) == 13 then
+        line = line:sub(1, -2)
+      end
+
+      count = count + 1
+      lines[count] = line
+      pos = nl + 1
+    end
+
+    if pos <= #chunk then
+      pending[#pending + 1] = chunk:sub(pos)
+    end
+  end
+
+  function splitter.finish()
+    if #pending > 0 then
+      count = count + 1
+      lines[count] = table.concat(pending)
+      pending = {}
+    end
+    return lines
+  end
+
+  return splitter
 end
 
 -- Run a git command asynchronously
 -- Uses vim.system if available (Neovim 0.10+), falls back to vim.loop.spawn
+-- opts.on_stdout: optional function(chunk) receiving stdout as it streams in;
+--   when set, stdout is not accumulated and callback receives (err, nil)
 local function run_git_async(args, opts, callback)
   opts = opts or {}
+  local on_stdout = opts.on_stdout
+
+  if profile.enabled then
+    local start = profile.now()
+    local stage = "git " .. args[1]
+    local done = callback
+    callback = function(err, output)
+      profile.record(stage, start)
+      done(err, output)
+    end
+  end
 
   -- Use vim.system if available (Neovim 0.10+)
   if vim.system then
@@ -94,11 +170,17 @@ local function run_git_async(args, opts, callback)
       vim.list_extend({ "git" }, args),
       {
         cwd = opts.cwd,
-        text = true,
+        -- Streaming handlers do their own CRLF normalization (chunks may split "\r\n")
+        text = not on_stdout,
+        stdout = on_stdout and function(_, data)
+          if data then
+            on_stdout(data)
+          end
+        end or nil,
       },
       function(result)
         if result.code == 0 then
-          callback(nil, result.stdout or "")
+          callback(nil, not on_stdout and (result.stdout or "") or nil)
         else
           callback(result.stderr or "Git command failed", nil)
         end
@@ -131,7 +213,7 @@ local function run_git_async(args, opts, callback)
 
       vim.schedule(function()
         if code == 0 then
-          callback(nil, table.concat(stdout_data))
+          callback(nil, not on_stdout and table.concat(stdout_data) or nil)
         else
           callback(table.concat(stderr_data) or "Git command failed", nil)
         end
@@ -148,7 +230,11 @@ local function run_git_async(args, opts, callback)
         if err then
           callback(err, nil)
         elseif data then
-          table.insert(stdout_data, data)
+          if on_stdout then
+            on_stdout(data)
+          else
+            table.insert(stdout_data, data)
+          end
         end
       end)
     end
@@ -165,11 +251,43 @@ local function run_git_async(args, opts, callback)
   end
 end
 
+-- Run a git command asynchronously and return stdout split into lines
+-- callback: function(err, lines)
+local function run_git_lines_async(args, opts, callback)
+  local splitter = new_line_splitter()
+  local feed = splitter.feed
+  local split_ns = 0
+
+  -- Splitting runs inside the git call; profiled separately to show its share
+  if profile.enabled then
+    feed = function(chunk)
+      local start = profile.now()
+      splitter.feed(chunk)
+      split_ns = split_ns + (profile.now() - start)
+    end
+  end
+  opts = vim.tbl_extend("force", opts or {}, { on_stdout = feed })
+
+  run_git_async(args, opts, function(err)
+    if err then
+      callback(err, nil)
+      return
+    end
+    local start = profile.enabled and profile.now()
+    local lines = splitter.finish()
+    if start then
+      profile.add("git.split", (split_ns + (profile.now() - start)) / 1e6)
+    end
+    callback(nil, lines)
+  end)
+end
+
 -- ATOMIC ASYNC OPERATIONS
 -- All functions below are simple, atomic git operations
 
 -- Get git root directory for the given file (async)
--- callback: function(err, git_root)
+-- callback: function(err, git_root), always invoked from the main loop, even
+-- when the root is already cached
 function M.get_git_root(file_path, callback)
   -- Handle both file paths and directory paths
   local dir
@@ -182,6 +300,15 @@ function M.get_git_root(file_path, callback)
   -- Normalize path separators for consistency
   dir = dir:gsub("\\", "/")
 
+  local cached_root = git_root_cache[dir]
+  if cached_root then
+    vim.schedule(function()
+      callback(nil, cached_root)
+    end)
+    return
+  end
+
+  -- Failures are not cached: the directory may become a repository later
   run_git_async(
     { "rev-parse", "--show-toplevel" },
     { cwd = dir },
@@ -198,6 +325,7 @@ function M.get_git_root(file_path, callback)
         if git_root:sub(-1) == "/" then
           git_root = git_root:sub(1, -2)
         end
+        git_root_cache[dir] = git_root
         callback(nil, git_root)
       end
     end
@@ -232,6 +360,37 @@ function M.resolve_revision(revision, git_root, callback)
   )
 end
 
+-- Resolve several revisions concurrently (async)
+-- callback: function(err, commit_hashes) with hashes in the order of revisions;
+-- err is the first failure in that order
+-- on_resolved: optional function(index, commit_hash), called as soon as each
+-- revision resolves (e.g. to start fetching its blobs)
+function M.resolve_revisions(revisions, git_root, callback, on_resolved)
+  local hashes = {}
+  local errors = {}
+  local pending = #revisions
+
+  for i, revision in ipairs(revisions) do
+    M.resolve_revision(revision, git_root, function(err, commit_hash)
+      hashes[i] = commit_hash
+      errors[i] = err
+      if commit_hash and on_resolved then
+        on_resolved(i, commit_hash)
+      end
+      pending = pending - 1
+      if pending == 0 then
+        for j = 1, #revisions do
+          if errors[j] then
+            callback(errors[j], nil)
+            return
+          end
+        end
+        callback(nil, hashes)
+      end
+    end)
+  end
+end
+
 -- Get file content from a specific git revision (async, atomic)
 -- revision: e.g., "HEAD", "HEAD~1", commit hash, branch name, tag
 -- git_root: absolute path to git repository root
@@ -250,37 +409,66 @@ function M.get_file_content(revision, git_root, rel_path, callback)
     end
   end
 
+  -- Join a fetch of the same blob that is already running
+  local key = file_content_cache:_make_key(revision, git_root, rel_path)
+  if not is_mutable then
+    if pending_fetches[key] then
+      table.insert(pending_fetches[key], callback)
+      return
+    end
+    pending_fetches[key] = { callback }
+  end
+
+  local function finish(err, lines)
+    if is_mutable then
+      callback(err, lines)
+      return
+    end
+    local waiters = pending_fetches[key]
+    pending_fetches[key] = nil
+    for i, waiter in ipairs(waiters) do
+      -- Every joined caller gets its own table, like a cache hit
+      waiter(err, (i > 1 and lines) and vim.list_extend({}, lines) or lines)
+    end
+  end
+
   -- Cache miss or mutable revision - fetch from git
   local git_object = revision .. ":" .. rel_path
 
-  run_git_async(
+  -- Stream stdout straight into a line table (no whole-blob string, no vim.split copy)
+  run_git_lines_async(
     { "show", git_object },
     { cwd = git_root },
-    function(err, output)
+    function(err, lines)
       if err then
         if err:match("does not exist") or err:match("exists on disk, but not in") then
-          callback(string.format("File '%s' not found in revision '%s'", rel_path, revision), nil)
+          finish(string.format("File '%s' not found in revision '%s'", rel_path, revision), nil)
         else
-          callback(err, nil)
+          finish(err, nil)
         end
         return
       end
 
-      local lines = vim.split(output, "\n")
-      if lines[#lines] == "" then
-        table.remove(lines, #lines)
-      end
-
       -- Store in cache (only for immutable revisions)
       if not is_mutable then
         file_content_cache:put(revision, git_root, rel_path, lines)
       end
 
-      callback(nil, lines)
+      finish(nil, lines)
     end
   )
 end
 
+-- Start fetching a file into the content cache without waiting for it (async)
+-- A later get_file_content() for the same blob joins the running fetch.
+function M.prefetch_file_content(revision, git_root, rel_path)
+  local key = file_content_cache:_make_key(revision, git_root, rel_path)
+  if revision:match("^:[0-3]$") or file_content_cache.cache[key] then
+    return  -- Mutable revisions are never shared; cached blobs need no fetch
+  end
+  M.get_file_content(revision, git_root, rel_path, function() end)
+end
+
 -- Get git status for current repository (async)
 -- git_root: absolute path to git repository root
 -- callback: function(err, status_result) where status_result is:
@@ -438,74 +626,70 @@ function M.get_diff_revisions(rev1, rev2, git_root, callback)
   )
 end
 
--- Run a git command synchronously
--- Returns output string or nil on error
-local function run_git_sync(args, opts)
-  opts = opts or {}
-  local cmd = vim.list_extend({ "git" }, args)
-
-  local result = vim.fn.systemlist(cmd)
-  if vim.v.shell_error ~= 0 then
-    return nil
-  end
-
-  return result
-end
-
--- Get git root directory synchronously (for completion)
--- Returns git_root or nil if not in a git repo
-function M.get_git_root_sync(file_path)
-  local dir
-  if vim.fn.isdirectory(file_path) == 1 then
-    dir = file_path
-  else
-    dir = vim.fn.fnamemodify(file_path, ":h")
+-- Get revision candidates for command completion (async)
+-- HEAD refs, then branches, tags, remotes and stashes; the ref and stash
+-- listings run concurrently
+-- callback: function(err, candidates)
+function M.get_rev_candidates_async(git_root, callback)
+  local refs, stashes
+  local pending = 2
+  local failed = nil
+
+  local function done()
+    pending = pending - 1
+    if pending > 0 then
+      return
+    end
+    if failed then
+      callback(failed, nil)
+      return
+    end
+    local candidates = { "HEAD", "HEAD~1", "HEAD~2", "HEAD~3" }
+    vim.list_extend(candidates, refs)
+    vim.list_extend(candidates, stashes)
+    callback(nil, candidates)
   end
 
-  local cmd = { "git", "-C", dir, "rev-parse", "--show-toplevel" }
-  local result = vim.fn.systemlist(cmd)
-
-  if vim.v.shell_error ~= 0 or #result == 0 then
-    return nil
-  end
+  run_git_lines_async(
+    { "rev-parse", "--symbolic", "--branches", "--tags", "--remotes" },
+    { cwd = git_root },
+    function(err, lines)
+      failed = failed or err
+      refs = lines or {}
+      done()
+    end
+  )
 
-  local git_root = vim.trim(result[1])
-  git_root = git_root:gsub("\\", "/")
-  return git_root
+  -- No stashes (or no stash ref at all) is not an error
+  run_git_lines_async(
+    { "stash", "list", "--pretty=format:%gd" },
+    { cwd = git_root },
+    function(_, lines)
+      stashes = lines or {}
+      done()
+    end
+  )
 end
 
--- Get revision candidates for command completion (sync)
--- Returns list of branches, tags, remotes, and special refs
-function M.get_rev_candidates(git_root)
-  if not git_root then
-    return {}
-  end
-
-  local candidates = {}
-
-  -- Special HEAD refs
-  local head_refs = { "HEAD", "HEAD~1", "HEAD~2", "HEAD~3" }
-  vim.list_extend(candidates, head_refs)
-
-  -- Get branches, tags, and remotes
-  local refs = run_git_sync({
-    "-C", git_root,
-    "rev-parse", "--symbolic", "--branches", "--tags", "--remotes"
-  })
-  if refs then
-    vim.list_extend(candidates, refs)
-  end
-
-  -- Get stashes
-  local stashes = run_git_sync({
-    "-C", git_root,
-    "stash", "list", "--pretty=format:%gd"
-  })
-  if stashes then
-    vim.list_extend(candidates, stashes)
-  end
-
-  return candidates
+-- Get the directory holding refs and packed-refs (async)
+-- For linked worktrees this is the main repository's .git directory
+-- callback: function(err, git_dir) with an absolute, forward-slash path
+function M.get_common_git_dir(git_root, callback)
+  run_git_async(
+    { "rev-parse", "--git-common-dir" },
+    { cwd = git_root },
+    function(err, output)
+      if err then
+        callback(err, nil)
+        return
+      end
+      local git_dir = vim.trim(output):gsub("\\", "/")
+      if not git_dir:match("^/") and not git_dir:match("^%a:") then
+        git_dir = git_root .. "/" .. git_dir
+      end
+      callback(nil, git_dir)
+    end
+  )
 end
 
 return M
@@ -0,0 +1,201 @@
+-- Session profiler for :CodeDiff profile
+-- Records how long each part of opening/refreshing a diff takes: git calls
+-- (per subcommand), line splitting, FFI marshaling, C compute (with per-stage
+-- DiffStats), result conversion, rendering and semantic tokens.
+-- Samples go into a fixed-size ring buffer, so a long session keeps only the
+-- most recent measurements; breakdown() aggregates them per stage.
+local M = {}
+
+local DEFAULT_CAPACITY = 500
+
+-- Checked by call sites before taking timestamps, so profiling costs one
+-- table lookup when off
+M.enabled = false
+
+local capacity = DEFAULT_CAPACITY
+local samples = {}  -- Ring buffer of { stage = string, ms = number }
+local next_slot = 1
+local sample_count = 0
+
+-- Top-level stage groups in pipeline order; sub-stages are "<group>.<name>"
+-- and git calls are "git <subcommand>"
+local STAGE_ORDER = { "git", "marshal", "compute", "convert", "render", "semantic_tokens" }
+local GROUP_RANK = {}
+for i, group in ipairs(STAGE_ORDER) do
+  GROUP_RANK[group] = i
+end
+
+-- DiffStats fields reported as compute sub-stages
+local STATS_STAGES = {
+  "hash", "line_alignment", "line_optimize", "refine", "whitespace_scan", "char_refine", "conversion", "moves",
+}
+local STATS_RANK = {}
+for i, name in ipairs(STATS_STAGES) do
+  STATS_RANK[name] = i
+end
+
+function M.now()
+  return vim.loop.hrtime()
+end
+
+-- Add one sample of `ms` milliseconds
+function M.add(stage, ms)
+  samples[next_slot] = { stage = stage, ms = ms }
+  next_slot = next_slot % capacity + 1
+  sample_count = math.min(sample_count + 1, capacity)
+end
+
+-- Add one sample covering the time since `start_ns` (from M.now())
+function M.record(stage, start_ns)
+  M.add(stage, (vim.loop.hrtime() - start_ns) / 1e6)
+end
+
+-- Add the C pipeline stages of a DiffStats table (diff.lua format)
+function M.record_stats(stats)
+  for _, name in ipairs(STATS_STAGES) do
+    M.add("compute." .. name, stats[name .. "_ms"])
+  end
+end
+
+function M.clear()
+  samples = {}
+  next_slot = 1
+  sample_count = 0
+end
+
+-- Start recording; `max_samples` resizes the ring buffer (and clears it)
+function M.start(max_samples)
+  if max_samples and max_samples > 0 and max_samples ~= capacity then
+    capacity = max_samples
+    M.clear()
+  end
+  M.enabled = true
+end
+
+function M.stop()
+  M.enabled = false
+end
+
+-- Samples oldest first
+function M.samples()
+  local ordered = {}
+  local first = sample_count < capacity and 1 or next_slot
+  for i = 0, sample_count - 1 do
+    ordered[#ordered + 1] = samples[(first - 1 + i) % capacity + 1]
+  end
+  return ordered
+end
+
+local function stage_group(stage)
+  return stage:match("^[^ .]+")
+end
+
+-- Groups in pipeline order, each group's top-level row before its sub-stages,
+-- compute sub-stages in DiffStats order
+local function sort_key(stage)
+  local group_rank = GROUP_RANK[stage_group(stage)] or #STAGE_ORDER + 1
+  local stats_stage = stage:match("^compute%.(.+)$")
+  if stats_stage then
+    stage = string.format("compute.%02d", STATS_RANK[stats_stage] or 99)
+  end
+  return string.format("%02d %s", group_rank, stage)
+end
+
+-- Per-stage aggregates in pipeline order:
+-- list of { stage, calls, total_ms, mean_ms, median_ms, max_ms, sub_stage }
+function M.breakdown()
+  local by_stage = {}
+  for _, sample in ipairs(M.samples()) do
+    local values = by_stage[sample.stage]
+    if not values then
+      values = {}
+      by_stage[sample.stage] = values
+    end
+    values[#values + 1] = sample.ms
+  end
+
+  local rows = {}
+  for stage, values in pairs(by_stage) do
+    table.sort(values)
+    local total = 0
+    for _, ms in ipairs(values) do
+      total = total + ms
+    end
+    local n = #values
+    rows[#rows + 1] = {
+      stage = stage,
+      calls = n,
+      total_ms = total,
+      mean_ms = total / n,
+      median_ms = n % 2 == 1 and values[(n + 1) / 2] or (values[n / 2] + values[n / 2 + 1]) / 2,
+      max_ms = values[n],
+      sub_stage = stage:find(".", 1, true) ~= nil,
+    }
+  end
+  table.sort(rows, function(a, b)
+    return sort_key(a.stage) < sort_key(b.stage)
+  end)
+  return rows
+end
+
+-- Breakdown table as display lines; share is relative to all top-level stages
+function M.format()
+  local rows = M.breakdown()
+  local lines = {
+    string.format("CodeDiff profile: %d samples (last %d kept), %s", sample_count, capacity,
+      M.enabled and "recording" or "stopped"),
+  }
+  if #rows == 0 then
+    lines[#lines + 1] = "No samples yet: open or refresh a diff, then run :CodeDiff profile again"
+    return lines
+  end
+
+  local top_level_ms = 0
+  for _, row in ipairs(rows) do
+    if not row.sub_stage then
+      top_level_ms = top_level_ms + row.total_ms
+    end
+  end
+
+  lines[#lines + 1] = string.format("%-26s %6s %10s %9s %9s %9s %6s", "stage", "calls", "total ms", "mean",
+    "median", "max", "share")
+  for _, row in ipairs(rows) do
+    local name = row.sub_stage and ("  " .. row.stage:match("%.(.+)$")) or row.stage
+    local share = ""
+    if not row.sub_stage and top_level_ms > 0 then
+      share = string.format("%.1f%%", row.total_ms / top_level_ms * 100)
+    end
+    lines[#lines + 1] = string.format("%-26s %6d %10.2f %9.2f %9.2f %9.2f %6s", name, row.calls, row.total_ms,
+      row.mean_ms, row.median_ms, row.max_ms, share)
+  end
+  return lines
+end
+
+-- :CodeDiff profile [start [N] | stop | clear | show]
+-- Without an action, starts recording if needed, otherwise shows the table
+function M.command(args)
+  local action = args[1]
+
+  if action == "start" or (action == nil and not M.enabled) then
+    M.start(tonumber(args[2]))
+    vim.notify(string.format(
+      "CodeDiff profiling enabled (last %d samples); reproduce the slow diff, then run :CodeDiff profile",
+      capacity), vim.log.levels.INFO)
+  elseif action == "stop" then
+    M.stop()
+    vim.notify("CodeDiff profiling stopped", vim.log.levels.INFO)
+  elseif action == "clear" then
+    M.clear()
+    vim.notify("CodeDiff profile cleared", vim.log.levels.INFO)
+  elseif action == nil or action == "show" then
+    local chunks = {}
+    for _, line in ipairs(M.format()) do
+      chunks[#chunks + 1] = { line .. "\n" }
+    end
+    vim.api.nvim_echo(chunks, true, {})
+  else
+    vim.notify("Usage: :CodeDiff profile [start [N] | stop | clear | show]", vim.log.levels.ERROR)
+  end
+end
+
+return M
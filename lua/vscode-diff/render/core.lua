@@ -2,6 +2,7 @@
 local M = {}
 
 local highlights = require('vscode-diff.render.highlights')
+local profile = require('vscode-diff.profile')
 
 -- Namespace references
 local ns_highlight = highlights.ns_highlight
@@ -307,6 +308,8 @@ end
 -- Render diff highlights and fillers
 -- Assumes buffer content is already set by caller
 function M.render_diff(left_bufnr, right_bufnr, original_lines, modified_lines, lines_diff)
+  local profile_start = profile.enabled and profile.now()
+
   -- Clear existing highlights
   vim.api.nvim_buf_clear_namespace(left_bufnr, ns_highlight, 0, -1)
   vim.api.nvim_buf_clear_namespace(right_bufnr, ns_highlight, 0, -1)
@@ -363,6 +366,10 @@ function M.render_diff(left_bufnr, right_bufnr, original_lines, modified_lines,
     end
   end
 
+  if profile_start then
+    profile.record("render", profile_start)
+  end
+
   return {
     left_fillers = total_left_fillers,
     right_fillers = total_right_fillers,
@@ -30,6 +30,7 @@ local M = {}
 
 local api = vim.api
 local bit = require('bit')
+local profile = require('vscode-diff.profile')
 
 -- Namespace for semantic token highlights
 local ns_semantic = api.nvim_create_namespace('vscode_diff_semantic_tokens')
@@ -212,7 +213,12 @@ function M.apply_semantic_tokens(left_buf, right_buf)
   }
 
   -- Make async request for semantic tokens
+  local request_start = profile.enabled and profile.now()
   client.request('textDocument/semanticTokens/full', params, function(err, result)
+    if request_start then
+      profile.record("semantic_tokens.lsp", request_start)
+    end
+
     if err then
       return
     end
@@ -234,6 +240,8 @@ function M.apply_semantic_tokens(left_buf, right_buf)
         return
       end
 
+      local apply_start = profile.enabled and profile.now()
+
       -- Get legend from client capabilities
       local legend = client.server_capabilities.semanticTokensProvider.legend
       local encoding = client.offset_encoding or 'utf-16'
@@ -243,6 +251,10 @@ function M.apply_semantic_tokens(left_buf, right_buf)
 
       -- Apply highlights
       apply_highlights(left_buf, ranges)
+
+      if apply_start then
+        profile.record("semantic_tokens", apply_start)
+      end
     end)
   end, left_buf)
 
@@ -8,6 +8,7 @@ local virtual_file = require('vscode-diff.virtual_file')
 local auto_refresh = require('vscode-diff.auto_refresh')
 local config = require('vscode-diff.config')
 local diff_module = require('vscode-diff.diff')
+local profile = require('vscode-diff.profile')
 
 -- Helper: Check if revision is virtual (commit hash or STAGED)
 -- Virtual: "STAGED" or commit hash | Real: nil or "WORKING"
@@ -82,12 +83,21 @@ local function compute_and_render(original_buf, modified_buf, original_lines, mo
   -- Compute diff
   local diff_options = {
     max_computation_time_ms = config.options.diff.max_computation_time_ms,
+    rewrite_threshold = config.options.diff.rewrite_threshold,
+    quality = config.options.diff.quality,
+    collect_stats = profile.enabled,  -- Profiler records stats without logging them
+    log_stats = config.options.diff.log_stats,
   }
   local lines_diff = diff_module.compute_diff(original_lines, modified_lines, diff_options)
   if not lines_diff then
     vim.notify("Failed to compute diff", vim.log.levels.ERROR)
     return nil
   end
+  -- Say why the whole file is one change, once per buffer (not on every re-render)
+  if lines_diff.is_rewrite and not vim.b[modified_buf].vscode_diff_rewrite_notified then
+    vim.b[modified_buf].vscode_diff_rewrite_notified = true
+    vim.notify("File rewritten: almost no lines in common, showing a single change", vim.log.levels.INFO)
+  end
 
   -- Render diff highlights
   core.render_diff(original_buf, modified_buf, original_lines, modified_lines, lines_diff)
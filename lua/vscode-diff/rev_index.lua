@@ -0,0 +1,233 @@
+-- Revision index for :CodeDiff completion
+-- Keeps every repository's branches, tags, remotes and stashes in memory so
+-- completion never runs git on the main thread. The index is built
+-- asynchronously on first use and rebuilt (debounced) when libuv reports a
+-- change to <git-dir>/packed-refs or under <git-dir>/refs. Until the first
+-- build finishes, completion offers the HEAD refs only.
+--
+-- fs_event is not recursive on Linux, so only the top levels of refs/ are
+-- watched; a watched index is also rebuilt in the background once it is
+-- older than WATCHED_MAX_AGE_MS. Where no watcher can be started the index
+-- simply expires after UNWATCHED_MAX_AGE_MS.
+local M = {}
+
+local git = require("vscode-diff.git")
+
+local HEAD_REFS = { "HEAD", "HEAD~1", "HEAD~2", "HEAD~3" }
+local REBUILD_DELAY_MS = 200  -- Coalesces bursts of ref writes (fetch, rebase)
+local WATCHED_MAX_AGE_MS = 60000
+local UNWATCHED_MAX_AGE_MS = 5000
+local ROOT_RETRY_MS = 5000    -- A cwd outside a repository may become one (git init)
+
+-- cwd -> git_root, true while resolving, or the time (ms) a lookup failed
+local roots = {}
+local indexes = {}  -- git_root -> index
+
+local function sorted_copy(list)
+  local sorted = vim.list_extend({}, list)
+  table.sort(sorted)
+  return sorted
+end
+
+-- First position in `sorted` whose entry is >= prefix
+local function lower_bound(sorted, prefix)
+  local lo, hi = 1, #sorted + 1
+  while lo < hi do
+    local mid = math.floor((lo + hi) / 2)
+    if sorted[mid] < prefix then
+      lo = mid + 1
+    else
+      hi = mid
+    end
+  end
+  return lo
+end
+
+local function filter_prefix(sorted, prefix)
+  local matches = {}
+  for i = lower_bound(sorted, prefix), #sorted do
+    local candidate = sorted[i]
+    if candidate:sub(1, #prefix) ~= prefix then
+      break
+    end
+    matches[#matches + 1] = candidate
+  end
+  return matches
+end
+
+local function build(git_root, index)
+  if index.building then
+    index.dirty = true
+    return
+  end
+  index.building = true
+  index.dirty = false
+
+  git.get_rev_candidates_async(git_root, function(err, candidates)
+    vim.schedule(function()
+      index.building = false
+      if indexes[git_root] ~= index then
+        return  -- Cleared while building
+      end
+      index.built_at = vim.loop.now()
+      if not err then
+        index.candidates = candidates
+        index.sorted = sorted_copy(candidates)
+        index.ready = true
+      end
+      if index.dirty then
+        build(git_root, index)
+      end
+    end)
+  end)
+end
+
+-- Safe from fs_event callbacks: only touches the index timer
+local function schedule_rebuild(git_root, index)
+  index.timer = index.timer or vim.loop.new_timer()
+  index.timer:stop()
+  index.timer:start(REBUILD_DELAY_MS, 0, vim.schedule_wrap(function()
+    if indexes[git_root] == index then
+      build(git_root, index)
+    end
+  end))
+end
+
+local function watch_dir(git_root, index, path, filter)
+  local handle = vim.loop.new_fs_event()
+  if not handle then
+    return
+  end
+  local ok = handle:start(path, {}, function(err, filename)
+    if not err and (not filter or filename == filter) then
+      schedule_rebuild(git_root, index)
+    end
+  end)
+  if ok then
+    table.insert(index.watchers, handle)
+  else
+    handle:close()
+  end
+end
+
+local function start_watchers(git_root, index)
+  git.get_common_git_dir(git_root, function(err, git_dir)
+    if err then
+      return
+    end
+    vim.schedule(function()
+      if indexes[git_root] ~= index then
+        return
+      end
+      watch_dir(git_root, index, git_dir, "packed-refs")
+      watch_dir(git_root, index, git_dir .. "/refs")  -- refs/stash lives here
+      for _, sub in ipairs({ "heads", "tags", "remotes" }) do
+        watch_dir(git_root, index, git_dir .. "/refs/" .. sub)
+      end
+      -- One level of remotes: refs/remotes/<remote>/<branch>
+      for _, remote in ipairs(vim.fn.glob(git_dir .. "/refs/remotes/*", false, true)) do
+        if vim.fn.isdirectory(remote) == 1 then
+          watch_dir(git_root, index, remote)
+        end
+      end
+    end)
+  end)
+end
+
+local function get_index(git_root)
+  local index = indexes[git_root]
+  if not index then
+    index = {
+      candidates = HEAD_REFS,
+      sorted = sorted_copy(HEAD_REFS),
+      ready = false,
+      building = false,
+      dirty = false,
+      built_at = 0,
+      watchers = {},
+    }
+    indexes[git_root] = index
+    start_watchers(git_root, index)
+    build(git_root, index)
+    return index
+  end
+
+  local max_age = #index.watchers > 0 and WATCHED_MAX_AGE_MS or UNWATCHED_MAX_AGE_MS
+  if index.ready and vim.loop.now() - index.built_at > max_age then
+    build(git_root, index)
+  end
+  return index
+end
+
+-- Git root for cwd from memory, resolving it in the background on first use
+-- Returns git_root, or nil while unknown or outside a repository. A failed
+-- lookup is retried once it is older than ROOT_RETRY_MS.
+local function get_root(cwd)
+  local root = roots[cwd]
+  if type(root) == "string" then
+    return root
+  end
+  if root == true or (root and vim.loop.now() - root < ROOT_RETRY_MS) then
+    return nil
+  end
+
+  roots[cwd] = true
+  git.get_git_root(cwd, function(err, git_root)
+    vim.schedule(function()
+      if roots[cwd] == true then
+        roots[cwd] = not err and git_root or vim.loop.now()
+        if not err then
+          get_index(git_root)
+        end
+      end
+    end)
+  end)
+  return nil
+end
+
+-- Start resolving the root and building the index for cwd (non-blocking)
+function M.warm(cwd)
+  local git_root = get_root(cwd)
+  if git_root then
+    get_index(git_root)
+  end
+end
+
+-- Revision candidates for cwd starting with prefix (never blocks)
+-- An empty prefix returns every candidate in git's order, otherwise matches
+-- are sorted. The returned table must not be modified.
+function M.complete(cwd, prefix)
+  local git_root = get_root(cwd)
+  if not git_root then
+    return {}
+  end
+  local index = get_index(git_root)
+  if not prefix or prefix == "" then
+    return index.candidates
+  end
+  return filter_prefix(index.sorted, prefix)
+end
+
+-- Whether the index for cwd holds a completed build
+function M.is_ready(cwd)
+  local git_root = roots[cwd]
+  return type(git_root) == "string" and indexes[git_root] ~= nil and indexes[git_root].ready
+end
+
+-- Stop all watchers and forget every index
+function M.clear()
+  for _, index in pairs(indexes) do
+    for _, handle in ipairs(index.watchers) do
+      handle:stop()
+      handle:close()
+    end
+    if index.timer then
+      index.timer:stop()
+      index.timer:close()
+    end
+  end
+  indexes = {}
+  roots = {}
+end
+
+return M
@@ -7,7 +7,7 @@ vim.g.loaded_vscode_diff = 1
 local render = require("vscode-diff.render")
 local commands = require("vscode-diff.commands")
 local virtual_file = require("vscode-diff.virtual_file")
-local git = require("vscode-diff.git")
+local rev_index = require("vscode-diff.rev_index")
 
 -- Setup virtual file scheme
 virtual_file.setup()
@@ -23,28 +23,17 @@ vim.api.nvim_create_autocmd("ColorScheme", {
   end,
 })
 
--- Cache for revision candidates (avoid repeated git calls during rapid completions)
-local rev_cache = {
-  candidates = nil,
-  git_root = nil,
-  timestamp = 0,
-  ttl = 5,  -- Cache for 5 seconds
-}
-
-local function get_cached_rev_candidates(git_root)
-  local now = vim.loop.now() / 1000  -- Convert to seconds
-  if rev_cache.candidates
-      and rev_cache.git_root == git_root
-      and (now - rev_cache.timestamp) < rev_cache.ttl then
-    return rev_cache.candidates
-  end
-
-  local candidates = git.get_rev_candidates(git_root)
-  rev_cache.candidates = candidates
-  rev_cache.git_root = git_root
-  rev_cache.timestamp = now
-  return candidates
-end
+-- Build the revision index while the command is being typed, so the first
+-- <Tab> already has branches and tags (rev_index never blocks)
+vim.api.nvim_create_autocmd("CmdlineChanged", {
+  group = vim.api.nvim_create_augroup("VscodeDiffRevIndex", { clear = true }),
+  pattern = ":",
+  callback = function()
+    if vim.fn.getcmdline():match("^%s*Code") then
+      rev_index.warm(vim.fn.getcwd())
+    end
+  end,
+})
 
 -- Register user command with subcommand completion
 local function complete_codediff(arg_lead, cmd_line, cursor_pos)
@@ -53,10 +42,7 @@ local function complete_codediff(arg_lead, cmd_line, cursor_pos)
   -- If no args or just ":CodeDiff", suggest subcommands and revisions
   if #args <= 1 then
     local candidates = vim.list_extend({}, commands.SUBCOMMANDS)
-    local cwd = vim.fn.getcwd()
-    local git_root = git.get_git_root_sync(cwd)
-    local rev_candidates = get_cached_rev_candidates(git_root)
-    return vim.list_extend(candidates, rev_candidates)
+    return vim.list_extend(candidates, rev_index.complete(vim.fn.getcwd(), ""))
   end
 
   -- If first arg is a subcommand that takes file args, complete with file paths
@@ -65,17 +51,18 @@ local function complete_codediff(arg_lead, cmd_line, cursor_pos)
     return vim.fn.getcompletion(arg_lead, "file")
   end
 
+  if first_arg == "profile" then
+    if (#args == 2 and arg_lead == "") or (#args == 3 and arg_lead ~= "") then
+      return vim.tbl_filter(function(action)
+        return action:find(arg_lead, 1, true) == 1
+      end, { "start", "stop", "clear", "show" })
+    end
+    return {}
+  end
+
   -- For revision arguments, suggest git refs filtered by arg_lead
   if #args == 2 and arg_lead ~= "" then
-    local cwd = vim.fn.getcwd()
-    local git_root = git.get_git_root_sync(cwd)
-    local rev_candidates = get_cached_rev_candidates(git_root)
-    local filtered = {}
-    for _, candidate in ipairs(rev_candidates) do
-      if candidate:find(arg_lead, 1, true) == 1 then
-        table.insert(filtered, candidate)
-      end
-    end
+    local filtered = rev_index.complete(vim.fn.getcwd(), arg_lead)
     if #filtered > 0 then
       return filtered
     end
@@ -89,5 +76,5 @@ vim.api.nvim_create_user_command("CodeDiff", commands.vscode_diff, {
   nargs = "*",
   bang = true,
   complete = complete_codediff,
-  desc = "VSCode-style diff view: :CodeDiff [<revision>] | file <revision> | file <file_a> <file_b> | install"
+  desc = "VSCode-style diff view: :CodeDiff [<revision>] | file <revision> | file <file_a> <file_b> | install | profile"
 })
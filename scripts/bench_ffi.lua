@@ -0,0 +1,280 @@
+-- FFI marshaling and conversion benchmark
+-- Splits M.compute_diff into its three costs for synthetic diffs with many inner changes:
+--   marshal  lua_to_c_strings + make_c_options (Lua tables -> C arrays)
+--   c_call   lib.compute_diff
+--   convert  lines_diff_to_lua + free_lines_diff (C result -> Lua tables)
+-- and reports LuaJIT GC cycles and Lua heap deltas per stage.
+--
+-- Usage: nvim --headless --noplugin -u NONE -c "lua dofile('scripts/bench_ffi.lua')" -- [options]
+--   --sizes N,N,...   Target inner change counts (default: 10000,30000,100000)
+--   --reps N          Timed repetitions per size, median kept (default: 5)
+--   --json FILE       Write results as JSON
+--   --baseline FILE   JSON from an earlier run (e.g. before an FFI-layer change) to compare against
+--
+-- Before/after an FFI change:
+--   git stash && nvim --headless ... -- --json /tmp/before.json
+--   git stash pop && nvim --headless ... -- --baseline /tmp/before.json
+-- With an older diff.lua that has no M._stages, only the end-to-end time is measured.
+
+local args = vim.fn.argv()
+local sizes = { 10000, 30000, 100000 }
+local reps = 5
+local json_path = nil
+local baseline_path = nil
+
+local i = 1
+while i <= #args do
+  local arg = args[i]
+  if arg == "--sizes" then
+    sizes = {}
+    for n in tostring(args[i + 1]):gmatch("%d+") do
+      table.insert(sizes, tonumber(n))
+    end
+    i = i + 2
+  elseif arg == "--reps" then
+    reps = math.max(1, tonumber(args[i + 1]) or reps)
+    i = i + 2
+  elseif arg == "--json" then
+    json_path = args[i + 1]
+    i = i + 2
+  elseif arg == "--baseline" then
+    baseline_path = args[i + 1]
+    i = i + 2
+  else
+    print("Unknown option: " .. tostring(arg))
+    print("Usage: nvim --headless --noplugin -u NONE -c \"lua dofile('scripts/bench_ffi.lua')\" -- " ..
+      "[--sizes N,N] [--reps N] [--json FILE] [--baseline FILE]")
+    vim.cmd('cquit 1')
+  end
+end
+
+vim.opt.runtimepath:prepend(vim.fn.getcwd())
+vim.env.VSCODE_DIFF_NO_AUTO_INSTALL = vim.env.VSCODE_DIFF_NO_AUTO_INSTALL or "1"
+local diff = require("vscode-diff.diff")
+local stages = diff._stages
+
+-- ============================================================================
+-- GC Accounting
+-- ============================================================================
+
+-- LuaJIT has no GC cycle counter: a userdata whose finalizer re-arms itself
+-- runs once per completed cycle
+local gc_cycles = 0
+local function arm_gc_sentinel()
+  local sentinel = newproxy(true)
+  getmetatable(sentinel).__gc = function()
+    gc_cycles = gc_cycles + 1
+    arm_gc_sentinel()
+  end
+end
+arm_gc_sentinel()
+
+local function heap_kb()
+  return collectgarbage("count")
+end
+
+local function now_ms()
+  return vim.loop.hrtime() / 1e6
+end
+
+-- ============================================================================
+-- Synthetic Input
+-- ============================================================================
+
+-- Every other line is edited in two separate words, so each changed line is
+-- its own region with two inner changes: size inner changes need ~size lines
+local function make_lines(target_inner_changes)
+  local line_count = target_inner_changes
+  local original, modified = {}, {}
+  for n = 1, line_count do
+    local line = string.format("  local value_%d = compute(alpha_%d, beta_%d) -- note %d", n, n, n, n)
+    original[n] = line
+    if n % 2 == 0 then
+      modified[n] = string.format("  local value_%d = compute(ALPHA_%d, beta_%d) -- NOTE %d", n, n, n, n)
+    else
+      modified[n] = line
+    end
+  end
+  return original, modified
+end
+
+local function count_inner_changes(result)
+  local total = 0
+  for _, change in ipairs(result.changes) do
+    total = total + #change.inner_changes
+  end
+  return total
+end
+
+-- ============================================================================
+-- Measurement
+-- ============================================================================
+
+local OPTIONS = { max_computation_time_ms = 0 }
+
+local function median(values)
+  local sorted = vim.deepcopy(values)
+  table.sort(sorted)
+  local n = #sorted
+  if n == 0 then
+    return 0
+  end
+  if n % 2 == 1 then
+    return sorted[(n + 1) / 2]
+  end
+  return (sorted[n / 2] + sorted[n / 2 + 1]) / 2
+end
+
+local function pack(...)
+  return { n = select("#", ...), ... }
+end
+
+-- One run split into stages; returns { marshal = {ms, gc, kb}, c_call = ..., convert = ... }
+local function run_staged(original, modified)
+  local sample = {}
+
+  local function stage(name, fn)
+    local gc_before, kb_before = gc_cycles, heap_kb()
+    local start = now_ms()
+    local values = pack(fn())
+    sample[name] = { ms = now_ms() - start, gc = gc_cycles - gc_before, kb = heap_kb() - kb_before }
+    return unpack(values, 1, values.n)
+  end
+
+  local c_orig, orig_count, c_mod, mod_count, c_options = stage("marshal", function()
+    local a, an = stages.lua_to_c_strings(original)
+    local b, bn = stages.lua_to_c_strings(modified)
+    return a, an, b, bn, stages.make_c_options(OPTIONS)
+  end)
+
+  local c_diff = stage("c_call", function()
+    return stages.lib.compute_diff(c_orig, orig_count, c_mod, mod_count, c_options)
+  end)
+  if c_diff == nil then
+    error("compute_diff returned NULL")
+  end
+
+  local result = stage("convert", function()
+    local lua_diff = stages.lines_diff_to_lua(c_diff, false)
+    stages.lib.free_lines_diff(c_diff)
+    return lua_diff
+  end)
+
+  return sample, result
+end
+
+local function run_end_to_end(original, modified)
+  local gc_before, kb_before = gc_cycles, heap_kb()
+  local start = now_ms()
+  local result = diff.compute_diff(original, modified, OPTIONS)
+  return { ms = now_ms() - start, gc = gc_cycles - gc_before, kb = heap_kb() - kb_before }, result
+end
+
+local STAGE_NAMES = { "marshal", "c_call", "convert", "total" }
+
+local function summarize(samples, name)
+  local ms, gc, kb = {}, {}, {}
+  for _, sample in ipairs(samples) do
+    table.insert(ms, sample[name].ms)
+    table.insert(gc, sample[name].gc)
+    table.insert(kb, sample[name].kb)
+  end
+  return { median_ms = median(ms), gc_cycles = median(gc), heap_delta_kb = median(kb) }
+end
+
+local results = {}
+print(string.format("\nFFI benchmark (vscode-diff %s, %d reps, %s)\n", diff.get_version(), reps,
+  stages and "staged" or "end-to-end only: diff.lua has no _stages"))
+
+for _, size in ipairs(sizes) do
+  local original, modified = make_lines(size)
+  local samples = {}
+  local inner_changes = 0
+
+  for rep = 0, reps do
+    collectgarbage("collect")
+    local sample, result
+    if stages then
+      sample, result = run_staged(original, modified)
+      local total = { ms = 0, gc = 0, kb = 0 }
+      for _, name in ipairs({ "marshal", "c_call", "convert" }) do
+        total.ms = total.ms + sample[name].ms
+        total.gc = total.gc + sample[name].gc
+        total.kb = total.kb + sample[name].kb
+      end
+      sample.total = total
+    else
+      local total
+      total, result = run_end_to_end(original, modified)
+      sample = { total = total }
+    end
+    inner_changes = count_inner_changes(result)
+    if rep > 0 then -- rep 0 is warmup (JIT traces, library page-in)
+      table.insert(samples, sample)
+    end
+  end
+
+  local entry = { size = size, lines = #original, inner_changes = inner_changes, stages = {} }
+  for _, name in ipairs(STAGE_NAMES) do
+    if samples[1][name] then
+      entry.stages[name] = summarize(samples, name)
+    end
+  end
+  table.insert(results, entry)
+end
+
+-- ============================================================================
+-- Report
+-- ============================================================================
+
+local baseline = nil
+if baseline_path then
+  local file = io.open(baseline_path, "r")
+  if file then
+    baseline = vim.json.decode(file:read("*a"))
+    file:close()
+  else
+    print("Cannot read baseline " .. baseline_path)
+  end
+end
+
+local function baseline_stage(size, name)
+  if not baseline then
+    return nil
+  end
+  for _, entry in ipairs(baseline.results or {}) do
+    if entry.size == size then
+      return entry.stages[name]
+    end
+  end
+  return nil
+end
+
+print(string.format("%-8s %-9s %-8s %12s %9s %12s %10s", "size", "inner", "stage", "median ms", "gc", "heap KB",
+  baseline and "vs base" or ""))
+print(string.rep("-", 74))
+for _, entry in ipairs(results) do
+  for _, name in ipairs(STAGE_NAMES) do
+    local stat = entry.stages[name]
+    if stat then
+      local base = baseline_stage(entry.size, name)
+      local delta = base and base.median_ms > 0 and string.format("%+.1f%%", (stat.median_ms / base.median_ms - 1) * 100)
+        or ""
+      print(string.format("%-8d %-9d %-8s %12.2f %9d %12.1f %10s", entry.size, entry.inner_changes, name,
+        stat.median_ms, stat.gc_cycles, stat.heap_delta_kb, delta))
+    end
+  end
+end
+
+if json_path then
+  local file = io.open(json_path, "w")
+  if file then
+    file:write(vim.json.encode({ version = diff.get_version(), reps = reps, staged = stages ~= nil, results = results }))
+    file:close()
+    print("\nWrote " .. json_path)
+  else
+    print("\nCannot write " .. json_path)
+  end
+end
+
+vim.cmd('quitall!')
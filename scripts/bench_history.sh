@@ -0,0 +1,167 @@
+#!/bin/bash
+
+# Git history replay benchmark for the C diff library
+# Walks the last N commits of a repository, extracts the before/after blobs of
+# every modified text file and times compute_diff on each pair with bench_replay.
+# Reports files/s, MB/s, p50/p99/max latency and timeout rate.
+#
+# Usage: ./bench_history.sh [OPTIONS] [REPO_PATH]
+#   -n, --commits N    Number of commits to replay (default: 200)
+#   -T, --timeout MS   max_computation_time_ms (default: 5000)
+#   -r, --reps N       Timed runs per file, median kept (default: 1)
+#   --max-bytes N      Skip blobs larger than N bytes (default: 2000000)
+#   --lib PATH         Library build to load; pass twice to compare two builds
+#   --json FILE        Also write the report as JSON
+#   --keep             Keep the extracted corpus directory
+#   REPO_PATH          Repository to replay (default: this repository)
+#
+# Example (compare a baseline build against the working tree build):
+#   ./bench_history.sh -n 500 --lib /tmp/base/libvscode_diff.so \
+#       --lib build/libvscode-diff/libvscode_diff.so ~/src/linux
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+TOOL_REPO_ROOT="$(cd "$SCRIPT_DIR/.." && pwd)"
+BENCH_REPLAY="$TOOL_REPO_ROOT/build/libvscode-diff/bench_replay"
+TARGET_REPO_ROOT=""
+WORK_DIR="/tmp/bench_history_$$"
+
+NUM_COMMITS=200
+TIMEOUT_MS=5000
+REPS=1
+MAX_BYTES=2000000
+KEEP=0
+JSON_OUT=""
+LIB_ARGS=()
+
+while [[ $# -gt 0 ]]; do
+    case $1 in
+        -n|--commits)
+            NUM_COMMITS="$2"
+            shift 2
+            ;;
+        -T|--timeout)
+            TIMEOUT_MS="$2"
+            shift 2
+            ;;
+        -r|--reps)
+            REPS="$2"
+            shift 2
+            ;;
+        --max-bytes)
+            MAX_BYTES="$2"
+            shift 2
+            ;;
+        --lib)
+            LIB_ARGS+=(--lib "$(cd "$(dirname "$2")" && pwd)/$(basename "$2")")
+            shift 2
+            ;;
+        --json)
+            JSON_OUT="$2"
+            shift 2
+            ;;
+        --keep)
+            KEEP=1
+            shift
+            ;;
+        -h|--help)
+            sed -n '3,20p' "$0" | sed 's/^# \{0,1\}//'
+            exit 0
+            ;;
+        -*)
+            echo "Unknown option: $1"
+            echo "Use -h or --help for usage information"
+            exit 1
+            ;;
+        *)
+            TARGET_REPO_ROOT="$1"
+            shift
+            ;;
+    esac
+done
+
+if [ -z "$TARGET_REPO_ROOT" ]; then
+    TARGET_REPO_ROOT="$TOOL_REPO_ROOT"
+fi
+TARGET_REPO_ROOT="$(cd "$TARGET_REPO_ROOT" && pwd)"
+if ! git -C "$TARGET_REPO_ROOT" rev-parse --git-dir >/dev/null 2>&1; then
+    echo "Error: $TARGET_REPO_ROOT is not a git repository" >&2
+    exit 1
+fi
+
+# Build bench_replay (Release) if needed
+if [ ! -x "$BENCH_REPLAY" ]; then
+    echo "Building bench_replay..."
+    cmake -S "$TOOL_REPO_ROOT" -B "$TOOL_REPO_ROOT/build" -DCMAKE_BUILD_TYPE=Release > /dev/null 2>&1
+    cmake --build "$TOOL_REPO_ROOT/build" --target bench_replay > /dev/null 2>&1
+    if [ ! -x "$BENCH_REPLAY" ]; then
+        echo "Error: Failed to build bench_replay" >&2
+        exit 1
+    fi
+fi
+
+cleanup() {
+    if [ $KEEP -eq 0 ]; then
+        rm -rf "$WORK_DIR"
+    else
+        echo "Corpus kept in $WORK_DIR"
+    fi
+}
+trap cleanup EXIT
+
+mkdir -p "$WORK_DIR/blobs"
+MANIFEST="$WORK_DIR/manifest.tsv"
+: > "$MANIFEST"
+
+echo "Extracting modified files from the last $NUM_COMMITS commits of $TARGET_REPO_ROOT..."
+
+extract_blob() {
+    local sha="$1"
+    local out="$WORK_DIR/blobs/$sha"
+    if [ ! -f "$out" ]; then
+        git -C "$TARGET_REPO_ROOT" cat-file blob "$sha" > "$out" 2>/dev/null || return 1
+    fi
+    return 0
+}
+
+pairs=0
+for commit in $(git -C "$TARGET_REPO_ROOT" rev-list --no-merges -n "$NUM_COMMITS" HEAD); do
+    # numstat reports "-" for binary files; raw gives the blob ids
+    declare -A binary=()
+    while IFS=$'\t' read -r added deleted path; do
+        if [ "$added" = "-" ]; then
+            binary["$path"]=1
+        fi
+    done < <(git -C "$TARGET_REPO_ROOT" diff-tree -r --no-commit-id --no-renames --numstat \
+        --diff-filter=M "$commit" 2>/dev/null)
+
+    while IFS=$'\t' read -r meta path; do
+        read -r old_mode new_mode old_sha new_sha status <<< "$meta"
+        [ "$old_mode" = ":160000" ] && continue
+        [ -n "${binary[$path]}" ] && continue
+        old_size=$(git -C "$TARGET_REPO_ROOT" cat-file -s "$old_sha" 2>/dev/null) || continue
+        new_size=$(git -C "$TARGET_REPO_ROOT" cat-file -s "$new_sha" 2>/dev/null) || continue
+        if [ "$old_size" -gt "$MAX_BYTES" ] || [ "$new_size" -gt "$MAX_BYTES" ]; then
+            continue
+        fi
+        extract_blob "$old_sha" && extract_blob "$new_sha" || continue
+        printf '%s\t%s\t%s@%s\n' "$WORK_DIR/blobs/$old_sha" "$WORK_DIR/blobs/$new_sha" \
+            "$path" "${commit:0:10}" >> "$MANIFEST"
+        pairs=$((pairs + 1))
+    done < <(git -C "$TARGET_REPO_ROOT" diff-tree -r --no-commit-id --no-renames --raw \
+        --abbrev=40 --diff-filter=M "$commit" 2>/dev/null)
+    unset binary
+done
+
+if [ $pairs -eq 0 ]; then
+    echo "No modified text files found" >&2
+    exit 1
+fi
+echo "Extracted $pairs file pairs"
+echo ""
+
+JSON_ARGS=()
+if [ -n "$JSON_OUT" ]; then
+    JSON_ARGS=(--json "$JSON_OUT")
+fi
+
+"$BENCH_REPLAY" --timeout "$TIMEOUT_MS" --reps "$REPS" "${LIB_ARGS[@]}" "${JSON_ARGS[@]}" "$MANIFEST"
@@ -0,0 +1,321 @@
+-- Render benchmark for render.core.render_diff
+-- Feeds precomputed LinesDiff results with increasing hunk counts into scratch
+-- buffers, so only the render path is timed (no diff computation, no fixed waits):
+--   render    first render_diff on freshly loaded buffers
+--   rerender  render_diff after a one-character edit on the modified side
+--             (clears the previous extmarks, then redraws with one extra hunk)
+-- and reports the extmarks and filler virt_lines each render leaves behind.
+-- Every changed line carries multibyte characters, so the UTF-16 -> byte column
+-- conversion is part of the measured cost.
+--
+-- Usage: nvim --headless --noplugin -u NONE -c "lua dofile('scripts/bench_render.lua')" -- [options]
+--   --hunks N,N,...   Hunk counts (default: 100,1000,5000,20000)
+--   --gap N           Unchanged lines between hunks (default: 4)
+--   --reps N          Timed repetitions per size, median kept (default: 5)
+--   --json FILE       Write results as JSON
+--   --baseline FILE   JSON from an earlier run to compare against
+
+local args = vim.fn.argv()
+local hunk_counts = { 100, 1000, 5000, 20000 }
+local gap = 4
+local reps = 5
+local json_path = nil
+local baseline_path = nil
+
+local i = 1
+while i <= #args do
+  local arg = args[i]
+  if arg == "--hunks" then
+    hunk_counts = {}
+    for n in tostring(args[i + 1]):gmatch("%d+") do
+      table.insert(hunk_counts, tonumber(n))
+    end
+    i = i + 2
+  elseif arg == "--gap" then
+    gap = math.max(1, tonumber(args[i + 1]) or gap)
+    i = i + 2
+  elseif arg == "--reps" then
+    reps = math.max(1, tonumber(args[i + 1]) or reps)
+    i = i + 2
+  elseif arg == "--json" then
+    json_path = args[i + 1]
+    i = i + 2
+  elseif arg == "--baseline" then
+    baseline_path = args[i + 1]
+    i = i + 2
+  else
+    print("Unknown option: " .. tostring(arg))
+    print("Usage: nvim --headless --noplugin -u NONE -c \"lua dofile('scripts/bench_render.lua')\" -- " ..
+      "[--hunks N,N] [--gap N] [--reps N] [--json FILE] [--baseline FILE]")
+    vim.cmd('cquit 1')
+  end
+end
+
+vim.opt.runtimepath:prepend(vim.fn.getcwd())
+local core = require("vscode-diff.render.core")
+local highlights = require("vscode-diff.render.highlights")
+highlights.setup()
+
+local function now_ms()
+  return vim.loop.hrtime() / 1e6
+end
+
+-- ============================================================================
+-- Synthetic Input
+-- ============================================================================
+
+-- "ä" is 2 bytes and "→" is 3 bytes, each one UTF-16 code unit: columns after
+-- the prefix are 3 smaller in UTF-16 than in bytes
+local PREFIX = "ä→ "
+local PREFIX_EXTRA_BYTES = 3
+
+local function equal_line(n)
+  return string.format("  local value_%d = compute(alpha_%d, beta_%d) -- note %d", n, n, n, n)
+end
+
+local function char_range(line, start_col, end_line, end_col)
+  return { start_line = line, start_col = start_col, end_line = end_line, end_col = end_col }
+end
+
+-- One changed line: the word "alpha" becomes "ALPHA", as a diff would report it
+local function modify_hunk(orig_line, mod_line, n)
+  local original = string.format("%sresult_%d = merge(alpha_%d, gamma) -- ä %d", PREFIX, n, n, n)
+  local modified = string.format("%sresult_%d = merge(ALPHA_%d, gamma) -- ä %d", PREFIX, n, n, n)
+  local byte_col = original:find("alpha", 1, true)
+  local col = byte_col - PREFIX_EXTRA_BYTES
+  local change = {
+    original = { start_line = orig_line, end_line = orig_line + 1 },
+    modified = { start_line = mod_line, end_line = mod_line + 1 },
+    inner_changes = {
+      {
+        original = char_range(orig_line, col, orig_line, col + 5),
+        modified = char_range(mod_line, col, mod_line, col + 5),
+      },
+    },
+  }
+  return { original }, { modified }, change
+end
+
+-- Two lines inserted on the modified side (filler lines on the left)
+local function insert_hunk(orig_line, mod_line, n)
+  local change = {
+    original = { start_line = orig_line, end_line = orig_line },
+    modified = { start_line = mod_line, end_line = mod_line + 2 },
+    inner_changes = {
+      {
+        original = char_range(orig_line, 1, orig_line, 1),
+        modified = char_range(mod_line, 1, mod_line + 2, 1),
+      },
+    },
+  }
+  return {}, { PREFIX .. "inserted " .. n, PREFIX .. "inserted " .. n .. " (2)" }, change
+end
+
+-- One line deleted from the original side (filler line on the right)
+local function delete_hunk(orig_line, mod_line, n)
+  local change = {
+    original = { start_line = orig_line, end_line = orig_line + 1 },
+    modified = { start_line = mod_line, end_line = mod_line },
+    inner_changes = {
+      {
+        original = char_range(orig_line, 1, orig_line + 1, 1),
+        modified = char_range(mod_line, 1, mod_line, 1),
+      },
+    },
+  }
+  return { PREFIX .. "deleted " .. n }, {}, change
+end
+
+local HUNK_KINDS = { modify_hunk, insert_hunk, delete_hunk }
+
+-- Builds both sides and the LinesDiff describing them: `hunks` hunks, each
+-- preceded by `gap` equal lines, cycling through modify/insert/delete
+local function make_input(hunks)
+  local original, modified, changes = {}, {}, {}
+  local n = 0
+  for h = 1, hunks do
+    for _ = 1, gap do
+      n = n + 1
+      table.insert(original, equal_line(n))
+      table.insert(modified, equal_line(n))
+    end
+    local kind = HUNK_KINDS[(h - 1) % #HUNK_KINDS + 1]
+    local orig_part, mod_part, change = kind(#original + 1, #modified + 1, h)
+    vim.list_extend(original, orig_part)
+    vim.list_extend(modified, mod_part)
+    table.insert(changes, change)
+  end
+  for _ = 1, gap do
+    n = n + 1
+    table.insert(original, equal_line(n))
+    table.insert(modified, equal_line(n))
+  end
+  return original, modified, { changes = changes, moves = {}, hit_timeout = false }
+end
+
+-- Simulates typing one character into an equal line of the modified buffer and
+-- returns the updated lines and a LinesDiff with that line as an extra hunk
+local function apply_edit(right_buf, original, modified, lines_diff, hunk_index)
+  -- The first equal line before the chosen hunk stays aligned on both sides
+  local change = lines_diff.changes[hunk_index]
+  local orig_line = change.original.start_line - gap
+  local mod_line = change.modified.start_line - gap
+  local text = modified[mod_line]
+  vim.api.nvim_buf_set_text(right_buf, mod_line - 1, #text, mod_line - 1, #text, { "x" })
+
+  local edited = vim.list_slice(modified)
+  edited[mod_line] = text .. "x"
+  local changes = vim.list_slice(lines_diff.changes, 1, hunk_index - 1)
+  table.insert(changes, {
+    original = { start_line = orig_line, end_line = orig_line + 1 },
+    modified = { start_line = mod_line, end_line = mod_line + 1 },
+    inner_changes = {
+      {
+        original = char_range(orig_line, #text + 1, orig_line, #text + 1),
+        modified = char_range(mod_line, #text + 1, mod_line, #text + 2),
+      },
+    },
+  })
+  vim.list_extend(changes, lines_diff.changes, hunk_index)
+  return edited, { changes = changes, moves = {}, hit_timeout = false }
+end
+
+-- ============================================================================
+-- Measurement
+-- ============================================================================
+
+local function median(values)
+  local sorted = vim.deepcopy(values)
+  table.sort(sorted)
+  local n = #sorted
+  if n == 0 then
+    return 0
+  end
+  if n % 2 == 1 then
+    return sorted[(n + 1) / 2]
+  end
+  return (sorted[n / 2] + sorted[n / 2 + 1]) / 2
+end
+
+local function count_extmarks(bufnr)
+  local highlight = #vim.api.nvim_buf_get_extmarks(bufnr, highlights.ns_highlight, 0, -1, {})
+  local fillers = vim.api.nvim_buf_get_extmarks(bufnr, highlights.ns_filler, 0, -1, { details = true })
+  local virt_lines = 0
+  for _, mark in ipairs(fillers) do
+    virt_lines = virt_lines + #(mark[4].virt_lines or {})
+  end
+  return { highlight = highlight, filler = #fillers, virt_lines = virt_lines }
+end
+
+local function load_buffers(original, modified)
+  local left = vim.api.nvim_create_buf(false, true)
+  local right = vim.api.nvim_create_buf(false, true)
+  vim.api.nvim_buf_set_lines(left, 0, -1, false, original)
+  vim.api.nvim_buf_set_lines(right, 0, -1, false, modified)
+  return left, right
+end
+
+local function timed_render(left, right, original, modified, lines_diff)
+  local start = now_ms()
+  core.render_diff(left, right, original, modified, lines_diff)
+  return now_ms() - start
+end
+
+local results = {}
+print(string.format("\nRender benchmark (%d reps, %d unchanged lines between hunks)\n", reps, gap))
+
+for _, hunks in ipairs(hunk_counts) do
+  local original, modified, lines_diff = make_input(hunks)
+  local render_ms, rerender_ms = {}, {}
+  local marks, remarks
+
+  for rep = 0, reps do
+    collectgarbage("collect")
+    local left, right = load_buffers(original, modified)
+    local first = timed_render(left, right, original, modified, lines_diff)
+    marks = { left = count_extmarks(left), right = count_extmarks(right) }
+
+    -- Edit next to a different hunk each rep so no single position dominates
+    local hunk_index = (rep * 7919) % hunks + 1
+    local edited, edited_diff = apply_edit(right, original, modified, lines_diff, hunk_index)
+    local second = timed_render(left, right, original, edited, edited_diff)
+    remarks = { left = count_extmarks(left), right = count_extmarks(right) }
+
+    vim.api.nvim_buf_delete(left, { force = true })
+    vim.api.nvim_buf_delete(right, { force = true })
+    if rep > 0 then -- rep 0 is warmup (JIT traces, extmark tree allocation)
+      table.insert(render_ms, first)
+      table.insert(rerender_ms, second)
+    end
+  end
+
+  table.insert(results, {
+    hunks = hunks,
+    lines = #original,
+    render_ms = median(render_ms),
+    rerender_ms = median(rerender_ms),
+    extmarks = marks,
+    rerender_extmarks = remarks,
+  })
+end
+
+-- ============================================================================
+-- Report
+-- ============================================================================
+
+local baseline = nil
+if baseline_path then
+  local file = io.open(baseline_path, "r")
+  if file then
+    baseline = vim.json.decode(file:read("*a"))
+    file:close()
+  else
+    print("Cannot read baseline " .. baseline_path)
+  end
+end
+
+local function baseline_entry(hunks)
+  if not baseline then
+    return nil
+  end
+  for _, entry in ipairs(baseline.results or {}) do
+    if entry.hunks == hunks then
+      return entry
+    end
+  end
+  return nil
+end
+
+local function delta(current, base)
+  if not base or base <= 0 then
+    return ""
+  end
+  return string.format("%+.1f%%", (current / base - 1) * 100)
+end
+
+local function total_marks(marks)
+  return marks.left.highlight + marks.right.highlight + marks.left.filler + marks.right.filler
+end
+
+print(string.format("%-8s %-8s %11s %11s %9s %10s %10s %10s", "hunks", "lines", "render ms", "rerender", "extmarks",
+  "virt_lines", baseline and "render" or "", baseline and "rerender" or ""))
+print(string.rep("-", 84))
+for _, entry in ipairs(results) do
+  local base = baseline_entry(entry.hunks)
+  print(string.format("%-8d %-8d %11.2f %11.2f %9d %10d %10s %10s", entry.hunks, entry.lines, entry.render_ms,
+    entry.rerender_ms, total_marks(entry.extmarks), entry.extmarks.left.virt_lines + entry.extmarks.right.virt_lines,
+    delta(entry.render_ms, base and base.render_ms), delta(entry.rerender_ms, base and base.rerender_ms)))
+end
+
+if json_path then
+  local file = io.open(json_path, "w")
+  if file then
+    file:write(vim.json.encode({ gap = gap, reps = reps, results = results }))
+    file:close()
+    print("\nWrote " .. json_path)
+  else
+    print("\nCannot write " .. json_path)
+  end
+end
+
+vim.cmd('quitall!')
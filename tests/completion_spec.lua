@@ -3,95 +3,111 @@
 
 local git = require("vscode-diff.git")
 local commands = require("vscode-diff.commands")
+local rev_index = require("vscode-diff.rev_index")
+local h = dofile('tests/helpers.lua')
 
 describe("Command Completion", function()
-  describe("git.get_git_root_sync", function()
-    it("Returns git root for valid directory", function()
-      local cwd = vim.fn.getcwd()
-      local root = git.get_git_root_sync(cwd)
-
-      -- We're running in the vscode-diff.nvim repo
-      if root then
-        assert.equal("string", type(root))
-        assert.equal(1, vim.fn.isdirectory(root))
-      end
-    end)
-
-    it("Returns nil for non-git directory", function()
-      local root = git.get_git_root_sync("/tmp")
-      -- /tmp might or might not be in a git repo depending on system
-      assert.is_true(root == nil or type(root) == "string")
+  describe("git.get_rev_candidates_async", function()
+    local function candidates_for(dir)
+      local result
+      git.get_rev_candidates_async(dir, function(err, candidates)
+        result = { err = err, candidates = candidates }
+      end)
+      assert.is_true(vim.wait(5000, function() return result ~= nil end))
+      return result
+    end
+
+    it("Lists HEAD refs, branches, tags and stashes", function()
+      local repo = h.create_temp_git_repo()
+      repo.write_file("file.txt", { "one" })
+      repo.git("add file.txt")
+      repo.git("commit -m initial")
+      repo.git("tag v1.0")
+      repo.write_file("file.txt", { "two" })
+      repo.git("stash")
+
+      local result = candidates_for(repo.dir)
+      repo.cleanup()
+
+      assert.is_nil(result.err)
+      assert.same({ "HEAD", "HEAD~1", "HEAD~2", "HEAD~3" }, vim.list_slice(result.candidates, 1, 4))
+      assert.is_true(vim.tbl_contains(result.candidates, "main"), "Should include branches")
+      assert.is_true(vim.tbl_contains(result.candidates, "v1.0"), "Should include tags")
+      assert.is_true(vim.tbl_contains(result.candidates, "stash@{0}"), "Should include stashes")
     end)
 
-    it("Handles file path input", function()
-      local test_file = vim.fn.getcwd() .. "/README.md"
-      local root = git.get_git_root_sync(test_file)
+    it("Reports an error outside a repository", function()
+      local dir = h.create_temp_dir()
+      local result = candidates_for(dir)
+      vim.fn.delete(dir, "rf")
 
-      if root then
-        assert.equal("string", type(root))
-      end
+      assert.is_not_nil(result.err)
+      assert.is_nil(result.candidates)
     end)
   end)
 
-  describe("git.get_rev_candidates", function()
-    it("Returns empty table for nil git_root", function()
-      local candidates = git.get_rev_candidates(nil)
-      assert.equal("table", type(candidates))
-      assert.equal(0, #candidates)
-    end)
-
-    it("Returns HEAD refs for valid git repo", function()
-      local cwd = vim.fn.getcwd()
-      local git_root = git.get_git_root_sync(cwd)
-
-      if git_root then
-        local candidates = git.get_rev_candidates(git_root)
-        assert.equal("table", type(candidates))
-        assert.is_true(#candidates > 0, "Should return some candidates")
+  describe("rev_index", function()
+    local repo
 
-        -- Should include HEAD refs
-        assert.is_true(vim.tbl_contains(candidates, "HEAD"), "Should include HEAD")
-        assert.is_true(vim.tbl_contains(candidates, "HEAD~1"), "Should include HEAD~1")
-      end
+    before_each(function()
+      rev_index.clear()
+      repo = h.create_temp_git_repo()
+      repo.write_file("file.txt", { "one" })
+      repo.git("add file.txt")
+      repo.git("commit -m initial")
+      repo.git("tag v1.0")
     end)
 
-    it("Returns branches for valid git repo", function()
-      local cwd = vim.fn.getcwd()
-      local git_root = git.get_git_root_sync(cwd)
-
-      if git_root then
-        local candidates = git.get_rev_candidates(git_root)
-
-        -- In CI, shallow clones may not have full branch info
-        -- Just verify we got some candidates (HEAD refs at minimum)
-        assert.is_true(#candidates >= 4, "Should have at least HEAD refs")
-      end
+    after_each(function()
+      rev_index.clear()
+      repo.cleanup()
     end)
 
-    it("Returns tags for valid git repo", function()
-      local cwd = vim.fn.getcwd()
-      local git_root = git.get_git_root_sync(cwd)
+    it("Builds in the background and filters by prefix", function()
+      -- Nothing is known before the root has been resolved
+      assert.same({}, rev_index.complete(repo.dir, "ma"))
+      assert.is_true(vim.wait(5000, function() return rev_index.is_ready(repo.dir) end))
 
-      if git_root then
-        local candidates = git.get_rev_candidates(git_root)
+      assert.same({ "main" }, rev_index.complete(repo.dir, "ma"))
+      assert.same({ "HEAD~1", "HEAD~2", "HEAD~3" }, rev_index.complete(repo.dir, "HEAD~"))
+      assert.same({}, rev_index.complete(repo.dir, "nope"))
 
-        -- In CI, shallow clones may not have tags
-        -- Just verify candidates is a valid table
-        assert.equal("table", type(candidates))
-      end
+      local all = rev_index.complete(repo.dir, "")
+      assert.equal("HEAD", all[1])
+      assert.is_true(vim.tbl_contains(all, "v1.0"))
     end)
 
-    it("Returns remotes for valid git repo", function()
-      local cwd = vim.fn.getcwd()
-      local git_root = git.get_git_root_sync(cwd)
+    it("Picks up new branches from fs events", function()
+      rev_index.warm(repo.dir)
+      assert.is_true(vim.wait(5000, function() return rev_index.is_ready(repo.dir) end))
+      assert.same({}, rev_index.complete(repo.dir, "feature"))
 
-      if git_root then
-        local candidates = git.get_rev_candidates(git_root)
+      repo.git("branch feature-x")
+      assert.is_true(vim.wait(5000, function()
+        return #rev_index.complete(repo.dir, "feature") == 1
+      end), "New branch should appear without a completion-time git call")
+    end)
 
-        -- In CI, shallow clones may not have remote refs
-        -- Just verify candidates is a valid table
-        assert.equal("table", type(candidates))
-      end
+    it("Retries the root lookup after it failed", function()
+      local dir = h.create_temp_dir()
+      rev_index.warm(dir)
+      vim.wait(200)
+      assert.is_false(rev_index.is_ready(dir))
+
+      h.git_cmd(dir, "init")
+      h.git_cmd(dir, "config user.email 'test@test.com'")
+      h.git_cmd(dir, "config user.name 'Test'")
+      h.git_cmd(dir, "commit --allow-empty -m initial")
+      -- Not resolved again while the failure is recent
+      rev_index.warm(dir)
+      vim.wait(200)
+      assert.is_false(rev_index.is_ready(dir))
+
+      assert.is_true(vim.wait(10000, function()
+        rev_index.warm(dir)
+        return rev_index.is_ready(dir)
+      end, 100), "A directory that became a repository should be indexed")
+      vim.fn.delete(dir, "rf")
     end)
   end)
 
@@ -110,11 +126,11 @@ describe("Command Completion", function()
   describe("Completion caching", function()
     it("Returns consistent results on repeated calls", function()
       local cwd = vim.fn.getcwd()
-      local git_root = git.get_git_root_sync(cwd)
+      rev_index.warm(cwd)
 
-      if git_root then
-        local candidates1 = git.get_rev_candidates(git_root)
-        local candidates2 = git.get_rev_candidates(git_root)
+      if vim.wait(5000, function() return rev_index.is_ready(cwd) end) then
+        local candidates1 = rev_index.complete(cwd, "")
+        local candidates2 = rev_index.complete(cwd, "")
 
         assert.equal(#candidates1, #candidates2, "Should return same number of candidates")
 
@@ -103,7 +103,103 @@ describe("FFI Integration", function()
     local version = diff.get_version()
     assert.equal("string", type(version), "Version should be a string")
     assert.is_true(#version > 0, "Version should not be empty")
+    assert.equal(6, diff.get_api_version(), "FFI declarations match API version 6")
     -- Note: original had print statement, keeping as comment for parity
     -- print("    (Version: " .. version .. ")")
   end)
+
+  -- Test 11: Counting-only stats API
+  it("compute_diff_stats returns line counts", function()
+    local stats = diff.compute_diff_stats(
+      {"keep", "old", "drop", "tail"},
+      {"keep", "new", "tail", "added"}
+    )
+    assert.equal(1, stats.modified, "old -> new is modified")
+    assert.equal(1, stats.deleted, "drop is deleted")
+    assert.equal(1, stats.inserted, "added is inserted")
+    assert.is_false(stats.hit_timeout)
+  end)
+
+  -- Test 12: Batch stats preserve order
+  it("compute_diff_stats_batch handles many pairs", function()
+    local file_pairs = {
+      { {"a"}, {"a"} },
+      { {"a", "b"}, {"a", "b", "c"} },
+      { {"x", "y"}, {"y"} },
+    }
+    local results = diff.compute_diff_stats_batch(file_pairs)
+    assert.equal(3, #results)
+    assert.equal(0, results[1].inserted + results[1].deleted + results[1].modified)
+    assert.equal(1, results[2].inserted)
+    assert.equal(1, results[3].deleted)
+  end)
+
+  -- Test 13: Rename candidate shortlisting
+  it("find_rename_candidates pairs similar files only", function()
+    local base, other = {}, {}
+    for i = 1, 100 do
+      table.insert(base, "local value_" .. i .. " = " .. i)
+      table.insert(other, "unrelated " .. i)
+    end
+    local renamed = vim.deepcopy(base)
+    renamed[50] = "local changed = true"
+
+    local candidates = diff.find_rename_candidates({ other, base }, { renamed })
+    assert.equal(1, #candidates)
+    assert.equal(2, candidates[1].original)
+    assert.equal(1, candidates[1].modified)
+    assert.is_true(candidates[1].similarity > 0.8)
+  end)
+
+  -- Test 14: Rewrite pre-check flag crosses the FFI boundary
+  it("Reports rewritten files via is_rewrite", function()
+    local original, modified = {}, {}
+    for i = 1, 150 do
+      table.insert(original, "old line " .. i)
+      table.insert(modified, "new text " .. i)
+    end
+
+    local result = diff.compute_diff(original, modified, { rewrite_threshold = 0.1 })
+    assert.is_true(result.is_rewrite)
+    assert.equal(1, #result.changes)
+
+    result = diff.compute_diff(original, modified)
+    assert.is_false(result.is_rewrite)
+  end)
+
+  -- Test 15: DiffStats instrumentation crosses the FFI boundary
+  it("Returns per-stage stats when collect_stats is set", function()
+    local original = { "int a = 1;", "int b = 2;", "int c = 3;" }
+    local modified = { "int a = 1;", "int b = 20;", "int c = 3;" }
+
+    local result = diff.compute_diff(original, modified, { collect_stats = true })
+    assert.is_not_nil(result.stats)
+    assert.equal("dp", result.stats.algorithm)
+    assert.equal(2, result.stats.line_edit_distance)
+    assert.equal(1, result.stats.refined_regions)
+    assert.is_true(result.stats.allocations > 0)
+    assert.is_true(result.stats.total_ms >= 0)
+    assert.is_string(diff.format_stats(result.stats))
+
+    result = diff.compute_diff(original, modified)
+    assert.is_nil(result.stats)
+  end)
+
+  -- Test 16: xdiff hunks from vim.diff are refined to character level
+  it("refine_line_alignments refines vim.diff hunks", function()
+    local original = { "int a = 1;", "int b = 2;", "int c = 3;", "int d = 4;" }
+    local modified = { "int a = 1;", "int b = 20;", "int c = 3;", "  int d = 4;", "int e = 5;" }
+    local hunks = vim.diff(
+      table.concat(original, "\n") .. "\n",
+      table.concat(modified, "\n") .. "\n",
+      { result_type = "indices", ignore_whitespace = true })
+
+    local staged = diff.refine_line_alignments(original, modified, hunks)
+    local expected = diff.compute_diff(original, modified)
+    assert.same(expected.changes, staged.changes)
+
+    assert.has_error(function()
+      diff.refine_line_alignments(original, modified, {})
+    end)
+  end)
 end)
@@ -254,4 +254,92 @@ describe("Git Integration", function()
     vim.wait(3000, function() return test_passed end)
     assert.is_true(test_passed, "Test should complete")
   end)
+
+  -- Test 10: Git roots are memoized per directory
+  it("Memoizes git root per directory", function()
+    local current_file = debug.getinfo(1).source:sub(2)
+    local first_root = nil
+    local first_done = false
+
+    git.clear_cache()
+    git.get_git_root(current_file, function(err, git_root)
+      first_root = not err and git_root or nil
+      first_done = true
+    end)
+    vim.wait(2000, function() return first_done end)
+
+    if first_root then
+      -- Answered from memory, but still through the main loop like a miss
+      local second_root = nil
+      git.get_git_root(current_file, function(_, git_root)
+        second_root = git_root
+      end)
+      assert.is_nil(second_root, "Cached root should not be delivered synchronously")
+      vim.wait(1000, function() return second_root ~= nil end)
+      assert.equal(first_root, second_root)
+    end
+  end)
+
+  -- Test 11: Concurrent requests for one blob share a single fetch
+  it("Joins concurrent fetches of the same blob", function()
+    local current_file = debug.getinfo(1).source:sub(2)
+    local results = {}
+    local done = false
+
+    git.clear_cache()
+    git.get_git_root(current_file, function(err_root, git_root)
+      if err_root then
+        done = true
+        return
+      end
+      local rel_path = git.get_relative_path(current_file, git_root)
+      git.resolve_revisions({ "HEAD", "HEAD" }, git_root, function(err_resolve, commit_hashes)
+        if err_resolve then
+          done = true
+          return
+        end
+        git.prefetch_file_content(commit_hashes[1], git_root, rel_path)
+        for i = 1, 2 do
+          git.get_file_content(commit_hashes[1], git_root, rel_path, function(_, lines)
+            results[i] = lines or false
+            done = results[1] ~= nil and results[2] ~= nil
+          end)
+        end
+      end)
+    end)
+
+    vim.wait(3000, function() return done end)
+    assert.is_true(done, "Test should complete")
+    if results[1] then
+      -- Joined callers get equal but separate tables: mutating one is safe
+      assert.same(results[1], results[2])
+      assert.are_not.equal(results[1], results[2])
+      local expected = #results[2]
+      table.insert(results[1], "mutated")
+      assert.equal(expected, #results[2])
+    end
+  end)
+
+  -- Test 12: resolve_revisions reports hashes in order, or the first error
+  it("Resolves revisions concurrently", function()
+    local current_file = debug.getinfo(1).source:sub(2)
+    local outcome = nil
+
+    git.get_git_root(current_file, function(err_root, git_root)
+      if err_root then
+        outcome = { root_err = err_root }
+        return
+      end
+      git.resolve_revisions({ "HEAD", "invalid-revision-12345" }, git_root, function(err, hashes)
+        outcome = { err = err, hashes = hashes }
+      end)
+    end)
+
+    vim.wait(3000, function() return outcome ~= nil end)
+    assert.is_not_nil(outcome, "Callback should be invoked")
+    assert.is_nil(outcome.root_err, "Test file should be inside the repository")
+    assert.is_not_nil(outcome.err, "An invalid revision should fail the batch")
+    assert.is_nil(outcome.hashes)
+    assert.is_truthy(outcome.err:match("invalid%-revision%-12345"))
+  end)
 end)
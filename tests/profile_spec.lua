@@ -0,0 +1,72 @@
+-- Test: Session Profiler
+-- Validates the :CodeDiff profile ring buffer, breakdown table and call-site hooks
+
+local profile = require("vscode-diff.profile")
+local diff = require("vscode-diff.diff")
+
+describe("Session Profiler", function()
+  before_each(function()
+    profile.stop()
+    profile.clear()
+  end)
+
+  after_each(function()
+    profile.start(500)  -- Restore the default ring size
+    profile.stop()
+    profile.clear()
+  end)
+
+  -- Test 1: Ring buffer keeps only the newest samples
+  it("Keeps the last N samples", function()
+    profile.start(3)
+    for i = 1, 5 do
+      profile.add("render", i)
+    end
+
+    local samples = profile.samples()
+    assert.equal(3, #samples)
+    assert.equal(3, samples[1].ms, "Oldest kept sample should be the third")
+    assert.equal(5, samples[3].ms, "Newest sample should be last")
+  end)
+
+  -- Test 2: Breakdown aggregates per stage in pipeline order
+  it("Aggregates stages in pipeline order", function()
+    profile.start()
+    profile.add("render", 4)
+    profile.add("compute", 10)
+    profile.add("compute.hash", 1)
+    profile.add("git show", 2)
+    profile.add("render", 2)
+
+    local rows = profile.breakdown()
+    local order = vim.tbl_map(function(row) return row.stage end, rows)
+    assert.same({ "git show", "compute", "compute.hash", "render" }, order)
+    assert.equal(2, rows[4].calls)
+    assert.equal(6, rows[4].total_ms)
+    assert.equal(3, rows[4].median_ms)
+    assert.equal(4, rows[4].max_ms)
+    assert.is_true(rows[3].sub_stage)
+  end)
+
+  -- Test 3: compute_diff records marshal/compute/convert and C stages
+  it("Records FFI and C stages of compute_diff", function()
+    profile.start()
+    diff.compute_diff({ "a", "b" }, { "a", "c" }, { collect_stats = true })
+
+    local stages = {}
+    for _, sample in ipairs(profile.samples()) do
+      stages[sample.stage] = true
+    end
+    for _, stage in ipairs({ "marshal", "compute", "convert", "compute.hash", "compute.refine" }) do
+      assert.is_true(stages[stage] ~= nil, "Missing stage " .. stage)
+    end
+  end)
+
+  -- Test 4: Nothing is recorded while profiling is off
+  it("Records nothing when disabled", function()
+    diff.compute_diff({ "a" }, { "b" })
+    assert.equal(0, #profile.samples())
+    local lines = profile.format()
+    assert.is_true(lines[2]:find("No samples yet", 1, true) ~= nil)
+  end)
+end)
@@ -30,6 +30,7 @@ SPEC_FILES=(
   "tests/timeout_spec.lua"
   "tests/git_integration_spec.lua"
   "tests/completion_spec.lua"
+  "tests/profile_spec.lua"
   "tests/autoscroll_spec.lua"
   "tests/explorer_spec.lua"
   "tests/explorer_staging_spec.lua"